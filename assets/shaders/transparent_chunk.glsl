@@ -2,9 +2,27 @@
 
 #version 450 core
 
-layout (location = 0) in uint  in_packed_vertex_attributes0;
-layout (location = 1) in uint  in_packed_vertex_attributes1;
-layout (location = 2) in ivec2 in_chunk_coords;
+layout (location = 0) in ivec2 in_chunk_coords;
+layout (location = 1) in int   in_sub_chunk_index;
+
+// one 64 bit record per face, the layout is the one of pack_block_face in the sub chunk mesher
+// the decoding in main is mirrored by decode_block_face_corner_like_shader there, validate_block_face_packing checks both
+struct Block_Face
+{
+    uint packed_face_attributes0;
+    uint packed_face_attributes1;
+};
+
+layout (std430, binding = 0) readonly buffer Block_Faces
+{
+    Block_Face faces[];
+};
+
+// the top, bottom and side texture ids of a block in 10 bits each and its flags
+layout (std430, binding = 1) readonly buffer Block_Infos
+{
+    uvec2 block_infos[];
+};
 
 out vec2 a_uv;
 out flat int a_texture_id;
@@ -31,14 +49,50 @@ uniform ivec3 u_highlighted_block_coords;
 uniform ivec2 u_highlighted_block_chunk_coords;
 
 #define BLOCK_X_MASK 15
-#define BLOCK_Y_MASK 255
+#define BLOCK_Y_MASK 7
 #define BLOCK_Z_MASK 15
-#define LOCAL_POSITION_ID_MASK 7
 #define FACE_ID_MASK 7
-#define FACE_CORNER_ID_MASK 3
+#define BLOCK_ID_MASK 127
+#define LOD_LEVEL_MASK 3
+#define UNIFORM_FACE_BIT (1u << 23)
+#define AMBIENT_OCCLUSION_LEVEL_MASK 3
 #define SKY_LIGHT_LEVEL_MASK 15
 #define LIGHT_SOURCE_LEVEL_MASK 15
-#define AMBIENT_OCCLUSION_LEVEL_MASK 3
+#define TEXTURE_ID_MASK 1023
+#define TEXTURE_REPEAT_MASK 15
+#define SUB_CHUNK_HEIGHT 8
+
+// the two triangles of a face as face corners
+const uint triangle_corners[6] = const uint[](3, 1, 0, 3, 2, 1);
+
+// the local position of each face corner (bottom right, bottom left, top left, top right)
+const uint face_local_position_ids[24] = const uint[](
+    0, 1, 2, 3, // top
+    5, 4, 7, 6, // bottom
+    5, 6, 2, 1, // left
+    7, 4, 0, 3, // right
+    6, 7, 3, 2, // front
+    4, 5, 1, 0  // back
+);
+
+// the axes the texture u and v coordinates run along
+const vec3 face_u_axes[6] = const vec3[](
+    const vec3(1.0f, 0.0f, 0.0f), // top
+    const vec3(1.0f, 0.0f, 0.0f), // bottom
+    const vec3(0.0f, 0.0f, 1.0f), // left
+    const vec3(0.0f, 0.0f, 1.0f), // right
+    const vec3(1.0f, 0.0f, 0.0f), // front
+    const vec3(1.0f, 0.0f, 0.0f)  // back
+);
+
+const vec3 face_v_axes[6] = const vec3[](
+    const vec3(0.0f, 0.0f, 1.0f), // top
+    const vec3(0.0f, 0.0f, 1.0f), // bottom
+    const vec3(0.0f, 1.0f, 0.0f), // left
+    const vec3(0.0f, 1.0f, 0.0f), // right
+    const vec3(0.0f, 1.0f, 0.0f), // front
+    const vec3(0.0f, 1.0f, 0.0f)  // back
+);
 
 const vec3 local_positions[8] = const vec3[](
     const vec3( 0.5f,  0.5f,  0.5f), // 0
@@ -73,16 +127,52 @@ uniform sampler2DArray u_block_array_texture;
 
 void main()
 {
-    uint block_x = in_packed_vertex_attributes0 & BLOCK_X_MASK;
-    uint block_y = (in_packed_vertex_attributes0 >> 4) & BLOCK_Y_MASK;
-    uint block_z = (in_packed_vertex_attributes0 >> 12) & BLOCK_Z_MASK;
-    vec3 block_coords = vec3(block_x, block_y, block_z);
-    uint local_position_id = (in_packed_vertex_attributes0 >> 16) & LOCAL_POSITION_ID_MASK;
-    uint face_id = (in_packed_vertex_attributes0 >> 19) & FACE_ID_MASK;
-    uint face_corner_id = (in_packed_vertex_attributes0 >> 22) & FACE_CORNER_ID_MASK;
-    uint flags = in_packed_vertex_attributes0 >> 24;
+    uint face_index = uint(gl_VertexID) / 6u;
+    uint face_corner_id = triangle_corners[uint(gl_VertexID) % 6u];
+
+    uint packed_face_attributes0 = faces[face_index].packed_face_attributes0;
+    uint packed_face_attributes1 = faces[face_index].packed_face_attributes1;
+
+    uint block_x = packed_face_attributes0 & BLOCK_X_MASK;
+    uint block_y = uint(in_sub_chunk_index * SUB_CHUNK_HEIGHT) + ((packed_face_attributes0 >> 4) & BLOCK_Y_MASK);
+    uint block_z = (packed_face_attributes0 >> 7) & BLOCK_Z_MASK;
+    uint face_id = (packed_face_attributes0 >> 11) & FACE_ID_MASK;
+    uint block_id = (packed_face_attributes0 >> 14) & BLOCK_ID_MASK;
+    uint local_position_id = face_local_position_ids[face_id * 4u + face_corner_id];
+
+    uvec2 block_info = block_infos[block_id];
+    uint flags = block_info.y;
+
+    uint texture_ids = block_info.x;
+    if (face_id == Bottom_Face_ID) texture_ids >>= 10;
+    else if (face_id != Top_Face_ID) texture_ids >>= 20;
+
+    uint corner_light;
+    uint texture_repeat_u_count = 1;
+    uint texture_repeat_v_count = 1;
 
-    vec3 position = vec3(in_chunk_coords.x * CHUNK_WIDTH, 0.0f, in_chunk_coords.y * CHUNK_DEPTH) + block_coords + local_positions[local_position_id] + vec3(0.5f, 0.5f, 0.5f);
+    // a uniform face has the same light at all four corners and may repeat its texture across several blocks
+    if ((packed_face_attributes0 & UNIFORM_FACE_BIT) != 0)
+    {
+        corner_light = (packed_face_attributes1 & 0xFF) | (((packed_face_attributes0 >> 24) & AMBIENT_OCCLUSION_LEVEL_MASK) << 8);
+        texture_repeat_u_count = ((packed_face_attributes1 >> 8)  & TEXTURE_REPEAT_MASK) + 1;
+        texture_repeat_v_count = ((packed_face_attributes1 >> 12) & TEXTURE_REPEAT_MASK) + 1;
+    }
+    else
+    {
+        corner_light = ((packed_face_attributes1 >> (face_corner_id * 8u)) & 0xFF) |
+                       (((packed_face_attributes0 >> (24u + face_corner_id * 2u)) & AMBIENT_OCCLUSION_LEVEL_MASK) << 8);
+    }
+
+    // a far sub chunk is meshed from cells of 2^lod_level blocks on a side, the block coords are the first block of the
+    // first cell and the repeat counts are how many cells the face spans along its u and v axes
+    float cell_size = float(1u << ((packed_face_attributes0 >> 21) & LOD_LEVEL_MASK));
+    vec3 face_size  = (vec3(1.0f, 1.0f, 1.0f) +
+                       face_u_axes[face_id] * float(texture_repeat_u_count - 1) +
+                       face_v_axes[face_id] * float(texture_repeat_v_count - 1)) * cell_size;
+
+    vec3 block_coords = vec3(block_x, block_y, block_z);
+    vec3 position = vec3(in_chunk_coords.x * CHUNK_WIDTH, 0.0f, in_chunk_coords.y * CHUNK_DEPTH) + block_coords + (local_positions[local_position_id] + vec3(0.5f, 0.5f, 0.5f)) * face_size;
     if ((flags & BlockFlags_Is_Solid) == 0)
     {
         position.y -= 0.05f;
@@ -93,16 +183,16 @@ void main()
     a_fog_factor = clamp(distance_relative_to_camera * u_one_over_chunk_radius, 0.0f, 1.0f);
 
     a_uv         = uvs[face_corner_id];
-    a_texture_id = int(in_packed_vertex_attributes1 >> 10);
+    a_texture_id = int(texture_ids & TEXTURE_ID_MASK);
 
-    float sky_light_level = float(in_packed_vertex_attributes1 & SKY_LIGHT_LEVEL_MASK);
+    float sky_light_level = float(corner_light & SKY_LIGHT_LEVEL_MASK);
     float sky_light_factor = u_sky_light_level - 15.0f;
     float sky_light = max(sky_light_level + sky_light_factor, 1.0f);
-    float light_source = float((in_packed_vertex_attributes1 >> 4) & LIGHT_SOURCE_LEVEL_MASK);
+    float light_source = float((corner_light >> 4) & LIGHT_SOURCE_LEVEL_MASK);
 
     a_light_level = float(max(sky_light, light_source)) / 15.0f;
     float ambient_factor = 0.5f + a_light_level * 1.5f;
-    float ambient_occlusion = (float((in_packed_vertex_attributes1 >> 8) & AMBIENT_OCCLUSION_LEVEL_MASK) + ambient_factor) / (3.0f + ambient_factor);
+    float ambient_occlusion = (float((corner_light >> 8) & AMBIENT_OCCLUSION_LEVEL_MASK) + ambient_factor) / (3.0f + ambient_factor);
 
     if ((flags & BlockFlags_Is_Light_Source) == 0)
     {
@@ -105,4 +105,53 @@ project("Minecraft")
     }
 
     targetdir("bin")
-	objdir("obj")
\ No newline at end of file
+	objdir("obj")
+
+-- note(harlequin): the parts of the engine that run without a gpu, the game code is linked in but never started
+project("Tests")
+    location("tests")
+    kind("ConsoleApp")
+    language("C++")
+    cppdialect("C++17")
+	staticruntime("on")
+
+    files
+	{
+		"tests/**.h",
+		"tests/**.cpp",
+		"src/**.h",
+		"src/**.cpp",
+		"src/**.c"
+	}
+
+	removefiles
+	{
+		"src/main.cpp"
+	}
+
+    includedirs
+	{
+		"src",
+		"tests",
+        "lib/include",
+	}
+
+	libdirs
+	{
+		"lib",
+	}
+
+    links
+    {
+        "opengl32.lib",
+        "glfw3dll.lib",
+    }
+
+    defines
+    {
+		"_CRT_SECURE_NO_WARNINGS",
+		"GLFW_INCLUDE_NONE"
+    }
+
+    targetdir("bin")
+	objdir("obj/tests")
@@ -31,6 +31,31 @@ typedef double   f64;
 #define MC_DebugBreak() __builtin_trap()
 #endif
 
+#ifdef _MSC_VER
+#include <intrin.h>
+inline u32 count_trailing_zeros(u64 value)
+{
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return (u32)index;
+}
+
+inline u32 count_set_bits(u64 value)
+{
+    return (u32)__popcnt64(value);
+}
+#else
+inline u32 count_trailing_zeros(u64 value)
+{
+    return (u32)__builtin_ctzll(value);
+}
+
+inline u32 count_set_bits(u64 value)
+{
+    return (u32)__builtin_popcountll(value);
+}
+#endif
+
 #define Min(A, B) ((A) < (B) ? (A) : (B))
 #define Max(A, B) ((A) > (B) ? (A) : (B))
 
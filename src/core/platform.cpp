@@ -6,6 +6,13 @@
 
 #include "renderer/opengl_renderer.h"
 
+#ifdef MC_PLATFORM_WINDOWS
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 namespace minecraft {
 
     static void on_framebuffer_resize(GLFWwindow *window, i32 width, i32 height)
@@ -296,6 +303,26 @@ namespace minecraft {
         return glfwGetTime();
     }
 
+    bool Platform::set_current_thread_affinity(u64 affinity_mask)
+    {
+#ifdef MC_PLATFORM_WINDOWS
+        return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)affinity_mask) != 0;
+#else
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+
+        for (u32 i = 0; i < 64; i++)
+        {
+            if (affinity_mask & ((u64)1 << i))
+            {
+                CPU_SET(i, &cpu_set);
+            }
+        }
+
+        return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpu_set) == 0;
+#endif
+    }
+
     void Platform::shutdown()
     {
         glfwTerminate();
@@ -41,5 +41,7 @@ namespace minecraft {
         static void toggle_cursor_visiblity(GLFWwindow *window, Game_Config *config);
 
         static f64 get_current_time_in_seconds();
+
+        static bool set_current_thread_affinity(u64 affinity_mask);
     };
 }
\ No newline at end of file
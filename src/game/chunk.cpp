@@ -14,16 +14,14 @@ namespace minecraft {
 
     bool initialize_sub_chunk_bucket(Sub_Chunk_Bucket *sub_chunk_bucket)
     {
-        sub_chunk_bucket->memory_id      = -1;
-        sub_chunk_bucket->current_vertex = nullptr;
-        sub_chunk_bucket->face_count     = 0;
+        sub_chunk_bucket->memory_offset = -1;
+        sub_chunk_bucket->face_count    = 0;
         return true;
     }
 
     bool is_sub_chunk_bucket_allocated(const Sub_Chunk_Bucket *sub_chunk_bucket)
     {
-        return sub_chunk_bucket->memory_id != -1 &&
-               sub_chunk_bucket->current_vertex != nullptr;
+        return sub_chunk_bucket->memory_offset != -1;
     }
 
     i32 get_block_index(const glm::ivec3& block_coords)
@@ -35,6 +33,15 @@ namespace minecraft {
         return block_coords.y * Chunk::Width * Chunk::Depth + block_coords.z * Chunk::Width + block_coords.x;
     }
 
+    glm::ivec3 get_block_coords(i32 block_index)
+    {
+        Assert(block_index >= 0 && block_index < (i32)Chunk::BlockCount);
+
+        return { block_index % Chunk::Width,
+                 block_index / (Chunk::Width * Chunk::Depth),
+                 (block_index / Chunk::Width) % Chunk::Depth };
+    }
+
     glm::vec3 get_block_position(Chunk *chunk, const glm::ivec3& block_coords)
     {
         return chunk->position + glm::vec3((f32)block_coords.x + 0.5f, (f32)block_coords.y + 0.5f, (f32)block_coords.z + 0.5f);
@@ -69,25 +76,52 @@ namespace minecraft {
         {
             Sub_Chunk_Render_Data& render_data = chunk->sub_chunks_render_data[sub_chunk_index];
 
-            render_data.face_count          =  0;
-            render_data.active_bucket_index =  0;
-            render_data.instance_memory_id  = -1;
+            render_data.face_count         =  0;
+            render_data.bucket_version     =  0;
+            render_data.instance_memory_id = -1;
+            render_data.content_hash       =  0;
+            render_data.face_connectivity  =  SubChunkFullFaceConnectivity;
+            render_data.occluder           =  0;
 
-            for (i32 j = 0; j < 2; j++)
-            {
-                initialize_sub_chunk_bucket(&render_data.opaque_buckets[j]);
-                initialize_sub_chunk_bucket(&render_data.transparent_buckets[j]);
+            initialize_sub_chunk_bucket(&render_data.opaque_bucket);
+            initialize_sub_chunk_bucket(&render_data.transparent_bucket);
 
-                constexpr f32 inf = std::numeric_limits< f32 >::max();
-                render_data.aabb[j] = { { inf, inf, inf }, { -inf, -inf, -inf } };
-            }
+            constexpr f32 inf = std::numeric_limits< f32 >::max();
+            render_data.aabb = { { inf, inf, inf }, { -inf, -inf, -inf } };
 
             render_data.state = TessellationState_None;
-            render_data.next  = nullptr;
         }
 
         chunk->state              = ChunkState_Initialized;
         chunk->tessellation_state = TessellationState_None;
+        chunk->pending_update_job_count = 0;
+        chunk->update_queue_time        = 0;
+
+        chunk->blocks                   = nullptr;
+        chunk->front_edge_blocks        = nullptr;
+        chunk->back_edge_blocks         = nullptr;
+        chunk->left_edge_blocks         = nullptr;
+        chunk->right_edge_blocks        = nullptr;
+        chunk->light_map                = nullptr;
+        chunk->front_edge_light_map     = nullptr;
+        chunk->back_edge_light_map      = nullptr;
+        chunk->left_edge_light_map      = nullptr;
+        chunk->right_edge_light_map     = nullptr;
+        chunk->pending_light_block_mask = nullptr;
+        chunk->light_source_block_masks = nullptr;
+
+        chunk->has_pending_light_blocks = false;
+        memset(chunk->light_source_block_counts, 0, sizeof(chunk->light_source_block_counts));
+
+        chunk->dirty_sub_chunk_mask     = 0;
+        chunk->lod_level                = 0;
+        chunk->is_far                   = true;
+        chunk->lod_cells                = nullptr;
+        chunk->has_lod_cells            = false;
+        chunk->is_mesh_outdated         = true;
+        chunk->patchable_sub_chunk_mask = 0;
+        chunk->visibility_pass_index    = 0;
+        chunk->reachable_sub_chunk_mask = 0;
 
         for (i32 i = 0; i < ChunkNeighbour_Count; i++)
         {
@@ -97,6 +131,52 @@ namespace minecraft {
         return true;
     }
 
+    void attach_chunk_blocks(Chunk *chunk, Chunk_Blocks *chunk_blocks)
+    {
+        Assert(!chunk->blocks);
+
+        chunk->blocks                   = chunk_blocks->blocks;
+        chunk->front_edge_blocks        = chunk_blocks->front_edge_blocks;
+        chunk->back_edge_blocks         = chunk_blocks->back_edge_blocks;
+        chunk->left_edge_blocks         = chunk_blocks->left_edge_blocks;
+        chunk->right_edge_blocks        = chunk_blocks->right_edge_blocks;
+        chunk->light_map                = chunk_blocks->light_map;
+        chunk->front_edge_light_map     = chunk_blocks->front_edge_light_map;
+        chunk->back_edge_light_map      = chunk_blocks->back_edge_light_map;
+        chunk->left_edge_light_map      = chunk_blocks->left_edge_light_map;
+        chunk->right_edge_light_map     = chunk_blocks->right_edge_light_map;
+        chunk->pending_light_block_mask = chunk_blocks->pending_light_block_mask;
+        chunk->light_source_block_masks = chunk_blocks->light_source_block_masks;
+
+        chunk->has_pending_light_blocks = false;
+        memset(chunk_blocks->pending_light_block_mask, 0, sizeof(chunk_blocks->pending_light_block_mask));
+
+        memset(chunk_blocks->light_source_block_masks, 0, sizeof(chunk_blocks->light_source_block_masks));
+        memset(chunk->light_source_block_counts,       0, sizeof(chunk->light_source_block_counts));
+    }
+
+    Chunk_Blocks *detach_chunk_blocks(Chunk *chunk)
+    {
+        static_assert(offsetof(Chunk_Blocks, blocks) == 0);
+        Chunk_Blocks *chunk_blocks = (Chunk_Blocks*)chunk->blocks;
+        Assert(chunk_blocks);
+
+        chunk->blocks                   = nullptr;
+        chunk->front_edge_blocks        = nullptr;
+        chunk->back_edge_blocks         = nullptr;
+        chunk->left_edge_blocks         = nullptr;
+        chunk->right_edge_blocks        = nullptr;
+        chunk->light_map                = nullptr;
+        chunk->front_edge_light_map     = nullptr;
+        chunk->back_edge_light_map      = nullptr;
+        chunk->left_edge_light_map      = nullptr;
+        chunk->right_edge_light_map     = nullptr;
+        chunk->pending_light_block_mask = nullptr;
+        chunk->light_source_block_masks = nullptr;
+
+        return chunk_blocks;
+    }
+
     inline static glm::vec2 get_sample(i32 seed, const glm::ivec2& chunk_coords, const glm::ivec2& block_xz_coords)
     {
         return {
@@ -126,32 +206,36 @@ namespace minecraft {
         return (i32)glm::trunc(min_height + ((max_height - min_height) * noise));
     }
 
-    static void set_block_id_based_on_height(Block *block,
-                                             i32 block_y,
-                                             i32 height,
-                                             i32 min_height,
-                                             i32 max_height,
-                                             i32 water_level)
+    static constexpr i32 MinBiomeHeight = 100;
+    static constexpr i32 MaxBiomeHeight = 250;
+    static constexpr i32 WaterLevel     = MinBiomeHeight + 50;
+    static_assert(WaterLevel >= MinBiomeHeight && WaterLevel <= MaxBiomeHeight);
+
+    static i32 get_generated_column_height(i32 seed, const glm::ivec2& chunk_coords, const glm::ivec2& block_xz_coords)
+    {
+        glm::vec2 sample = get_sample(seed, chunk_coords, block_xz_coords);
+        f32 noise = get_noise01(sample);
+        Assert(noise >= 0.0f && noise <= 1.0f);
+        return get_height_from_noise01(MinBiomeHeight, MaxBiomeHeight, noise);
+    }
+
+    static u16 get_block_id_based_on_height(i32 block_y, i32 height)
     {
         if (block_y > height)
         {
-            if (block_y < water_level)
-            {
-                block->id = BlockId_Water;
-            }
-            else
+            if (block_y < WaterLevel)
             {
-                block->id = BlockId_Air;
+                return BlockId_Water;
             }
+
+            return BlockId_Air;
         }
         else if (block_y == height)
         {
-            block->id = BlockId_Grass;
-        }
-        else
-        {
-            block->id = BlockId_Dirt;
+            return BlockId_Grass;
         }
+
+        return BlockId_Dirt;
     }
 
     void generate_chunk(Chunk *chunk, i32 seed)
@@ -163,11 +247,6 @@ namespace minecraft {
         i32 left_edge_height_map[Chunk::Depth];
         i32 right_edge_height_map[Chunk::Depth];
 
-        constexpr i32 min_biome_height = 100;
-        constexpr i32 max_biome_height = 250;
-        constexpr i32 water_level = min_biome_height + 50;
-        static_assert(water_level >= min_biome_height && water_level <= max_biome_height);
-
         const glm::ivec2 front_chunk_coords = { chunk->world_coords.x + 0, chunk->world_coords.y - 1 };
         const glm::ivec2 back_chunk_coords  = { chunk->world_coords.x + 0, chunk->world_coords.y + 1 };
         const glm::ivec2 left_chunk_coords  = { chunk->world_coords.x - 1, chunk->world_coords.y + 0 };
@@ -177,44 +256,20 @@ namespace minecraft {
         {
             for (i32 x = 0; x < Chunk::Width; ++x)
             {
-                glm::ivec2 block_xz_coords = { x, z };
-                glm::vec2 sample = get_sample(seed, chunk->world_coords, block_xz_coords);
-                f32 noise = get_noise01(sample);
-                Assert(noise >= 0.0f && noise <= 1.0f);
-                height_map[z][x] = get_height_from_noise01(min_biome_height, max_biome_height, noise);
+                height_map[z][x] = get_generated_column_height(seed, chunk->world_coords, { x, z });
             }
         }
 
         for (i32 x = 0; x < Chunk::Width; ++x)
         {
-            glm::ivec2 block_xz_coords = { x, Chunk::Depth - 1 };
-            glm::vec2 sample = get_sample(seed, front_chunk_coords, block_xz_coords);
-            f32 noise = get_noise01(sample);
-            top_edge_height_map[x] = get_height_from_noise01(min_biome_height, max_biome_height, noise);
-        }
-
-        for (i32 x = 0; x < Chunk::Width; ++x)
-        {
-            glm::ivec2 block_xz_coords = { x, 0 };
-            glm::vec2 sample = get_sample(seed, back_chunk_coords, block_xz_coords);
-            f32 noise = get_noise01(sample);
-            bottom_edge_height_map[x] = get_height_from_noise01(min_biome_height, max_biome_height, noise);
+            top_edge_height_map[x]    = get_generated_column_height(seed, front_chunk_coords, { x, Chunk::Depth - 1 });
+            bottom_edge_height_map[x] = get_generated_column_height(seed, back_chunk_coords,  { x, 0 });
         }
 
         for (i32 z = 0; z < Chunk::Depth; ++z)
         {
-            glm::ivec2 block_xz_coords = { Chunk::Width - 1, z };
-            glm::vec2 sample = get_sample(seed, left_chunk_coords, block_xz_coords);
-            f32 noise = get_noise01(sample);
-            left_edge_height_map[z] = get_height_from_noise01(min_biome_height, max_biome_height, noise);
-        }
-
-        for (i32 z = 0; z < Chunk::Depth; ++z)
-        {
-            glm::ivec2 block_xz_coords = { 0, z };
-            glm::vec2 sample = get_sample(seed, right_chunk_coords, block_xz_coords);
-            f32 noise = get_noise01(sample);
-            right_edge_height_map[z] = get_height_from_noise01(min_biome_height, max_biome_height, noise);
+            left_edge_height_map[z]  = get_generated_column_height(seed, left_chunk_coords,  { Chunk::Width - 1, z });
+            right_edge_height_map[z] = get_generated_column_height(seed, right_chunk_coords, { 0, z });
         }
 
         for (i32 y = 0; y < Chunk::Height; ++y)
@@ -225,8 +280,8 @@ namespace minecraft {
                 {
                     glm::ivec3 block_coords = { x, y, z };
                     Block *block = get_block(chunk, block_coords);
-                    const i32& height = height_map[z][x];
-                    set_block_id_based_on_height(block, y, height, min_biome_height, max_biome_height, water_level);
+                    block->id = get_block_id_based_on_height(y, height_map[z][x]);
+                    update_light_source_block_mask(chunk, get_block_index(block_coords));
                 }
             }
         }
@@ -235,24 +290,108 @@ namespace minecraft {
         {
             for (i32 x = 0; x < Chunk::Width; ++x)
             {
-                const i32& top_edge_height = top_edge_height_map[x];
-                Block *top_edge_block = &(chunk->front_edge_blocks[y * Chunk::Width + x]);
-                set_block_id_based_on_height(top_edge_block, y, top_edge_height, min_biome_height, max_biome_height, water_level);
-
-                const i32& bottom_edge_height = bottom_edge_height_map[x];
-                Block *bottom_edge_block = &(chunk->back_edge_blocks[y * Chunk::Width + x]);
-                set_block_id_based_on_height(bottom_edge_block, y, bottom_edge_height, min_biome_height, max_biome_height, water_level);
+                chunk->front_edge_blocks[y * Chunk::Width + x].id = get_block_id_based_on_height(y, top_edge_height_map[x]);
+                chunk->back_edge_blocks[y * Chunk::Width + x].id  = get_block_id_based_on_height(y, bottom_edge_height_map[x]);
             }
 
             for (i32 z = 0; z < Chunk::Depth; ++z)
             {
-                const i32& left_edge_height = left_edge_height_map[z];
-                Block *left_edge_block = &(chunk->left_edge_blocks[y * Chunk::Depth + z]);
-                set_block_id_based_on_height(left_edge_block, y, left_edge_height, min_biome_height, max_biome_height, water_level);
+                chunk->left_edge_blocks[y * Chunk::Depth + z].id  = get_block_id_based_on_height(y, left_edge_height_map[z]);
+                chunk->right_edge_blocks[y * Chunk::Depth + z].id = get_block_id_based_on_height(y, right_edge_height_map[z]);
+            }
+        }
+    }
+
+    void generate_chunk_lod_cells(Chunk *chunk, Chunk_Lod_Cells *lod_cells, i32 seed)
+    {
+        i32 height_map[Chunk::Depth][Chunk::Width];
+
+        // note(harlequin): every block above the top non air block of a column is air and every block below the
+        // water level is water or ground
+        i32 top_non_air_block_y[Chunk::Depth][Chunk::Width];
+
+        for (i32 z = 0; z < Chunk::Depth; z++)
+        {
+            for (i32 x = 0; x < Chunk::Width; x++)
+            {
+                i32 height = get_generated_column_height(seed, chunk->world_coords, { x, z });
+                height_map[z][x]          = height;
+                top_non_air_block_y[z][x] = Max(height, WaterLevel - 1);
+
+                i32 y = Chunk::Height - 1;
+
+                for (; y >= 0; y--)
+                {
+                    if (!is_block_transparent(&World::block_infos[get_block_id_based_on_height(y, height)]))
+                    {
+                        break;
+                    }
+                }
+
+                chunk->height_map[z * Chunk::Width + x] = (i16)y;
+            }
+        }
+
+        // note(harlequin): the same cells downsample_lod_cell finds unlit, the first block it finds from the top
+        // layer down is the top non air block of the first column that reaches the highest layer
+        for (u32 lod_level = Chunk::MinFarLodLevel; lod_level <= Chunk::MaxLodLevel; lod_level++)
+        {
+            i32 cell_size        = 1 << lod_level;
+            i32 cell_block_count = cell_size * cell_size * cell_size;
+
+            i32 cell_count_x = Chunk::Width  >> lod_level;
+            i32 cell_count_y = Chunk::Height >> lod_level;
+            i32 cell_count_z = Chunk::Depth  >> lod_level;
+
+            u64 cell_index = get_first_lod_cell_index(lod_level);
+
+            for (i32 cell_y = 0; cell_y < cell_count_y; cell_y++)
+            {
+                i32 first_block_y = cell_y * cell_size;
+                i32 last_block_y  = first_block_y + cell_size - 1;
 
-                const i32& right_edge_height = right_edge_height_map[z];
-                Block *right_edge_block = &(chunk->right_edge_blocks[y * Chunk::Depth + z]);
-                set_block_id_based_on_height(right_edge_block, y, right_edge_height, min_biome_height, max_biome_height, water_level);
+                for (i32 cell_z = 0; cell_z < cell_count_z; cell_z++)
+                {
+                    for (i32 cell_x = 0; cell_x < cell_count_x; cell_x++, cell_index++)
+                    {
+                        u16 block_id            = BlockId_Air;
+                        i32 top_block_y         = -1;
+                        i32 non_air_block_count = 0;
+                        u8  sky_light_level     = 0;
+
+                        for (i32 z = cell_z * cell_size; z < (cell_z + 1) * cell_size; z++)
+                        {
+                            for (i32 x = cell_x * cell_size; x < (cell_x + 1) * cell_size; x++)
+                            {
+                                i32 column_top_block_y = Min(top_non_air_block_y[z][x], last_block_y);
+
+                                if (column_top_block_y >= first_block_y)
+                                {
+                                    non_air_block_count += column_top_block_y - first_block_y + 1;
+
+                                    if (column_top_block_y > top_block_y)
+                                    {
+                                        top_block_y = column_top_block_y;
+                                        block_id    = get_block_id_based_on_height(column_top_block_y, height_map[z][x]);
+                                    }
+                                }
+
+                                if (last_block_y > chunk->height_map[z * Chunk::Width + x])
+                                {
+                                    sky_light_level = 15;
+                                }
+                            }
+                        }
+
+                        if (non_air_block_count * 2 < cell_block_count)
+                        {
+                            block_id = BlockId_Air;
+                        }
+
+                        lod_cells->block_ids[cell_index]    = block_id;
+                        lod_cells->light_levels[cell_index] = sky_light_level;
+                    }
+                }
             }
         }
     }
@@ -281,6 +420,7 @@ namespace minecraft {
 
         Chunk *original_chunk = ArenaPushZero(temp_arena, Chunk);
         initialize_chunk(original_chunk, chunk->world_coords);
+        attach_chunk_blocks(original_chunk, ArenaPush(temp_arena, Chunk_Blocks));
         generate_chunk(original_chunk, seed);
 
         u32 block_count = 0;
@@ -460,6 +600,7 @@ namespace minecraft {
                 Block_Serialization_Info& info = serialized_blocks[i];
                 Block* block = chunk->blocks + info.block_index;
                 block->id = info.block_id;
+                update_light_source_block_mask(chunk, info.block_index);
             }
         }
 
@@ -518,89 +659,343 @@ namespace minecraft {
         fclose(file);
     }
 
-    void propagate_sky_light(World *world, Chunk *chunk, Circular_Queue< Block_Query_Result > *queue)
+    // note(harlequin): has to be called after the block id at block_index changed
+    void update_light_source_block_mask(Chunk *chunk, i32 block_index)
+    {
+        i32 sub_chunk_index = get_sub_chunk_render_data_index(get_block_coords(block_index));
+        i32 bit_index       = block_index % Chunk::SubChunkBlockCount;
+
+        u64  bit  = (u64)1 << (bit_index & 63);
+        u64& mask = chunk->light_source_block_masks[sub_chunk_index][bit_index >> 6];
+
+        bool is_light_source_block = is_light_source(&World::block_infos[chunk->blocks[block_index].id]);
+        bool was_light_source_block = (mask & bit) != 0;
+
+        if (is_light_source_block && !was_light_source_block)
+        {
+            mask |= bit;
+            chunk->light_source_block_counts[sub_chunk_index]++;
+        }
+        else if (!is_light_source_block && was_light_source_block)
+        {
+            mask &= ~bit;
+            chunk->light_source_block_counts[sub_chunk_index]--;
+        }
+    }
+
+    void calculate_height_map(Chunk *chunk)
     {
         for (i32 z = 0; z < Chunk::Depth; z++)
         {
             for (i32 x = 0; x < Chunk::Width; x++)
             {
-                bool can_sky_light_propagate = true;
+                i32 y = Chunk::Height - 1;
 
-                for (i32 y = Chunk::Height - 1; y >= 0; y--)
+                for (; y >= 0; y--)
                 {
-                    glm::ivec3 block_coords = { x, y, z };
-                    Block *block = get_block(chunk, block_coords);
-                    const Block_Info* info = get_block_info(world, block);
+                    Block *block = get_block(chunk, { x, y, z });
+                    if (!is_block_transparent(&World::block_infos[block->id]))
+                    {
+                        break;
+                    }
+                }
+
+                chunk->height_map[z * Chunk::Width + x] = (i16)y;
+            }
+        }
+    }
+
+    Lod_Cell downsample_lod_cell(Chunk *chunk, const glm::ivec3& cell_coords, u32 lod_level, bool is_lit)
+    {
+        Assert(chunk->blocks);
+
+        i32 cell_size        = 1 << lod_level;
+        i32 cell_block_count = cell_size * cell_size * cell_size;
+
+        glm::ivec3 first_block_coords = cell_coords * cell_size;
+
+        u16 block_id            = BlockId_Air;
+        i32 non_air_block_count = 0;
+        u8  sky_light_level     = 0;
+        u8  light_source_level  = 0;
+
+        for (i32 y = cell_size - 1; y >= 0; y--)
+        {
+            for (i32 z = 0; z < cell_size; z++)
+            {
+                i32 block_index = get_block_index({ first_block_coords.x, first_block_coords.y + y, first_block_coords.z + z });
 
-                    if (is_light_source(info))
+                for (i32 x = 0; x < cell_size; x++, block_index++)
+                {
+                    u16 id = chunk->blocks[block_index].id;
+
+                    if (id != BlockId_Air)
                     {
-                        set_block_light_source_level(world, chunk, block_coords, 15);
+                        block_id = non_air_block_count ? block_id : id;
+                        non_air_block_count++;
+                    }
 
-                        Block_Query_Result query = {};
-                        query.block              = block;
-                        query.block_coords       = block_coords;
-                        query.chunk              = chunk;
+                    if (!is_block_transparent(&World::block_infos[id]))
+                    {
+                        continue;
+                    }
 
-                        queue->push(query);
+                    if (is_lit)
+                    {
+                        const Block_Light_Info& light_info = chunk->light_map[block_index];
+                        sky_light_level    = Max(sky_light_level,    light_info.sky_light_level);
+                        light_source_level = Max(light_source_level, light_info.light_source_level);
                     }
-                    else
+                    else if (is_block_exposed_to_sky(chunk, { first_block_coords.x + x, first_block_coords.y + y, first_block_coords.z + z }))
                     {
-                        set_block_light_source_level(world, chunk, block_coords, 1);
+                        sky_light_level = 15;
                     }
+                }
+            }
+        }
+
+        if (non_air_block_count * 2 < cell_block_count)
+        {
+            block_id = BlockId_Air;
+        }
+
+        return { block_id, (u8)(sky_light_level | (light_source_level << 4)) };
+    }
+
+    void calculate_lod_cells(Chunk *chunk, Chunk_Lod_Cells *lod_cells)
+    {
+        for (u32 lod_level = Chunk::MinFarLodLevel; lod_level <= Chunk::MaxLodLevel; lod_level++)
+        {
+            i32 cell_count_x = Chunk::Width  >> lod_level;
+            i32 cell_count_y = Chunk::Height >> lod_level;
+            i32 cell_count_z = Chunk::Depth  >> lod_level;
 
-                    if (!is_block_transparent(info))
+            u64 cell_index = get_first_lod_cell_index(lod_level);
+
+            for (i32 y = 0; y < cell_count_y; y++)
+            {
+                for (i32 z = 0; z < cell_count_z; z++)
+                {
+                    for (i32 x = 0; x < cell_count_x; x++, cell_index++)
                     {
-                        can_sky_light_propagate = false;
+                        bool is_lit = false;
+                        Lod_Cell cell = downsample_lod_cell(chunk, { x, y, z }, lod_level, is_lit);
+                        lod_cells->block_ids[cell_index]    = cell.block_id;
+                        lod_cells->light_levels[cell_index] = cell.light_levels;
                     }
+                }
+            }
+        }
+    }
+
+    Lod_Cell get_lod_cell(Chunk *chunk, const glm::ivec3& cell_coords, u32 lod_level)
+    {
+        // note(harlequin): a chunk that got its blocks back keeps reading from its cells until the blocks are loaded
+        if (chunk->has_lod_cells.load(std::memory_order_acquire))
+        {
+            u32 stored_lod_level = Max(lod_level, Chunk::MinFarLodLevel);
+            i32 shift            = (i32)(stored_lod_level - lod_level);
+
+            i32 cell_count_x = Chunk::Width >> stored_lod_level;
+            i32 cell_count_z = Chunk::Depth >> stored_lod_level;
+
+            u64 cell_index = get_first_lod_cell_index(stored_lod_level) +
+                             ((cell_coords.y >> shift) * cell_count_z + (cell_coords.z >> shift)) * cell_count_x + (cell_coords.x >> shift);
+            Assert(cell_index < Chunk::LodCellCount);
+
+            return { chunk->lod_cells->block_ids[cell_index], chunk->lod_cells->light_levels[cell_index] };
+        }
+
+        // note(harlequin): a chunk whose load job did not finish yet reads as unlit air
+        if (!chunk->blocks || chunk->state == ChunkState_Initialized)
+        {
+            return { BlockId_Air, 0 };
+        }
+
+        bool is_lit = !chunk->is_far.load(std::memory_order_relaxed);
+        return downsample_lod_cell(chunk, cell_coords, lod_level, is_lit);
+    }
+
+    // note(harlequin): has to be called after the block id at block_coords changed
+    void update_height_map(Chunk *chunk, const glm::ivec3& block_coords)
+    {
+        i16& height = chunk->height_map[block_coords.z * Chunk::Width + block_coords.x];
+
+        Block *block = get_block(chunk, block_coords);
+
+        if (!is_block_transparent(&World::block_infos[block->id]))
+        {
+            if (block_coords.y > height)
+            {
+                height = (i16)block_coords.y;
+            }
+        }
+        else if (block_coords.y == height)
+        {
+            i32 y = block_coords.y - 1;
+
+            for (; y >= 0; y--)
+            {
+                Block *block_below = get_block(chunk, { block_coords.x, y, block_coords.z });
+                if (!is_block_transparent(&World::block_infos[block_below->id]))
+                {
+                    break;
+                }
+            }
+
+            height = (i16)y;
+        }
+    }
+
+    // note(harlequin): x and z can be one block outside of the chunk, the height is read from the neighbour chunk then
+    static i32 get_column_height(Chunk *chunk, i32 x, i32 z)
+    {
+        if (x < 0)
+        {
+            chunk = chunk->neighbours[ChunkNeighbour_Left];
+            x += Chunk::Width;
+        }
+        else if (x >= Chunk::Width)
+        {
+            chunk = chunk->neighbours[ChunkNeighbour_Right];
+            x -= Chunk::Width;
+        }
+        else if (z < 0)
+        {
+            chunk = chunk->neighbours[ChunkNeighbour_Front];
+            z += Chunk::Depth;
+        }
+        else if (z >= Chunk::Depth)
+        {
+            chunk = chunk->neighbours[ChunkNeighbour_Back];
+            z -= Chunk::Depth;
+        }
+
+        Assert(chunk);
+        return chunk->height_map[z * Chunk::Width + x];
+    }
+
+    // note(harlequin): writes the light map directly instead of going through set_block_*_light_level per block,
+    // the edge light maps of the neighbours and their sub chunks are updated once for the whole chunk at the end
+    void propagate_sky_light(World *world, Chunk *chunk, Circular_Queue< Light_Node > *queue)
+    {
+        u16 chunk_node_index = get_chunk_node_index(world, chunk);
+
+        for (i32 y = 0; y < Chunk::Height; y++)
+        {
+            for (i32 z = 0; z < Chunk::Depth; z++)
+            {
+                for (i32 x = 0; x < Chunk::Width; x++)
+                {
+                    i32 block_index = get_block_index({ x, y, z });
+
+                    Block_Light_Info& light_info  = chunk->light_map[block_index];
+                    light_info.sky_light_level    = y > chunk->height_map[z * Chunk::Width + x] ? 15 : 1;
+                    light_info.light_source_level = 1;
+                }
+            }
+        }
+
+        for (i32 sub_chunk_index = 0; sub_chunk_index < Chunk::SubChunkCount; sub_chunk_index++)
+        {
+            if (!chunk->light_source_block_counts[sub_chunk_index])
+            {
+                continue;
+            }
+
+            i32 sub_chunk_first_block_index = get_block_index({ 0, get_sub_chunk_first_block_y(sub_chunk_index), 0 });
+
+            for (i32 i = 0; i < Chunk::SubChunkBlockCount / 64; i++)
+            {
+                u64 mask = chunk->light_source_block_masks[sub_chunk_index][i];
+
+                while (mask)
+                {
+                    i32 block_index = sub_chunk_first_block_index + i * 64 + count_trailing_zeros(mask);
+                    mask &= mask - 1;
 
-                    set_block_sky_light_level(world, chunk, block_coords, can_sky_light_propagate ? 15 : 1);
+                    chunk->light_map[block_index].light_source_level = 15;
+                    queue->push(pack_light_node(chunk_node_index, block_index));
                 }
             }
         }
+
+        Chunk *left_chunk  = chunk->neighbours[ChunkNeighbour_Left];
+        Chunk *right_chunk = chunk->neighbours[ChunkNeighbour_Right];
+        Chunk *front_chunk = chunk->neighbours[ChunkNeighbour_Front];
+        Chunk *back_chunk  = chunk->neighbours[ChunkNeighbour_Back];
+        Assert(left_chunk && right_chunk && front_chunk && back_chunk);
+
+        for (i32 y = 0; y < Chunk::Height; y++)
+        {
+            for (i32 z = 0; z < Chunk::Depth; z++)
+            {
+                left_chunk->right_edge_light_map[y * Chunk::Depth + z] = chunk->light_map[get_block_index({ 0, y, z })];
+                right_chunk->left_edge_light_map[y * Chunk::Depth + z] = chunk->light_map[get_block_index({ Chunk::Width - 1, y, z })];
+            }
+
+            for (i32 x = 0; x < Chunk::Width; x++)
+            {
+                front_chunk->back_edge_light_map[y * Chunk::Width + x] = chunk->light_map[get_block_index({ x, y, 0 })];
+                back_chunk->front_edge_light_map[y * Chunk::Width + x] = chunk->light_map[get_block_index({ x, y, Chunk::Depth - 1 })];
+            }
+        }
+
+        for (i32 sub_chunk_index = 0; sub_chunk_index < Chunk::SubChunkCount; sub_chunk_index++)
+        {
+            mark_sub_chunk_dirty(world, chunk,       sub_chunk_index);
+            mark_sub_chunk_dirty(world, left_chunk,  sub_chunk_index);
+            mark_sub_chunk_dirty(world, right_chunk, sub_chunk_index);
+            mark_sub_chunk_dirty(world, front_chunk, sub_chunk_index);
+            mark_sub_chunk_dirty(world, back_chunk,  sub_chunk_index);
+        }
     }
 
+    // note(harlequin): sky light only spreads sideways from the open part of a column into the neighbour columns
+    // that are covered at the same height, so only the blocks between the column height and the highest
+    // neighbour column height can be seeds
     void calculate_lighting(World *world,
                             Chunk *chunk,
-                            Circular_Queue< Block_Query_Result > *queue)
+                            Circular_Queue< Light_Node > *queue)
     {
-        for (i32 y = Chunk::Height - 1; y >= 0; y--)
+        u16 chunk_node_index = get_chunk_node_index(world, chunk);
+
+        for (i32 z = 0; z < Chunk::Depth; z++)
         {
-            bool found_any_sky_lights = false;
-            for (i32 z = 0; z < Chunk::Width; z++)
+            for (i32 x = 0; x < Chunk::Width; x++)
             {
-                for (i32 x = 0; x < Chunk::Width; x++)
+                i32 height = chunk->height_map[z * Chunk::Width + x];
+
+                i32 max_neighbour_height = glm::max(glm::max(get_column_height(chunk, x - 1, z), get_column_height(chunk, x + 1, z)),
+                                                    glm::max(get_column_height(chunk, x, z - 1), get_column_height(chunk, x, z + 1)));
+
+                for (i32 y = height + 1; y <= max_neighbour_height; y++)
                 {
                     glm::ivec3 block_coords = { x, y, z };
-                    Block* block = get_block(chunk, block_coords);
-                    const Block_Info* info = get_block_info(world, block);
-                    if (!is_block_transparent(info)) continue;
-                    Block_Light_Info *block_light_info = get_block_light_info(chunk, block_coords);
-                    if (block_light_info->sky_light_level == 15)
+                    i32 block_index = get_block_index(block_coords);
+
+                    if (chunk->light_map[block_index].sky_light_level != 15)
+                    {
+                        continue;
+                    }
+
+                    auto neighbours_query = query_neighbours(chunk, block_coords);
+                    for (i32 direction = 2; direction < 6; direction++)
                     {
-                        found_any_sky_lights = true;
-                        auto neighbours_query = query_neighbours(chunk, block_coords);
-                        for (i32 direction = 2; direction < 6; direction++)
+                        auto& neighbour_query = neighbours_query[direction];
+                        Block *neighbour = neighbour_query.block;
+                        const Block_Info* neighbour_info       = get_block_info(world, neighbour);
+                        Block_Light_Info *neighbour_light_info = get_block_light_info(neighbour_query.chunk,
+                                                                                      neighbour_query.block_coords);
+                        if (neighbour_light_info->sky_light_level != 15 &&
+                            is_block_transparent(neighbour_info))
                         {
-                            auto& neighbour_query = neighbours_query[direction];
-                            Block *neighbour = neighbour_query.block;
-                            const Block_Info* neighbour_info       = get_block_info(world, neighbour);
-                            Block_Light_Info *neighbour_light_info = get_block_light_info(neighbour_query.chunk,
-                                                                                          neighbour_query.block_coords);
-                            if (neighbour_light_info->sky_light_level != 15 &&
-                                is_block_transparent(neighbour_info))
-                            {
-                                Block_Query_Result query = {};
-                                query.block              = block;
-                                query.block_coords       = block_coords;
-                                query.chunk              = chunk;
-                                queue->push(query);
-                                break;
-                            }
+                            queue->push(pack_light_node(chunk_node_index, block_index));
+                            break;
                         }
                     }
                 }
             }
-            if (!found_any_sky_lights) break;
         }
     }
 
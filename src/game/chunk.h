@@ -131,6 +131,25 @@ namespace minecraft {
         return block_info->flags & BlockFlags_ColorBottomByBiome;
     }
 
+    // note(harlequin): a light bfs queue entry, the chunk node index in the high 16 bits and the block index
+    // inside that chunk in the low 16 bits
+    typedef u32 Light_Node;
+
+    inline Light_Node pack_light_node(u16 chunk_node_index, i32 block_index)
+    {
+        return ((u32)chunk_node_index << 16) | (u32)block_index;
+    }
+
+    inline u16 get_light_node_chunk_node_index(Light_Node node)
+    {
+        return (u16)(node >> 16);
+    }
+
+    inline i32 get_light_node_block_index(Light_Node node)
+    {
+        return (i32)(node & 0xFFFF);
+    }
+
     enum BlockNeighbour
     {
         BlockNeighbour_Up    = 0,
@@ -163,6 +182,7 @@ namespace minecraft {
         ChunkState_LightPropagated            = 4,
         ChunkState_PendingForLightCalculation = 5,
         ChunkState_LightCalculated            = 6,
+        ChunkState_BlocksSaved                = 7,
         ChunkState_PendingForSave             = 8,
         ChunkState_Saved                      = 9,
         ChunkState_Freed                      = 10
@@ -175,44 +195,78 @@ namespace minecraft {
         TessellationState_Done    = 2
     };
 
-    struct Block_Face_Vertex
+    // note(harlequin): one record per quad, the vertex shader pulls it by gl_VertexID / 6 and expands
+    // the corner it is drawing, the bit layout lives with pack_block_face in the sub chunk mesher
+    struct Block_Face
     {
-        u32 packed_vertex_attributes0;
-        u32 packed_vertex_attributes1;
+        u32 packed_face_attributes0;
+        u32 packed_face_attributes1;
     };
 
     struct Chunk_Instance
     {
         glm::ivec2 chunk_coords;
+        i32        sub_chunk_index; // block y of a face is relative to the sub chunk
     };
 
     struct Sub_Chunk_Bucket
     {
-        i32                memory_id;
-        Block_Face_Vertex *current_vertex;
-        i32                face_count;
+        i64 memory_offset; // in faces
+        i32 face_count;
     };
 
     bool initialize_sub_chunk_bucket(Sub_Chunk_Bucket *sub_chunk_bucket);
     bool is_sub_chunk_bucket_allocated(const Sub_Chunk_Bucket *sub_chunk_bucket);
 
+    // note(harlequin): byte i of the face connectivity of a sub chunk is a mask of the faces its see through blocks
+    // connect face i to, a sub chunk that was never meshed connects every face to every other face
+    constexpr u64 SubChunkFullFaceConnectivity = 0x3F3F3F3F3F3Full;
+
+    inline u32 get_connected_face_mask(u64 face_connectivity, u32 face)
+    {
+        return (u32)(face_connectivity >> (face * 8)) & 0x3F;
+    }
+
+    // note(harlequin): a box of opaque blocks inside a sub chunk that hides whatever is behind it, packed a byte per
+    // coordinate in sub chunk block units min x y z then max x y z, a sub chunk with no occluder packs to zero
+    inline u64 pack_sub_chunk_occluder(const glm::ivec3& min, const glm::ivec3& max)
+    {
+        return (u64)min.x | ((u64)min.y << 8) | ((u64)min.z << 16) | ((u64)max.x << 24) | ((u64)max.y << 32) | ((u64)max.z << 40);
+    }
+
+    inline void unpack_sub_chunk_occluder(u64 occluder, glm::ivec3 *min, glm::ivec3 *max)
+    {
+        *min = { (i32)(occluder & 0xFF), (i32)((occluder >> 8) & 0xFF),  (i32)((occluder >> 16) & 0xFF) };
+        *max = { (i32)((occluder >> 24) & 0xFF), (i32)((occluder >> 32) & 0xFF), (i32)((occluder >> 40) & 0xFF) };
+    }
+
     struct Sub_Chunk_Render_Data
     {
         i32             instance_memory_id;
         Chunk_Instance *base_instance;
 
-        std::atomic< i32 > active_bucket_index;
-        Sub_Chunk_Bucket opaque_buckets[2];
-        Sub_Chunk_Bucket transparent_buckets[2];
-        AABB aabb[2];
+        // note(harlequin): a remesh lands in new runs and the runs it replaces are retired until the gpu is done
+        // drawing them, the version is odd while the buckets are swapped so they are never read half written
+        std::atomic< u32 > bucket_version;
+        Sub_Chunk_Bucket opaque_bucket;
+        Sub_Chunk_Bucket transparent_bucket;
+        AABB aabb;
+
+        // note(harlequin): the buckets may be shared with every other sub chunk of the same content through the
+        // mesh cache of the renderer, only the worker meshing the sub chunk touches the hash
+        u64 content_hash;
+
+        // note(harlequin): written by the worker that uploads the mesh and read by the visibility pass and the occluder gathering
+        std::atomic< u64 > face_connectivity;
+        std::atomic< u64 > occluder;
 
         std::atomic< TessellationState > state;
 
         i32 face_count;
-
-        Sub_Chunk_Render_Data *next;
     };
 
+    struct Chunk_Lod_Cells;
+
     struct Chunk
     {
         constexpr static i32 Width  = 16;
@@ -223,9 +277,29 @@ namespace minecraft {
         static_assert(Height % SubChunkHeight == 0);
         static constexpr u64 SubChunkCount = Height / SubChunkHeight;
 
-        static constexpr u64 SubChunkBlockCount  = Width * Depth * SubChunkHeight;
-        static constexpr u64 SubChunkVertexCount = SubChunkBlockCount * 24;
-        static constexpr u64 SubChunkIndexCount  = SubChunkBlockCount * 36;
+        static constexpr u64 BlockCount         = Width * Depth * Height;
+        static constexpr u64 SubChunkBlockCount = Width * Depth * SubChunkHeight;
+
+        // note(harlequin): far chunks are meshed from cells of 2^lod_level blocks on a side
+        static constexpr u32 MaxLodLevel = 3;
+        static_assert((SubChunkHeight >> MaxLodLevel) >= 1, "a lod cell has to fit in a sub chunk");
+
+        // note(harlequin): the chunks outside the active region are never lit and never hold on to their blocks,
+        // they are meshed at MinFarLodLevel or coarser from the cells kept for every level from it up
+        static constexpr u32 MinFarLodLevel = 2;
+        static_assert(MinFarLodLevel > 0 && MinFarLodLevel <= MaxLodLevel);
+
+        static constexpr u64 LodCellCount = []()
+        {
+            u64 cell_count = 0;
+
+            for (u32 lod_level = MinFarLodLevel; lod_level <= MaxLodLevel; lod_level++)
+            {
+                cell_count += BlockCount >> (3 * lod_level);
+            }
+
+            return cell_count;
+        }();
 
         static constexpr std::array< glm::ivec2, ChunkNeighbour_Count > NeighbourDirections =
         {
@@ -247,6 +321,95 @@ namespace minecraft {
         std::atomic< ChunkState >        state;
         std::atomic< TessellationState > tessellation_state;
 
+        // note(harlequin): the sub chunk update jobs a chunk update was split into that are not done yet,
+        // the last one to finish marks the chunk done
+        std::atomic< u32 > pending_update_job_count;
+        u64                update_queue_time;
+
+        // note(harlequin): point into the Chunk_Blocks the chunk was given by attach_chunk_blocks, all null for a
+        // chunk that holds lod cells instead, see Chunk_Blocks
+        Block *blocks;
+        Block *front_edge_blocks;
+        Block *back_edge_blocks;
+        Block *left_edge_blocks;
+        Block *right_edge_blocks;
+
+        Block_Light_Info *light_map;
+        Block_Light_Info *front_edge_light_map;
+        Block_Light_Info *back_edge_light_map;
+        Block_Light_Info *left_edge_light_map;
+        Block_Light_Info *right_edge_light_map;
+
+        Sub_Chunk_Render_Data sub_chunks_render_data[Chunk::SubChunkCount];
+
+        // note(harlequin): blocks that still have to spread their light, light propagation
+        // crossing into this chunk from a neighbour lands here instead of touching a shared queue
+        std::atomic< bool > has_pending_light_blocks;
+        u64 *pending_light_block_mask;
+
+        // note(harlequin): y of the highest opaque block of each column indexed by z * Width + x,
+        // -1 when the whole column is transparent. every block above it sees the sky
+        i16 height_map[Chunk::Depth * Chunk::Width];
+
+        // note(harlequin): light source blocks of each sub chunk, bit i of a sub chunk mask is the block
+        // with index i inside that sub chunk (block index % SubChunkBlockCount)
+        u64 (*light_source_block_masks)[Chunk::SubChunkBlockCount / 64];
+        u16 light_source_block_counts[Chunk::SubChunkCount];
+
+        // note(harlequin): sub chunks whose blocks or light changed since the last flush_dirty_sub_chunks
+        std::atomic< u32 > dirty_sub_chunk_mask;
+        static_assert(SubChunkCount <= 32);
+
+        // note(harlequin): set while the chunk is in the dirty chunks of the world, it outlives initialize_chunk
+        // since a freed chunk can still be in there
+        std::atomic< bool > is_dirty_chunk_listed;
+
+        // note(harlequin): the level of detail the sub chunks are meshed at, set by the distance to the player
+        std::atomic< u8 > lod_level;
+
+        // note(harlequin): set for the chunks outside the active region and the ones that have no blocks, their sub
+        // chunks are meshed from the lod cells, never below MinFarLodLevel
+        std::atomic< bool > is_far;
+
+        // note(harlequin): the Chunk_Lod_Cells a chunk with no blocks was given by the world, has_lod_cells is set
+        // once the load job or the job saving its blocks built them, see Chunk_Lod_Cells
+        Chunk_Lod_Cells    *lod_cells;
+        std::atomic< bool > has_lod_cells;
+
+        // note(harlequin): only touched by load_and_update_chunks, set when the lod level or is_far changed
+        // and cleared once every sub chunk was marked dirty or the light pass is going to mesh the chunk
+        bool is_mesh_outdated;
+
+        // note(harlequin): sub chunks a block was placed or broken in, the mesher keeps their last mesh around
+        // and patches it instead of meshing them from scratch, the bit is cleared when the mesher drops that mesh
+        // so the sub chunk goes back to full (greedy) meshes
+        std::atomic< u32 > patchable_sub_chunk_mask;
+
+        // note(harlequin): the sub chunks find_reachable_sub_chunks reached in the visibility pass the chunk was
+        // last active in, only touched by the main thread
+        u32 visibility_pass_index;
+        u32 reachable_sub_chunk_mask;
+    };
+
+    // note(harlequin): the index of the first cell of lod_level in the lod cells of a chunk
+    constexpr u64 get_first_lod_cell_index(u32 lod_level)
+    {
+        u64 first_cell_index = 0;
+
+        for (u32 level = Chunk::MinFarLodLevel; level < lod_level; level++)
+        {
+            first_cell_index += Chunk::BlockCount >> (3 * level);
+        }
+
+        return first_cell_index;
+    }
+
+    static_assert(get_first_lod_cell_index(Chunk::MaxLodLevel + 1) == Chunk::LodCellCount);
+
+    // note(harlequin): the full resolution blocks and light of a chunk, only the chunks the light passes can reach
+    // hold one, a chunk further away is drawn from its lod cells and gives its blocks back to the world
+    struct Chunk_Blocks
+    {
         Block blocks[Chunk::Height * Chunk::Depth * Chunk::Width];
         Block front_edge_blocks[Chunk::Height * Chunk::Width];
         Block back_edge_blocks[Chunk::Height  * Chunk::Width];
@@ -259,10 +422,25 @@ namespace minecraft {
         Block_Light_Info left_edge_light_map[Chunk::Height  * Chunk::Depth];
         Block_Light_Info right_edge_light_map[Chunk::Height * Chunk::Depth];
 
-        Sub_Chunk_Render_Data sub_chunks_render_data[Chunk::SubChunkCount];
+        u64 pending_light_block_mask[Chunk::BlockCount / 64];
+        u64 light_source_block_masks[Chunk::SubChunkCount][Chunk::SubChunkBlockCount / 64];
+    };
+
+    // note(harlequin): the cells of every level from MinFarLodLevel up indexed like blocks inside their level, only the
+    // chunks that gave their blocks back hold them, far chunks are never lit so a transparent cell sees the sky when
+    // it is above the height map
+    struct Chunk_Lod_Cells
+    {
+        u16 block_ids[Chunk::LodCellCount];
+        u8  light_levels[Chunk::LodCellCount]; // sky light level in the low nibble and light source level in the high nibble
     };
 
+    // note(harlequin): clears the pending light blocks and the light source blocks of the chunk
+    void attach_chunk_blocks(Chunk *chunk, Chunk_Blocks *chunk_blocks);
+    Chunk_Blocks *detach_chunk_blocks(Chunk *chunk);
+
     i32 get_block_index(const glm::ivec3& block_coords);
+    glm::ivec3 get_block_coords(i32 block_index);
     glm::vec3 get_block_position(Chunk *chunk, const glm::ivec3& block_coords);
     Block* get_block(Chunk *chunk, const glm::ivec3& block_coords);
     Block_Light_Info* get_block_light_info(Chunk *chunk, const glm::ivec3& block_coords);
@@ -273,6 +451,10 @@ namespace minecraft {
 
     void generate_chunk(Chunk *chunk, i32 seed);
 
+    // note(harlequin): fills the height map and the lod cells of a chunk that was never saved straight from the
+    // terrain heights, the cells match the ones calculate_lod_cells builds from the blocks of generate_chunk
+    void generate_chunk_lod_cells(Chunk *chunk, Chunk_Lod_Cells *lod_cells, i32 seed);
+
         void serialize_chunk(World *world,
                          Chunk *chunk,
                          i32 seed,
@@ -282,13 +464,47 @@ namespace minecraft {
                            Chunk *chunk,
                            Temprary_Memory_Arena *temp_arena);
 
+    void update_light_source_block_mask(Chunk *chunk, i32 block_index);
+
+    void calculate_height_map(Chunk *chunk);
+    void update_height_map(Chunk *chunk, const glm::ivec3& block_coords);
+
+    // note(harlequin): a cell of 2^lod_level blocks on a side, it takes the first block found from its top layer down
+    // if at least half of it is not air, the block id is air otherwise
+    struct Lod_Cell
+    {
+        u16 block_id;
+        u8  light_levels; // sky light level in the low nibble and light source level in the high nibble
+    };
+
+    // note(harlequin): a lit chunk lights the cell with the brightest light of its transparent blocks, an unlit one
+    // with the sky when any of its transparent blocks is above the height map
+    Lod_Cell downsample_lod_cell(Chunk *chunk, const glm::ivec3& cell_coords, u32 lod_level, bool is_lit);
+
+    // note(harlequin): builds the lod cells of the chunk from its blocks and height map
+    void calculate_lod_cells(Chunk *chunk, Chunk_Lod_Cells *lod_cells);
+
+    // note(harlequin): the cell at cell_coords in cells of 2^lod_level blocks, a chunk with lod cells returns its
+    // stored cell (the one holding it below MinFarLodLevel) and a chunk with blocks downsamples them, lit if it is near
+    Lod_Cell get_lod_cell(Chunk *chunk, const glm::ivec3& cell_coords, u32 lod_level);
+
+    inline AABB get_chunk_column_aabb(Chunk *chunk)
+    {
+        return { chunk->position, chunk->position + glm::vec3(Chunk::Width, Chunk::Height, Chunk::Depth) };
+    }
+
+    inline bool is_block_exposed_to_sky(Chunk *chunk, const glm::ivec3& block_coords)
+    {
+        return block_coords.y > chunk->height_map[block_coords.z * Chunk::Width + block_coords.x];
+    }
+
     void propagate_sky_light(World *world,
                              Chunk *chunk,
-                             Circular_Queue< struct Block_Query_Result > *queue);
+                             Circular_Queue< Light_Node > *queue);
 
     void calculate_lighting(World *world,
                             Chunk *chunk,
-                            Circular_Queue< struct Block_Query_Result > *queue);
+                            Circular_Queue< Light_Node > *queue);
 
     Block* get_neighbour_block_from_right(Chunk  *chunk, const glm::ivec3& block_coords);
     Block* get_neighbour_block_from_left(Chunk   *chunk, const glm::ivec3& block_coords);
@@ -309,8 +525,15 @@ namespace minecraft {
         return glm::abs(((i64)coords.x * (i64)92837111) ^ ((i64)coords.y * (i64)689287499));
     }
 
+    // note(harlequin): sub chunk i holds the blocks with y in [i * SubChunkHeight, (i + 1) * SubChunkHeight), the
+    // mesher, the light source masks and the remesh marks all go through these two
     inline i32 get_sub_chunk_render_data_index(const glm::ivec3& block_coords)
     {
-        return (Chunk::SubChunkCount - 1) - (block_coords.y / Chunk::SubChunkHeight);
+        return block_coords.y / Chunk::SubChunkHeight;
+    }
+
+    inline i32 get_sub_chunk_first_block_y(i32 sub_chunk_index)
+    {
+        return sub_chunk_index * (i32)Chunk::SubChunkHeight;
     }
 }
@@ -21,6 +21,8 @@
 #include "renderer/font.h"
 #include "ui/ui.h"
 
+#include "meshing/sub_chunk_mesher.h"
+
 #include "assets/texture_packer.h"
 
 #include <glm/glm.hpp>
@@ -49,6 +51,10 @@ namespace minecraft {
             load_game_config_defaults(game_config);
         }
 
+        // note(harlequin): a config saved when the world could reach further is clamped to what it can hold now
+        game_config->chunk_radius     = Min(game_config->chunk_radius,     (u32)World::MaxChunkRadius);
+        game_config->far_chunk_radius = Min(game_config->far_chunk_radius, (u32)World::MaxFarChunkRadius);
+
         u32 opengl_major_version       = 4;
         u32 opengl_minor_version       = 5;
         u32 opengl_back_buffer_samples = 16;
@@ -113,6 +119,7 @@ namespace minecraft {
         }
 
         opengl_renderer_set_is_fxaa_enabled(game_config->is_fxaa_enabled);
+        set_is_greedy_meshing_enabled(game_config->is_greedy_meshing_enabled);
 
         if (!initialize_opengl_2d_renderer(&game_memory->permanent_arena))
         {
@@ -218,6 +225,20 @@ namespace minecraft {
         initialize_world(world, world_path, &temp_arena);
         end_temprary_memory_arena(&temp_arena);
 
+        if (!initialize_sub_chunk_mesher(&game_memory->transient_arena))
+        {
+            fprintf(stderr, "[ERROR]: failed to initialize sub chunk mesher\n");
+            return false;
+        }
+
+        game_state->occlusion_buffer = ArenaPushAligned(&game_memory->permanent_arena, Occlusion_Buffer);
+
+        if (!game_state->occlusion_buffer || !initialize_occlusion_buffer(game_state->occlusion_buffer))
+        {
+            fprintf(stderr, "[ERROR]: failed to initialize occlusion buffer\n");
+            return false;
+        }
+
         if (!initialize_inventory(inventory, &game_state->assets))
         {
             fprintf(stderr, "[ERROR]: failed to initialize inventory\n");
@@ -228,7 +249,7 @@ namespace minecraft {
         deserialize_inventory(inventory, world_path, &temp_arena);
         end_temprary_memory_arena(&temp_arena);
 
-        if (!Job_System::initialize(world, &game_memory->permanent_arena))
+        if (!Job_System::initialize(world, &game_memory->permanent_arena, game_config))
         {
             fprintf(stderr, "[ERROR]: failed to initialize job system\n");
             return false;
@@ -274,7 +295,9 @@ namespace minecraft {
 
     void shutdown_game(Game_State *game_state)
     {
-        save_chunks(game_state->world);
+        Temprary_Memory_Arena temp_arena = begin_temprary_memory_arena(&game_state->game_memory->transient_arena);
+        save_chunks(game_state->world, &temp_arena);
+        end_temprary_memory_arena(&temp_arena);
 
         Job_System::shutdown();
 
@@ -287,7 +310,7 @@ namespace minecraft {
         shutdown_dropdown_console(&game_state->console);
         shutdown_ui();
 
-        Temprary_Memory_Arena temp_arena = begin_temprary_memory_arena(&game_state->game_memory->transient_arena);
+        temp_arena = begin_temprary_memory_arena(&game_state->game_memory->transient_arena);
         shutdown_inventory(&game_state->inventory, game_state->world->path, &temp_arena);
         end_temprary_memory_arena(&temp_arena);
 
@@ -415,6 +438,7 @@ namespace minecraft {
     }
 
     static void late_update_entities(Registry            *registry,
+                                     World               *world,
                                      Input               *input,
                                      Select_Block_Result *select_query,
                                      Inventory           *inventory,
@@ -466,7 +490,8 @@ namespace minecraft {
                 bool is_active_slot_empty = slot.block_id == BlockId_Air && slot.count == 0;
                 if (!is_active_slot_empty)
                 {
-                    set_block_id(select_query->block_facing_normal_query.chunk,
+                    set_block_id(world,
+                                 select_query->block_facing_normal_query.chunk,
                                  select_query->block_facing_normal_query.block_coords,
                                  slot.block_id);
                     slot.count--;
@@ -496,7 +521,8 @@ namespace minecraft {
             i32 block_id  = select_query->block_query.block->id;
             bool is_added = add_block_to_inventory(inventory, block_id);
 
-            set_block_id(select_query->block_query.chunk,
+            set_block_id(world,
+                         select_query->block_query.chunk,
                          select_query->block_query.block_coords,
                          any_neighbouring_water_block ? BlockId_Water : BlockId_Air);
             if (!is_added)
@@ -555,7 +581,10 @@ namespace minecraft {
             glm::vec2 active_chunk_coords = world_position_to_chunk_coords(camera->position);
             world->active_region_bounds   = get_world_bounds_from_chunk_coords(game_config->chunk_radius,
                                                                                active_chunk_coords);
-            load_and_update_chunks(world, world->active_region_bounds);
+            world->lod_chunk_radius       = game_config->lod_chunk_radius;
+            world->far_chunk_radius       = game_config->far_chunk_radius;
+            load_and_update_chunks(world, world->active_region_bounds, &frame_arena);
+            Job_System::sample_queue_depths();
 
             update_entities(&registry, gameplay_input, camera, game_state->delta_time);
 
@@ -582,6 +611,23 @@ namespace minecraft {
 
             update_camera(camera);
 
+            // note(harlequin): the occluders are rasterized on a worker while the entities are late updated
+            Occlusion_Buffer *occlusion_buffer = game_config->is_occlusion_buffer_enabled ? game_state->occlusion_buffer : nullptr;
+
+            if (occlusion_buffer)
+            {
+                gather_occluders(occlusion_buffer,
+                                 world->active_chunks,
+                                 world->active_chunk_count,
+                                 camera,
+                                 &frame_arena);
+
+                Rasterize_Occluders_Job job;
+                job.occlusion_buffer = occlusion_buffer;
+                job.frame_index      = occlusion_buffer->frame_index;
+                Job_System::schedule(job);
+            }
+
             u32 max_block_select_dist_in_cube_units = 5;
             Select_Block_Result select_query = select_block(world,
                                                             camera->position,
@@ -589,6 +635,7 @@ namespace minecraft {
                                                             max_block_select_dist_in_cube_units);
 
             late_update_entities(&registry,
+                                 world,
                                  gameplay_input,
                                  &select_query,
                                  inventory,
@@ -621,8 +668,21 @@ namespace minecraft {
                                         tint_color,
                                         camera);
 
-            opengl_renderer_render_chunks(world->first_active_sub_chunk_render_data_sentinal.next,
-                                          camera);
+            find_reachable_sub_chunks(world,
+                                      camera->position,
+                                      camera->frustum,
+                                      game_config->is_occlusion_culling_enabled,
+                                      &frame_arena);
+
+            if (occlusion_buffer)
+            {
+                wait_for_occluders(occlusion_buffer);
+            }
+
+            opengl_renderer_render_chunks(world->active_chunks,
+                                          world->active_chunk_count,
+                                          camera,
+                                          occlusion_buffer);
 
             opengl_renderer_end_frame(&game_state->assets,
                                       game_config->chunk_radius,
@@ -9,6 +9,7 @@
 #include "containers/string.h"
 
 #include "renderer/camera.h"
+#include "renderer/occlusion_buffer.h"
 
 #include "game/game_config.h"
 #include "game/ecs.h"
@@ -50,6 +51,7 @@ namespace minecraft {
         Game_Assets      assets;
         Dropdown_Console console;
         World           *world;
+        Occlusion_Buffer *occlusion_buffer;
 
         f32              frame_timer;
         u32              frames_per_second_counter;
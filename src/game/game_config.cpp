@@ -15,7 +15,16 @@ namespace minecraft {
         config->is_cursor_visible           = false;
         config->is_raw_mouse_motion_enabled = true;
         config->is_fxaa_enabled             = false;
+        config->is_greedy_meshing_enabled   = true;
+        config->is_occlusion_culling_enabled = true;
+        config->is_occlusion_buffer_enabled = true;
         config->chunk_radius                = 8;
+        config->lod_chunk_radius            = 12;
+        config->far_chunk_radius            = 32;
+        config->worker_thread_count         = 0;
+        config->should_pin_worker_threads   = false;
+        config->worker_thread_affinity_mask = 0;
+        config->light_thread_affinity_mask  = 0;
     }
 
     bool load_game_config(Game_Config *config, const char *config_file_path)
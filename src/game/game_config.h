@@ -25,7 +25,16 @@ namespace minecraft {
         bool       is_cursor_visible;
         bool       is_raw_mouse_motion_enabled;
         bool       is_fxaa_enabled;
+        bool       is_greedy_meshing_enabled;
+        bool       is_occlusion_culling_enabled; // sub chunks hidden behind opaque blocks are not drawn
+        bool       is_occlusion_buffer_enabled;  // sub chunks behind the occluders rasterized on the cpu are not drawn
         u32        chunk_radius;
+        u32        lod_chunk_radius;            // chunks further away are meshed at a lower level of detail
+        u32        far_chunk_radius;            // chunks past chunk_radius up to this one are drawn from their lod cells
+        u32        worker_thread_count;         // 0 means hardware thread count - 2
+        bool       should_pin_worker_threads;
+        u64        worker_thread_affinity_mask; // 0 means every logical processor but the first two
+        u64        light_thread_affinity_mask;  // 0 means the light thread is not pinned
     };
 
     void load_game_config_defaults(Game_Config *config);
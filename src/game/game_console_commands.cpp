@@ -1,7 +1,13 @@
 #include "game/game_console_commands.h"
 #include "game/console_commands.h"
 #include "game/world.h"
+#include "game/job_system.h"
+#include "core/platform.h"
 #include "renderer/opengl_renderer.h"
+#include "renderer/occlusion_buffer.h"
+#include "meshing/sub_chunk_mesher.h"
+#include "memory/buddy_allocator.h"
+#include "memory/retire_queue.h"
 #include "ui/dropdown_console.h"
 #include "assets/texture_packer.h"
 #include "game_console_commands.h"
@@ -41,6 +47,39 @@ namespace minecraft {
         console_commands_register_command(String8FromCString("toggle_fxaa"),
                                           &toggle_fxaa_command);
 
+        console_commands_register_command(String8FromCString("toggle_greedy_meshing"),
+                                          &toggle_greedy_meshing_command);
+
+        console_commands_register_command(String8FromCString("toggle_occlusion_culling"),
+                                          &toggle_occlusion_culling_command);
+
+        console_commands_register_command(String8FromCString("toggle_occlusion_buffer"),
+                                          &toggle_occlusion_buffer_command);
+
+        console_commands_register_command(String8FromCString("validate_greedy_meshing"),
+                                          &validate_greedy_meshing_command);
+
+        console_commands_register_command(String8FromCString("validate_block_face_packing"),
+                                          &validate_block_face_packing_command);
+
+        console_commands_register_command(String8FromCString("benchmark_meshing"),
+                                          &benchmark_meshing_command);
+
+        console_commands_register_command(String8FromCString("benchmark_vertex_allocator"),
+                                          &benchmark_vertex_allocator_command);
+
+        console_commands_register_command(String8FromCString("validate_bucket_retirement"),
+                                          &validate_bucket_retirement_command);
+
+        console_commands_register_command(String8FromCString("benchmark_frustum_culling"),
+                                          &benchmark_frustum_culling_command);
+
+        console_commands_register_command(String8FromCString("benchmark_occlusion_culling"),
+                                          &benchmark_occlusion_culling_command);
+
+        console_commands_register_command(String8FromCString("benchmark_occlusion_buffer"),
+                                          &benchmark_occlusion_buffer_command);
+
         Console_Command_Argument_Info set_chunk_radius_command_args[] = {
             { ConsoleCommandArgumentType_UInt32, String8FromCString("chunk_radius") }
         };
@@ -49,6 +88,30 @@ namespace minecraft {
                                           set_chunk_radius_command_args,
                                           ArrayCount(set_chunk_radius_command_args));
 
+        Console_Command_Argument_Info set_lod_chunk_radius_command_args[] = {
+            { ConsoleCommandArgumentType_UInt32, String8FromCString("lod_chunk_radius") }
+        };
+        console_commands_register_command(String8FromCString("set_lod_chunk_radius"),
+                                          &set_lod_chunk_radius_command,
+                                          set_lod_chunk_radius_command_args,
+                                          ArrayCount(set_lod_chunk_radius_command_args));
+
+        Console_Command_Argument_Info set_far_chunk_radius_command_args[] = {
+            { ConsoleCommandArgumentType_UInt32, String8FromCString("far_chunk_radius") }
+        };
+        console_commands_register_command(String8FromCString("set_far_chunk_radius"),
+                                          &set_far_chunk_radius_command,
+                                          set_far_chunk_radius_command_args,
+                                          ArrayCount(set_far_chunk_radius_command_args));
+
+        Console_Command_Argument_Info set_sub_chunk_mesh_job_group_size_command_args[] = {
+            { ConsoleCommandArgumentType_UInt32, String8FromCString("sub_chunk_count") }
+        };
+        console_commands_register_command(String8FromCString("set_sub_chunk_mesh_job_group_size"),
+                                          &set_sub_chunk_mesh_job_group_size_command,
+                                          set_sub_chunk_mesh_job_group_size_command_args,
+                                          ArrayCount(set_sub_chunk_mesh_job_group_size_command_args));
+
         Console_Command_Argument_Info set_time_command_args[] = {
             { ConsoleCommandArgumentType_UInt32, String8FromCString("hours") },
             { ConsoleCommandArgumentType_UInt32, String8FromCString("minutes") },
@@ -62,6 +125,56 @@ namespace minecraft {
 
         console_commands_register_command(String8FromCString("pack_textures"),
                                           &pack_textures_command);
+
+        Console_Command_Argument_Info set_worker_thread_count_command_args[] = {
+            { ConsoleCommandArgumentType_UInt32, String8FromCString("worker_thread_count") }
+        };
+        console_commands_register_command(String8FromCString("set_worker_thread_count"),
+                                          &set_worker_thread_count_command,
+                                          set_worker_thread_count_command_args,
+                                          ArrayCount(set_worker_thread_count_command_args));
+
+        Console_Command_Argument_Info set_worker_thread_affinity_command_args[] = {
+            { ConsoleCommandArgumentType_UInt64, String8FromCString("affinity_mask") }
+        };
+        console_commands_register_command(String8FromCString("set_worker_thread_affinity"),
+                                          &set_worker_thread_affinity_command,
+                                          set_worker_thread_affinity_command_args,
+                                          ArrayCount(set_worker_thread_affinity_command_args));
+
+        Console_Command_Argument_Info set_light_thread_affinity_command_args[] = {
+            { ConsoleCommandArgumentType_UInt64, String8FromCString("affinity_mask") }
+        };
+        console_commands_register_command(String8FromCString("set_light_thread_affinity"),
+                                          &set_light_thread_affinity_command,
+                                          set_light_thread_affinity_command_args,
+                                          ArrayCount(set_light_thread_affinity_command_args));
+
+        console_commands_register_command(String8FromCString("toggle_worker_thread_pinning"),
+                                          &toggle_worker_thread_pinning_command);
+
+        console_commands_register_command(String8FromCString("worker_topology"),
+                                          &worker_topology_command);
+
+        console_commands_register_command(String8FromCString("job_stats"),
+                                          &job_stats_command);
+
+        console_commands_register_command(String8FromCString("reset_job_stats"),
+                                          &reset_job_stats_command);
+
+        Console_Command_Argument_Info dump_job_stats_command_args[] = {
+            { ConsoleCommandArgumentType_String, String8FromCString("file_path") }
+        };
+        console_commands_register_command(String8FromCString("dump_job_stats"),
+                                          &dump_job_stats_command,
+                                          dump_job_stats_command_args,
+                                          ArrayCount(dump_job_stats_command_args));
+
+        console_commands_register_command(String8FromCString("benchmark_lighting"),
+                                          &benchmark_lighting_command);
+
+        console_commands_register_command(String8FromCString("benchmark_light_kernel"),
+                                          &benchmark_light_kernel_command);
     }
 
     bool clear_command(Console_Command_Argument *args)
@@ -127,6 +240,55 @@ namespace minecraft {
         return true;
     }
 
+    bool toggle_greedy_meshing_command(Console_Command_Argument *args)
+    {
+        Game_State *game_state = (Game_State*)console_commands_get_user_pointer();
+        World      *world      = game_state->world;
+
+        game_state->game_config.is_greedy_meshing_enabled = !game_state->game_config.is_greedy_meshing_enabled;
+        set_is_greedy_meshing_enabled(game_state->game_config.is_greedy_meshing_enabled);
+
+        {
+            std::unique_lock light_pass_lock(world->light_pass_mutex);
+
+            for (u32 i = 0; i < World::ChunkCapacity; i++)
+            {
+                Chunk *chunk = &world->chunk_nodes[i].chunk;
+                if (chunk->state == ChunkState_LightCalculated)
+                {
+                    for (i32 sub_chunk_index = 0; sub_chunk_index < (i32)Chunk::SubChunkCount; sub_chunk_index++)
+                    {
+                        mark_sub_chunk_dirty(world, chunk, sub_chunk_index);
+                    }
+                }
+                else
+                {
+                    // note(harlequin): load_and_update_chunks remeshes a far chunk once it is meshable
+                    chunk->is_mesh_outdated = true;
+                }
+            }
+
+            flush_dirty_sub_chunks(world);
+        }
+
+        Job_System::signal_light_thread();
+        return true;
+    }
+
+    bool toggle_occlusion_culling_command(Console_Command_Argument *args)
+    {
+        Game_State *game_state = (Game_State*)console_commands_get_user_pointer();
+        game_state->game_config.is_occlusion_culling_enabled = !game_state->game_config.is_occlusion_culling_enabled;
+        return true;
+    }
+
+    bool toggle_occlusion_buffer_command(Console_Command_Argument *args)
+    {
+        Game_State *game_state = (Game_State*)console_commands_get_user_pointer();
+        game_state->game_config.is_occlusion_buffer_enabled = !game_state->game_config.is_occlusion_buffer_enabled;
+        return true;
+    }
+
     bool set_chunk_radius_command(Console_Command_Argument *args)
     {
         u32 new_chunk_radius = glm::clamp(args[0].uint32,
@@ -137,6 +299,40 @@ namespace minecraft {
         return true;
     }
 
+    bool set_lod_chunk_radius_command(Console_Command_Argument *args)
+    {
+        u32 new_lod_chunk_radius = glm::clamp(args[0].uint32,
+                                              (u32)2,
+                                              (u32)World::MaxChunkRadius);
+        Game_State *game_state   = (Game_State*)console_commands_get_user_pointer();
+        game_state->game_config.lod_chunk_radius = new_lod_chunk_radius;
+        return true;
+    }
+
+    bool set_far_chunk_radius_command(Console_Command_Argument *args)
+    {
+        u32 new_far_chunk_radius = glm::clamp(args[0].uint32,
+                                              (u32)8,
+                                              (u32)World::MaxFarChunkRadius);
+        Game_State *game_state   = (Game_State*)console_commands_get_user_pointer();
+        game_state->game_config.far_chunk_radius = new_far_chunk_radius;
+        return true;
+    }
+
+    bool set_sub_chunk_mesh_job_group_size_command(Console_Command_Argument *args)
+    {
+        u32 group_size = glm::clamp(args[0].uint32,
+                                    (u32)1,
+                                    (u32)Chunk::SubChunkCount);
+        Game_State *game_state = (Game_State*)console_commands_get_user_pointer();
+        World      *world      = game_state->world;
+
+        // note(harlequin): the worst column remesh latency starts over so group sizes can be compared
+        world->sub_chunk_mesh_job_group_size = group_size;
+        world->max_column_remesh_latency     = 0;
+        return true;
+    }
+
     bool list_commands_command(Console_Command_Argument *args)
     {
         Game_State       *game_state   = (Game_State*)console_commands_get_user_pointer();
@@ -217,6 +413,151 @@ namespace minecraft {
         return true;
     }
 
+    static void push_restart_required_line(Dropdown_Console *console)
+    {
+        push_line(console, String8FromCString("worker topology changes take effect after a restart"));
+    }
+
+    bool set_worker_thread_count_command(Console_Command_Argument *args)
+    {
+        Game_State       *game_state = (Game_State*)console_commands_get_user_pointer();
+        Dropdown_Console *console    = &game_state->console;
+
+        game_state->game_config.worker_thread_count = glm::min(args[0].uint32, (u32)MC_MAX_THREAD_COUNT);
+        push_restart_required_line(console);
+        return true;
+    }
+
+    bool set_worker_thread_affinity_command(Console_Command_Argument *args)
+    {
+        Game_State       *game_state = (Game_State*)console_commands_get_user_pointer();
+        Dropdown_Console *console    = &game_state->console;
+
+        game_state->game_config.worker_thread_affinity_mask = args[0].uint64;
+        push_restart_required_line(console);
+        return true;
+    }
+
+    bool set_light_thread_affinity_command(Console_Command_Argument *args)
+    {
+        Game_State       *game_state = (Game_State*)console_commands_get_user_pointer();
+        Dropdown_Console *console    = &game_state->console;
+
+        game_state->game_config.light_thread_affinity_mask = args[0].uint64;
+        push_restart_required_line(console);
+        return true;
+    }
+
+    bool toggle_worker_thread_pinning_command(Console_Command_Argument *args)
+    {
+        Game_State       *game_state = (Game_State*)console_commands_get_user_pointer();
+        Dropdown_Console *console    = &game_state->console;
+
+        game_state->game_config.should_pin_worker_threads = !game_state->game_config.should_pin_worker_threads;
+        push_restart_required_line(console);
+        return true;
+    }
+
+    bool worker_topology_command(Console_Command_Argument *args)
+    {
+        Game_State       *game_state = (Game_State*)console_commands_get_user_pointer();
+        Dropdown_Console *console    = &game_state->console;
+
+        Temprary_Memory_Arena temp_arena = begin_temprary_memory_arena(&game_state->game_memory->permanent_arena);
+
+        const Job_System_Data &job_system_data = Job_System::internal_data;
+
+        push_line(console, push_string8(&temp_arena,
+                                        "worker threads: %u, light thread affinity: 0x%llx",
+                                        job_system_data.thread_count,
+                                        (unsigned long long)job_system_data.light_thread_affinity_mask));
+
+        for (u32 i = 0; i < job_system_data.thread_count; i++)
+        {
+            push_line(console, push_string8(&temp_arena,
+                                            "worker %u affinity: 0x%llx",
+                                            i,
+                                            (unsigned long long)job_system_data.worker_thread_affinity_masks[i]));
+        }
+
+        end_temprary_memory_arena(&temp_arena);
+        return true;
+    }
+
+    bool job_stats_command(Console_Command_Argument *args)
+    {
+        Game_State       *game_state = (Game_State*)console_commands_get_user_pointer();
+        Dropdown_Console *console    = &game_state->console;
+
+        Temprary_Memory_Arena temp_arena = begin_temprary_memory_arena(&game_state->game_memory->permanent_arena);
+
+        const Job_System_Data &job_system_data = Job_System::internal_data;
+
+        push_line(console, push_string8(&temp_arena,
+                                        "queue depth: high %u, low %u",
+                                        Job_System::get_queue_job_count(&job_system_data.high_priority_queue),
+                                        Job_System::get_queue_job_count(&job_system_data.low_priority_queue)));
+
+        for (u32 i = 0; i < job_system_data.thread_count; i++)
+        {
+            const Worker_Thread_Stats &stats = job_system_data.worker_thread_stats[i];
+            push_line(console, push_string8(&temp_arena,
+                                            "worker %u: jobs %llu, busy %.2f ms, idle %.2f ms, contended pops %llu",
+                                            i,
+                                            (unsigned long long)stats.executed_job_count.load(),
+                                            stats.busy_time / 1000000.0,
+                                            stats.idle_time / 1000000.0,
+                                            (unsigned long long)stats.contended_pop_count.load()));
+        }
+
+        for (u32 i = 0; i < JobType_Count; i++)
+        {
+            const Job_Type_Stats &stats = job_system_data.job_type_stats[i];
+            u64 job_count = stats.executed_job_count;
+            f64 divisor   = job_count ? (f64)job_count : 1.0;
+
+            push_line(console, push_string8(&temp_arena,
+                                            "%s: jobs %llu, exec avg %.3f ms max %.3f ms p50 < %.3f ms p99 < %.3f ms, latency avg %.3f ms max %.3f ms p99 < %.3f ms",
+                                            convert_job_type_to_cstring((JobType)i),
+                                            (unsigned long long)job_count,
+                                            stats.total_execution_time / divisor / 1000000.0,
+                                            stats.max_execution_time / 1000000.0,
+                                            Job_System::get_histogram_percentile(stats.execution_time_histogram, 0.5) / 1000.0,
+                                            Job_System::get_histogram_percentile(stats.execution_time_histogram, 0.99) / 1000.0,
+                                            stats.total_latency / divisor / 1000000.0,
+                                            stats.max_latency / 1000000.0,
+                                            Job_System::get_histogram_percentile(stats.latency_histogram, 0.99) / 1000.0));
+        }
+
+        end_temprary_memory_arena(&temp_arena);
+        return true;
+    }
+
+    bool reset_job_stats_command(Console_Command_Argument *args)
+    {
+        Job_System::reset_stats();
+        return true;
+    }
+
+    bool dump_job_stats_command(Console_Command_Argument *args)
+    {
+        Game_State       *game_state = (Game_State*)console_commands_get_user_pointer();
+        Dropdown_Console *console    = &game_state->console;
+
+        Temprary_Memory_Arena temp_arena = begin_temprary_memory_arena(&game_state->game_memory->permanent_arena);
+
+        String8 file_path = push_string8(&temp_arena, "%.*s", (i32)args[0].string.count, args[0].string.data);
+        bool dumped = Job_System::dump_stats_to_csv(file_path.data);
+
+        if (!dumped)
+        {
+            push_line(console, String8FromCString("failed to dump job stats"));
+        }
+
+        end_temprary_memory_arena(&temp_arena);
+        return dumped;
+    }
+
     bool minecraft::pack_textures_command(Console_Command_Argument *args)
     {
         std::vector< std::string > paths = list_files_at_path("../assets/textures/blocks/",
@@ -229,4 +570,1279 @@ namespace minecraft {
                                       "../src/meta/spritesheet_meta.h");
         return true;
     }
+
+    static u64 hash_chunk_light(Chunk *chunk)
+    {
+        u64 hash = 14695981039346656037ull;
+
+        auto hash_bytes = [&](const void *data, u64 size)
+        {
+            const u8 *bytes = (const u8*)data;
+            for (u64 i = 0; i < size; i++)
+            {
+                hash = (hash ^ bytes[i]) * 1099511628211ull;
+            }
+        };
+
+        hash_bytes(chunk->light_map,            sizeof(Block_Light_Info) * Chunk::BlockCount);
+        hash_bytes(chunk->front_edge_light_map, sizeof(Block_Light_Info) * Chunk::Height * Chunk::Width);
+        hash_bytes(chunk->back_edge_light_map,  sizeof(Block_Light_Info) * Chunk::Height * Chunk::Width);
+        hash_bytes(chunk->left_edge_light_map,  sizeof(Block_Light_Info) * Chunk::Height * Chunk::Depth);
+        hash_bytes(chunk->right_edge_light_map, sizeof(Block_Light_Info) * Chunk::Height * Chunk::Depth);
+
+        return hash;
+    }
+
+    // note(harlequin): relights every lit chunk of the active region twice, once with the serial bfs
+    // and once with the parallel chunk islands and checks that both end up with the same light values
+    bool benchmark_lighting_command(Console_Command_Argument *args)
+    {
+        Game_State       *game_state = (Game_State*)console_commands_get_user_pointer();
+        Dropdown_Console *console    = &game_state->console;
+        World            *world      = game_state->world;
+
+        Temprary_Memory_Arena temp_arena = begin_temprary_memory_arena(&game_state->game_memory->permanent_arena);
+
+        u32 chunk_count     = 0;
+        u32 mismatch_count  = 0;
+        f64 serial_time     = 0.0;
+        f64 parallel_time   = 0.0;
+
+        {
+            std::unique_lock light_pass_lock(world->light_pass_mutex);
+
+            World_Region_Bounds region_bounds = world->active_region_bounds;
+
+            Chunk **chunks = ArenaBeginArray(&temp_arena, Chunk*);
+
+            for (u32 i = 0; i < World::ChunkCapacity; i++)
+            {
+                Chunk *chunk = &world->chunk_nodes[i].chunk;
+                if (chunk->state == ChunkState_LightCalculated &&
+                    is_chunk_in_region_bounds(chunk->world_coords, region_bounds))
+                {
+                    Chunk **entry = ArenaPushArrayEntry(&temp_arena, chunks);
+                    *entry = chunk;
+                }
+            }
+
+            chunk_count = (u32)ArenaEndArray(&temp_arena, chunks);
+
+            u64 *serial_hashes = ArenaPushArray(&temp_arena, u64, chunk_count);
+            auto *light_queue  = ArenaPushAligned(&temp_arena, Circular_Queue< Light_Node >);
+            Assert(serial_hashes && light_queue);
+            light_queue->initialize();
+
+            f64 begin_time = Platform::get_current_time_in_seconds();
+
+            for (u32 i = 0; i < chunk_count; i++)
+            {
+                propagate_sky_light(world, chunks[i], light_queue);
+            }
+
+            propagate_light(world, light_queue, region_bounds);
+
+            for (u32 i = 0; i < chunk_count; i++)
+            {
+                calculate_lighting(world, chunks[i], light_queue);
+                propagate_light(world, light_queue, region_bounds);
+            }
+
+            serial_time = Platform::get_current_time_in_seconds() - begin_time;
+
+            for (u32 i = 0; i < chunk_count; i++)
+            {
+                serial_hashes[i] = hash_chunk_light(chunks[i]);
+            }
+
+            begin_time = Platform::get_current_time_in_seconds();
+
+            for (u32 i = 0; i < chunk_count; i++)
+            {
+                propagate_sky_light(world, chunks[i], light_queue);
+                push_pending_light_blocks(world, light_queue);
+            }
+
+            for (u32 i = 0; i < chunk_count; i++)
+            {
+                calculate_lighting(world, chunks[i], light_queue);
+                push_pending_light_blocks(world, light_queue);
+            }
+
+            propagate_light_in_parallel(world, region_bounds, &temp_arena);
+
+            parallel_time = Platform::get_current_time_in_seconds() - begin_time;
+
+            for (u32 i = 0; i < chunk_count; i++)
+            {
+                if (serial_hashes[i] != hash_chunk_light(chunks[i]))
+                {
+                    mismatch_count++;
+                }
+            }
+
+            flush_dirty_sub_chunks(world);
+        }
+
+        Job_System::signal_light_thread();
+
+        String8 str = push_string8(&temp_arena,
+                                   "lighting %u chunks: serial %.2f ms, parallel %.2f ms (%.2fx), %u mismatched chunks",
+                                   chunk_count,
+                                   serial_time * 1000.0,
+                                   parallel_time * 1000.0,
+                                   parallel_time > 0.0 ? serial_time / parallel_time : 0.0,
+                                   mismatch_count);
+        push_line(console, str);
+
+        end_temprary_memory_arena(&temp_arena);
+        return mismatch_count == 0;
+    }
+
+    // note(harlequin): a null block_query_queue runs the packed light node kernel, otherwise the nodes are
+    // turned into block queries first and the old kernel runs on them, only the bfs itself is timed
+    static u64 run_light_kernel(World *world,
+                                Circular_Queue< Light_Node > *light_queue,
+                                Circular_Queue< Block_Query_Result > *block_query_queue,
+                                const World_Region_Bounds& region_bounds,
+                                u64 *time)
+    {
+        if (!block_query_queue)
+        {
+            u64 begin_time = Job_System::get_time_stamp();
+            u64 processed_block_count = propagate_light(world, light_queue, region_bounds);
+            *time += Job_System::get_time_stamp() - begin_time;
+            return processed_block_count;
+        }
+
+        while (!light_queue->is_empty())
+        {
+            Light_Node node = light_queue->pop();
+            i32 block_index = get_light_node_block_index(node);
+
+            Block_Query_Result block_query = {};
+            block_query.chunk              = get_light_node_chunk(world, node);
+            block_query.block_coords       = get_block_coords(block_index);
+            block_query.block              = &block_query.chunk->blocks[block_index];
+            block_query_queue->push(block_query);
+        }
+
+        u64 begin_time = Job_System::get_time_stamp();
+        u64 processed_block_count = propagate_light_with_block_queries(world, block_query_queue, region_bounds);
+        *time += Job_System::get_time_stamp() - begin_time;
+        return processed_block_count;
+    }
+
+    static u64 relight_chunks_with_light_kernel(World *world,
+                                                Chunk **chunks,
+                                                u32 chunk_count,
+                                                Circular_Queue< Light_Node > *light_queue,
+                                                Circular_Queue< Block_Query_Result > *block_query_queue,
+                                                const World_Region_Bounds& region_bounds,
+                                                u64 *time)
+    {
+        u64 processed_block_count = 0;
+
+        for (u32 i = 0; i < chunk_count; i++)
+        {
+            propagate_sky_light(world, chunks[i], light_queue);
+        }
+
+        processed_block_count += run_light_kernel(world, light_queue, block_query_queue, region_bounds, time);
+
+        for (u32 i = 0; i < chunk_count; i++)
+        {
+            calculate_lighting(world, chunks[i], light_queue);
+            processed_block_count += run_light_kernel(world, light_queue, block_query_queue, region_bounds, time);
+        }
+
+        return processed_block_count;
+    }
+
+    // note(harlequin): relights every lit chunk of the active region with the block query bfs and then with
+    // the packed light node bfs, reports the blocks each kernel takes out of its queue per second
+    bool benchmark_light_kernel_command(Console_Command_Argument *args)
+    {
+        Game_State       *game_state = (Game_State*)console_commands_get_user_pointer();
+        Dropdown_Console *console    = &game_state->console;
+        World            *world      = game_state->world;
+
+        Temprary_Memory_Arena temp_arena = begin_temprary_memory_arena(&game_state->game_memory->permanent_arena);
+
+        u32 chunk_count                       = 0;
+        u32 mismatch_count                    = 0;
+        u64 block_query_processed_block_count = 0;
+        u64 block_query_time                  = 0;
+        u64 packed_processed_block_count      = 0;
+        u64 packed_time                       = 0;
+
+        {
+            std::unique_lock light_pass_lock(world->light_pass_mutex);
+
+            World_Region_Bounds region_bounds = world->active_region_bounds;
+
+            Chunk **chunks = ArenaBeginArray(&temp_arena, Chunk*);
+
+            for (u32 i = 0; i < World::ChunkCapacity; i++)
+            {
+                Chunk *chunk = &world->chunk_nodes[i].chunk;
+                if (chunk->state == ChunkState_LightCalculated &&
+                    is_chunk_in_region_bounds(chunk->world_coords, region_bounds))
+                {
+                    Chunk **entry = ArenaPushArrayEntry(&temp_arena, chunks);
+                    *entry = chunk;
+                }
+            }
+
+            chunk_count = (u32)ArenaEndArray(&temp_arena, chunks);
+
+            u64 *block_query_hashes = ArenaPushArray(&temp_arena, u64, chunk_count);
+            auto *light_queue       = ArenaPushAligned(&temp_arena, Circular_Queue< Light_Node >);
+            auto *block_query_queue = ArenaPushAligned(&temp_arena, Circular_Queue< Block_Query_Result >);
+            Assert(block_query_hashes && light_queue && block_query_queue);
+            light_queue->initialize();
+            block_query_queue->initialize();
+
+            block_query_processed_block_count = relight_chunks_with_light_kernel(world,
+                                                                                 chunks,
+                                                                                 chunk_count,
+                                                                                 light_queue,
+                                                                                 block_query_queue,
+                                                                                 region_bounds,
+                                                                                 &block_query_time);
+
+            for (u32 i = 0; i < chunk_count; i++)
+            {
+                block_query_hashes[i] = hash_chunk_light(chunks[i]);
+            }
+
+            packed_processed_block_count = relight_chunks_with_light_kernel(world,
+                                                                            chunks,
+                                                                            chunk_count,
+                                                                            light_queue,
+                                                                            nullptr,
+                                                                            region_bounds,
+                                                                            &packed_time);
+
+            for (u32 i = 0; i < chunk_count; i++)
+            {
+                if (block_query_hashes[i] != hash_chunk_light(chunks[i]))
+                {
+                    mismatch_count++;
+                }
+            }
+
+            flush_dirty_sub_chunks(world);
+        }
+
+        Job_System::signal_light_thread();
+
+        f64 block_query_blocks_per_second = block_query_time ? (f64)block_query_processed_block_count / ((f64)block_query_time * 1e-9) : 0.0;
+        f64 packed_blocks_per_second      = packed_time      ? (f64)packed_processed_block_count      / ((f64)packed_time      * 1e-9) : 0.0;
+
+        String8 str = push_string8(&temp_arena,
+                                   "light kernel %u chunks: block queries %.2f M blocks/s (%llu blocks, %.2f ms), packed %.2f M blocks/s (%llu blocks, %.2f ms), %.2fx, %u mismatched chunks",
+                                   chunk_count,
+                                   block_query_blocks_per_second * 1e-6,
+                                   block_query_processed_block_count,
+                                   (f64)block_query_time * 1e-6,
+                                   packed_blocks_per_second * 1e-6,
+                                   packed_processed_block_count,
+                                   (f64)packed_time * 1e-6,
+                                   block_query_blocks_per_second > 0.0 ? packed_blocks_per_second / block_query_blocks_per_second : 0.0,
+                                   mismatch_count);
+        push_line(console, str);
+
+        end_temprary_memory_arena(&temp_arena);
+        return mismatch_count == 0;
+    }
+
+    // note(harlequin): meshes every lit chunk of the active region with and without greedy meshing
+    // and reports mismatched block faces along with the face, bucket and meshing time savings
+    bool validate_greedy_meshing_command(Console_Command_Argument *args)
+    {
+        Game_State       *game_state = (Game_State*)console_commands_get_user_pointer();
+        Dropdown_Console *console    = &game_state->console;
+        World            *world      = game_state->world;
+
+        Temprary_Memory_Arena temp_arena = begin_temprary_memory_arena(&game_state->game_memory->permanent_arena);
+
+        u32 chunk_count = 0;
+        Greedy_Meshing_Validation_Result result = {};
+
+        {
+            std::unique_lock light_pass_lock(world->light_pass_mutex);
+
+            World_Region_Bounds region_bounds = world->active_region_bounds;
+
+            Chunk **chunks = ArenaBeginArray(&temp_arena, Chunk*);
+
+            for (u32 i = 0; i < World::ChunkCapacity; i++)
+            {
+                Chunk *chunk = &world->chunk_nodes[i].chunk;
+                if (chunk->state == ChunkState_LightCalculated &&
+                    is_chunk_in_region_bounds(chunk->world_coords, region_bounds))
+                {
+                    Chunk **entry = ArenaPushArrayEntry(&temp_arena, chunks);
+                    *entry = chunk;
+                }
+            }
+
+            chunk_count = (u32)ArenaEndArray(&temp_arena, chunks);
+            validate_greedy_meshing(world, chunks, chunk_count, &temp_arena, &result);
+        }
+
+        String8 str = push_string8(&temp_arena,
+                                   "greedy meshing %u chunks (%u sub chunks): %u faces -> %u faces (%.2f%%), %.2f MiB -> %.2f MiB, %u buckets -> %u buckets, %.2f ms -> %.2f ms, %u mismatched faces, %u faces the shaders decode differently",
+                                   chunk_count,
+                                   result.sub_chunk_count,
+                                   result.face_count,
+                                   result.greedy_face_count,
+                                   result.face_count ? 100.0f * (f32)result.greedy_face_count / (f32)result.face_count : 0.0f,
+                                   (f64)result.face_count * sizeof(Block_Face) / (1024.0 * 1024.0),
+                                   (f64)result.greedy_face_count * sizeof(Block_Face) / (1024.0 * 1024.0),
+                                   result.bucket_count,
+                                   result.greedy_bucket_count,
+                                   (f64)result.time * 1e-6,
+                                   (f64)result.greedy_time * 1e-6,
+                                   result.mismatched_face_count,
+                                   result.mismatched_packed_face_count);
+        push_line(console, str);
+
+        end_temprary_memory_arena(&temp_arena);
+        return result.mismatched_face_count == 0 && result.mismatched_packed_face_count == 0;
+    }
+
+    // note(harlequin): round trips every value of every block face field through pack_block_face, unpack_block_face
+    // and the decoding of the chunk vertex shaders, needs no world
+    bool validate_block_face_packing_command(Console_Command_Argument *args)
+    {
+        Game_State       *game_state = (Game_State*)console_commands_get_user_pointer();
+        Dropdown_Console *console    = &game_state->console;
+
+        Temprary_Memory_Arena temp_arena = begin_temprary_memory_arena(&game_state->game_memory->permanent_arena);
+
+        Block_Face_Packing_Validation_Result result = {};
+        bool success = validate_block_face_packing(&result);
+
+        String8 str = push_string8(&temp_arena,
+                                   "block face packing: %llu faces round tripped in %.2f ms, %llu mismatched",
+                                   result.checked_face_count,
+                                   (f64)result.time * 1e-6,
+                                   result.mismatched_face_count);
+        push_line(console, str);
+
+        end_temprary_memory_arena(&temp_arena);
+        return success;
+    }
+    // note(harlequin): meshes every sub chunk of the lit chunks in the active region into cpu scratch memory
+    // with per block face lookups, with row mask face culling and with row masks plus cached corner samples,
+    // each without and with greedy meshing, nothing is uploaded so this only measures the mesher, the times
+    // are also split by underground, surface and sky sub chunks and the halo reads made to light the face
+    // corners are counted
+    bool benchmark_meshing_command(Console_Command_Argument *args)
+    {
+        Game_State       *game_state = (Game_State*)console_commands_get_user_pointer();
+        Dropdown_Console *console    = &game_state->console;
+        World            *world      = game_state->world;
+
+        Temprary_Memory_Arena temp_arena = begin_temprary_memory_arena(&game_state->game_memory->permanent_arena);
+
+        u32 chunk_count = 0;
+        Meshing_Benchmark_Result results[6] = {};
+
+        {
+            std::unique_lock light_pass_lock(world->light_pass_mutex);
+
+            World_Region_Bounds region_bounds = world->active_region_bounds;
+
+            Chunk **chunks = ArenaBeginArray(&temp_arena, Chunk*);
+
+            for (u32 i = 0; i < World::ChunkCapacity; i++)
+            {
+                Chunk *chunk = &world->chunk_nodes[i].chunk;
+                if (chunk->state == ChunkState_LightCalculated &&
+                    is_chunk_in_region_bounds(chunk->world_coords, region_bounds))
+                {
+                    Chunk **entry = ArenaPushArrayEntry(&temp_arena, chunks);
+                    *entry = chunk;
+                }
+            }
+
+            chunk_count = (u32)ArenaEndArray(&temp_arena, chunks);
+
+            for (i32 i = 0; i < 6; i++)
+            {
+                bool is_greedy_meshing_enabled   = (i & 1) != 0;
+                bool should_cull_faces_by_masks  = i >= 2;
+                bool should_cache_corner_samples = i >= 4;
+                benchmark_sub_chunk_meshing(world,
+                                            chunks,
+                                            chunk_count,
+                                            is_greedy_meshing_enabled,
+                                            should_cull_faces_by_masks,
+                                            should_cache_corner_samples,
+                                            &temp_arena,
+                                            &results[i]);
+            }
+        }
+
+        const char *names[] = {
+            "lookups per block",
+            "lookups greedy",
+            "row masks per block",
+            "row masks greedy",
+            "row masks with corner samples per block",
+            "row masks with corner samples greedy"
+        };
+
+        auto get_average_time_in_us = [](u64 time, u32 count) -> f64
+        {
+            return count ? (f64)time * 1e-3 / (f64)count : 0.0;
+        };
+
+        for (i32 i = 0; i < 6; i++)
+        {
+            Meshing_Benchmark_Result& result = results[i];
+
+            String8 str = push_string8(&temp_arena,
+                                       "meshing %s %u chunks: %u sub chunks (%u empty), %llu faces, %.2f ms, %.2f us per sub chunk, slowest %.2f us",
+                                       names[i],
+                                       chunk_count,
+                                       result.sub_chunk_count,
+                                       result.empty_sub_chunk_count,
+                                       result.face_count,
+                                       (f64)result.time * 1e-6,
+                                       get_average_time_in_us(result.time, result.sub_chunk_count),
+                                       (f64)result.slowest_sub_chunk_time * 1e-3);
+            push_line(console, str);
+
+            str = push_string8(&temp_arena,
+                               "    underground %u: %.2f us, surface %u: %.2f us, sky %u: %.2f us per sub chunk",
+                               result.layer_sub_chunk_counts[MeshingBenchmarkLayer_Underground],
+                               get_average_time_in_us(result.layer_times[MeshingBenchmarkLayer_Underground], result.layer_sub_chunk_counts[MeshingBenchmarkLayer_Underground]),
+                               result.layer_sub_chunk_counts[MeshingBenchmarkLayer_Surface],
+                               get_average_time_in_us(result.layer_times[MeshingBenchmarkLayer_Surface], result.layer_sub_chunk_counts[MeshingBenchmarkLayer_Surface]),
+                               result.layer_sub_chunk_counts[MeshingBenchmarkLayer_Sky],
+                               get_average_time_in_us(result.layer_times[MeshingBenchmarkLayer_Sky], result.layer_sub_chunk_counts[MeshingBenchmarkLayer_Sky]));
+            push_line(console, str);
+
+            str = push_string8(&temp_arena,
+                               "    %llu corner light reads, %.2f per face",
+                               result.corner_light_read_count,
+                               result.face_count ? (f64)result.corner_light_read_count / (f64)result.face_count : 0.0);
+            push_line(console, str);
+        }
+
+        end_temprary_memory_arena(&temp_arena);
+        return true;
+    }
+
+    // note(harlequin): runs a random mix of allocations, reallocations and frees shaped like sub chunk meshes
+    // against a buddy allocator in scratch memory, the allocator never touches the memory it hands out so
+    // this needs no gpu, the allocator is validated along the way and has to end up empty
+    bool benchmark_vertex_allocator_command(Console_Command_Argument *args)
+    {
+        Game_State       *game_state = (Game_State*)console_commands_get_user_pointer();
+        Dropdown_Console *console    = &game_state->console;
+
+        Temprary_Memory_Arena temp_arena = begin_temprary_memory_arena(&game_state->game_memory->permanent_arena);
+
+        constexpr u64 UnitCount       = 1 << 22;
+        constexpr u64 ArenaSize       = 1024 * 1024;
+        constexpr u32 SlotCount       = 4096;
+        constexpr u32 OperationCount  = 1 << 20;
+        constexpr u32 ValidationCount = 64;
+
+        void *arena_memory = ArenaPushArrayAligned(&temp_arena, u8, ArenaSize);
+        Memory_Arena allocator_arena = create_memory_arena(arena_memory, ArenaSize);
+
+        Buddy_Allocator *allocator = ArenaPushAlignedZero(&temp_arena, Buddy_Allocator);
+        i64 *offsets = ArenaPushArrayAligned(&temp_arena, i64, SlotCount);
+        Buddy_Allocator_Thread_Cache cache = {};
+
+        bool success = allocator && offsets &&
+                       initialize_buddy_allocator(allocator,
+                                                  UnitCount,
+                                                  World::SubChunkBucketMinFaceCount,
+                                                  World::SubChunkBucketMaxFaceCount,
+                                                  &allocator_arena);
+        if (!success)
+        {
+            end_temprary_memory_arena(&temp_arena);
+            return false;
+        }
+
+        for (u32 i = 0; i < SlotCount; i++)
+        {
+            offsets[i] = -1;
+        }
+
+        u32 random_state = 0x9E3779B9;
+        auto next_random = [&]() -> u32
+        {
+            random_state ^= random_state << 13;
+            random_state ^= random_state >> 17;
+            random_state ^= random_state << 5;
+            return random_state;
+        };
+
+        // note(harlequin): most sub chunks have a few hundred faces, a few are dense caves or foliage
+        auto next_face_count = [&]() -> u32
+        {
+            u32 max_face_count = (next_random() & 15) == 0 ? (u32)World::SubChunkBucketMaxFaceCount : 512;
+            return 1 + next_random() % max_face_count;
+        };
+
+        u32 failed_allocation_count = 0;
+        u32 failed_validation_count = 0;
+        f64 max_fragmentation       = 0.0;
+
+        u64 total_time = 0;
+
+        for (u32 validation_index = 0; validation_index < ValidationCount; validation_index++)
+        {
+            u64 begin_time = Job_System::get_time_stamp();
+
+            for (u32 i = 0; i < OperationCount / ValidationCount; i++)
+            {
+                i64& offset = offsets[next_random() % SlotCount];
+                u32 operation = next_random() & 3;
+
+                if (offset != -1 && operation == 0)
+                {
+                    buddy_allocator_free(allocator, offset, &cache);
+                    offset = -1;
+                    continue;
+                }
+
+                offset = buddy_allocator_reallocate(allocator, offset, next_face_count(), i, &cache);
+                failed_allocation_count += offset == -1;
+            }
+
+            total_time += Job_System::get_time_stamp() - begin_time;
+
+            failed_validation_count += !validate_buddy_allocator(allocator);
+
+            Buddy_Allocator_Stats stats = get_buddy_allocator_stats(allocator);
+            if (stats.free_unit_count)
+            {
+                f64 fragmentation = 100.0 * (1.0 - (f64)stats.largest_free_block_unit_count / (f64)stats.free_unit_count);
+                max_fragmentation = Max(max_fragmentation, fragmentation);
+            }
+        }
+
+        for (u32 i = 0; i < SlotCount; i++)
+        {
+            if (offsets[i] != -1)
+            {
+                buddy_allocator_free(allocator, offsets[i], &cache);
+            }
+        }
+
+        buddy_allocator_flush_thread_cache(allocator, &cache);
+
+        Buddy_Allocator_Stats stats = get_buddy_allocator_stats(allocator);
+        bool is_empty = stats.allocation_count == 0 &&
+                        stats.allocated_unit_count == 0 &&
+                        stats.free_unit_count == stats.unit_count &&
+                        validate_buddy_allocator(allocator);
+
+        String8 str = push_string8(&temp_arena,
+                                   "vertex allocator: %u operations in %.2f ms, %.2f ns per operation, %u failed allocations, max fragmentation %.2f%%, %u failed validations, %s",
+                                   OperationCount,
+                                   (f64)total_time * 1e-6,
+                                   (f64)total_time / (f64)OperationCount,
+                                   failed_allocation_count,
+                                   max_fragmentation,
+                                   failed_validation_count,
+                                   is_empty ? "empty after free" : "leaked runs after free");
+        push_line(console, str);
+
+        end_temprary_memory_arena(&temp_arena);
+        return failed_validation_count == 0 && is_empty;
+    }
+
+    // note(harlequin): plays sub chunks being remeshed and unloaded over many frames against a buddy allocator and
+    // a retire queue in scratch memory, every run is stamped when it is written and the draws a frame recorded are
+    // checked against the stamps right before the frame is retired, which is the last moment a gpu could read them,
+    // so a run freed and reused too early shows up as a stale draw, no gpu is needed
+    bool validate_bucket_retirement_command(Console_Command_Argument *args)
+    {
+        Game_State       *game_state = (Game_State*)console_commands_get_user_pointer();
+        Dropdown_Console *console    = &game_state->console;
+
+        Temprary_Memory_Arena temp_arena = begin_temprary_memory_arena(&game_state->game_memory->permanent_arena);
+
+        constexpr u64 UnitCount      = 1 << 20;
+        constexpr u64 ArenaSize      = 1024 * 1024;
+        constexpr u32 SlotCount      = 1024;
+        constexpr u32 FrameCount     = 1024;
+        constexpr u32 FramesInFlight = 3;
+
+        struct Slot
+        {
+            i64 offset;
+            u32 face_count;
+            u32 stamp;
+        };
+
+        void *arena_memory = ArenaPushArrayAligned(&temp_arena, u8, ArenaSize);
+        Memory_Arena allocator_arena = create_memory_arena(arena_memory, ArenaSize);
+
+        Buddy_Allocator *allocator = ArenaPushAlignedZero(&temp_arena, Buddy_Allocator);
+        Retire_Queue *retire_queue = ArenaPushAlignedZero(&temp_arena, Retire_Queue);
+        u32  *memory      = ArenaPushArrayAligned(&temp_arena, u32, UnitCount);
+        Slot *slots       = ArenaPushArrayAligned(&temp_arena, Slot, SlotCount);
+        Slot *frame_draws = ArenaPushArrayAligned(&temp_arena, Slot, (FramesInFlight + 1) * SlotCount);
+        u32  *frame_draw_counts = ArenaPushArrayAligned(&temp_arena, u32, FramesInFlight + 1);
+        Buddy_Allocator_Thread_Cache cache = {};
+
+        bool success = allocator && retire_queue && memory && slots && frame_draws && frame_draw_counts &&
+                       initialize_buddy_allocator(allocator,
+                                                  UnitCount,
+                                                  World::SubChunkBucketMinFaceCount,
+                                                  World::SubChunkBucketMaxFaceCount,
+                                                  &allocator_arena) &&
+                       initialize_retire_queue(retire_queue, allocator, &allocator_arena);
+        if (!success)
+        {
+            end_temprary_memory_arena(&temp_arena);
+            return false;
+        }
+
+        for (u32 i = 0; i < SlotCount; i++)
+        {
+            slots[i] = { -1, 0, 0 };
+        }
+
+        u32 random_state = 0x9E3779B9;
+        auto next_random = [&]() -> u32
+        {
+            random_state ^= random_state << 13;
+            random_state ^= random_state >> 17;
+            random_state ^= random_state << 5;
+            return random_state;
+        };
+
+        u32 stale_draw_count        = 0;
+        u32 failed_allocation_count = 0;
+        u32 max_retired_run_count   = 0;
+        u32 next_stamp              = 1;
+
+        // note(harlequin): what the gpu would read for the draws of the frame
+        auto retire_frame = [&](u64 frame_index)
+        {
+            u32 ring_index = (u32)(frame_index % (FramesInFlight + 1));
+            Slot *draws = frame_draws + ring_index * SlotCount;
+
+            for (u32 i = 0; i < frame_draw_counts[ring_index]; i++)
+            {
+                for (u32 j = 0; j < draws[i].face_count; j++)
+                {
+                    if (memory[draws[i].offset + j] != draws[i].stamp)
+                    {
+                        stale_draw_count++;
+                        break;
+                    }
+                }
+            }
+
+            frame_draw_counts[ring_index] = 0;
+        };
+
+        u64 begin_time = Job_System::get_time_stamp();
+
+        for (u64 frame_index = 0; frame_index < FrameCount; frame_index++)
+        {
+            // note(harlequin): the frame FramesInFlight frames back is done on the gpu
+            if (frame_index >= FramesInFlight)
+            {
+                retire_frame(frame_index - FramesInFlight);
+                free_retired_runs(retire_queue, allocator, frame_index - FramesInFlight + 1, &cache);
+            }
+
+            // note(harlequin): the frame is recorded before the sub chunks are swapped, the runs retired this
+            // frame are the ones it draws
+            u32 ring_index = (u32)(frame_index % (FramesInFlight + 1));
+            Slot *draws = frame_draws + ring_index * SlotCount;
+
+            for (u32 i = 0; i < SlotCount; i++)
+            {
+                if (slots[i].offset != -1)
+                {
+                    draws[frame_draw_counts[ring_index]++] = slots[i];
+                }
+            }
+
+            for (u32 i = 0; i < SlotCount / 8; i++)
+            {
+                Slot& slot = slots[next_random() % SlotCount];
+
+                if (slot.offset != -1 && (next_random() & 7) == 0)
+                {
+                    retire_run(retire_queue, allocator, slot.offset, frame_index);
+                    slot = { -1, 0, 0 };
+                    continue;
+                }
+
+                u32 face_count = 1 + next_random() % 512;
+                i64 offset = buddy_allocator_allocate(allocator, face_count, 0, &cache);
+
+                if (offset == -1)
+                {
+                    failed_allocation_count++;
+                    continue;
+                }
+
+                u32 stamp = next_stamp++;
+                for (u32 j = 0; j < face_count; j++)
+                {
+                    memory[offset + j] = stamp;
+                }
+
+                if (slot.offset != -1)
+                {
+                    retire_run(retire_queue, allocator, slot.offset, frame_index);
+                }
+
+                slot = { offset, face_count, stamp };
+            }
+
+            max_retired_run_count = Max(max_retired_run_count, get_retire_queue_stats(retire_queue).run_count);
+        }
+
+        for (u64 frame_index = FrameCount - FramesInFlight; frame_index < FrameCount; frame_index++)
+        {
+            retire_frame(frame_index);
+        }
+
+        free_retired_runs(retire_queue, allocator, FrameCount, &cache);
+
+        u64 total_time = Job_System::get_time_stamp() - begin_time;
+
+        // note(harlequin): once the queue drains every sub chunk owns exactly one run
+        u32 live_slot_count = 0;
+        for (u32 i = 0; i < SlotCount; i++)
+        {
+            live_slot_count += slots[i].offset != -1;
+        }
+
+        buddy_allocator_flush_thread_cache(allocator, &cache);
+
+        Retire_Queue_Stats    retire_stats = get_retire_queue_stats(retire_queue);
+        Buddy_Allocator_Stats stats        = get_buddy_allocator_stats(allocator);
+
+        bool is_one_run_per_slot = retire_stats.run_count == 0 &&
+                                   stats.allocation_count == live_slot_count &&
+                                   validate_buddy_allocator(allocator);
+
+        String8 str = push_string8(&temp_arena,
+                                   "bucket retirement: %u frames (%u in flight) in %.2f ms, %llu runs retired, at most %u waiting, %u failed allocations, %u stale draws, %s",
+                                   FrameCount,
+                                   FramesInFlight,
+                                   (f64)total_time * 1e-6,
+                                   retire_stats.total_retired_run_count,
+                                   max_retired_run_count,
+                                   failed_allocation_count,
+                                   stale_draw_count,
+                                   is_one_run_per_slot ? "one run per sub chunk after draining" : "leaked runs after draining");
+        push_line(console, str);
+
+        end_temprary_memory_arena(&temp_arena);
+        return stale_draw_count == 0 && is_one_run_per_slot;
+    }
+
+    // note(harlequin): culls a made up region of chunk columns at the max chunk radius from a sweep of camera
+    // directions three ways, every sub chunk on its own like before, chunk columns first and then every sub chunk
+    // on its own, and chunk columns and sub chunks in aabb batches like the renderer does, the sub chunks are
+    // never drawn so no gpu or world is needed, every way has to find the same sub chunks visible
+    bool benchmark_frustum_culling_command(Console_Command_Argument *args)
+    {
+        Game_State       *game_state = (Game_State*)console_commands_get_user_pointer();
+        Dropdown_Console *console    = &game_state->console;
+
+        Temprary_Memory_Arena temp_arena = begin_temprary_memory_arena(&game_state->game_memory->permanent_arena);
+
+        constexpr i32 ChunkRadius    = (i32)World::MaxChunkRadius;
+        constexpr i32 ChunkSideCount = 2 * ChunkRadius + 1;
+        constexpr u32 ChunkCount     = ChunkSideCount * ChunkSideCount;
+        constexpr u32 YawCount       = 64;
+        constexpr u32 PitchCount     = 5;
+        constexpr u32 ViewCount      = YawCount * PitchCount;
+
+        AABB *column_aabbs              = ArenaPushArrayAligned(&temp_arena, AABB, ChunkCount);
+        AABB *sub_chunk_aabbs           = ArenaPushArrayAligned(&temp_arena, AABB, ChunkCount * Chunk::SubChunkCount);
+        u32  *non_empty_sub_chunk_masks = ArenaPushArrayAligned(&temp_arena, u32, ChunkCount);
+        u32  *visible_sub_chunk_masks   = ArenaPushArrayAligned(&temp_arena, u32, ChunkCount);
+
+        if (!column_aabbs || !sub_chunk_aabbs || !non_empty_sub_chunk_masks || !visible_sub_chunk_masks)
+        {
+            end_temprary_memory_arena(&temp_arena);
+            return false;
+        }
+
+        u32 random_state = 0x9E3779B9;
+        auto next_random = [&]() -> u32
+        {
+            random_state ^= random_state << 13;
+            random_state ^= random_state >> 17;
+            random_state ^= random_state << 5;
+            return random_state;
+        };
+
+        // note(harlequin): the sky above the surface is empty and a few sub chunks under it are solid stone,
+        // a sub chunk aabb is shrunk to its faces like the mesher does
+        u64 non_empty_sub_chunk_count = 0;
+
+        for (u32 chunk_index = 0; chunk_index < ChunkCount; chunk_index++)
+        {
+            glm::vec3 chunk_position = { (f32)((i32)(chunk_index % ChunkSideCount) - ChunkRadius) * Chunk::Width,
+                                         0.0f,
+                                         (f32)((i32)(chunk_index / ChunkSideCount) - ChunkRadius) * Chunk::Depth };
+
+            column_aabbs[chunk_index] = { chunk_position, chunk_position + glm::vec3(Chunk::Width, Chunk::Height, Chunk::Depth) };
+
+            u32 surface_height = 48 + next_random() % 48;
+            u32 non_empty_sub_chunk_mask = 0;
+
+            for (u32 sub_chunk_index = 0; sub_chunk_index < Chunk::SubChunkCount; sub_chunk_index++)
+            {
+                u32 sub_chunk_y = sub_chunk_index * Chunk::SubChunkHeight;
+
+                bool is_empty = sub_chunk_y > surface_height || (next_random() & 3) == 0;
+                non_empty_sub_chunk_mask |= (u32)!is_empty << sub_chunk_index;
+
+                glm::vec3 min = chunk_position + glm::vec3(0.0f, (f32)sub_chunk_y, 0.0f);
+                glm::vec3 max = min + glm::vec3(Chunk::Width, Chunk::SubChunkHeight, Chunk::Depth);
+                min += glm::vec3((f32)(next_random() % 4), 0.0f, (f32)(next_random() % 4));
+                max -= glm::vec3((f32)(next_random() % 4), (f32)(next_random() % 4), (f32)(next_random() % 4));
+
+                sub_chunk_aabbs[chunk_index * Chunk::SubChunkCount + sub_chunk_index] = { min, max };
+            }
+
+            non_empty_sub_chunk_masks[chunk_index] = non_empty_sub_chunk_mask;
+            non_empty_sub_chunk_count += count_set_bits(non_empty_sub_chunk_mask);
+        }
+
+        Camera camera = game_state->camera;
+        camera.position = { 0.5f * Chunk::Width, 80.0f, 0.5f * Chunk::Depth };
+
+        u64 sub_chunk_time          = 0;
+        u64 column_time             = 0;
+        u64 column_batch_time       = 0;
+        u64 visible_sub_chunk_count = 0;
+        u64 visible_column_count    = 0;
+        u32 mismatched_view_count   = 0;
+
+        for (u32 view_index = 0; view_index < ViewCount; view_index++)
+        {
+            camera.yaw   = 360.0f * (f32)(view_index % YawCount) / (f32)YawCount;
+            camera.pitch = -60.0f + 30.0f * (f32)(view_index / YawCount);
+            update_camera(&camera);
+
+            const Frustum& frustum = camera.frustum;
+
+            u64 view_visible_sub_chunk_count = 0;
+
+            u64 begin_time = Job_System::get_time_stamp();
+
+            for (u32 chunk_index = 0; chunk_index < ChunkCount; chunk_index++)
+            {
+                u32 visible_sub_chunk_mask = 0;
+
+                for (u32 sub_chunk_index = 0; sub_chunk_index < Chunk::SubChunkCount; sub_chunk_index++)
+                {
+                    bool is_sub_chunk_visible = (non_empty_sub_chunk_masks[chunk_index] & (1u << sub_chunk_index)) &&
+                                                frustum.is_aabb_visible(sub_chunk_aabbs[chunk_index * Chunk::SubChunkCount + sub_chunk_index]);
+                    visible_sub_chunk_mask |= (u32)is_sub_chunk_visible << sub_chunk_index;
+                }
+
+                visible_sub_chunk_masks[chunk_index] = visible_sub_chunk_mask;
+                view_visible_sub_chunk_count += count_set_bits(visible_sub_chunk_mask);
+            }
+
+            sub_chunk_time += Job_System::get_time_stamp() - begin_time;
+            visible_sub_chunk_count += view_visible_sub_chunk_count;
+
+            bool is_view_mismatched = false;
+
+            begin_time = Job_System::get_time_stamp();
+
+            for (u32 chunk_index = 0; chunk_index < ChunkCount; chunk_index++)
+            {
+                u32 visible_sub_chunk_mask = 0;
+
+                if (frustum.is_aabb_visible(column_aabbs[chunk_index]))
+                {
+                    for (u32 sub_chunk_index = 0; sub_chunk_index < Chunk::SubChunkCount; sub_chunk_index++)
+                    {
+                        bool is_sub_chunk_visible = (non_empty_sub_chunk_masks[chunk_index] & (1u << sub_chunk_index)) &&
+                                                    frustum.is_aabb_visible(sub_chunk_aabbs[chunk_index * Chunk::SubChunkCount + sub_chunk_index]);
+                        visible_sub_chunk_mask |= (u32)is_sub_chunk_visible << sub_chunk_index;
+                    }
+                }
+
+                is_view_mismatched |= visible_sub_chunk_mask != visible_sub_chunk_masks[chunk_index];
+            }
+
+            column_time += Job_System::get_time_stamp() - begin_time;
+
+            begin_time = Job_System::get_time_stamp();
+
+            for (u32 first_chunk_index = 0; first_chunk_index < ChunkCount; first_chunk_index += AABB_Batch::Capacity)
+            {
+                AABB_Batch column_batch;
+                column_batch.count = Min(ChunkCount - first_chunk_index, AABB_Batch::Capacity);
+
+                for (u32 i = 0; i < column_batch.count; i++)
+                {
+                    set_aabb_batch_entry(&column_batch, i, column_aabbs[first_chunk_index + i]);
+                }
+
+                u32 visible_column_mask = frustum.get_visible_aabb_mask(&column_batch);
+                visible_column_count += count_set_bits(visible_column_mask);
+
+                for (u32 i = 0; i < column_batch.count; i++)
+                {
+                    u32 chunk_index = first_chunk_index + i;
+                    u32 visible_sub_chunk_mask = 0;
+
+                    if (visible_column_mask & (1u << i))
+                    {
+                        AABB_Batch batch;
+                        batch.count = 0;
+
+                        u8 sub_chunk_indices[Chunk::SubChunkCount];
+
+                        for (u32 sub_chunk_index = 0; sub_chunk_index < Chunk::SubChunkCount; sub_chunk_index++)
+                        {
+                            if (non_empty_sub_chunk_masks[chunk_index] & (1u << sub_chunk_index))
+                            {
+                                sub_chunk_indices[batch.count] = (u8)sub_chunk_index;
+                                set_aabb_batch_entry(&batch, batch.count, sub_chunk_aabbs[chunk_index * Chunk::SubChunkCount + sub_chunk_index]);
+                                batch.count++;
+                            }
+                        }
+
+                        u32 visible_mask = frustum.get_visible_aabb_mask(&batch);
+
+                        while (visible_mask)
+                        {
+                            visible_sub_chunk_mask |= 1u << sub_chunk_indices[count_trailing_zeros(visible_mask)];
+                            visible_mask &= visible_mask - 1;
+                        }
+                    }
+
+                    is_view_mismatched |= visible_sub_chunk_mask != visible_sub_chunk_masks[chunk_index];
+                }
+            }
+
+            column_batch_time += Job_System::get_time_stamp() - begin_time;
+
+            mismatched_view_count += is_view_mismatched;
+        }
+
+        String8 str = push_string8(&temp_arena,
+                                   "frustum culling %u chunk columns (%llu sub chunks) from %u views: %.2f%% columns visible, %.2f%% sub chunks visible",
+                                   ChunkCount,
+                                   non_empty_sub_chunk_count,
+                                   ViewCount,
+                                   100.0 * (f64)visible_column_count / (f64)(ChunkCount * ViewCount),
+                                   100.0 * (f64)visible_sub_chunk_count / (f64)(non_empty_sub_chunk_count * ViewCount));
+        push_line(console, str);
+
+        str = push_string8(&temp_arena,
+                           "    per sub chunk %.2f us, columns then sub chunks %.2f us, column and sub chunk batches %.2f us per view, %u mismatched views",
+                           (f64)sub_chunk_time * 1e-3 / (f64)ViewCount,
+                           (f64)column_time * 1e-3 / (f64)ViewCount,
+                           (f64)column_batch_time * 1e-3 / (f64)ViewCount,
+                           mismatched_view_count);
+        push_line(console, str);
+
+        end_temprary_memory_arena(&temp_arena);
+        return mismatched_view_count == 0;
+    }
+    // note(harlequin): runs the visibility pass over the active chunks from the camera position for a sweep of
+    // camera directions and counts the sub chunks with faces in the frustum and the ones the pass reached, nothing
+    // is drawn so this only needs the meshed world, the pass of the current view is run again when this is done
+    bool benchmark_occlusion_culling_command(Console_Command_Argument *args)
+    {
+        Game_State       *game_state = (Game_State*)console_commands_get_user_pointer();
+        Dropdown_Console *console    = &game_state->console;
+        World            *world      = game_state->world;
+
+        constexpr u32 YawCount   = 64;
+        constexpr u32 PitchCount = 5;
+        constexpr u32 ViewCount  = YawCount * PitchCount;
+
+        Camera camera = game_state->camera;
+
+        u64 in_frustum_sub_chunk_count = 0;
+        u64 in_frustum_face_count      = 0;
+        u64 reachable_sub_chunk_count  = 0;
+        u64 reachable_face_count       = 0;
+        u64 total_time                 = 0;
+
+        for (u32 view_index = 0; view_index < ViewCount; view_index++)
+        {
+            camera.yaw   = 360.0f * (f32)(view_index % YawCount) / (f32)YawCount;
+            camera.pitch = -60.0f + 30.0f * (f32)(view_index / YawCount);
+            update_camera(&camera);
+
+            Temprary_Memory_Arena temp_arena = begin_temprary_memory_arena(&game_state->game_memory->permanent_arena);
+            find_reachable_sub_chunks(world, camera.position, camera.frustum, true, &temp_arena);
+            end_temprary_memory_arena(&temp_arena);
+
+            total_time += world->last_visibility_pass_time;
+
+            for (u32 i = 0; i < world->active_chunk_count; i++)
+            {
+                Chunk *chunk = world->active_chunks[i];
+
+                for (u32 sub_chunk_index = 0; sub_chunk_index < Chunk::SubChunkCount; sub_chunk_index++)
+                {
+                    i32 face_count = chunk->sub_chunks_render_data[sub_chunk_index].face_count;
+
+                    glm::vec3 min = chunk->position + glm::vec3(0.0f, (f32)(sub_chunk_index * Chunk::SubChunkHeight), 0.0f);
+                    glm::vec3 max = min + glm::vec3(Chunk::Width, Chunk::SubChunkHeight, Chunk::Depth);
+
+                    if (face_count == 0 || !camera.frustum.is_aabb_visible({ min, max }))
+                    {
+                        continue;
+                    }
+
+                    in_frustum_sub_chunk_count++;
+                    in_frustum_face_count += face_count;
+
+                    if (chunk->reachable_sub_chunk_mask & (1u << sub_chunk_index))
+                    {
+                        reachable_sub_chunk_count++;
+                        reachable_face_count += face_count;
+                    }
+                }
+            }
+        }
+
+        {
+            Temprary_Memory_Arena temp_arena = begin_temprary_memory_arena(&game_state->game_memory->permanent_arena);
+            find_reachable_sub_chunks(world,
+                                      game_state->camera.position,
+                                      game_state->camera.frustum,
+                                      game_state->game_config.is_occlusion_culling_enabled,
+                                      &temp_arena);
+            end_temprary_memory_arena(&temp_arena);
+        }
+
+        Temprary_Memory_Arena temp_arena = begin_temprary_memory_arena(&game_state->game_memory->permanent_arena);
+
+        String8 str = push_string8(&temp_arena,
+                                   "occlusion culling %u chunks from %u views: %.1f sub chunks (%.1f faces) in the frustum, %.1f sub chunks (%.1f faces) reached per view",
+                                   world->active_chunk_count,
+                                   ViewCount,
+                                   (f64)in_frustum_sub_chunk_count / (f64)ViewCount,
+                                   (f64)in_frustum_face_count / (f64)ViewCount,
+                                   (f64)reachable_sub_chunk_count / (f64)ViewCount,
+                                   (f64)reachable_face_count / (f64)ViewCount);
+        push_line(console, str);
+
+        str = push_string8(&temp_arena,
+                           "    %.2f%% of the sub chunks and %.2f%% of the faces hidden, %.2f us per pass",
+                           in_frustum_sub_chunk_count ? 100.0 * (f64)(in_frustum_sub_chunk_count - reachable_sub_chunk_count) / (f64)in_frustum_sub_chunk_count : 0.0,
+                           in_frustum_face_count ? 100.0 * (f64)(in_frustum_face_count - reachable_face_count) / (f64)in_frustum_face_count : 0.0,
+                           (f64)total_time * 1e-3 / (f64)ViewCount);
+        push_line(console, str);
+
+        end_temprary_memory_arena(&temp_arena);
+        return true;
+    }
+
+    static bool is_block_opaque(World *world, const Block *block)
+    {
+        const Block_Info *block_info = get_block_info(world, block);
+        return is_block_solid(block_info) && !is_block_transparent(block_info);
+    }
+
+    // note(harlequin): the first column of chunk from the top down whose blocks go opaque then see through again
+    // under at least 8 opaque blocks, returns false when the chunk has no such column
+    static bool find_cave_block(World *world, Chunk *chunk, glm::ivec3 *cave_block_coords)
+    {
+        for (i32 z = 0; z < Chunk::Depth; z++)
+        {
+            for (i32 x = 0; x < Chunk::Width; x++)
+            {
+                i32 roof_block_count = 0;
+
+                for (i32 y = Chunk::Height - 1; y >= 0; y--)
+                {
+                    if (is_block_opaque(world, get_block(chunk, { x, y, z })))
+                    {
+                        roof_block_count++;
+                    }
+                    else if (roof_block_count >= 8)
+                    {
+                        *cave_block_coords = { x, y, z };
+                        return true;
+                    }
+                }
+            }
+        }
+
+        return false;
+    }
+
+    // note(harlequin): rasterizes the occluders of a sweep of camera directions from above the ground at the camera
+    // position and from a cave under the chunk of the camera when there is one, and counts the sub chunks with faces
+    // in the frustum the occlusion buffer hides, nothing is drawn so this only needs the meshed world, the next frame
+    // gathers its own occluders again and the visibility pass of the current view is run again when this is done
+    bool benchmark_occlusion_buffer_command(Console_Command_Argument *args)
+    {
+        Game_State       *game_state = (Game_State*)console_commands_get_user_pointer();
+        Dropdown_Console *console    = &game_state->console;
+        World            *world      = game_state->world;
+
+        constexpr u32 YawCount   = 64;
+        constexpr u32 PitchCount = 3;
+        constexpr u32 ViewCount  = YawCount * PitchCount;
+
+        Occlusion_Buffer *occlusion_buffer = game_state->occlusion_buffer;
+
+        glm::ivec2 chunk_coords = world_position_to_chunk_coords(game_state->camera.position);
+        Chunk *chunk = get_chunk(world, chunk_coords);
+        if (!chunk)
+        {
+            return false;
+        }
+
+        glm::ivec3 block_coords = { (i32)glm::floor(game_state->camera.position.x) - chunk_coords.x * Chunk::Width,
+                                    Chunk::Height - 1,
+                                    (i32)glm::floor(game_state->camera.position.z) - chunk_coords.y * Chunk::Depth };
+
+        while (block_coords.y > 0 && !is_block_opaque(world, get_block(chunk, block_coords)))
+        {
+            block_coords.y--;
+        }
+
+        const char *view_names[2]      = { "surface", "cave" };
+        glm::vec3   view_positions[2]  = { chunk->position + glm::vec3(block_coords) + glm::vec3(0.5f, 2.5f, 0.5f) };
+        u32         view_position_count = 1;
+
+        if (find_cave_block(world, chunk, &block_coords))
+        {
+            view_positions[view_position_count++] = chunk->position + glm::vec3(block_coords) + glm::vec3(0.5f);
+        }
+        else
+        {
+            push_line(console, String8FromCString("benchmark_occlusion_buffer: no cave under the chunk of the camera"));
+        }
+
+        for (u32 view_position_index = 0; view_position_index < view_position_count; view_position_index++)
+        {
+            Camera camera   = game_state->camera;
+            camera.position = view_positions[view_position_index];
+
+            u64 in_frustum_sub_chunk_count       = 0;
+            u64 in_frustum_face_count            = 0;
+            u64 reachable_sub_chunk_count        = 0;
+            u64 hidden_sub_chunk_count           = 0;
+            u64 hidden_face_count                = 0;
+            u64 hidden_reachable_sub_chunk_count = 0;
+            u64 occluder_count                   = 0;
+            u64 triangle_count                   = 0;
+            u64 gather_time                      = 0;
+            u64 rasterize_time                   = 0;
+            u64 test_time                        = 0;
+
+            for (u32 view_index = 0; view_index < ViewCount; view_index++)
+            {
+                camera.yaw   = 360.0f * (f32)(view_index % YawCount) / (f32)YawCount;
+                camera.pitch = -30.0f + 30.0f * (f32)(view_index / YawCount);
+                update_camera(&camera);
+
+                Temprary_Memory_Arena view_arena = begin_temprary_memory_arena(&game_state->game_memory->permanent_arena);
+
+                find_reachable_sub_chunks(world, camera.position, camera.frustum, true, &view_arena);
+                gather_occluders(occlusion_buffer, world->active_chunks, world->active_chunk_count, &camera, &view_arena);
+                rasterize_occluders(occlusion_buffer, occlusion_buffer->frame_index);
+
+                end_temprary_memory_arena(&view_arena);
+
+                occluder_count += occlusion_buffer->occluder_count;
+                triangle_count += occlusion_buffer->rasterized_triangle_count;
+                gather_time    += occlusion_buffer->gather_time;
+                rasterize_time += occlusion_buffer->rasterize_time;
+
+                for (u32 i = 0; i < world->active_chunk_count; i++)
+                {
+                    Chunk *active_chunk = world->active_chunks[i];
+
+                    for (u32 sub_chunk_index = 0; sub_chunk_index < Chunk::SubChunkCount; sub_chunk_index++)
+                    {
+                        const Sub_Chunk_Render_Data& render_data = active_chunk->sub_chunks_render_data[sub_chunk_index];
+
+                        if (render_data.face_count == 0 || !camera.frustum.is_aabb_visible(render_data.aabb))
+                        {
+                            continue;
+                        }
+
+                        bool is_reachable = active_chunk->reachable_sub_chunk_mask & (1u << sub_chunk_index);
+
+                        u64 begin_time = Job_System::get_time_stamp();
+                        bool is_hidden = is_aabb_occluded(occlusion_buffer, render_data.aabb);
+                        test_time += Job_System::get_time_stamp() - begin_time;
+
+                        in_frustum_sub_chunk_count++;
+                        in_frustum_face_count += render_data.face_count;
+                        reachable_sub_chunk_count += is_reachable;
+
+                        if (is_hidden)
+                        {
+                            hidden_sub_chunk_count++;
+                            hidden_face_count += render_data.face_count;
+                            hidden_reachable_sub_chunk_count += is_reachable;
+                        }
+                    }
+                }
+            }
+
+            Temprary_Memory_Arena temp_arena = begin_temprary_memory_arena(&game_state->game_memory->permanent_arena);
+
+            String8 str = push_string8(&temp_arena,
+                                       "%s view at (%.1f, %.1f, %.1f) from %u views: %.1f sub chunks in the frustum, %.2f%% of them (%.2f%% of the faces) hidden, %.2f%% of the %.1f reached ones",
+                                       view_names[view_position_index],
+                                       camera.position.x,
+                                       camera.position.y,
+                                       camera.position.z,
+                                       ViewCount,
+                                       (f64)in_frustum_sub_chunk_count / (f64)ViewCount,
+                                       in_frustum_sub_chunk_count ? 100.0 * (f64)hidden_sub_chunk_count / (f64)in_frustum_sub_chunk_count : 0.0,
+                                       in_frustum_face_count ? 100.0 * (f64)hidden_face_count / (f64)in_frustum_face_count : 0.0,
+                                       reachable_sub_chunk_count ? 100.0 * (f64)hidden_reachable_sub_chunk_count / (f64)reachable_sub_chunk_count : 0.0,
+                                       (f64)reachable_sub_chunk_count / (f64)ViewCount);
+            push_line(console, str);
+
+            str = push_string8(&temp_arena,
+                               "    %.1f occluders %.1f triangles, %.2f us gather %.2f us rasterize %.2f us test per view",
+                               (f64)occluder_count / (f64)ViewCount,
+                               (f64)triangle_count / (f64)ViewCount,
+                               (f64)gather_time * 1e-3 / (f64)ViewCount,
+                               (f64)rasterize_time * 1e-3 / (f64)ViewCount,
+                               (f64)test_time * 1e-3 / (f64)ViewCount);
+            push_line(console, str);
+
+            end_temprary_memory_arena(&temp_arena);
+        }
+
+        {
+            Temprary_Memory_Arena view_arena = begin_temprary_memory_arena(&game_state->game_memory->permanent_arena);
+            find_reachable_sub_chunks(world,
+                                      game_state->camera.position,
+                                      game_state->camera.frustum,
+                                      game_state->game_config.is_occlusion_culling_enabled,
+                                      &view_arena);
+            end_temprary_memory_arena(&view_arena);
+        }
+
+        return true;
+    }
 }
\ No newline at end of file
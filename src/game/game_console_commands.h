@@ -13,9 +13,33 @@ namespace minecraft {
     bool quit_command(Console_Command_Argument *args);
     bool add_block_to_inventory_command(Console_Command_Argument *args);
     bool toggle_fxaa_command(Console_Command_Argument *args);
+    bool toggle_greedy_meshing_command(Console_Command_Argument *args);
+    bool toggle_occlusion_culling_command(Console_Command_Argument *args);
+    bool toggle_occlusion_buffer_command(Console_Command_Argument *args);
+    bool validate_greedy_meshing_command(Console_Command_Argument *args);
+    bool validate_block_face_packing_command(Console_Command_Argument *args);
+    bool benchmark_meshing_command(Console_Command_Argument *args);
+    bool benchmark_vertex_allocator_command(Console_Command_Argument *args);
+    bool validate_bucket_retirement_command(Console_Command_Argument *args);
+    bool benchmark_frustum_culling_command(Console_Command_Argument *args);
+    bool benchmark_occlusion_culling_command(Console_Command_Argument *args);
+    bool benchmark_occlusion_buffer_command(Console_Command_Argument *args);
     bool set_chunk_radius_command(Console_Command_Argument *args);
+    bool set_lod_chunk_radius_command(Console_Command_Argument *args);
+    bool set_far_chunk_radius_command(Console_Command_Argument *args);
+    bool set_sub_chunk_mesh_job_group_size_command(Console_Command_Argument *args);
     bool list_commands_command(Console_Command_Argument *args);
     bool list_blocks_command(Console_Command_Argument *args);
     bool set_time_command(Console_Command_Argument *args);
     bool pack_textures_command(Console_Command_Argument *args);
+    bool set_worker_thread_count_command(Console_Command_Argument *args);
+    bool set_worker_thread_affinity_command(Console_Command_Argument *args);
+    bool set_light_thread_affinity_command(Console_Command_Argument *args);
+    bool toggle_worker_thread_pinning_command(Console_Command_Argument *args);
+    bool worker_topology_command(Console_Command_Argument *args);
+    bool job_stats_command(Console_Command_Argument *args);
+    bool reset_job_stats_command(Console_Command_Argument *args);
+    bool dump_job_stats_command(Console_Command_Argument *args);
+    bool benchmark_lighting_command(Console_Command_Argument *args);
+    bool benchmark_light_kernel_command(Console_Command_Argument *args);
 }
@@ -1,8 +1,61 @@
 #include "job_system.h"
 #include "world.h"
+#include "core/platform.h"
+#include "renderer/opengl_renderer.h"
+
+#include <chrono>
 
 namespace minecraft {
 
+    static u32 get_stats_histogram_bucket(u64 time)
+    {
+        u64 microseconds = time / 1000;
+        u32 bucket = 0;
+
+        while (microseconds && bucket < MC_JOB_STATS_HISTOGRAM_BUCKET_COUNT - 1)
+        {
+            microseconds >>= 1;
+            bucket++;
+        }
+
+        return bucket;
+    }
+
+    static void update_max(std::atomic< u64 > &max_value, u64 value)
+    {
+        u64 current_value = max_value.load(std::memory_order_relaxed);
+        while (value > current_value &&
+               !max_value.compare_exchange_weak(current_value, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    static u64 execute_job(Job *job, Memory_Arena *arena)
+    {
+        JobType type        = job->type;
+        u64     submit_time = job->submit_time;
+        u64     start_time  = Job_System::get_time_stamp();
+
+        Temprary_Memory_Arena temp_arena = begin_temprary_memory_arena(arena);
+        job->execute(job->data, &temp_arena);
+        end_temprary_memory_arena(&temp_arena);
+
+        u64 end_time       = Job_System::get_time_stamp();
+        u64 execution_time = end_time - start_time;
+        u64 latency        = start_time > submit_time ? start_time - submit_time : 0;
+
+        Job_Type_Stats *stats = &Job_System::internal_data.job_type_stats[type];
+        stats->executed_job_count.fetch_add(1, std::memory_order_relaxed);
+        stats->total_execution_time.fetch_add(execution_time, std::memory_order_relaxed);
+        stats->total_latency.fetch_add(latency, std::memory_order_relaxed);
+        update_max(stats->max_execution_time, execution_time);
+        update_max(stats->max_latency, latency);
+        stats->execution_time_histogram[get_stats_histogram_bucket(execution_time)].fetch_add(1, std::memory_order_relaxed);
+        stats->latency_histogram[get_stats_histogram_bucket(latency)].fetch_add(1, std::memory_order_relaxed);
+
+        return execution_time;
+    }
+
     static void execute_jobs(u32 thread_index)
     {
         auto& work_mutex = Job_System::internal_data.work_mutex;
@@ -13,9 +66,19 @@ namespace minecraft {
         bool& running = Job_System::internal_data.running;
 
         Memory_Arena *arena = &Job_System::internal_data.arenas[thread_index];
+        Worker_Thread_Stats *stats = &Job_System::internal_data.worker_thread_stats[thread_index];
+
+        u64 affinity_mask = Job_System::internal_data.worker_thread_affinity_masks[thread_index];
+        if (affinity_mask)
+        {
+            Platform::set_current_thread_affinity(affinity_mask);
+        }
 
         while (running || !high_priority_queue->is_empty() || !low_priority_queue->is_empty())
         {
+            u64 iteration_begin_time = Job_System::get_time_stamp();
+            u64 busy_time = 0;
+
             {
                 std::unique_lock lock(work_mutex);
                 work_cv.wait(lock, [&] { return !running || !high_priority_queue->is_empty() || !low_priority_queue->is_empty(); });
@@ -31,11 +94,13 @@ namespace minecraft {
             {
                 if (high_priority_queue->job_index.compare_exchange_strong(job_index, next_job_index))
                 {
-                    Temprary_Memory_Arena temp_arena = begin_temprary_memory_arena(arena);
                     Job *job = high_priority_queue->jobs + job_index;
-                    job->execute(job->data, &temp_arena);
+                    busy_time = execute_job(job, arena);
                     high_priority_job = job;
-                    end_temprary_memory_arena(&temp_arena);
+                }
+                else
+                {
+                    stats->contended_pop_count.fetch_add(1, std::memory_order_relaxed);
                 }
             }
 
@@ -49,13 +114,25 @@ namespace minecraft {
                 {
                     if (low_priority_queue->job_index.compare_exchange_strong(job_index, next_job_index))
                     {
-                        Temprary_Memory_Arena temp_arena = begin_temprary_memory_arena(arena);
                         Job* job = low_priority_queue->jobs + job_index;
-                        job->execute(job->data, &temp_arena);
-                        end_temprary_memory_arena(&temp_arena);
+                        busy_time = execute_job(job, arena);
+                    }
+                    else
+                    {
+                        stats->contended_pop_count.fetch_add(1, std::memory_order_relaxed);
                     }
                 }
             }
+
+            u64 iteration_time = Job_System::get_time_stamp() - iteration_begin_time;
+
+            if (busy_time)
+            {
+                stats->executed_job_count.fetch_add(1, std::memory_order_relaxed);
+                stats->busy_time.fetch_add(busy_time, std::memory_order_relaxed);
+            }
+
+            stats->idle_time.fetch_add(iteration_time > busy_time ? iteration_time - busy_time : 0, std::memory_order_relaxed);
         }
     }
 
@@ -64,76 +141,108 @@ namespace minecraft {
         auto& light_propagation_queue        = world->light_propagation_queue;
         auto& calculate_chunk_lighting_queue = world->calculate_chunk_lighting_queue;
         auto& update_chunk_jobs_queue        = world->update_chunk_jobs_queue;
+        auto& block_edits_queue              = world->block_edits_queue;
 
-        auto *light_queue = ArenaPushAligned(arena, Circular_Queue< Block_Query_Result >);
+        if (Job_System::internal_data.light_thread_affinity_mask)
+        {
+            Platform::set_current_thread_affinity(Job_System::internal_data.light_thread_affinity_mask);
+        }
+
+        auto *light_queue = ArenaPushAligned(arena, Circular_Queue< Light_Node >);
         Assert(light_queue);
         light_queue->initialize();
 
-        while (Job_System::internal_data.running)
+        auto *light_removal_queue = ArenaPushAligned(arena, Circular_Queue< Light_Removal_Node >);
+        Assert(light_removal_queue);
+        light_removal_queue->initialize();
+
+        auto& light_mutex = Job_System::internal_data.light_mutex;
+        auto& light_cv    = Job_System::internal_data.light_cv;
+        bool& running     = Job_System::internal_data.running;
+
+        while (running)
         {
-            while (!light_propagation_queue.is_empty())
             {
-                Calculate_Chunk_Light_Propagation_Job job = light_propagation_queue.pop();
-                Chunk *chunk = job.chunk;
-                propagate_sky_light(world, chunk, light_queue);
-                chunk->state = ChunkState_LightPropagated;
+                std::unique_lock lock(light_mutex);
+                light_cv.wait(lock, [&] { return !running ||
+                                                 !light_propagation_queue.is_empty() ||
+                                                 !calculate_chunk_lighting_queue.is_empty() ||
+                                                 !block_edits_queue.is_empty() ||
+                                                 !update_chunk_jobs_queue.is_empty(); });
             }
 
-            while (!calculate_chunk_lighting_queue.is_empty())
             {
-                Calculate_Chunk_Lighting_Job job = calculate_chunk_lighting_queue.pop();
-                Chunk *chunk = job.chunk;
-                calculate_lighting(world, chunk, light_queue);
-                chunk->state = ChunkState_LightCalculated;
-            }
+                std::unique_lock light_pass_lock(world->light_pass_mutex);
 
-            while (!light_queue->is_empty())
-            {
-                auto block_query = light_queue->pop();
+                while (!light_propagation_queue.is_empty())
+                {
+                    Calculate_Chunk_Light_Propagation_Job job = light_propagation_queue.pop();
+                    Chunk *chunk = job.chunk;
+                    propagate_sky_light(world, chunk, light_queue);
+                    push_pending_light_blocks(world, light_queue);
+                    chunk->state = ChunkState_LightPropagated;
+                }
 
-                Block* block = block_query.block;
-                Block_Light_Info *block_light_info = get_block_light_info(block_query.chunk, block_query.block_coords);
-                const Block_Info* info = get_block_info(world, block);
-                auto neighbours_query = query_neighbours(block_query.chunk, block_query.block_coords);
+                while (!calculate_chunk_lighting_queue.is_empty())
+                {
+                    Calculate_Chunk_Lighting_Job job = calculate_chunk_lighting_queue.pop();
+                    Chunk *chunk = job.chunk;
+                    calculate_lighting(world, chunk, light_queue);
+                    push_pending_light_blocks(world, light_queue);
+                    chunk->state = ChunkState_LightCalculated;
+                }
+
+                World_Region_Bounds region_bounds = world->active_region_bounds;
 
-                for (i32 d = 0; d < 6; d++)
+                while (!block_edits_queue.is_empty())
                 {
-                    auto &neighbour_query = neighbours_query[d];
+                    Block_Edit block_edit = block_edits_queue.pop();
 
-                    if (is_block_query_valid(neighbour_query) &&
-                        is_block_query_in_world_region(neighbour_query, world->active_region_bounds))
+                    if (!block_edit.is_applied)
                     {
-                        Block* neighbour = neighbour_query.block;
-                        const auto* neighbour_info = get_block_info(world, neighbour);
-                        if (is_block_transparent(neighbour_info))
-                        {
-                            Block_Light_Info *neighbour_block_light_info = get_block_light_info(neighbour_query.chunk, neighbour_query.block_coords);
-
-                            if ((i32)neighbour_block_light_info->sky_light_level <= (i32)block_light_info->sky_light_level - 2)
-                            {
-                                set_block_sky_light_level(world, neighbour_query.chunk, neighbour_query.block_coords, (i32)block_light_info->sky_light_level - 1);
-                                light_queue->push(neighbour_query);
-                            }
-
-                            if ((i32)neighbour_block_light_info->light_source_level <= (i32)block_light_info->light_source_level - 2)
-                            {
-                                set_block_light_source_level(world, neighbour_query.chunk, neighbour_query.block_coords, (i32)block_light_info->light_source_level - 1);
-                                light_queue->push(neighbour_query);
-                            }
-                        }
+                        apply_block_edit(world, &block_edit);
+                        world->deferred_block_edit_count--;
                     }
+
+                    u64 begin_time = Job_System::get_time_stamp();
+                    update_light_for_block_edit(world, block_edit, region_bounds, light_queue, light_removal_queue);
+                    world->last_block_edit_light_update_time = Job_System::get_time_stamp() - begin_time;
                 }
+
+                world->block_edits_drained_cv.notify_all();
+
+                Temprary_Memory_Arena temp_arena = begin_temprary_memory_arena(arena);
+                propagate_light_in_parallel(world, region_bounds, &temp_arena);
+                end_temprary_memory_arena(&temp_arena);
+
+                opengl_renderer_defragment_sub_chunk_buckets(world, World::SubChunkBucketDefragmentBudget);
+
+                flush_dirty_sub_chunks(world);
             }
 
+            static_assert(Chunk::SubChunkCount <= MC_MAX_THREAD_COUNT, "a chunk update has to fit in one batch");
+            u32 sub_chunk_mesh_job_group_size = world->sub_chunk_mesh_job_group_size;
+
             while (!update_chunk_jobs_queue.is_empty())
             {
-                auto job = update_chunk_jobs_queue.pop();
-                Job_System::schedule(job);
+                Update_Chunk_Job update_chunk_jobs[MC_MAX_THREAD_COUNT];
+                u32 update_chunk_job_count = 0;
+
+                while (!update_chunk_jobs_queue.is_empty() &&
+                       update_chunk_job_count + Chunk::SubChunkCount <= MC_MAX_THREAD_COUNT)
+                {
+                    Update_Chunk_Job update_chunk_job = update_chunk_jobs_queue.pop();
+                    update_chunk_job_count += split_update_chunk_job(update_chunk_job,
+                                                                     sub_chunk_mesh_job_group_size,
+                                                                     update_chunk_jobs + update_chunk_job_count);
+                }
+
+                Job_System::schedule_batch(update_chunk_jobs, update_chunk_job_count);
             }
         }
     }
 
-    bool Job_System::initialize(World *world, Memory_Arena *permanent_arena)
+    bool Job_System::initialize(World *world, Memory_Arena *permanent_arena, const Game_Config *config)
     {
         u32 concurrent_thread_count = std::thread::hardware_concurrency();
 
@@ -143,9 +252,41 @@ namespace minecraft {
             return false;
         }
 
-        internal_data.thread_count = concurrent_thread_count - 2;
+        internal_data.thread_count = config->worker_thread_count ? config->worker_thread_count : concurrent_thread_count - 2;
+        if (internal_data.thread_count == 0) internal_data.thread_count = 1;
         if (internal_data.thread_count > MC_MAX_THREAD_COUNT) internal_data.thread_count = MC_MAX_THREAD_COUNT;
 
+        u64 worker_thread_affinity_mask = config->worker_thread_affinity_mask;
+        if (!worker_thread_affinity_mask)
+        {
+            for (u32 i = 2; i < concurrent_thread_count && i < 64; i++)
+            {
+                worker_thread_affinity_mask |= (u64)1 << i;
+            }
+        }
+
+        // note(harlequin): pinned workers take the set bits of the mask round robin, one logical processor each
+        u64 remaining_affinity_mask = worker_thread_affinity_mask;
+
+        for (u32 i = 0; i < internal_data.thread_count; i++)
+        {
+            internal_data.worker_thread_affinity_masks[i] = 0;
+
+            if (config->should_pin_worker_threads && worker_thread_affinity_mask)
+            {
+                if (!remaining_affinity_mask)
+                {
+                    remaining_affinity_mask = worker_thread_affinity_mask;
+                }
+
+                u64 processor_mask = remaining_affinity_mask & (~remaining_affinity_mask + 1);
+                remaining_affinity_mask &= ~processor_mask;
+                internal_data.worker_thread_affinity_masks[i] = processor_mask;
+            }
+        }
+
+        internal_data.light_thread_affinity_mask = config->light_thread_affinity_mask;
+
         internal_data.high_priority_queue.job_index = 0;
         internal_data.high_priority_queue.tail_job_index = 0;
         memset(internal_data.high_priority_queue.jobs, 0, sizeof(Job) * MC_MAX_JOB_COUNT_PER_QUEUE);
@@ -159,11 +300,16 @@ namespace minecraft {
         for (u32 i = 0; i < internal_data.thread_count; i++)
         {
             // todo(harlequin): maybe we can use thread local storage
-            internal_data.arenas[i]  = push_sub_arena(permanent_arena, MegaBytes(1));
+            void *arena_memory = arena_allocate_aligned(permanent_arena, MegaBytes(1), KiloBytes(4));
+            Assert(arena_memory);
+            internal_data.arenas[i]  = create_memory_arena(arena_memory, MegaBytes(1));
             internal_data.threads[i] = std::thread(execute_jobs, i);
         }
 
-        internal_data.light_thread = std::thread(do_light_thread_work, world, permanent_arena);
+        void *light_thread_arena_memory = arena_allocate_aligned(permanent_arena, MegaBytes(8), KiloBytes(4));
+        Assert(light_thread_arena_memory);
+        internal_data.light_thread_arena = create_memory_arena(light_thread_arena_memory, MegaBytes(8));
+        internal_data.light_thread = std::thread(do_light_thread_work, world, &internal_data.light_thread_arena);
         return true;
     }
 
@@ -179,6 +325,8 @@ namespace minecraft {
             work_cv.notify_all();
         }
 
+        signal_light_thread();
+
         for (u32 thread_index = 0; thread_index < internal_data.thread_count; thread_index++)
         {
             internal_data.threads[thread_index].join();
@@ -197,6 +345,26 @@ namespace minecraft {
         queue->tail_job_index = next_tail_job_index;
     }
 
+    void Job_System::signal_light_thread()
+    {
+        std::unique_lock lock(internal_data.light_mutex);
+        internal_data.light_cv.notify_one();
+    }
+
+    void Job_System::wake_worker_threads(u32 job_count)
+    {
+        if (job_count >= internal_data.thread_count)
+        {
+            internal_data.work_cv.notify_all();
+            return;
+        }
+
+        for (u32 i = 0; i < job_count; i++)
+        {
+            internal_data.work_cv.notify_one();
+        }
+    }
+
     void Job_System::wait_for_jobs_to_finish()
     {
         Job_Queue* high_priority_queue = &internal_data.high_priority_queue;
@@ -208,5 +376,169 @@ namespace minecraft {
         }
     }
 
+    u64 Job_System::get_time_stamp()
+    {
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        return (u64)std::chrono::duration_cast< std::chrono::nanoseconds >(now).count();
+    }
+
+    u32 Job_System::get_queue_job_count(const Job_Queue *queue)
+    {
+        i32 job_index      = queue->job_index;
+        i32 tail_job_index = queue->tail_job_index;
+        return (u32)((tail_job_index - job_index + MC_MAX_JOB_COUNT_PER_QUEUE) % MC_MAX_JOB_COUNT_PER_QUEUE);
+    }
+
+    void Job_System::sample_queue_depths()
+    {
+        Job_Queue_Depth_Sample *sample = &internal_data.queue_depth_samples[internal_data.queue_depth_sample_index];
+        sample->high_priority_job_count = get_queue_job_count(&internal_data.high_priority_queue);
+        sample->low_priority_job_count  = get_queue_job_count(&internal_data.low_priority_queue);
+
+        internal_data.queue_depth_sample_index++;
+        if (internal_data.queue_depth_sample_index == MC_JOB_QUEUE_DEPTH_SAMPLE_COUNT) internal_data.queue_depth_sample_index = 0;
+
+        if (internal_data.queue_depth_sample_count < MC_JOB_QUEUE_DEPTH_SAMPLE_COUNT)
+        {
+            internal_data.queue_depth_sample_count++;
+        }
+    }
+
+    void Job_System::reset_stats()
+    {
+        for (u32 i = 0; i < MC_MAX_THREAD_COUNT; i++)
+        {
+            Worker_Thread_Stats *stats = &internal_data.worker_thread_stats[i];
+            stats->executed_job_count  = 0;
+            stats->busy_time           = 0;
+            stats->idle_time           = 0;
+            stats->contended_pop_count = 0;
+        }
+
+        for (u32 i = 0; i < JobType_Count; i++)
+        {
+            Job_Type_Stats *stats       = &internal_data.job_type_stats[i];
+            stats->executed_job_count   = 0;
+            stats->total_execution_time = 0;
+            stats->max_execution_time   = 0;
+            stats->total_latency        = 0;
+            stats->max_latency          = 0;
+
+            for (u32 j = 0; j < MC_JOB_STATS_HISTOGRAM_BUCKET_COUNT; j++)
+            {
+                stats->execution_time_histogram[j] = 0;
+                stats->latency_histogram[j]        = 0;
+            }
+        }
+
+        internal_data.queue_depth_sample_index = 0;
+        internal_data.queue_depth_sample_count = 0;
+    }
+
+    // note(harlequin): returns the upper bound of the bucket containing the percentile in microseconds
+    u64 Job_System::get_histogram_percentile(const std::atomic< u32 > *histogram, f64 percentile)
+    {
+        u64 total_count = 0;
+        for (u32 i = 0; i < MC_JOB_STATS_HISTOGRAM_BUCKET_COUNT; i++)
+        {
+            total_count += histogram[i];
+        }
+
+        if (total_count == 0)
+        {
+            return 0;
+        }
+
+        u64 target_count = (u64)(percentile * total_count);
+        u64 count = 0;
+
+        for (u32 i = 0; i < MC_JOB_STATS_HISTOGRAM_BUCKET_COUNT; i++)
+        {
+            count += histogram[i];
+            if (count >= target_count)
+            {
+                return (u64)1 << i;
+            }
+        }
+
+        return (u64)1 << (MC_JOB_STATS_HISTOGRAM_BUCKET_COUNT - 1);
+    }
+
+    bool Job_System::dump_stats_to_csv(const char *file_path)
+    {
+        FILE *file = fopen(file_path, "w");
+
+        if (!file)
+        {
+            fprintf(stderr, "[ERROR]: failed to open file %s for writting\n", file_path);
+            return false;
+        }
+
+        defer { fclose(file); };
+
+        fprintf(file, "worker,executed_jobs,busy_ms,idle_ms,contended_pops\n");
+
+        for (u32 i = 0; i < internal_data.thread_count; i++)
+        {
+            const Worker_Thread_Stats *stats = &internal_data.worker_thread_stats[i];
+            fprintf(file,
+                    "%u,%llu,%.3f,%.3f,%llu\n",
+                    i,
+                    (unsigned long long)stats->executed_job_count.load(),
+                    stats->busy_time.load() / 1000000.0,
+                    stats->idle_time.load() / 1000000.0,
+                    (unsigned long long)stats->contended_pop_count.load());
+        }
+
+        fprintf(file, "\njob_type,executed_jobs,avg_execution_us,max_execution_us,avg_latency_us,max_latency_us");
+        for (u32 i = 0; i < MC_JOB_STATS_HISTOGRAM_BUCKET_COUNT; i++)
+        {
+            fprintf(file, ",execution_lt_%lluus", (unsigned long long)((u64)1 << i));
+        }
+        for (u32 i = 0; i < MC_JOB_STATS_HISTOGRAM_BUCKET_COUNT; i++)
+        {
+            fprintf(file, ",latency_lt_%lluus", (unsigned long long)((u64)1 << i));
+        }
+        fprintf(file, "\n");
+
+        for (u32 i = 0; i < JobType_Count; i++)
+        {
+            const Job_Type_Stats *stats = &internal_data.job_type_stats[i];
+            u64 executed_job_count = stats->executed_job_count;
+            f64 job_count = executed_job_count ? (f64)executed_job_count : 1.0;
+
+            fprintf(file,
+                    "%s,%llu,%.3f,%.3f,%.3f,%.3f",
+                    convert_job_type_to_cstring((JobType)i),
+                    (unsigned long long)executed_job_count,
+                    stats->total_execution_time / job_count / 1000.0,
+                    stats->max_execution_time / 1000.0,
+                    stats->total_latency / job_count / 1000.0,
+                    stats->max_latency / 1000.0);
+
+            for (u32 j = 0; j < MC_JOB_STATS_HISTOGRAM_BUCKET_COUNT; j++)
+            {
+                fprintf(file, ",%u", stats->execution_time_histogram[j].load());
+            }
+            for (u32 j = 0; j < MC_JOB_STATS_HISTOGRAM_BUCKET_COUNT; j++)
+            {
+                fprintf(file, ",%u", stats->latency_histogram[j].load());
+            }
+            fprintf(file, "\n");
+        }
+
+        fprintf(file, "\nsample,high_priority_jobs,low_priority_jobs\n");
+
+        u32 first_sample_index = (internal_data.queue_depth_sample_index + MC_JOB_QUEUE_DEPTH_SAMPLE_COUNT - internal_data.queue_depth_sample_count) % MC_JOB_QUEUE_DEPTH_SAMPLE_COUNT;
+
+        for (u32 i = 0; i < internal_data.queue_depth_sample_count; i++)
+        {
+            const Job_Queue_Depth_Sample *sample = &internal_data.queue_depth_samples[(first_sample_index + i) % MC_JOB_QUEUE_DEPTH_SAMPLE_COUNT];
+            fprintf(file, "%u,%u,%u\n", i, sample->high_priority_job_count, sample->low_priority_job_count);
+        }
+
+        return true;
+    }
+
     Job_System_Data Job_System::internal_data;
 }
\ No newline at end of file
@@ -7,16 +7,22 @@
 #include <atomic>
 #include <condition_variable>
 #include "memory/memory_arena.h"
+#include "game/game_config.h"
+#include "game/jobs.h"
 
 namespace minecraft {
 
     #define MC_MAX_THREAD_COUNT 64
     #define MC_MAX_JOB_COUNT_PER_QUEUE 65536
+    #define MC_JOB_STATS_HISTOGRAM_BUCKET_COUNT 24
+    #define MC_JOB_QUEUE_DEPTH_SAMPLE_COUNT 256
 
     struct Job
     {
         void *data;
         void (*execute)(void *data, Temprary_Memory_Arena *temp_arena);
+        JobType type;
+        u64     submit_time;
     };
 
     struct Job_Queue
@@ -28,6 +34,34 @@ namespace minecraft {
         inline bool is_empty() { return job_index == tail_job_index; }
     };
 
+    // note(harlequin): there is no work stealing, contended_pop_count counts the pops a worker
+    // lost to another worker on the shared queues which is the closest thing we have to a steal
+    struct Worker_Thread_Stats alignas(std::hardware_destructive_interference_size)
+    {
+        std::atomic< u64 > executed_job_count;
+        std::atomic< u64 > busy_time;
+        std::atomic< u64 > idle_time;
+        std::atomic< u64 > contended_pop_count;
+    };
+
+    // note(harlequin): times are in nanoseconds, histogram bucket 0 is [0, 1us) and bucket i is [2^(i - 1), 2^i) us
+    struct Job_Type_Stats
+    {
+        std::atomic< u64 > executed_job_count;
+        std::atomic< u64 > total_execution_time;
+        std::atomic< u64 > max_execution_time;
+        std::atomic< u64 > total_latency;
+        std::atomic< u64 > max_latency;
+        std::atomic< u32 > execution_time_histogram[MC_JOB_STATS_HISTOGRAM_BUCKET_COUNT];
+        std::atomic< u32 > latency_histogram[MC_JOB_STATS_HISTOGRAM_BUCKET_COUNT];
+    };
+
+    struct Job_Queue_Depth_Sample
+    {
+        u32 high_priority_job_count;
+        u32 low_priority_job_count;
+    };
+
     struct Job_System_Data
     {
         bool running;
@@ -35,14 +69,26 @@ namespace minecraft {
         u32 thread_count;
         std::thread threads[MC_MAX_THREAD_COUNT];
         Memory_Arena arenas[MC_MAX_THREAD_COUNT];
+        u64 worker_thread_affinity_masks[MC_MAX_THREAD_COUNT];
 
         std::thread light_thread;
+        Memory_Arena light_thread_arena;
+        u64 light_thread_affinity_mask;
+        std::mutex light_mutex;
+        std::condition_variable light_cv;
 
         std::mutex work_mutex;
         std::condition_variable work_cv;
 
         Job_Queue high_priority_queue;
         Job_Queue low_priority_queue;
+
+        Worker_Thread_Stats worker_thread_stats[MC_MAX_THREAD_COUNT];
+        Job_Type_Stats      job_type_stats[JobType_Count];
+
+        Job_Queue_Depth_Sample queue_depth_samples[MC_JOB_QUEUE_DEPTH_SAMPLE_COUNT];
+        u32                    queue_depth_sample_index;
+        u32                    queue_depth_sample_count;
     };
 
     struct World;
@@ -51,36 +97,90 @@ namespace minecraft {
     {
         static Job_System_Data internal_data;
 
-        static bool initialize(World *world, Memory_Arena *permenent_arena);
+        static bool initialize(World *world, Memory_Arena *permenent_arena, const Game_Config *config);
         static void shutdown();
 
         static void dispatch(const Job& job, bool high_prority);
+        static void signal_light_thread();
 
         template<typename T>
-        static void schedule(const T& job_data, bool high_prority = true)
+        static T* push_job_data(const T& job_data)
         {
             static std::vector<T> job_data_pool(MC_MAX_JOB_COUNT_PER_QUEUE);
             static u32 job_data_index = 0;
 
+            T *result = &job_data_pool[job_data_index];
+            *result = job_data;
+
+            job_data_index++;
+            if (job_data_index == MC_MAX_JOB_COUNT_PER_QUEUE) job_data_index = 0;
+
+            return result;
+        }
+
+        template<typename T>
+        static void schedule(const T& job_data, bool high_prority = true)
+        {
             bool should_notifiy_worker_threads = internal_data.high_priority_queue.is_empty() && internal_data.low_priority_queue.is_empty();
 
             std::unique_lock lock(internal_data.work_mutex);
-            job_data_pool[job_data_index] = job_data;
 
             Job job;
-            job.data    = &job_data_pool[job_data_index];
-            job.execute = &T::execute;
+            job.data        = push_job_data(job_data);
+            job.execute     = &T::execute;
+            job.type        = T::Type;
+            job.submit_time = get_time_stamp();
             dispatch(job, high_prority);
 
-            job_data_index++;
-            if (job_data_index == MC_MAX_JOB_COUNT_PER_QUEUE) job_data_index = 0;
-
             if (should_notifiy_worker_threads)
             {
                 internal_data.work_cv.notify_all();
             }
         }
 
+        // note(harlequin): publishes all the jobs with a single tail bump under one lock
+        // and only wakes as many worker threads as there are jobs
+        template<typename T>
+        static void schedule_batch(const T *jobs_data, u32 job_count, bool high_prority = true)
+        {
+            if (job_count == 0)
+            {
+                return;
+            }
+
+            Job_Queue *queue = high_prority ? &internal_data.high_priority_queue : &internal_data.low_priority_queue;
+
+            std::unique_lock lock(internal_data.work_mutex);
+
+            i32 tail_job_index = queue->tail_job_index;
+            u64 submit_time    = get_time_stamp();
+
+            for (u32 i = 0; i < job_count; i++)
+            {
+                Job *job         = &queue->jobs[tail_job_index];
+                job->data        = push_job_data(jobs_data[i]);
+                job->execute     = &T::execute;
+                job->type        = T::Type;
+                job->submit_time = submit_time;
+
+                tail_job_index++;
+                if (tail_job_index == MC_MAX_JOB_COUNT_PER_QUEUE) tail_job_index = 0;
+            }
+
+            queue->tail_job_index = tail_job_index;
+
+            wake_worker_threads(job_count);
+        }
+
+        static void wake_worker_threads(u32 job_count);
+
         static void wait_for_jobs_to_finish();
+
+        static u64 get_time_stamp();
+        static u32 get_queue_job_count(const Job_Queue *queue);
+        static void sample_queue_depths();
+        static void reset_stats();
+        static u64 get_histogram_percentile(const std::atomic< u32 > *histogram, f64 percentile);
+        static bool dump_stats_to_csv(const char *file_path);
     };
 }
\ No newline at end of file
@@ -1,15 +1,63 @@
 #include "jobs.h"
 #include "renderer/opengl_renderer.h"
 #include "renderer/camera.h"
+#include "renderer/occlusion_buffer.h"
 #include "core/file_system.h"
 #include "memory/memory_arena.h"
 #include "game/world.h"
 #include "game/job_system.h"
 #include "game/game.h"
+#include "meshing/sub_chunk_mesher.h"
 #include "ui/dropdown_console.h"
 
 namespace minecraft {
 
+    const char* convert_job_type_to_cstring(JobType type)
+    {
+        switch (type)
+        {
+            case JobType_LoadChunk:
+            {
+                return "load_chunk";
+            } break;
+
+            case JobType_PropagateChunkLight:
+            {
+                return "propagate_chunk_light";
+            } break;
+
+            case JobType_UpdateChunk:
+            {
+                return "update_chunk";
+            } break;
+
+            case JobType_SerializeChunk:
+            {
+                return "serialize_chunk";
+            } break;
+
+            case JobType_SerializeAndFreeChunk:
+            {
+                return "serialize_and_free_chunk";
+            } break;
+
+            case JobType_RasterizeOccluders:
+            {
+                return "rasterize_occluders";
+            } break;
+
+            case JobType_SerializeChunkBlocks:
+            {
+                return "serialize_chunk_blocks";
+            } break;
+
+            default:
+            {
+                return "";
+            } break;
+        }
+    }
+
     void Load_Chunk_Job::execute(void* job_data, Temprary_Memory_Arena *temp_arena)
     {
         Load_Chunk_Job* data = (Load_Chunk_Job*)job_data;
@@ -19,33 +67,172 @@ namespace minecraft {
 
         String8 chunk_file_path = get_chunk_file_path(world, chunk, temp_arena);
 
-        generate_chunk(chunk, world->seed);
+        bool is_saved = exists(chunk_file_path.data);
+
+        // note(harlequin): a far chunk is given lod cells instead of blocks, one that was never saved gets them
+        // straight from the terrain heights and a saved one is loaded into blocks that only live as long as the job
+        Chunk *loaded_chunk = chunk;
+
+        if (!chunk->blocks)
+        {
+            Assert(chunk->lod_cells);
+
+            if (!is_saved)
+            {
+                generate_chunk_lod_cells(chunk, chunk->lod_cells, world->seed);
+                chunk->has_lod_cells.store(true, std::memory_order_release);
+                chunk->state = ChunkState_Loaded;
+                return;
+            }
+
+            loaded_chunk = ArenaPushZero(temp_arena, Chunk);
+            initialize_chunk(loaded_chunk, chunk->world_coords);
+            attach_chunk_blocks(loaded_chunk, ArenaPush(temp_arena, Chunk_Blocks));
+        }
+
+        generate_chunk(loaded_chunk, world->seed);
 
-        if (exists(chunk_file_path.data))
+        if (is_saved)
         {
-            deserialize_chunk(world, chunk, temp_arena);
+            deserialize_chunk(world, loaded_chunk, temp_arena);
+        }
+
+        calculate_height_map(loaded_chunk);
+
+        if (loaded_chunk != chunk)
+        {
+            memcpy(chunk->height_map, loaded_chunk->height_map, sizeof(chunk->height_map));
+            calculate_lod_cells(loaded_chunk, chunk->lod_cells);
+            chunk->has_lod_cells.store(true, std::memory_order_release);
         }
 
         chunk->state = ChunkState_Loaded;
     }
 
+    void Propagate_Chunk_Light_Job::execute(void* job_data, Temprary_Memory_Arena *temp_arena)
+    {
+        Propagate_Chunk_Light_Job* data = (Propagate_Chunk_Light_Job*)job_data;
+        propagate_chunk_light(data->world, data->chunk, *data->region_bounds, temp_arena);
+        data->world->dirty_sub_chunk_mark_count += take_dirty_sub_chunk_mark_count();
+
+        // note(harlequin): the count drops and the waiter is notified under the mutex, the batch lives on the stack
+        // of the light thread and is gone as soon as it sees the count reach zero, which it can only do once the
+        // mutex is released and the batch is not touched again
+        Propagate_Light_Batch *batch = data->batch;
+        std::lock_guard lock(batch->done_mutex);
+        if (batch->pending_job_count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            batch->done_cv.notify_one();
+        }
+    }
+
+    static void finish_chunk_update(World *world, Chunk *chunk)
+    {
+        u64 latency = Job_System::get_time_stamp() - chunk->update_queue_time;
+        world->last_column_remesh_latency = latency;
+
+        u64 max_latency = world->max_column_remesh_latency.load(std::memory_order_relaxed);
+        while (latency > max_latency &&
+               !world->max_column_remesh_latency.compare_exchange_weak(max_latency, latency, std::memory_order_relaxed))
+        {
+        }
+
+        chunk->tessellation_state = TessellationState_Done;
+
+        // note(harlequin): sub chunks marked while the chunk was pending did not queue an update of their own
+        for (i32 sub_chunk_index = 0; sub_chunk_index < Chunk::SubChunkCount; sub_chunk_index++)
+        {
+            if (chunk->sub_chunks_render_data[sub_chunk_index].state == TessellationState_Pending)
+            {
+                queue_update_chunk_job(world, chunk);
+                Job_System::signal_light_thread();
+                break;
+            }
+        }
+    }
+
+    u32 split_update_chunk_job(const Update_Chunk_Job& job, u32 group_size, Update_Chunk_Job *jobs)
+    {
+        Chunk *chunk = job.chunk;
+
+        u32 pending_sub_chunk_mask = 0;
+
+        for (i32 sub_chunk_index = 0; sub_chunk_index < Chunk::SubChunkCount; sub_chunk_index++)
+        {
+            if (chunk->sub_chunks_render_data[sub_chunk_index].state == TessellationState_Pending)
+            {
+                pending_sub_chunk_mask |= 1u << sub_chunk_index;
+            }
+        }
+
+        if (!pending_sub_chunk_mask)
+        {
+            finish_chunk_update(job.world, chunk);
+            return 0;
+        }
+
+        u32 job_count = 0;
+
+        while (pending_sub_chunk_mask)
+        {
+            Update_Chunk_Job *sub_chunk_job = &jobs[job_count++];
+            sub_chunk_job->world          = job.world;
+            sub_chunk_job->chunk          = chunk;
+            sub_chunk_job->sub_chunk_mask = 0;
+
+            for (u32 i = 0; i < group_size && pending_sub_chunk_mask; i++)
+            {
+                sub_chunk_job->sub_chunk_mask |= pending_sub_chunk_mask & (~pending_sub_chunk_mask + 1);
+                pending_sub_chunk_mask &= pending_sub_chunk_mask - 1;
+            }
+        }
+
+        chunk->pending_update_job_count = job_count;
+        return job_count;
+    }
+
     void Update_Chunk_Job::execute(void* job_data, Temprary_Memory_Arena *temp_arena)
     {
         Update_Chunk_Job* data = (Update_Chunk_Job*)job_data;
         World *world = data->world;
         Chunk *chunk = data->chunk;
 
-        for (i32 sub_chunk_index = 0; sub_chunk_index < Chunk::SubChunkCount; sub_chunk_index++)
+        Sub_Chunk_Mesh *mesh = ArenaPushAligned(temp_arena, Sub_Chunk_Mesh);
+        Assert(mesh);
+
+        bool should_use_greedy_meshing = is_greedy_meshing_enabled();
+
+        u32 sub_chunk_mask = data->sub_chunk_mask;
+
+        while (sub_chunk_mask)
         {
+            i32 sub_chunk_index = (i32)count_trailing_zeros(sub_chunk_mask);
+            sub_chunk_mask &= sub_chunk_mask - 1;
+
+            // note(harlequin): the sub chunk is marked done before it is meshed so a mark that comes in
+            // while it is being meshed is not lost
             Sub_Chunk_Render_Data& render_data = chunk->sub_chunks_render_data[sub_chunk_index];
-            if (render_data.state == TessellationState_Pending)
+            if (render_data.state.exchange(TessellationState_Done) == TessellationState_Pending)
             {
-                opengl_renderer_update_sub_chunk(world, chunk, sub_chunk_index);
-                render_data.state = TessellationState_Done;
+                Sub_Chunk_Mesh *patched_mesh = patch_sub_chunk_mesh(chunk, sub_chunk_index, mesh);
+
+                if (patched_mesh)
+                {
+                    opengl_renderer_update_sub_chunk(world, chunk, sub_chunk_index, patched_mesh);
+                    release_patched_sub_chunk_mesh(patched_mesh);
+                }
+                else
+                {
+                    mesh_sub_chunk(world, chunk, sub_chunk_index, should_use_greedy_meshing, mesh);
+                    opengl_renderer_update_sub_chunk(world, chunk, sub_chunk_index, mesh);
+                }
             }
         }
 
-        chunk->tessellation_state = TessellationState_Done;
+        if (chunk->pending_update_job_count.fetch_sub(1) == 1)
+        {
+            finish_chunk_update(world, chunk);
+        }
     }
 
     void Serialize_Chunk_Job::execute(void* job_data, Temprary_Memory_Arena *temp_arena)
@@ -71,7 +258,33 @@ namespace minecraft {
                 opengl_renderer_free_sub_chunk(chunk, sub_chunk_index);
             }
         }
-        serialize_chunk(world, chunk, world->seed, temp_arena);
+
+        // note(harlequin): a far chunk has no blocks to save, its file was written when it gave them back
+        if (chunk->blocks)
+        {
+            serialize_chunk(world, chunk, world->seed, temp_arena);
+        }
+
         chunk->state = ChunkState_Saved;
     }
+
+    void Serialize_Chunk_Blocks_Job::execute(void* job_data, Temprary_Memory_Arena *temp_arena)
+    {
+        Serialize_Chunk_Blocks_Job* data = (Serialize_Chunk_Blocks_Job*)job_data;
+        World *world = data->world;
+        Chunk *chunk = data->chunk;
+        serialize_chunk(world, chunk, world->seed, temp_arena);
+
+        // note(harlequin): the neighbours of the chunk mesh from its cells once it gave its blocks back
+        calculate_lod_cells(chunk, chunk->lod_cells);
+        chunk->has_lod_cells.store(true, std::memory_order_release);
+
+        chunk->state = ChunkState_BlocksSaved;
+    }
+
+    void Rasterize_Occluders_Job::execute(void* job_data, Temprary_Memory_Arena *temp_arena)
+    {
+        Rasterize_Occluders_Job* data = (Rasterize_Occluders_Job*)job_data;
+        rasterize_occluders(data->occlusion_buffer, data->frame_index);
+    }
 }
\ No newline at end of file
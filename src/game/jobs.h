@@ -2,19 +2,38 @@
 
 #include "core/common.h"
 #include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
 #include <glm/glm.hpp>
 
 namespace minecraft {
 
     struct Chunk;
     struct World;
+    struct Occlusion_Buffer;
     struct World_Region_Bounds;
     struct Temprary_Memory_Arena;
 
+    enum JobType : u8
+    {
+        JobType_LoadChunk             = 0,
+        JobType_PropagateChunkLight   = 1,
+        JobType_UpdateChunk           = 2,
+        JobType_SerializeChunk        = 3,
+        JobType_SerializeAndFreeChunk = 4,
+        JobType_RasterizeOccluders    = 5,
+        JobType_SerializeChunkBlocks  = 6,
+        JobType_Count                 = 7
+    };
+
+    const char* convert_job_type_to_cstring(JobType type);
+
     struct Load_Chunk_Job alignas(std::hardware_constructive_interference_size)
     {
         World *world;
         Chunk *chunk;
+        static constexpr JobType Type = JobType_LoadChunk;
         static void execute(void* job_data, Temprary_Memory_Arena *temp_arena);
     };
 
@@ -32,17 +51,45 @@ namespace minecraft {
         static void execute(void* job_data, Temprary_Memory_Arena *temp_arena);
     };
 
+    // note(harlequin): the jobs of one color of propagate_light_in_parallel, the last job to finish wakes
+    // the light thread sleeping on done_cv
+    struct Propagate_Light_Batch
+    {
+        std::atomic< u32 >      pending_job_count;
+        std::mutex              done_mutex;
+        std::condition_variable done_cv;
+    };
+
+    struct Propagate_Chunk_Light_Job alignas(std::hardware_constructive_interference_size)
+    {
+        World *world;
+        Chunk *chunk;
+        const World_Region_Bounds *region_bounds;
+        Propagate_Light_Batch     *batch;
+        static constexpr JobType Type = JobType_PropagateChunkLight;
+        static void execute(void* job_data, Temprary_Memory_Arena *temp_arena);
+    };
+
+    // note(harlequin): a chunk is queued for an update with an empty sub chunk mask, the light thread splits it
+    // with split_update_chunk_job into jobs for groups of its pending sub chunks so the sub chunks of a column
+    // are meshed on many workers at once
     struct Update_Chunk_Job alignas(std::hardware_constructive_interference_size)
     {
         World *world;
         Chunk *chunk;
+        u32    sub_chunk_mask;
+        static constexpr JobType Type = JobType_UpdateChunk;
         static void execute(void* job_data, Temprary_Memory_Arena *temp_arena);
     };
 
+    // note(harlequin): returns the number of jobs written to jobs (at most Chunk::SubChunkCount)
+    u32 split_update_chunk_job(const Update_Chunk_Job& job, u32 group_size, Update_Chunk_Job *jobs);
+
     struct Serialize_Chunk_Job alignas(std::hardware_constructive_interference_size)
     {
         World *world;
         Chunk *chunk;
+        static constexpr JobType Type = JobType_SerializeChunk;
         static void execute(void* job_data, Temprary_Memory_Arena *temp_arena);
     };
 
@@ -50,6 +97,27 @@ namespace minecraft {
     {
         World *world;
         Chunk *chunk;
+        static constexpr JobType Type = JobType_SerializeAndFreeChunk;
+        static void execute(void* job_data, Temprary_Memory_Arena *temp_arena);
+    };
+
+    // note(harlequin): saves the blocks of a chunk that left the region the light passes can reach and builds the lod
+    // cells it was given, the main thread gives the blocks back to the world once the chunk is ChunkState_BlocksSaved
+    struct Serialize_Chunk_Blocks_Job alignas(std::hardware_constructive_interference_size)
+    {
+        World *world;
+        Chunk *chunk;
+        static constexpr JobType Type = JobType_SerializeChunkBlocks;
+        static void execute(void* job_data, Temprary_Memory_Arena *temp_arena);
+    };
+
+    // note(harlequin): the occluders of a frame are rasterized while the main thread finishes the frame, the job
+    // does nothing when the main thread needed the occlusion buffer first and rasterized the frame itself
+    struct Rasterize_Occluders_Job alignas(std::hardware_constructive_interference_size)
+    {
+        Occlusion_Buffer *occlusion_buffer;
+        u64               frame_index;
+        static constexpr JobType Type = JobType_RasterizeOccluders;
         static void execute(void* job_data, Temprary_Memory_Arena *temp_arena);
     };
 }
\ No newline at end of file
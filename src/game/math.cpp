@@ -3,6 +3,13 @@
 #include "renderer/camera.h"
 #include "math.h"
 
+#if defined(_M_X64) || defined(__SSE2__)
+#define MC_SSE2 1
+#include <emmintrin.h>
+#else
+#define MC_SSE2 0
+#endif
+
 namespace minecraft {
 
     Rectangle rectangle(const glm::vec2& top_left,
@@ -173,6 +180,15 @@ namespace minecraft {
         points[5] = intersection<Left, Top, Far>(crosses);
         points[6] = intersection<Right, Bottom, Far>(crosses);
         points[7] = intersection<Right, Top, Far>(crosses);
+
+        points_min = points[0];
+        points_max = points[0];
+
+        for (i32 i = 1; i < 8; i++)
+        {
+            points_min = glm::min(points_min, points[i]);
+            points_max = glm::max(points_max, points[i]);
+        }
     }
 
     // http://iquilezles.org/www/articles/frustumcorrect/frustumcorrect.htm
@@ -208,4 +224,78 @@ namespace minecraft {
 
         return true;
     }
+
+    u32 Frustum::get_visible_aabb_mask(const AABB_Batch *batch) const
+    {
+        Assert(batch->count <= AABB_Batch::Capacity);
+
+        u32 visible_mask = 0;
+
+#if MC_SSE2
+        // note(harlequin): the plane distances are summed in the order glm::dot sums them so a box that
+        // touches a plane lands on the same side as it does in is_aabb_visible
+        for (u32 i = 0; i < batch->count; i += 4)
+        {
+            __m128 min_x = _mm_load_ps(batch->min_x + i);
+            __m128 min_y = _mm_load_ps(batch->min_y + i);
+            __m128 min_z = _mm_load_ps(batch->min_z + i);
+            __m128 max_x = _mm_load_ps(batch->max_x + i);
+            __m128 max_y = _mm_load_ps(batch->max_y + i);
+            __m128 max_z = _mm_load_ps(batch->max_z + i);
+
+            __m128 outside = _mm_or_ps(_mm_cmpgt_ps(_mm_set1_ps(points_min.x), max_x),
+                                       _mm_cmplt_ps(_mm_set1_ps(points_max.x), min_x));
+            outside = _mm_or_ps(outside, _mm_cmpgt_ps(_mm_set1_ps(points_min.y), max_y));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_set1_ps(points_max.y), min_y));
+            outside = _mm_or_ps(outside, _mm_cmpgt_ps(_mm_set1_ps(points_min.z), max_z));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_set1_ps(points_max.z), min_z));
+
+            for (i32 plane_index = 0; plane_index < Count; plane_index++)
+            {
+                const glm::vec4& plane = planes[plane_index];
+
+                __m128 x = plane.x >= 0.0f ? max_x : min_x;
+                __m128 y = plane.y >= 0.0f ? max_y : min_y;
+                __m128 z = plane.z >= 0.0f ? max_z : min_z;
+
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), x),
+                                                        _mm_mul_ps(_mm_set1_ps(plane.y), y)),
+                                             _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.z), z),
+                                                        _mm_set1_ps(plane.w)));
+
+                outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_setzero_ps()));
+            }
+
+            visible_mask |= ((u32)_mm_movemask_ps(outside) ^ 0xF) << i;
+        }
+#else
+        for (u32 i = 0; i < batch->count; i++)
+        {
+            bool is_outside = points_min.x > batch->max_x[i] || points_max.x < batch->min_x[i] ||
+                              points_min.y > batch->max_y[i] || points_max.y < batch->min_y[i] ||
+                              points_min.z > batch->max_z[i] || points_max.z < batch->min_z[i];
+
+            for (i32 plane_index = 0; plane_index < Count && !is_outside; plane_index++)
+            {
+                const glm::vec4& plane = planes[plane_index];
+
+                f32 x = plane.x >= 0.0f ? batch->max_x[i] : batch->min_x[i];
+                f32 y = plane.y >= 0.0f ? batch->max_y[i] : batch->min_y[i];
+                f32 z = plane.z >= 0.0f ? batch->max_z[i] : batch->min_z[i];
+
+                is_outside = (plane.x * x + plane.y * y) + (plane.z * z + plane.w) < 0.0f;
+            }
+
+            visible_mask |= (u32)!is_outside << i;
+        }
+#endif
+
+        // note(harlequin): the lanes past the end of the batch are garbage
+        if (batch->count < AABB_Batch::Capacity)
+        {
+            visible_mask &= (1u << batch->count) - 1;
+        }
+
+        return visible_mask;
+    }
 }
\ No newline at end of file
@@ -73,6 +73,41 @@ namespace minecraft {
         glm::vec3 max;
     };
 
+    // note(harlequin): aabbs stored one array per component so a plane is tested against four of them at once
+    struct alignas(16) AABB_Batch
+    {
+        static constexpr u32 Capacity = 32;
+
+        f32 min_x[Capacity];
+        f32 min_y[Capacity];
+        f32 min_z[Capacity];
+        f32 max_x[Capacity];
+        f32 max_y[Capacity];
+        f32 max_z[Capacity];
+
+        u32 count;
+    };
+
+    static_assert(AABB_Batch::Capacity % 4 == 0, "an aabb batch is tested four aabbs at a time");
+
+    inline void set_aabb_batch_entry(AABB_Batch *batch, u32 index, const AABB& aabb)
+    {
+        Assert(index < AABB_Batch::Capacity);
+        batch->min_x[index] = aabb.min.x;
+        batch->min_y[index] = aabb.min.y;
+        batch->min_z[index] = aabb.min.z;
+        batch->max_x[index] = aabb.max.x;
+        batch->max_y[index] = aabb.max.y;
+        batch->max_z[index] = aabb.max.z;
+    }
+
+    inline AABB get_aabb_batch_entry(const AABB_Batch *batch, u32 index)
+    {
+        Assert(index < batch->count);
+        return { { batch->min_x[index], batch->min_y[index], batch->min_z[index] },
+                 { batch->max_x[index], batch->max_y[index], batch->max_z[index] } };
+    }
+
     struct Ray
     {
         glm::vec3 origin;
@@ -113,11 +148,19 @@ namespace minecraft {
         glm::vec4 planes[Count];
         glm::vec3 points[8];
 
+        // note(harlequin): the bounds of the corner points, a box is out if every point is on the far side of one of its faces
+        glm::vec3 points_min;
+        glm::vec3 points_max;
+
         void initialize(const glm::mat4& camera_projection_mul_view);
 
         void update(const glm::mat4& camera_projection_mul_view);
         bool is_aabb_visible(const AABB& aabb) const;
 
+        // note(harlequin): the same test as is_aabb_visible for every aabb in the batch, bit i is set if aabb i
+        // is visible, a box is out of a plane if the corner furthest along the plane normal is
+        u32 get_visible_aabb_mask(const AABB_Batch *batch) const;
+
     private:
         template< Planes i, Planes j >
         struct ij2k
@@ -4,11 +4,13 @@
 #include "game/world.h"
 #include "game/game.h"
 #include "game/game_assets.h"
+#include "game/job_system.h"
 #include "core/input.h"
 #include "ui/ui.h"
 #include "renderer/opengl_renderer.h"
 #include "renderer/opengl_debug_renderer.h"
 #include "renderer/opengl_2d_renderer.h"
+#include "meshing/sub_chunk_mesher.h"
 
 namespace minecraft {
 
@@ -112,8 +114,44 @@ namespace minecraft {
                                                        "light level: %d",
                                                        glm::max(sky_light_level, (i32)light_info->light_source_level));
 
+            debug_state->block_facing_normal_exposed_to_sky_text =
+                push_string8(frame_arena,
+                             "exposed to sky: %s",
+                             is_block_exposed_to_sky(select_query->block_facing_normal_query.chunk, block_coords) ? "yes" : "no");
         }
 
+        debug_state->block_edit_light_update_time_text =
+            push_string8(frame_arena,
+                         "last edit light update: %.2f us",
+                         world->last_block_edit_light_update_time / 1000.0);
+
+        u64 dirty_sub_chunk_mark_count  = world->dirty_sub_chunk_mark_count;
+        u64 dirty_sub_chunk_flush_count = world->dirty_sub_chunk_flush_count;
+
+        debug_state->dirty_sub_chunk_text =
+            push_string8(frame_arena,
+                         "sub chunk updates: %llu requested, %llu queued, %llu avoided",
+                         dirty_sub_chunk_mark_count,
+                         dirty_sub_chunk_flush_count,
+                         dirty_sub_chunk_mark_count > dirty_sub_chunk_flush_count ? dirty_sub_chunk_mark_count - dirty_sub_chunk_flush_count : 0);
+
+        debug_state->column_remesh_latency_text =
+            push_string8(frame_arena,
+                         "column remesh latency: last %.2f ms, max %.2f ms (%u sub chunks per job)",
+                         world->last_column_remesh_latency / 1000000.0,
+                         world->max_column_remesh_latency / 1000000.0,
+                         world->sub_chunk_mesh_job_group_size.load());
+
+        Sub_Chunk_Patch_Stats patch_stats = get_sub_chunk_patch_stats();
+
+        debug_state->sub_chunk_patch_text =
+            push_string8(frame_arena,
+                         "sub chunk patches: %llu, rebuilds: %llu, last: %.2f us (%u blocks)",
+                         patch_stats.patch_count,
+                         patch_stats.rebuild_count,
+                         patch_stats.last_patch_time / 1000.0,
+                         patch_stats.last_patched_block_count);
+
         const Opengl_Renderer_Stats *stats = opengl_renderer_get_stats();
 
         debug_state->frames_per_second_text =
@@ -136,20 +174,50 @@ namespace minecraft {
                          "face count: %u",
                          stats->per_frame.face_count);
 
+        debug_state->frustum_culling_text =
+            push_string8(frame_arena,
+                         "frustum culling: %d/%d columns visible, %d sub chunks drawn, %d culled",
+                         stats->per_frame.visible_chunk_column_count,
+                         stats->per_frame.chunk_column_count,
+                         stats->per_frame.sub_chunk_count,
+                         stats->per_frame.culled_sub_chunk_count);
+
+        debug_state->occlusion_culling_text =
+            push_string8(frame_arena,
+                         "occlusion culling: %u sub chunks reached in %.2f us, %d sub chunks (%d faces) hidden",
+                         world->reachable_sub_chunk_count,
+                         world->last_visibility_pass_time / 1000.0,
+                         stats->per_frame.occluded_sub_chunk_count,
+                         stats->per_frame.occluded_face_count);
+
+        const Occlusion_Buffer *occlusion_buffer = game_state->occlusion_buffer;
+
+        debug_state->occlusion_buffer_text =
+            push_string8(frame_arena,
+                         "occlusion buffer: %u/%u occluders (%u triangles) in %.2f us + %.2f us, %d sub chunks (%d faces) hidden",
+                         occlusion_buffer->occluder_count,
+                         occlusion_buffer->candidate_occluder_count,
+                         occlusion_buffer->rasterized_triangle_count,
+                         occlusion_buffer->gather_time / 1000.0,
+                         occlusion_buffer->rasterize_time / 1000.0,
+                         stats->per_frame.depth_occluded_sub_chunk_count,
+                         stats->per_frame.depth_occluded_face_count);
+
         debug_state->sub_chunk_bucket_capacity_text =
             push_string8(frame_arena,
                          "sub chunk bucket capacity: %llu",
                          World::SubChunkBucketCapacity);
 
-        i64 sub_chunk_bucket_count = World::SubChunkBucketCapacity - opengl_renderer_get_free_chunk_bucket_count();
+        Buddy_Allocator_Stats bucket_stats = opengl_renderer_get_sub_chunk_bucket_stats();
+
         debug_state->sub_chunk_bucket_count_text =
             push_string8(frame_arena,
-                         "sub chunk buckets: %llu",
-                         sub_chunk_bucket_count);
+                         "sub chunk buckets: %u",
+                         bucket_stats.allocation_count);
 
         {
             f64 total_size =
-                (World::SubChunkBucketCapacity * World::SubChunkBucketSize) / (1024.0 * 1024.0);
+                (bucket_stats.unit_count * sizeof(Block_Face)) / (1024.0 * 1024.0);
 
             debug_state->sub_chunk_bucket_total_memory_text =
                 push_string8(frame_arena,
@@ -159,7 +227,7 @@ namespace minecraft {
 
         {
             f64 total_size =
-                (sub_chunk_bucket_count * World::SubChunkBucketSize) / (1024.0 * 1024.0);
+                (bucket_stats.allocated_unit_count * sizeof(Block_Face)) / (1024.0 * 1024.0);
             debug_state->sub_chunk_bucket_allocated_memory_text =
                 push_string8(frame_arena,
                              "buckets allocated memory: %.2f mb",
@@ -175,6 +243,72 @@ namespace minecraft {
                              total_size);
         }
 
+        {
+            f64 total_size =
+                (bucket_stats.cached_unit_count * sizeof(Block_Face)) / (1024.0 * 1024.0);
+            debug_state->sub_chunk_bucket_cached_memory_text =
+                push_string8(frame_arena,
+                             "buckets cached memory: %.2f mb",
+                             total_size);
+        }
+
+        {
+            // note(harlequin): the share of the free memory that is not in the largest free run
+            f64 fragmentation = 0.0;
+            if (bucket_stats.free_unit_count)
+            {
+                fragmentation = 100.0 * (1.0 - (f64)bucket_stats.largest_free_block_unit_count / (f64)bucket_stats.free_unit_count);
+            }
+
+            debug_state->sub_chunk_bucket_fragmentation_text =
+                push_string8(frame_arena,
+                             "buckets fragmentation: %.2f%% (%u free runs, largest %llu faces)",
+                             fragmentation,
+                             bucket_stats.free_block_count,
+                             bucket_stats.largest_free_block_unit_count);
+        }
+
+        debug_state->sub_chunk_bucket_relocated_text =
+            push_string8(frame_arena,
+                         "buckets relocated: %llu",
+                         stats->persistent.relocated_sub_chunk_bucket_count.load());
+
+        {
+            Retire_Queue_Stats retire_stats = opengl_renderer_get_retired_sub_chunk_bucket_stats();
+            f64 total_size = (retire_stats.unit_count * sizeof(Block_Face)) / (1024.0 * 1024.0);
+
+            debug_state->sub_chunk_bucket_retired_text =
+                push_string8(frame_arena,
+                             "buckets retired: %u (%.2f mb) waiting for the gpu, %llu freed",
+                             retire_stats.run_count,
+                             total_size,
+                             retire_stats.total_freed_run_count);
+        }
+
+        {
+            // note(harlequin): how many sub chunks draw each cached mesh and the memory their copies would take
+            Sub_Chunk_Mesh_Cache_Stats cache_stats = opengl_renderer_get_sub_chunk_mesh_cache_stats();
+
+            f64 dedupe_ratio = 1.0;
+            if (cache_stats.mesh_count)
+            {
+                dedupe_ratio = (f64)cache_stats.sub_chunk_count / (f64)cache_stats.mesh_count;
+            }
+
+            f64 saved_size = (cache_stats.shared_face_count * sizeof(Block_Face)) / (1024.0 * 1024.0);
+
+            debug_state->sub_chunk_mesh_cache_text =
+                push_string8(frame_arena,
+                             "mesh cache: %u sub chunks draw %u meshes (%.2fx), %.2f mb saved, %llu hits %llu misses %llu collisions",
+                             cache_stats.sub_chunk_count,
+                             cache_stats.mesh_count,
+                             dedupe_ratio,
+                             saved_size,
+                             cache_stats.hit_count,
+                             cache_stats.miss_count,
+                             cache_stats.collision_count);
+        }
+
         debug_state->player_position_text =
             push_string8(frame_arena,
                          "position: (%.2f, %.2f, %.2f)",
@@ -217,6 +351,10 @@ namespace minecraft {
                 {
                     return "LightCalculated";
                 } break;
+                case ChunkState_BlocksSaved:
+                {
+                    return "BlocksSaved";
+                } break;
                 case ChunkState_PendingForSave:
                 {
                     return "PendingForSave";
@@ -284,14 +422,89 @@ namespace minecraft {
 
         debug_state->chunk_radius_text =
             push_string8(frame_arena,
-                         "chunk radius: %d",
-                         game_config->chunk_radius);
+                         "chunk radius: %d, lod chunk radius: %d, far chunk radius: %d",
+                         game_config->chunk_radius,
+                         game_config->lod_chunk_radius,
+                         game_config->far_chunk_radius);
 
         debug_state->global_sky_light_level_text =
             push_string8(frame_arena,
                          "global sky light level: %d",
                          (u32)world->sky_light_level);
 
+        {
+            const Job_System_Data &job_system_data = Job_System::internal_data;
+
+            u32 max_high_priority_job_count = 0;
+            u32 max_low_priority_job_count  = 0;
+
+            for (u32 i = 0; i < job_system_data.queue_depth_sample_count; i++)
+            {
+                const Job_Queue_Depth_Sample &sample = job_system_data.queue_depth_samples[i];
+                max_high_priority_job_count = glm::max(max_high_priority_job_count, sample.high_priority_job_count);
+                max_low_priority_job_count  = glm::max(max_low_priority_job_count,  sample.low_priority_job_count);
+            }
+
+            debug_state->job_queue_depth_text =
+                push_string8(frame_arena,
+                             "queue depth: high %u (max %u), low %u (max %u)",
+                             Job_System::get_queue_job_count(&job_system_data.high_priority_queue),
+                             max_high_priority_job_count,
+                             Job_System::get_queue_job_count(&job_system_data.low_priority_queue),
+                             max_low_priority_job_count);
+
+            u64 executed_job_count  = 0;
+            u64 contended_pop_count = 0;
+            f64 min_utilization     = 1.0;
+            f64 max_utilization     = 0.0;
+
+            for (u32 i = 0; i < job_system_data.thread_count; i++)
+            {
+                const Worker_Thread_Stats &stats = job_system_data.worker_thread_stats[i];
+                executed_job_count  += stats.executed_job_count;
+                contended_pop_count += stats.contended_pop_count;
+
+                u64 busy_time  = stats.busy_time;
+                u64 total_time = busy_time + stats.idle_time;
+                f64 utilization = total_time ? (f64)busy_time / (f64)total_time : 0.0;
+                min_utilization = glm::min(min_utilization, utilization);
+                max_utilization = glm::max(max_utilization, utilization);
+            }
+
+            debug_state->job_worker_thread_count_text =
+                push_string8(frame_arena,
+                             "workers: %u, executed jobs: %llu",
+                             job_system_data.thread_count,
+                             executed_job_count);
+
+            debug_state->job_worker_utilization_text =
+                push_string8(frame_arena,
+                             "worker utilization: %.1f%% - %.1f%%",
+                             min_utilization * 100.0,
+                             max_utilization * 100.0);
+
+            debug_state->job_contended_pop_count_text =
+                push_string8(frame_arena,
+                             "contended pops: %llu",
+                             contended_pop_count);
+
+            for (u32 i = 0; i < JobType_Count; i++)
+            {
+                const Job_Type_Stats &stats = job_system_data.job_type_stats[i];
+                u64 job_count = stats.executed_job_count;
+                f64 divisor   = job_count ? (f64)job_count : 1.0;
+
+                debug_state->job_type_stats_texts[i] =
+                    push_string8(frame_arena,
+                                 "%s: %llu, avg %.2f ms, p99 < %.2f ms, latency avg %.2f ms",
+                                 convert_job_type_to_cstring((JobType)i),
+                                 job_count,
+                                 stats.total_execution_time / divisor / 1000000.0,
+                                 Job_System::get_histogram_percentile(stats.execution_time_histogram, 0.99) / 1000.0,
+                                 stats.total_latency / divisor / 1000000.0);
+            }
+        }
+
         u32 hours;
         u32 minutes;
         u32 seconds;
@@ -329,6 +542,11 @@ namespace minecraft {
         ui_label(UIName("block_facing_normal_sky_light_level_text"), debug_state->block_facing_normal_sky_light_level_text);
         ui_label(UIName("block_facing_normal_light_source_level_text"), debug_state->block_facing_normal_light_source_level_text);
         ui_label(UIName("block_facing_normal_light_level_text"), debug_state->block_facing_normal_light_level_text);
+        ui_label(UIName("block_facing_normal_exposed_to_sky_text"), debug_state->block_facing_normal_exposed_to_sky_text);
+        ui_label(UIName("block_edit_light_update_time_text"), debug_state->block_edit_light_update_time_text);
+        ui_label(UIName("dirty_sub_chunk_text"), debug_state->dirty_sub_chunk_text);
+        ui_label(UIName("sub_chunk_patch_text"), debug_state->sub_chunk_patch_text);
+        ui_label(UIName("column_remesh_latency_text"), debug_state->column_remesh_latency_text);
         ui_end_panel();}
 
         {ui_begin_panel(UIName("Rendering"));
@@ -336,11 +554,19 @@ namespace minecraft {
         ui_label(UIName("frame_time_text"), debug_state->frame_time_text);
         ui_label(UIName("face_count_text"), debug_state->face_count_text);
         ui_label(UIName("vertex_count_text"), debug_state->vertex_count_text);
+        ui_label(UIName("frustum_culling_text"), debug_state->frustum_culling_text);
+        ui_label(UIName("occlusion_culling_text"), debug_state->occlusion_culling_text);
+        ui_label(UIName("occlusion_buffer_text"), debug_state->occlusion_buffer_text);
         ui_label(UIName("sub_chunk_bucket_capacity_text"), debug_state->sub_chunk_bucket_capacity_text);
         ui_label(UIName("sub_chunk_bucket_count_text"), debug_state->sub_chunk_bucket_count_text);
         ui_label(UIName("sub_chunk_bucket_total_memory_text"), debug_state->sub_chunk_bucket_total_memory_text);
         ui_label(UIName("sub_chunk_bucket_allocated_memory_text"), debug_state->sub_chunk_bucket_allocated_memory_text);
         ui_label(UIName("sub_chunk_bucket_used_memory_text"), debug_state->sub_chunk_bucket_used_memory_text);
+        ui_label(UIName("sub_chunk_bucket_cached_memory_text"), debug_state->sub_chunk_bucket_cached_memory_text);
+        ui_label(UIName("sub_chunk_bucket_fragmentation_text"), debug_state->sub_chunk_bucket_fragmentation_text);
+        ui_label(UIName("sub_chunk_bucket_relocated_text"), debug_state->sub_chunk_bucket_relocated_text);
+        ui_label(UIName("sub_chunk_bucket_retired_text"), debug_state->sub_chunk_bucket_retired_text);
+        ui_label(UIName("sub_chunk_mesh_cache_text"), debug_state->sub_chunk_mesh_cache_text);
         ui_toggle(UIName("FXAA"), opengl_renderer_is_fxaa_enabled());
 
         ui_end_panel();}
@@ -351,6 +577,20 @@ namespace minecraft {
         ui_label(UIName("chunk_radius_text"), debug_state->global_sky_light_level_text);
         ui_end_panel();}
 
+        {ui_begin_panel(UIName("Job System"));
+        ui_label(UIName("job_queue_depth_text"), debug_state->job_queue_depth_text);
+        ui_label(UIName("job_worker_thread_count_text"), debug_state->job_worker_thread_count_text);
+        ui_label(UIName("job_worker_utilization_text"), debug_state->job_worker_utilization_text);
+        ui_label(UIName("job_contended_pop_count_text"), debug_state->job_contended_pop_count_text);
+        ui_label(UIName("job_load_chunk_stats_text"), debug_state->job_type_stats_texts[JobType_LoadChunk]);
+        ui_label(UIName("job_propagate_chunk_light_stats_text"), debug_state->job_type_stats_texts[JobType_PropagateChunkLight]);
+        ui_label(UIName("job_update_chunk_stats_text"), debug_state->job_type_stats_texts[JobType_UpdateChunk]);
+        ui_label(UIName("job_serialize_chunk_stats_text"), debug_state->job_type_stats_texts[JobType_SerializeChunk]);
+        ui_label(UIName("job_serialize_and_free_chunk_stats_text"), debug_state->job_type_stats_texts[JobType_SerializeAndFreeChunk]);
+        ui_label(UIName("job_rasterize_occluders_stats_text"), debug_state->job_type_stats_texts[JobType_RasterizeOccluders]);
+        ui_label(UIName("job_serialize_chunk_blocks_stats_text"), debug_state->job_type_stats_texts[JobType_SerializeChunkBlocks]);
+        ui_end_panel();}
+
         ui_pop_style(StyleVar_TextColor);
         ui_pop_style(StyleVar_BorderColor);
         ui_pop_style(StyleVar_BackgroundColor);
@@ -2,6 +2,7 @@
 
 #include "core/common.h"
 #include "containers/string.h"
+#include "game/jobs.h"
 
 #include <glm/glm.hpp>
 
@@ -19,11 +20,19 @@ namespace minecraft {
         String8 frame_time_text;
         String8 vertex_count_text;
         String8 face_count_text;
+        String8 frustum_culling_text;
+        String8 occlusion_culling_text;
+        String8 occlusion_buffer_text;
         String8 sub_chunk_bucket_capacity_text;
         String8 sub_chunk_bucket_count_text;
         String8 sub_chunk_bucket_total_memory_text;
         String8 sub_chunk_bucket_allocated_memory_text;
         String8 sub_chunk_bucket_used_memory_text;
+        String8 sub_chunk_bucket_cached_memory_text;
+        String8 sub_chunk_bucket_fragmentation_text;
+        String8 sub_chunk_bucket_relocated_text;
+        String8 sub_chunk_bucket_retired_text;
+        String8 sub_chunk_mesh_cache_text;
         String8 player_position_text;
         String8 player_chunk_coords_text;
         String8 player_chunk_state_text;
@@ -37,6 +46,16 @@ namespace minecraft {
         String8 block_facing_normal_sky_light_level_text;
         String8 block_facing_normal_light_source_level_text;
         String8 block_facing_normal_light_level_text;
+        String8 block_facing_normal_exposed_to_sky_text;
+        String8 block_edit_light_update_time_text;
+        String8 dirty_sub_chunk_text;
+        String8 sub_chunk_patch_text;
+        String8 column_remesh_latency_text;
+        String8 job_queue_depth_text;
+        String8 job_worker_thread_count_text;
+        String8 job_worker_utilization_text;
+        String8 job_contended_pop_count_text;
+        String8 job_type_stats_texts[JobType_Count];
     };
 
     void collect_visual_debugging_data(Game_Debug_State      *debug_state,
@@ -45,7 +45,7 @@ namespace minecraft {
 
         fclose(meta_file);
 
-        for (u32 i = 0; i < World::ChunkCapacity; i++)
+        for (u32 i = 0; i < World::ChunkHashTableCapacity; i++)
         {
             set_entry_state(world->chunk_hash_table_values[i], ChunkHashTableEntryState_Empty);
         }
@@ -62,9 +62,58 @@ namespace minecraft {
         world->free_chunk_count      = World::ChunkCapacity;
         world->first_free_chunk_node = &world->chunk_nodes[0];
 
+        Chunk_Blocks_Node *last_chunk_blocks_node = &world->chunk_blocks_nodes[World::ChunkBlocksCapacity - 1];
+        last_chunk_blocks_node->next              = nullptr;
+
+        for (u32 i = 0; i < World::ChunkBlocksCapacity - 1; i++)
+        {
+            Chunk_Blocks_Node *chunk_blocks_node = world->chunk_blocks_nodes + i;
+            chunk_blocks_node->next = world->chunk_blocks_nodes + i + 1;
+        }
+
+        world->free_chunk_blocks_count      = World::ChunkBlocksCapacity;
+        world->first_free_chunk_blocks_node = &world->chunk_blocks_nodes[0];
+
+        Chunk_Lod_Cells_Node *last_chunk_lod_cells_node = &world->chunk_lod_cells_nodes[World::ChunkLodCellsCapacity - 1];
+        last_chunk_lod_cells_node->next                 = nullptr;
+
+        for (u32 i = 0; i < World::ChunkLodCellsCapacity - 1; i++)
+        {
+            Chunk_Lod_Cells_Node *chunk_lod_cells_node = world->chunk_lod_cells_nodes + i;
+            chunk_lod_cells_node->next = world->chunk_lod_cells_nodes + i + 1;
+        }
+
+        world->free_chunk_lod_cells_count      = World::ChunkLodCellsCapacity;
+        world->first_free_chunk_lod_cells_node = &world->chunk_lod_cells_nodes[0];
+
+        world->loaded_chunk_count           = 0;
+        world->pending_free_chunk_count     = 0;
+        world->has_pending_chunk_insertions = true;
+
+        new (&world->light_pass_mutex) std::mutex;
+        new (&world->update_chunk_jobs_queue_mutex) std::mutex;
+        new (&world->dirty_chunks_mutex) std::mutex;
+        new (&world->block_edits_drained_cv) std::condition_variable;
+
         world->update_chunk_jobs_queue.initialize();
         world->calculate_chunk_lighting_queue.initialize();
         world->light_propagation_queue.initialize();
+        world->block_edits_queue.initialize();
+        world->deferred_block_edit_count         = 0;
+        world->last_block_edit_light_update_time = 0;
+        world->dirty_sub_chunk_mark_count        = 0;
+        world->dirty_sub_chunk_flush_count       = 0;
+        world->dirty_chunk_count                 = 0;
+        world->lod_chunk_radius                  = World::MaxChunkRadius;
+        world->far_chunk_radius                  = World::MaxFarChunkRadius;
+        world->sub_chunk_mesh_job_group_size     = World::DefaultSubChunkMeshJobGroupSize;
+        world->last_column_remesh_latency        = 0;
+        world->max_column_remesh_latency         = 0;
+        world->active_chunk_count                = 0;
+        world->pending_light_chunk_count         = 0;
+        world->visibility_pass_index             = 0;
+        world->reachable_sub_chunk_count         = 0;
+        world->last_visibility_pass_time         = 0;
 
         world->game_timer     = 0.0f;
         world->game_time_rate = 1.0f / 72.0f; // 1 / 72.0f is the number used by minecraft
@@ -123,7 +172,11 @@ namespace minecraft {
 
     Chunk *allocate_chunk(World *world)
     {
-        Assert(world->free_chunk_count);
+        if (!world->free_chunk_count)
+        {
+            return nullptr;
+        }
+
         world->free_chunk_count--;
         Chunk_Node *chunk_node       = world->first_free_chunk_node;
         world->first_free_chunk_node = world->first_free_chunk_node->next;
@@ -140,11 +193,50 @@ namespace minecraft {
         world->first_free_chunk_node = chunk_node;
     }
 
-    static inline u16 get_chunk_node_index(World *world, Chunk *chunk)
+    Chunk_Blocks *allocate_chunk_blocks(World *world)
     {
-        Chunk_Node *chunk_node = (Chunk_Node*)chunk;
-        Assert(chunk_node >= world->chunk_nodes && chunk_node <= world->chunk_nodes + World::ChunkCapacity);
-        return (u16)(chunk_node - world->chunk_nodes);
+        if (!world->free_chunk_blocks_count)
+        {
+            return nullptr;
+        }
+
+        world->free_chunk_blocks_count--;
+        Chunk_Blocks_Node *chunk_blocks_node = world->first_free_chunk_blocks_node;
+        world->first_free_chunk_blocks_node  = world->first_free_chunk_blocks_node->next;
+        return &chunk_blocks_node->chunk_blocks;
+    }
+
+    void free_chunk_blocks(World *world, Chunk_Blocks *chunk_blocks)
+    {
+        Assert(chunk_blocks);
+        Chunk_Blocks_Node *chunk_blocks_node = (Chunk_Blocks_Node*)chunk_blocks;
+        Assert(chunk_blocks_node >= world->chunk_blocks_nodes && chunk_blocks_node < world->chunk_blocks_nodes + World::ChunkBlocksCapacity);
+        world->free_chunk_blocks_count++;
+        chunk_blocks_node->next             = world->first_free_chunk_blocks_node;
+        world->first_free_chunk_blocks_node = chunk_blocks_node;
+    }
+
+    Chunk_Lod_Cells *allocate_chunk_lod_cells(World *world)
+    {
+        if (!world->free_chunk_lod_cells_count)
+        {
+            return nullptr;
+        }
+
+        world->free_chunk_lod_cells_count--;
+        Chunk_Lod_Cells_Node *chunk_lod_cells_node = world->first_free_chunk_lod_cells_node;
+        world->first_free_chunk_lod_cells_node     = world->first_free_chunk_lod_cells_node->next;
+        return &chunk_lod_cells_node->chunk_lod_cells;
+    }
+
+    void free_chunk_lod_cells(World *world, Chunk_Lod_Cells *chunk_lod_cells)
+    {
+        Assert(chunk_lod_cells);
+        Chunk_Lod_Cells_Node *chunk_lod_cells_node = (Chunk_Lod_Cells_Node*)chunk_lod_cells;
+        Assert(chunk_lod_cells_node >= world->chunk_lod_cells_nodes && chunk_lod_cells_node < world->chunk_lod_cells_nodes + World::ChunkLodCellsCapacity);
+        world->free_chunk_lod_cells_count++;
+        chunk_lod_cells_node->next             = world->first_free_chunk_lod_cells_node;
+        world->first_free_chunk_lod_cells_node = chunk_lod_cells_node;
     }
 
     Chunk* insert_and_allocate_chunk(World            *world,
@@ -157,7 +249,7 @@ namespace minecraft {
 
         do
         {
-            u16 &entry = world->chunk_hash_table_values[index];
+            u32 &entry = world->chunk_hash_table_values[index];
             ChunkHashTableEntryState state = get_entry_state(entry);
 
             if (state == ChunkHashTableEntryState_Empty)
@@ -193,11 +285,11 @@ namespace minecraft {
 
         Chunk *chunk = nullptr;
 
-        if (!found)
+        if (!found && world->free_chunk_count)
         {
             chunk = allocate_chunk(world);
             u16 chunk_node_index = get_chunk_node_index(world, chunk);
-            u16 &entry = world->chunk_hash_table_values[insertion_index];
+            u32 &entry = world->chunk_hash_table_values[insertion_index];
             set_entry_state(entry, ChunkHashTableEntryState_Occupied);
             set_entry_value(entry, chunk_node_index);
             world->chunk_hash_table_keys[insertion_index] = chunk_coords;
@@ -213,7 +305,7 @@ namespace minecraft {
 
         do
         {
-            u16 &entry = world->chunk_hash_table_values[index];
+            u32 &entry = world->chunk_hash_table_values[index];
             ChunkHashTableEntryState state = get_entry_state(entry);
             if (state == ChunkHashTableEntryState_Empty)
             {
@@ -244,7 +336,7 @@ namespace minecraft {
 
         do
         {
-            u16 &entry = world->chunk_hash_table_values[index];
+            u32 &entry = world->chunk_hash_table_values[index];
             ChunkHashTableEntryState state = get_entry_state(entry);
             if (state == ChunkHashTableEntryState_Empty)
             {
@@ -268,54 +360,366 @@ namespace minecraft {
         return false;
     }
 
-    void load_and_update_chunks(World *world, const World_Region_Bounds& region_bounds)
+    // note(harlequin): the neighbour a chunk looked up last time may have been freed since and its node reused
+    static Chunk *update_chunk_neighbour(World *world, Chunk *chunk, i32 neighbour_index)
+    {
+        glm::ivec2 neighbour_chunk_coords = chunk->world_coords + Chunk::NeighbourDirections[neighbour_index];
+
+        Chunk *neighbour_chunk = chunk->neighbours[neighbour_index];
+
+        if (!neighbour_chunk ||
+            neighbour_chunk->world_coords != neighbour_chunk_coords ||
+            neighbour_chunk->state >= ChunkState_PendingForSave)
+        {
+            neighbour_chunk = get_chunk(world, neighbour_chunk_coords);
+            chunk->neighbours[neighbour_index] = neighbour_chunk;
+        }
+
+        return neighbour_chunk;
+    }
+
+    // note(harlequin): the cells of a chunk are read from its lod cells, or downsampled from its blocks once they
+    // are loaded
+    static bool has_chunk_lod_cells_to_read(Chunk *chunk)
+    {
+        return chunk->has_lod_cells.load(std::memory_order_acquire) ||
+               (chunk->blocks && chunk->state != ChunkState_Initialized);
+    }
+
+    // note(harlequin): a near chunk is meshed by the light pass first and can be remeshed once it is lit, a far chunk
+    // as soon as the cells of its neighbours are there too
+    static bool is_chunk_meshable(Chunk *chunk, bool is_in_far_region)
+    {
+        if (!chunk->is_far.load(std::memory_order_relaxed))
+        {
+            return chunk->state == ChunkState_LightCalculated;
+        }
+
+        if (!is_in_far_region ||
+            chunk->state == ChunkState_Initialized ||
+            chunk->state >= ChunkState_PendingForSave ||
+            !has_chunk_lod_cells_to_read(chunk))
+        {
+            return false;
+        }
+
+        for (i32 i = 0; i < ChunkNeighbour_Count; i++)
+        {
+            Chunk *neighbour_chunk = chunk->neighbours[i];
+
+            if (!neighbour_chunk || !has_chunk_lod_cells_to_read(neighbour_chunk))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // note(harlequin): the update jobs of a chunk read the blocks and cells of its neighbours, the blocks and cells of
+    // a chunk are only given back while neither the chunk nor a neighbour has an update queued or running, checked with
+    // the light pass mutex held so no light pass can queue one in between
+    static bool is_chunk_neighbourhood_idle(Chunk *chunk)
+    {
+        if (chunk->tessellation_state == TessellationState_Pending)
+        {
+            return false;
+        }
+
+        for (i32 i = 0; i < ChunkNeighbour_Count; i++)
+        {
+            Chunk *neighbour_chunk = chunk->neighbours[i];
+
+            if (neighbour_chunk && neighbour_chunk->tessellation_state == TessellationState_Pending)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // note(harlequin): a chunk in the blocks region is given blocks and any other chunk lod cells, a chunk that finds
+    // its pool empty takes from the other one, a far chunk holding blocks trades them for cells once there are some
+    static bool give_chunk_storage(World *world, Chunk *chunk, bool is_in_blocks_region)
+    {
+        Chunk_Blocks    *chunk_blocks    = is_in_blocks_region ? allocate_chunk_blocks(world) : nullptr;
+        Chunk_Lod_Cells *chunk_lod_cells = chunk_blocks ? nullptr : allocate_chunk_lod_cells(world);
+
+        if (!chunk_blocks && !chunk_lod_cells && !is_in_blocks_region)
+        {
+            chunk_blocks = allocate_chunk_blocks(world);
+        }
+
+        if (chunk_blocks)
+        {
+            attach_chunk_blocks(chunk, chunk_blocks);
+        }
+
+        chunk->lod_cells = chunk_lod_cells;
+        return chunk_blocks || chunk_lod_cells;
+    }
+
+    static void release_chunk_lod_cells(World *world, Chunk *chunk)
+    {
+        chunk->has_lod_cells.store(false, std::memory_order_relaxed);
+        free_chunk_lod_cells(world, chunk->lod_cells);
+        chunk->lod_cells = nullptr;
+    }
+
+    static void mark_chunk_neighbour_meshes_outdated(Chunk *chunk)
+    {
+        for (i32 i = 0; i < ChunkNeighbour_Count; i++)
+        {
+            if (chunk->neighbours[i])
+            {
+                chunk->neighbours[i]->is_mesh_outdated = true;
+            }
+        }
+    }
+
+    void load_and_update_chunks(World *world,
+                                const World_Region_Bounds& region_bounds,
+                                Temprary_Memory_Arena *temp_arena)
     {
-        for (u32 i = 0; i < World::ChunkCapacity; i++)
         {
-            Chunk *chunk = &world->chunk_nodes[i].chunk;
-            if (chunk->state == ChunkState_Saved)
+            std::unique_lock light_pass_lock(world->light_pass_mutex, std::try_to_lock);
+
+            if (light_pass_lock.owns_lock())
             {
-                chunk->state = ChunkState_Freed;
-                free_chunk(world, chunk);
+                u32 pending_free_chunk_count = 0;
+
+                for (u32 i = 0; i < world->pending_free_chunk_count; i++)
+                {
+                    Chunk *chunk = world->pending_free_chunks[i];
+
+                    if (chunk->state != ChunkState_Saved || !is_chunk_neighbourhood_idle(chunk))
+                    {
+                        world->pending_free_chunks[pending_free_chunk_count++] = chunk;
+                        continue;
+                    }
+
+                    if (chunk->blocks)
+                    {
+                        free_chunk_blocks(world, detach_chunk_blocks(chunk));
+                    }
+
+                    if (chunk->lod_cells)
+                    {
+                        release_chunk_lod_cells(world, chunk);
+                    }
+
+                    chunk->state = ChunkState_Freed;
+                    free_chunk(world, chunk);
+                }
+
+                world->pending_free_chunk_count = pending_free_chunk_count;
             }
         }
 
-        world->first_active_sub_chunk_render_data_sentinal.next = nullptr;
-        world->last_active_sub_chunk_render_data = &world->first_active_sub_chunk_render_data_sentinal;
+        i32        chunk_radius        = (region_bounds.max.x - region_bounds.min.x) / 2;
+        i32        far_chunk_radius    = Max(world->far_chunk_radius, chunk_radius);
+        glm::ivec2 center_chunk_coords = (region_bounds.min + region_bounds.max) / 2;
+
+        Assert(chunk_radius <= World::MaxChunkRadius && far_chunk_radius <= World::MaxFarChunkRadius);
 
-        for (i32 z = region_bounds.min.y - World::PendingFreeChunkRadius;
-             z <= region_bounds.max.y + World::PendingFreeChunkRadius;
-             z++)
+        // note(harlequin): a chunk on the border of the active region never has all of its neighbours light propagated
+        // so only the ones inside it are ever lit, the chunks that hold blocks reach PendingFreeChunkRadius past the
+        // active region so every neighbour of an active chunk has blocks
+        World_Region_Bounds lit_region_bounds    = get_world_bounds_from_chunk_coords(Max(chunk_radius - 1, 0), center_chunk_coords);
+        World_Region_Bounds blocks_region_bounds = get_world_bounds_from_chunk_coords(chunk_radius + (i32)World::PendingFreeChunkRadius, center_chunk_coords);
+        World_Region_Bounds far_region_bounds    = get_world_bounds_from_chunk_coords(far_chunk_radius, center_chunk_coords);
+        World_Region_Bounds loaded_region_bounds = get_world_bounds_from_chunk_coords(far_chunk_radius + (i32)World::PendingFreeChunkRadius, center_chunk_coords);
+
+        world->active_chunk_count = 0;
+
+        if (world->has_pending_chunk_insertions ||
+            world->loaded_region_bounds.min != loaded_region_bounds.min ||
+            world->loaded_region_bounds.max != loaded_region_bounds.max)
         {
-            for (i32 x = region_bounds.min.x - World::PendingFreeChunkRadius;
-                 x <= region_bounds.max.x + World::PendingFreeChunkRadius;
-                 x++)
+            world->loaded_region_bounds         = loaded_region_bounds;
+            world->has_pending_chunk_insertions = false;
+
+            Load_Chunk_Job *load_chunk_jobs = ArenaBeginArray(temp_arena, Load_Chunk_Job);
+
+            for (i32 z = loaded_region_bounds.min.y; z <= loaded_region_bounds.max.y; z++)
             {
-                glm::ivec2 chunk_coords = { x, z };
-                Chunk *chunk = insert_and_allocate_chunk(world, chunk_coords);
-                if (chunk)
+                for (i32 x = loaded_region_bounds.min.x; x <= loaded_region_bounds.max.x; x++)
                 {
+                    glm::ivec2 chunk_coords = { x, z };
+
+                    if (!world->free_chunk_count)
+                    {
+                        world->has_pending_chunk_insertions = true;
+                        break;
+                    }
+
+                    Chunk *chunk = insert_and_allocate_chunk(world, chunk_coords);
+                    if (!chunk)
+                    {
+                        continue;
+                    }
+
                     initialize_chunk(chunk, chunk_coords);
-                    Load_Chunk_Job load_chunk_job = {};
+
+                    // note(harlequin): a chunk that gets no blocks is loaded as a far chunk and given them later
+                    bool is_in_blocks_region = is_chunk_in_region_bounds(chunk_coords, blocks_region_bounds);
+
+                    if (!give_chunk_storage(world, chunk, is_in_blocks_region))
+                    {
+                        bool removed = remove_chunk(world, chunk_coords);
+                        Assert(removed);
+
+                        chunk->state = ChunkState_Freed;
+                        free_chunk(world, chunk);
+
+                        world->has_pending_chunk_insertions = true;
+                        continue;
+                    }
+
+                    world->loaded_chunks[world->loaded_chunk_count++] = chunk;
+
+                    Load_Chunk_Job *load_chunk_job = ArenaPushArrayEntry(temp_arena, load_chunk_jobs);
+                    Assert(load_chunk_job);
+                    *load_chunk_job = {};
+                    load_chunk_job->world = world;
+                    load_chunk_job->chunk = chunk;
+                }
+            }
+
+            u32 load_chunk_job_count = (u32)ArenaEndArray(temp_arena, load_chunk_jobs);
+            Job_System::schedule_batch(load_chunk_jobs, load_chunk_job_count);
+        }
+
+        bool should_signal_light_thread = false;
+        bool has_outdated_meshes      = false;
+
+        // note(harlequin): chunks that have blocks or cells to give back, they give them back at the end
+        Chunk **releasing_chunks = ArenaBeginArray(temp_arena, Chunk*);
+
+        u32 loaded_chunk_count = 0;
+
+        for (u32 i = 0; i < world->loaded_chunk_count; i++)
+        {
+            Chunk *chunk = world->loaded_chunks[i];
+            const glm::ivec2& chunk_coords = chunk->world_coords;
+
+            for (i32 j = 0; j < ChunkNeighbour_Count; j++)
+            {
+                update_chunk_neighbour(world, chunk, j);
+            }
+
+            bool is_in_blocks_region = is_chunk_in_region_bounds(chunk_coords, blocks_region_bounds);
+            bool is_in_far_region    = is_chunk_in_region_bounds(chunk_coords, far_region_bounds);
+            bool out_of_bounds       = !is_chunk_in_region_bounds(chunk_coords, loaded_region_bounds);
+
+            // note(harlequin): a chunk that came back while its blocks were being saved keeps them, it goes through
+            // the light passes again if it is in the active region
+            if (chunk->state == ChunkState_BlocksSaved && is_in_blocks_region)
+            {
+                chunk->state = ChunkState_Loaded;
+            }
+
+            bool is_idle = chunk->tessellation_state != TessellationState_Pending &&
+                           !chunk->dirty_sub_chunk_mask.load(std::memory_order_relaxed) &&
+                           !chunk->has_pending_light_blocks.load(std::memory_order_relaxed);
+
+            bool is_loaded = chunk->state == ChunkState_Loaded ||
+                             chunk->state == ChunkState_NeighboursLoaded ||
+                             chunk->state == ChunkState_LightPropagated ||
+                             chunk->state == ChunkState_LightCalculated;
+
+            bool should_release_storage = chunk->state == ChunkState_BlocksSaved;
+
+            if (!out_of_bounds && !is_in_blocks_region && chunk->blocks && is_idle && is_loaded)
+            {
+                // note(harlequin): with no free cells the chunk keeps its blocks and is drawn from them
+                if (!chunk->lod_cells)
+                {
+                    chunk->lod_cells = allocate_chunk_lod_cells(world);
+                }
+
+                if (chunk->lod_cells)
+                {
+                    chunk->state = ChunkState_PendingForSave;
+
+                    Serialize_Chunk_Blocks_Job serialize_chunk_blocks_job;
+                    serialize_chunk_blocks_job.world = world;
+                    serialize_chunk_blocks_job.chunk = chunk;
+                    bool is_high_priority = false;
+                    Job_System::schedule(serialize_chunk_blocks_job, is_high_priority);
+                }
+            }
+            else if (is_in_blocks_region && !chunk->blocks && is_idle && chunk->state == ChunkState_Loaded)
+            {
+                Chunk_Blocks *chunk_blocks = allocate_chunk_blocks(world);
+
+                if (chunk_blocks)
+                {
+                    attach_chunk_blocks(chunk, chunk_blocks);
+                    chunk->state = ChunkState_Initialized;
+
+                    Load_Chunk_Job load_chunk_job;
                     load_chunk_job.world = world;
                     load_chunk_job.chunk = chunk;
                     Job_System::schedule(load_chunk_job);
                 }
+                else if (chunk->lod_cells && !world->free_chunk_lod_cells_count)
+                {
+                    // note(harlequin): the blocks are all held by far chunks that wait for cells, the chunk gives its
+                    // cells back so one of them can trade its blocks for them
+                    should_release_storage = true;
+                }
             }
-        }
+            else if (!out_of_bounds && !chunk->blocks && !chunk->lod_cells && is_idle && chunk->state == ChunkState_Loaded)
+            {
+                // note(harlequin): a chunk that gave its cells back and left the blocks region before it got blocks
+                if (give_chunk_storage(world, chunk, is_in_blocks_region))
+                {
+                    chunk->state = ChunkState_Initialized;
 
-        for (u32 i = 0; i < World::ChunkHashTableCapacity; i++)
-        {
-            if (get_entry_state(world->chunk_hash_table_values[i]) != ChunkHashTableEntryState_Occupied)
+                    Load_Chunk_Job load_chunk_job;
+                    load_chunk_job.world = world;
+                    load_chunk_job.chunk = chunk;
+                    Job_System::schedule(load_chunk_job);
+                }
+            }
+
+            // note(harlequin): a chunk that got its blocks back drops its cells once the blocks are loaded
+            if (chunk->blocks && chunk->lod_cells && is_loaded)
             {
-                continue;
+                should_release_storage = true;
+            }
+
+            if (should_release_storage)
+            {
+                Chunk **releasing_chunk = ArenaPushArrayEntry(temp_arena, releasing_chunks);
+                Assert(releasing_chunk);
+                *releasing_chunk = chunk;
+            }
+
+            bool is_near = chunk->blocks &&
+                           chunk->state >= ChunkState_PendingForLightCalculation &&
+                           chunk->state <= ChunkState_LightCalculated &&
+                           is_chunk_in_region_bounds(chunk_coords, lit_region_bounds);
+
+            u8 lod_level = get_chunk_lod_level(chunk_coords, region_bounds, world->lod_chunk_radius);
+
+            if (!is_near)
+            {
+                lod_level = Max(lod_level, (u8)Chunk::MinFarLodLevel);
             }
 
-            const glm::ivec2& chunk_coords = world->chunk_hash_table_keys[i];
+            if (chunk->lod_level.load(std::memory_order_relaxed) != lod_level ||
+                chunk->is_far.load(std::memory_order_relaxed) == is_near)
+            {
+                chunk->lod_level.store(lod_level, std::memory_order_relaxed);
+                chunk->is_far.store(!is_near, std::memory_order_relaxed);
 
-            u16 chunk_node_index = get_entry_value(world->chunk_hash_table_values[i]);
-            Chunk *chunk = &world->chunk_nodes[chunk_node_index].chunk;
-            Assert(chunk);
+                // note(harlequin): the neighbours are remeshed as well to redo the seams on their side
+                chunk->is_mesh_outdated = true;
+                mark_chunk_neighbour_meshes_outdated(chunk);
+            }
 
             if (is_chunk_in_region_bounds(chunk_coords, world->active_region_bounds))
             {
@@ -323,24 +727,16 @@ namespace minecraft {
 
                 for (i32 i = 0; i < ChunkNeighbour_Count; i++)
                 {
-                    glm::ivec2 neighbour_chunk_coords = chunk_coords + Chunk::NeighbourDirections[i];
-
                     Chunk *neighbour_chunk = chunk->neighbours[i];
+                    Assert(neighbour_chunk);
 
-                    if (!neighbour_chunk)
-                    {
-                        neighbour_chunk = get_chunk(world, neighbour_chunk_coords);
-                        Assert(neighbour_chunk);
-                        chunk->neighbours[i] = neighbour_chunk;
-                    }
-
-                    if (neighbour_chunk->state == ChunkState_Initialized)
+                    if (!neighbour_chunk->blocks || neighbour_chunk->state == ChunkState_Initialized)
                     {
                         all_neighbours_loaded = false;
                     }
                 }
 
-                if (all_neighbours_loaded && chunk->state == ChunkState_Loaded)
+                if (chunk->blocks && all_neighbours_loaded && chunk->state == ChunkState_Loaded)
                 {
                     chunk->state = ChunkState_NeighboursLoaded;
                 }
@@ -356,6 +752,7 @@ namespace minecraft {
                     job.world = world;
                     job.chunk = chunk;
                     light_propagation_queue.push(job);
+                    should_signal_light_thread = true;
                 }
                 else if (chunk->state == ChunkState_LightPropagated)
                 {
@@ -365,7 +762,8 @@ namespace minecraft {
                     {
                         Chunk *neighbour_chunk = chunk->neighbours[i];
 
-                        if (neighbour_chunk->state < ChunkState_LightPropagated)
+                        if (neighbour_chunk->state < ChunkState_LightPropagated ||
+                            neighbour_chunk->state > ChunkState_LightCalculated)
                         {
                             all_neighbours_light_propagated = false;
                             break;
@@ -380,30 +778,41 @@ namespace minecraft {
                         job.world = world;
                         job.chunk = chunk;
                         calculate_chunk_lighting_queue.push(job);
+                        should_signal_light_thread = true;
                     }
                 }
+            }
 
-                if (chunk->state >= ChunkState_NeighboursLoaded)
+            // note(harlequin): the light pass meshes a chunk it lights with the lod level and is_far it finds
+            if (chunk->state == ChunkState_PendingForLightCalculation)
+            {
+                chunk->is_mesh_outdated = false;
+            }
+
+            if (chunk->is_mesh_outdated && is_chunk_meshable(chunk, is_in_far_region))
+            {
+                chunk->is_mesh_outdated = false;
+
+                for (i32 sub_chunk_index = 0; sub_chunk_index < (i32)Chunk::SubChunkCount; sub_chunk_index++)
                 {
-                    for (u32 i = 0; i < Chunk::SubChunkCount; i++)
-                    {
-                        Sub_Chunk_Render_Data *render_data             = &chunk->sub_chunks_render_data[i];
-                        world->last_active_sub_chunk_render_data->next = render_data;
-                        world->last_active_sub_chunk_render_data       = render_data;
-                    }
+                    mark_sub_chunk_dirty(world, chunk, sub_chunk_index);
                 }
+
+                has_outdated_meshes = true;
             }
 
-            bool out_of_bounds = chunk_coords.x < region_bounds.min.x - World::PendingFreeChunkRadius ||
-                                 chunk_coords.x > region_bounds.max.x + World::PendingFreeChunkRadius ||
-                                 chunk_coords.y < region_bounds.min.y - World::PendingFreeChunkRadius ||
-                                 chunk_coords.y > region_bounds.max.y + World::PendingFreeChunkRadius;
+            bool is_in_active_region = is_chunk_in_region_bounds(chunk_coords, world->active_region_bounds);
+
+            if ((is_in_active_region && chunk->state >= ChunkState_NeighboursLoaded && chunk->state <= ChunkState_LightCalculated) ||
+                (is_in_far_region && chunk->tessellation_state != TessellationState_None))
+            {
+                Assert(world->active_chunk_count < World::ChunkCapacity);
+                world->active_chunks[world->active_chunk_count++] = chunk;
+            }
 
             if (out_of_bounds &&
                 chunk->tessellation_state != TessellationState_Pending &&
-                (chunk->state == ChunkState_Loaded ||
-                 chunk->state == ChunkState_NeighboursLoaded ||
-                 chunk->state == ChunkState_LightCalculated))
+                is_loaded)
             {
                 chunk->state = ChunkState_PendingForSave;
 
@@ -415,7 +824,67 @@ namespace minecraft {
 
                 bool removed = remove_chunk(world, chunk->world_coords);
                 Assert(removed);
+
+                world->pending_free_chunks[world->pending_free_chunk_count++] = chunk;
+                continue;
+            }
+
+            world->loaded_chunks[loaded_chunk_count++] = chunk;
+        }
+
+        world->loaded_chunk_count = loaded_chunk_count;
+
+        u32 releasing_chunk_count = (u32)ArenaEndArray(temp_arena, releasing_chunks);
+
+        std::unique_lock light_pass_lock(world->light_pass_mutex, std::try_to_lock);
+
+        // note(harlequin): a chunk that can't give its blocks or cells back yet is tried again next frame, a chunk
+        // that is saved or freed in the meantime gives them back when it is freed
+        if (light_pass_lock.owns_lock())
+        {
+            for (u32 i = 0; i < releasing_chunk_count; i++)
+            {
+                Chunk *chunk = releasing_chunks[i];
+
+                if (chunk->state >= ChunkState_PendingForSave || !is_chunk_neighbourhood_idle(chunk))
+                {
+                    continue;
+                }
+
+                if (chunk->state == ChunkState_BlocksSaved)
+                {
+                    free_chunk_blocks(world, detach_chunk_blocks(chunk));
+                    chunk->state = ChunkState_Loaded;
+                }
+                else
+                {
+                    release_chunk_lod_cells(world, chunk);
+                    chunk->is_mesh_outdated = true;
+                }
+
+                // note(harlequin): the neighbours read the cells of their seam from the blocks or the other way around now
+                mark_chunk_neighbour_meshes_outdated(chunk);
+            }
+        }
+
+        if (has_outdated_meshes)
+        {
+            // note(harlequin): a light pass that is running flushes the marks itself when it is done
+            if (light_pass_lock.owns_lock())
+            {
+                flush_dirty_sub_chunks(world);
             }
+            else
+            {
+                world->dirty_sub_chunk_mark_count += take_dirty_sub_chunk_mark_count();
+            }
+
+            should_signal_light_thread = true;
+        }
+
+        if (should_signal_light_thread)
+        {
+            Job_System::signal_light_thread();
         }
     }
 
@@ -427,6 +896,22 @@ namespace minecraft {
         return { (i32)glm::floor(offset.x), (i32)glm::floor(position.y), (i32)glm::floor(offset.z) };
     }
 
+    u8 get_chunk_lod_level(const glm::ivec2& chunk_coords, const World_Region_Bounds& region_bounds, i32 lod_chunk_radius)
+    {
+        glm::ivec2 center   = (region_bounds.min + region_bounds.max) / 2;
+        glm::ivec2 offset   = glm::abs(chunk_coords - center);
+        i32        distance = glm::max(offset.x, offset.y);
+
+        u8 lod_level = 0;
+
+        while (lod_level < Chunk::MaxLodLevel && distance > (lod_chunk_radius << lod_level))
+        {
+            lod_level++;
+        }
+
+        return lod_level;
+    }
+
     World_Region_Bounds get_world_bounds_from_chunk_coords(i32 chunk_radius, const glm::ivec2 &chunk_coords)
     {
         World_Region_Bounds bounds;
@@ -554,43 +1039,294 @@ namespace minecraft {
         return result;
     }
 
-    static void queue_update_sub_chunk_job(Circular_Queue< Update_Chunk_Job > &queue, Chunk *chunk, i32 sub_chunk_index)
+    void queue_update_chunk_job(World *world, Chunk *chunk)
     {
-        Sub_Chunk_Render_Data& render_data = chunk->sub_chunks_render_data[sub_chunk_index];
-
-        if (render_data.state != TessellationState_Pending)
+        if (chunk->tessellation_state.exchange(TessellationState_Pending) != TessellationState_Pending)
         {
-            render_data.state = TessellationState_Pending;
+            chunk->update_queue_time = Job_System::get_time_stamp();
 
-            if (chunk->tessellation_state != TessellationState_Pending)
-            {
-                chunk->tessellation_state = TessellationState_Pending;
+            Update_Chunk_Job job;
+            job.world          = world;
+            job.chunk          = chunk;
+            job.sub_chunk_mask = 0;
 
-                Update_Chunk_Job job;
-                job.chunk = chunk;
-                queue.push(job);
-            }
+            std::unique_lock lock(world->update_chunk_jobs_queue_mutex);
+            world->update_chunk_jobs_queue.push(job);
         }
     }
 
-    void set_block_id(Chunk *chunk, const glm::ivec3& block_coords, u16 block_id)
+    static void queue_update_sub_chunk_job(World *world, Chunk *chunk, i32 sub_chunk_index)
     {
-        chunk->state = ChunkState_NeighboursLoaded;
+        Sub_Chunk_Render_Data& render_data = chunk->sub_chunks_render_data[sub_chunk_index];
 
-        for (i32 i = 0; i < ChunkNeighbour_Count; i++)
+        if (render_data.state.exchange(TessellationState_Pending) != TessellationState_Pending)
         {
-            Chunk* neighbour = chunk->neighbours[i];
-            Assert(neighbour);
-
-            neighbour->state = ChunkState_NeighboursLoaded;
+            queue_update_chunk_job(world, chunk);
         }
+    }
 
-        Block *block = get_block(chunk, block_coords);
-        block->id = block_id;
+    // note(harlequin): counted per thread so the light kernels never share a counter, the owner of the
+    // work adds it to the world once with take_dirty_sub_chunk_mark_count
+    static thread_local u64 dirty_sub_chunk_mark_count;
 
-        i32 sub_chunk_index = get_sub_chunk_render_data_index(block_coords);
+    void mark_sub_chunk_dirty(World *world, Chunk *chunk, i32 sub_chunk_index)
+    {
+        dirty_sub_chunk_mark_count++;
 
-        if (block_coords.x == 0)
+        u32 bit = (u32)1 << sub_chunk_index;
+
+        // note(harlequin): most marks hit a sub chunk that is already dirty, the plain load keeps
+        // the cache line shared between the light jobs instead of taking it for every write
+        if (chunk->dirty_sub_chunk_mask.load(std::memory_order_relaxed) & bit)
+        {
+            return;
+        }
+
+        chunk->dirty_sub_chunk_mask.fetch_or(bit);
+
+        // note(harlequin): the flag is only raised after the bit is set and flush_dirty_sub_chunks lowers it before
+        // it takes the bits so a bit is either taken by the flush or its chunk is pushed again
+        if (!chunk->is_dirty_chunk_listed.exchange(true))
+        {
+            std::lock_guard lock(world->dirty_chunks_mutex);
+            Assert(world->dirty_chunk_count < World::ChunkCapacity);
+            world->dirty_chunks[world->dirty_chunk_count++] = chunk;
+        }
+    }
+
+    // note(harlequin): a block on the bottom or top row of its sub chunk is also drawn into the faces of the sub chunk
+    // below or above it
+    static void mark_vertical_neighbour_sub_chunk_dirty(World *world, Chunk *chunk, const glm::ivec3& block_coords)
+    {
+        i32 sub_chunk_index   = get_sub_chunk_render_data_index(block_coords);
+        i32 sub_chunk_start_y = get_sub_chunk_first_block_y(sub_chunk_index);
+        i32 sub_chunk_end_y   = sub_chunk_start_y + (i32)Chunk::SubChunkHeight - 1;
+
+        if (block_coords.y == sub_chunk_end_y && sub_chunk_index != Chunk::SubChunkCount - 1)
+        {
+            mark_sub_chunk_dirty(world, chunk, sub_chunk_index + 1);
+        }
+        else if (block_coords.y == sub_chunk_start_y && sub_chunk_index != 0)
+        {
+            mark_sub_chunk_dirty(world, chunk, sub_chunk_index - 1);
+        }
+    }
+
+    u64 take_dirty_sub_chunk_mark_count()
+    {
+        u64 mark_count = dirty_sub_chunk_mark_count;
+        dirty_sub_chunk_mark_count = 0;
+        return mark_count;
+    }
+
+    // note(harlequin): queues an update for every sub chunk marked dirty since the last flush, a sub chunk
+    // written any number of times during a light pass is tessellated once
+    void flush_dirty_sub_chunks(World *world)
+    {
+        u64 sub_chunk_update_count = 0;
+
+        std::lock_guard lock(world->dirty_chunks_mutex);
+
+        for (u32 i = 0; i < world->dirty_chunk_count; i++)
+        {
+            Chunk *chunk = world->dirty_chunks[i];
+
+            chunk->is_dirty_chunk_listed = false;
+            u32 mask = chunk->dirty_sub_chunk_mask.exchange(0);
+
+            if (chunk->state == ChunkState_Initialized || chunk->state == ChunkState_Freed)
+            {
+                continue;
+            }
+
+            while (mask)
+            {
+                i32 sub_chunk_index = (i32)count_trailing_zeros(mask);
+                mask &= mask - 1;
+                queue_update_sub_chunk_job(world, chunk, sub_chunk_index);
+                sub_chunk_update_count++;
+            }
+        }
+
+        world->dirty_chunk_count = 0;
+
+        world->dirty_sub_chunk_mark_count += take_dirty_sub_chunk_mark_count();
+        world->dirty_sub_chunk_flush_count += sub_chunk_update_count;
+    }
+
+    struct Sub_Chunk_Visibility_Node
+    {
+        Chunk *chunk;
+        i32    sub_chunk_index;
+        u32    entry_face;
+        u32    step_face_mask;
+    };
+
+    // note(harlequin): the faces are paired with their opposite face as 2 * i and 2 * i + 1
+    static_assert((BlockFace_Top ^ 1) == BlockFace_Bottom && (BlockFace_Left ^ 1) == BlockFace_Right && (BlockFace_Front ^ 1) == BlockFace_Back);
+
+    static constexpr u32 NullFace = 6;
+
+    static constexpr ChunkNeighbour FaceChunkNeighbours[6] =
+    {
+        ChunkNeighbour_Count, // top
+        ChunkNeighbour_Count, // bottom
+        ChunkNeighbour_Left,
+        ChunkNeighbour_Right,
+        ChunkNeighbour_Front,
+        ChunkNeighbour_Back
+    };
+
+    void find_reachable_sub_chunks(World                 *world,
+                                   const glm::vec3&       view_position,
+                                   const Frustum&         frustum,
+                                   bool                   should_cull_occluded_sub_chunks,
+                                   Temprary_Memory_Arena *temp_arena)
+    {
+        u64 begin_time = Job_System::get_time_stamp();
+
+        u32 pass_index = ++world->visibility_pass_index;
+
+        glm::ivec2 view_chunk_coords = world_position_to_chunk_coords(view_position);
+        Chunk *view_chunk = nullptr;
+
+        for (u32 i = 0; i < world->active_chunk_count; i++)
+        {
+            Chunk *chunk = world->active_chunks[i];
+            chunk->visibility_pass_index    = pass_index;
+            chunk->reachable_sub_chunk_mask = 0;
+
+            if (chunk->world_coords == view_chunk_coords)
+            {
+                view_chunk = chunk;
+            }
+        }
+
+        // note(harlequin): with no sub chunk to start from under the view position nothing is culled
+        if (!should_cull_occluded_sub_chunks || !view_chunk)
+        {
+            constexpr u32 AllSubChunksMask = (u32)(((u64)1 << Chunk::SubChunkCount) - 1);
+
+            for (u32 i = 0; i < world->active_chunk_count; i++)
+            {
+                world->active_chunks[i]->reachable_sub_chunk_mask = AllSubChunksMask;
+            }
+
+            world->reachable_sub_chunk_count = world->active_chunk_count * Chunk::SubChunkCount;
+            world->last_visibility_pass_time = Job_System::get_time_stamp() - begin_time;
+            return;
+        }
+
+        // note(harlequin): a sub chunk is pushed once so the queue never wraps
+        Sub_Chunk_Visibility_Node *queue = ArenaPushArrayAligned(temp_arena,
+                                                                 Sub_Chunk_Visibility_Node,
+                                                                 world->active_chunk_count * Chunk::SubChunkCount);
+        Assert(queue);
+
+        u32 first_node_index = 0;
+        u32 node_count       = 0;
+
+        i32 view_sub_chunk_index = (i32)glm::floor(view_position.y / (f32)Chunk::SubChunkHeight);
+        view_sub_chunk_index = glm::clamp(view_sub_chunk_index, 0, (i32)Chunk::SubChunkCount - 1);
+
+        view_chunk->reachable_sub_chunk_mask |= 1u << view_sub_chunk_index;
+        queue[node_count++] = { view_chunk, view_sub_chunk_index, NullFace, 0 };
+
+        while (first_node_index < node_count)
+        {
+            Sub_Chunk_Visibility_Node node = queue[first_node_index++];
+
+            u32 exit_face_mask = 0x3F;
+
+            if (node.entry_face != NullFace)
+            {
+                const Sub_Chunk_Render_Data& render_data = node.chunk->sub_chunks_render_data[node.sub_chunk_index];
+                u64 face_connectivity = render_data.face_connectivity.load(std::memory_order_relaxed);
+                exit_face_mask = get_connected_face_mask(face_connectivity, node.entry_face);
+            }
+
+            u32 backward_face_mask = ((node.step_face_mask & 0x15) << 1) | ((node.step_face_mask & 0x2A) >> 1);
+            exit_face_mask &= ~backward_face_mask;
+
+            while (exit_face_mask)
+            {
+                u32 face = count_trailing_zeros(exit_face_mask);
+                exit_face_mask &= exit_face_mask - 1;
+
+                Chunk *neighbour_chunk = node.chunk;
+                i32 neighbour_sub_chunk_index = node.sub_chunk_index;
+
+                if (face == BlockFace_Top)
+                {
+                    neighbour_sub_chunk_index++;
+                }
+                else if (face == BlockFace_Bottom)
+                {
+                    neighbour_sub_chunk_index--;
+                }
+                else
+                {
+                    ChunkNeighbour neighbour = FaceChunkNeighbours[face];
+                    neighbour_chunk = node.chunk->neighbours[neighbour];
+
+                    // note(harlequin): the neighbours of a chunk at the edge of the region may have been freed and reused
+                    if (!neighbour_chunk ||
+                        neighbour_chunk->world_coords != node.chunk->world_coords + Chunk::NeighbourDirections[neighbour])
+                    {
+                        continue;
+                    }
+                }
+
+                if (neighbour_sub_chunk_index < 0 ||
+                    neighbour_sub_chunk_index >= (i32)Chunk::SubChunkCount ||
+                    neighbour_chunk->visibility_pass_index != pass_index)
+                {
+                    continue;
+                }
+
+                u32 neighbour_bit = 1u << neighbour_sub_chunk_index;
+
+                if (neighbour_chunk->reachable_sub_chunk_mask & neighbour_bit)
+                {
+                    continue;
+                }
+
+                glm::vec3 min = neighbour_chunk->position + glm::vec3(0.0f, (f32)(neighbour_sub_chunk_index * Chunk::SubChunkHeight), 0.0f);
+                glm::vec3 max = min + glm::vec3(Chunk::Width, Chunk::SubChunkHeight, Chunk::Depth);
+
+                if (!frustum.is_aabb_visible({ min, max }))
+                {
+                    continue;
+                }
+
+                neighbour_chunk->reachable_sub_chunk_mask |= neighbour_bit;
+                queue[node_count++] = { neighbour_chunk, neighbour_sub_chunk_index, face ^ 1, node.step_face_mask | (1u << face) };
+            }
+        }
+
+        world->reachable_sub_chunk_count = node_count;
+        world->last_visibility_pass_time = Job_System::get_time_stamp() - begin_time;
+    }
+
+    void apply_block_edit(World *world, Block_Edit *block_edit)
+    {
+        Chunk *chunk                   = block_edit->chunk;
+        const glm::ivec3& block_coords = block_edit->block_coords;
+        u16 block_id                   = block_edit->block_id;
+
+        Block *block = get_block(chunk, block_coords);
+
+        block_edit->previous_block_id = block->id;
+        block_edit->is_applied        = true;
+
+        block->id = block_id;
+        update_height_map(chunk, block_coords);
+        update_light_source_block_mask(chunk, get_block_index(block_coords));
+
+        i32 sub_chunk_index = get_sub_chunk_render_data_index(block_coords);
+        chunk->patchable_sub_chunk_mask.fetch_or(1u << sub_chunk_index, std::memory_order_relaxed);
+
+        if (block_coords.x == 0)
         {
             Chunk *left_chunk = chunk->neighbours[ChunkNeighbour_Left];
             Assert(left_chunk);
@@ -617,6 +1353,46 @@ namespace minecraft {
         }
     }
 
+    void set_block_id(World *world, Chunk *chunk, const glm::ivec3& block_coords, u16 block_id)
+    {
+        Block_Edit block_edit   = {};
+        block_edit.chunk        = chunk;
+        block_edit.block_coords = block_coords;
+        block_edit.block_id     = block_id;
+        block_edit.is_applied   = false;
+
+        auto& block_edits_queue = world->block_edits_queue;
+
+        {
+            std::unique_lock light_pass_lock(world->light_pass_mutex, std::try_to_lock);
+
+            if (block_edits_queue.is_full())
+            {
+                if (!light_pass_lock.owns_lock())
+                {
+                    light_pass_lock.lock();
+                }
+
+                Job_System::signal_light_thread();
+                world->block_edits_drained_cv.wait(light_pass_lock, [&] { return !block_edits_queue.is_full(); });
+            }
+
+            // note(harlequin): the edits have to reach the chunk in the order they were made
+            if (light_pass_lock.owns_lock() && world->deferred_block_edit_count == 0)
+            {
+                apply_block_edit(world, &block_edit);
+            }
+            else
+            {
+                world->deferred_block_edit_count++;
+            }
+
+            block_edits_queue.push(block_edit);
+        }
+
+        Job_System::signal_light_thread();
+    }
+
     // todo(harlequin): remove *world
     void set_block_sky_light_level(World *world, Chunk *chunk, const glm::ivec3& block_coords, u8 light_level)
     {
@@ -625,21 +1401,21 @@ namespace minecraft {
         light_info->sky_light_level = light_level;
 
         i32 sub_chunk_index = get_sub_chunk_render_data_index(block_coords);
-        queue_update_sub_chunk_job(world->update_chunk_jobs_queue, chunk, sub_chunk_index);
+        mark_sub_chunk_dirty(world, chunk, sub_chunk_index);
 
         if (block_coords.x == 0)
         {
             Chunk *left_chunk = chunk->neighbours[ChunkNeighbour_Left];
             Assert(left_chunk);
             left_chunk->right_edge_light_map[block_coords.y * Chunk::Depth + block_coords.z].sky_light_level = light_level;
-            queue_update_sub_chunk_job(world->update_chunk_jobs_queue, left_chunk, sub_chunk_index);
+            mark_sub_chunk_dirty(world, left_chunk, sub_chunk_index);
         }
         else if (block_coords.x == Chunk::Width - 1)
         {
             Chunk *right_chunk = chunk->neighbours[ChunkNeighbour_Right];
             Assert(right_chunk);
             right_chunk->left_edge_light_map[block_coords.y * Chunk::Depth + block_coords.z].sky_light_level = light_level;
-            queue_update_sub_chunk_job(world->update_chunk_jobs_queue, right_chunk, sub_chunk_index);
+            mark_sub_chunk_dirty(world, right_chunk, sub_chunk_index);
         }
 
         if (block_coords.z == 0)
@@ -647,27 +1423,17 @@ namespace minecraft {
             Chunk *front_chunk = chunk->neighbours[ChunkNeighbour_Front];
             Assert(front_chunk);
             front_chunk->back_edge_light_map[block_coords.y * Chunk::Width + block_coords.x].sky_light_level = light_level;
-            queue_update_sub_chunk_job(world->update_chunk_jobs_queue, front_chunk, sub_chunk_index);
+            mark_sub_chunk_dirty(world, front_chunk, sub_chunk_index);
         }
         else if (block_coords.z == Chunk::Depth - 1)
         {
             Chunk *back_chunk = chunk->neighbours[ChunkNeighbour_Back];
             Assert(back_chunk);
             back_chunk->front_edge_light_map[block_coords.y * Chunk::Width + block_coords.x].sky_light_level = light_level;
-            queue_update_sub_chunk_job(world->update_chunk_jobs_queue, back_chunk, sub_chunk_index);
+            mark_sub_chunk_dirty(world, back_chunk, sub_chunk_index);
         }
 
-        i32 sub_chunk_start_y = sub_chunk_index * Chunk::SubChunkHeight;
-        i32 sub_chunk_end_y = (sub_chunk_index + 1) * Chunk::SubChunkHeight - 1;
-
-        if (block_coords.y == sub_chunk_end_y && sub_chunk_index != (Chunk::SubChunkCount - 1))
-        {
-            queue_update_sub_chunk_job(world->update_chunk_jobs_queue, chunk, sub_chunk_index + 1);
-        }
-        else if (block_coords.y == sub_chunk_start_y && sub_chunk_index != 0)
-        {
-            queue_update_sub_chunk_job(world->update_chunk_jobs_queue, chunk, sub_chunk_index - 1);
-        }
+        mark_vertical_neighbour_sub_chunk_dirty(world, chunk, block_coords);
     }
 
     void set_block_light_source_level(World *world, Chunk *chunk, const glm::ivec3& block_coords, u8 light_level)
@@ -677,21 +1443,21 @@ namespace minecraft {
         light_info->light_source_level = light_level;
 
         i32 sub_chunk_index = get_sub_chunk_render_data_index(block_coords);
-        queue_update_sub_chunk_job(world->update_chunk_jobs_queue, chunk, sub_chunk_index);
+        mark_sub_chunk_dirty(world, chunk, sub_chunk_index);
 
         if (block_coords.x == 0)
         {
             Chunk *left_chunk = chunk->neighbours[ChunkNeighbour_Left];
             Assert(left_chunk);
             left_chunk->right_edge_light_map[block_coords.y * Chunk::Depth + block_coords.z].light_source_level = light_level;
-            queue_update_sub_chunk_job(world->update_chunk_jobs_queue, left_chunk, sub_chunk_index);
+            mark_sub_chunk_dirty(world, left_chunk, sub_chunk_index);
         }
         else if (block_coords.x == Chunk::Width - 1)
         {
             Chunk *right_chunk = chunk->neighbours[ChunkNeighbour_Right];
             Assert(right_chunk);
             right_chunk->left_edge_light_map[block_coords.y * Chunk::Depth + block_coords.z].light_source_level = light_level;
-            queue_update_sub_chunk_job(world->update_chunk_jobs_queue, right_chunk, sub_chunk_index);
+            mark_sub_chunk_dirty(world, right_chunk, sub_chunk_index);
         }
 
         if (block_coords.z == 0)
@@ -699,34 +1465,584 @@ namespace minecraft {
             Chunk *front_chunk = chunk->neighbours[ChunkNeighbour_Front];
             Assert(front_chunk);
             front_chunk->back_edge_light_map[block_coords.y * Chunk::Width + block_coords.x].light_source_level = light_level;
-            queue_update_sub_chunk_job(world->update_chunk_jobs_queue, front_chunk, sub_chunk_index);
+            mark_sub_chunk_dirty(world, front_chunk, sub_chunk_index);
         }
         else if (block_coords.z == Chunk::Depth - 1)
         {
             Chunk *back_chunk = chunk->neighbours[ChunkNeighbour_Back];
             Assert(back_chunk);
             back_chunk->front_edge_light_map[block_coords.y * Chunk::Width + block_coords.x].light_source_level = light_level;
-            queue_update_sub_chunk_job(world->update_chunk_jobs_queue, back_chunk, sub_chunk_index);
+            mark_sub_chunk_dirty(world, back_chunk, sub_chunk_index);
         }
 
-        i32 sub_chunk_start_y = sub_chunk_index * Chunk::SubChunkHeight;
-        i32 sub_chunk_end_y = (sub_chunk_index + 1) * (Chunk::SubChunkHeight - 1);
+        mark_vertical_neighbour_sub_chunk_dirty(world, chunk, block_coords);
+    }
+
+    static inline void push_pending_light_block(World *world, Chunk *chunk, i32 block_index)
+    {
+        chunk->pending_light_block_mask[block_index >> 6] |= (u64)1 << (block_index & 63);
 
-        if (block_coords.y == sub_chunk_end_y && sub_chunk_index != (Chunk::SubChunkCount - 1))
+        if (!chunk->has_pending_light_blocks.exchange(true, std::memory_order_relaxed))
         {
-            queue_update_sub_chunk_job(world->update_chunk_jobs_queue, chunk, sub_chunk_index + 1);
+            u32 pending_light_chunk_index = world->pending_light_chunk_count.fetch_add(1, std::memory_order_relaxed);
+            Assert(pending_light_chunk_index < World::ChunkCapacity);
+            world->pending_light_chunks[pending_light_chunk_index] = chunk;
         }
-        else if (block_coords.y == sub_chunk_start_y && sub_chunk_index != 0)
+    }
+
+    void push_pending_light_blocks(World *world, Circular_Queue< Light_Node > *queue)
+    {
+        while (!queue->is_empty())
         {
-            queue_update_sub_chunk_job(world->update_chunk_jobs_queue, chunk, sub_chunk_index - 1);
+            Light_Node node = queue->pop();
+            push_pending_light_block(world, get_light_node_chunk(world, node), get_light_node_block_index(node));
         }
     }
 
+    // note(harlequin): a block under a full sky light block is in the same open column so it is fully lit as well,
+    // propagate_sky_light already fills the columns so this only matters when a block edit opens a column
+    static inline i32 get_propagated_sky_light_level(const Block_Light_Info *block_light_info, i32 direction)
+    {
+        if (direction == BlockNeighbour_Down && block_light_info->sky_light_level == 15)
+        {
+            return 15;
+        }
+
+        return (i32)block_light_info->sky_light_level - 1;
+    }
+
+    // note(harlequin): block index deltas to the six neighbours in BlockNeighbour order, the border deltas are
+    // used instead when the step leaves the chunk and lands on the opposite side of the neighbour chunk
+    static constexpr i32 BlockNeighbourIndexDeltas[6] =
+    {
+        Chunk::Width * Chunk::Depth,
+        -(Chunk::Width * Chunk::Depth),
+        -1,
+        1,
+        -Chunk::Width,
+        Chunk::Width
+    };
+
+    static constexpr i32 BlockNeighbourBorderIndexDeltas[6] =
+    {
+        0,
+        0,
+        Chunk::Width - 1,
+        -(Chunk::Width - 1),
+        (Chunk::Depth - 1) * Chunk::Width,
+        -((Chunk::Depth - 1) * Chunk::Width)
+    };
+
+    static constexpr i32 BlockNeighbourBorderChunks[6] =
+    {
+        -1,
+        -1,
+        ChunkNeighbour_Left,
+        ChunkNeighbour_Right,
+        ChunkNeighbour_Front,
+        ChunkNeighbour_Back
+    };
+
+    // note(harlequin): bit d is set when the step to neighbour d leaves the chunk
+    static inline u32 get_block_border_mask(i32 block_index)
+    {
+        i32 x = block_index % Chunk::Width;
+        i32 y = block_index / (Chunk::Width * Chunk::Depth);
+        i32 z = (block_index / Chunk::Width) % Chunk::Depth;
+
+        return ((u32)(y == Chunk::Height - 1) << BlockNeighbour_Up)    |
+               ((u32)(y == 0)                 << BlockNeighbour_Down)  |
+               ((u32)(x == 0)                 << BlockNeighbour_Left)  |
+               ((u32)(x == Chunk::Width - 1)  << BlockNeighbour_Right) |
+               ((u32)(z == 0)                 << BlockNeighbour_Front) |
+               ((u32)(z == Chunk::Depth - 1)  << BlockNeighbour_Back);
+    }
+
+    // note(harlequin): returns the chunk of neighbour d or null when the neighbour is outside of the world or the region,
+    // steps inside the chunk are a single add, only border steps look at the neighbour chunks
+    static inline Chunk* get_neighbour_block(Chunk *chunk,
+                                             i32 block_index,
+                                             u32 border_mask,
+                                             bool is_chunk_in_region,
+                                             i32 direction,
+                                             const World_Region_Bounds& region_bounds,
+                                             i32 *out_neighbour_block_index)
+    {
+        if (!(border_mask & (1 << direction)))
+        {
+            *out_neighbour_block_index = block_index + BlockNeighbourIndexDeltas[direction];
+            return is_chunk_in_region ? chunk : nullptr;
+        }
+
+        i32 chunk_neighbour = BlockNeighbourBorderChunks[direction];
+        if (chunk_neighbour == -1)
+        {
+            return nullptr;
+        }
+
+        Chunk *neighbour_chunk = chunk->neighbours[chunk_neighbour];
+        if (!neighbour_chunk || !is_chunk_in_region_bounds(neighbour_chunk->world_coords, region_bounds))
+        {
+            return nullptr;
+        }
+
+        *out_neighbour_block_index = block_index + BlockNeighbourBorderIndexDeltas[direction];
+        return neighbour_chunk;
+    }
+
+    // note(harlequin): returns true when the neighbour got brighter and has to spread its light as well
+    static inline bool spread_light_to_neighbour_block(World *world,
+                                                       const Block_Light_Info& block_light_info,
+                                                       i32 direction,
+                                                       Chunk *neighbour_chunk,
+                                                       i32 neighbour_block_index)
+    {
+        const Block_Info *neighbour_info = &World::block_infos[neighbour_chunk->blocks[neighbour_block_index].id];
+        if (!is_block_transparent(neighbour_info))
+        {
+            return false;
+        }
+
+        Block_Light_Info neighbour_light_info = neighbour_chunk->light_map[neighbour_block_index];
+
+        i32 sky_light_level    = get_propagated_sky_light_level(&block_light_info, direction);
+        i32 light_source_level = (i32)block_light_info.light_source_level - 1;
+
+        bool is_sky_light_brighter    = (i32)neighbour_light_info.sky_light_level    < sky_light_level;
+        bool is_light_source_brighter = (i32)neighbour_light_info.light_source_level < light_source_level;
+
+        if (!is_sky_light_brighter && !is_light_source_brighter)
+        {
+            return false;
+        }
+
+        glm::ivec3 neighbour_block_coords = get_block_coords(neighbour_block_index);
+
+        if (is_sky_light_brighter)
+        {
+            set_block_sky_light_level(world, neighbour_chunk, neighbour_block_coords, sky_light_level);
+        }
+
+        if (is_light_source_brighter)
+        {
+            set_block_light_source_level(world, neighbour_chunk, neighbour_block_coords, light_source_level);
+        }
+
+        return true;
+    }
+
+    u64 propagate_light(World *world,
+                        Circular_Queue< Light_Node > *queue,
+                        const World_Region_Bounds& region_bounds)
+    {
+        u64 processed_block_count = 0;
+
+        while (!queue->is_empty())
+        {
+            Light_Node node = queue->pop();
+            processed_block_count++;
+
+            Chunk *chunk    = get_light_node_chunk(world, node);
+            i32 block_index = get_light_node_block_index(node);
+
+            Block_Light_Info block_light_info = chunk->light_map[block_index];
+            u32  border_mask                  = get_block_border_mask(block_index);
+            bool is_chunk_in_region           = is_chunk_in_region_bounds(chunk->world_coords, region_bounds);
+
+            for (i32 d = 0; d < 6; d++)
+            {
+                i32 neighbour_block_index;
+                Chunk *neighbour_chunk = get_neighbour_block(chunk, block_index, border_mask, is_chunk_in_region, d, region_bounds, &neighbour_block_index);
+
+                if (neighbour_chunk &&
+                    spread_light_to_neighbour_block(world, block_light_info, d, neighbour_chunk, neighbour_block_index))
+                {
+                    queue->push(pack_light_node(get_chunk_node_index(world, neighbour_chunk), neighbour_block_index));
+                }
+            }
+        }
+
+        return processed_block_count;
+    }
+
+    u64 propagate_light_with_block_queries(World *world,
+                                           Circular_Queue< Block_Query_Result > *queue,
+                                           const World_Region_Bounds& region_bounds)
+    {
+        u64 processed_block_count = 0;
+
+        while (!queue->is_empty())
+        {
+            auto block_query = queue->pop();
+            processed_block_count++;
+
+            Block_Light_Info *block_light_info = get_block_light_info(block_query.chunk, block_query.block_coords);
+            auto neighbours_query = query_neighbours(block_query.chunk, block_query.block_coords);
+
+            for (i32 d = 0; d < 6; d++)
+            {
+                auto &neighbour_query = neighbours_query[d];
+
+                if (is_block_query_valid(neighbour_query) &&
+                    is_block_query_in_world_region(neighbour_query, region_bounds))
+                {
+                    Block* neighbour = neighbour_query.block;
+                    const auto* neighbour_info = get_block_info(world, neighbour);
+                    if (is_block_transparent(neighbour_info))
+                    {
+                        Block_Light_Info *neighbour_block_light_info = get_block_light_info(neighbour_query.chunk, neighbour_query.block_coords);
+
+                        i32 sky_light_level = get_propagated_sky_light_level(block_light_info, d);
+
+                        if ((i32)neighbour_block_light_info->sky_light_level < sky_light_level)
+                        {
+                            set_block_sky_light_level(world, neighbour_query.chunk, neighbour_query.block_coords, sky_light_level);
+                            queue->push(neighbour_query);
+                        }
+
+                        if ((i32)neighbour_block_light_info->light_source_level <= (i32)block_light_info->light_source_level - 2)
+                        {
+                            set_block_light_source_level(world, neighbour_query.chunk, neighbour_query.block_coords, (i32)block_light_info->light_source_level - 1);
+                            queue->push(neighbour_query);
+                        }
+                    }
+                }
+            }
+        }
+
+        return processed_block_count;
+    }
+
+    static void mark_block_sub_chunks_dirty(World *world, Chunk *chunk, const glm::ivec3& block_coords)
+    {
+        i32 sub_chunk_index = get_sub_chunk_render_data_index(block_coords);
+        mark_sub_chunk_dirty(world, chunk, sub_chunk_index);
+
+        if (block_coords.x == 0)
+        {
+            mark_sub_chunk_dirty(world, chunk->neighbours[ChunkNeighbour_Left], sub_chunk_index);
+        }
+        else if (block_coords.x == Chunk::Width - 1)
+        {
+            mark_sub_chunk_dirty(world, chunk->neighbours[ChunkNeighbour_Right], sub_chunk_index);
+        }
+
+        if (block_coords.z == 0)
+        {
+            mark_sub_chunk_dirty(world, chunk->neighbours[ChunkNeighbour_Front], sub_chunk_index);
+        }
+        else if (block_coords.z == Chunk::Depth - 1)
+        {
+            mark_sub_chunk_dirty(world, chunk->neighbours[ChunkNeighbour_Back], sub_chunk_index);
+        }
+
+        mark_vertical_neighbour_sub_chunk_dirty(world, chunk, block_coords);
+    }
+
+    static void remove_light(World *world,
+                             Circular_Queue< Light_Removal_Node > *light_removal_queue,
+                             Circular_Queue< Light_Node > *light_queue,
+                             const World_Region_Bounds& region_bounds,
+                             bool is_sky_light)
+    {
+        while (!light_removal_queue->is_empty())
+        {
+            Light_Removal_Node node = light_removal_queue->pop();
+
+            Chunk *chunk    = get_light_node_chunk(world, node.node);
+            i32 block_index = get_light_node_block_index(node.node);
+
+            u32  border_mask        = get_block_border_mask(block_index);
+            bool is_chunk_in_region = is_chunk_in_region_bounds(chunk->world_coords, region_bounds);
+
+            for (i32 d = 0; d < 6; d++)
+            {
+                i32 neighbour_block_index;
+                Chunk *neighbour_chunk = get_neighbour_block(chunk, block_index, border_mask, is_chunk_in_region, d, region_bounds, &neighbour_block_index);
+
+                if (!neighbour_chunk)
+                {
+                    continue;
+                }
+
+                Light_Node neighbour_node = pack_light_node(get_chunk_node_index(world, neighbour_chunk), neighbour_block_index);
+
+                const Block_Light_Info& neighbour_light_info = neighbour_chunk->light_map[neighbour_block_index];
+                i32 neighbour_light_level = is_sky_light ? neighbour_light_info.sky_light_level : neighbour_light_info.light_source_level;
+
+                bool is_lit_by_node = neighbour_light_level < node.light_level ||
+                                      (is_sky_light && d == BlockNeighbour_Down && node.light_level == 15);
+
+                if (neighbour_light_level > 1 && is_lit_by_node)
+                {
+                    glm::ivec3 neighbour_block_coords = get_block_coords(neighbour_block_index);
+
+                    if (is_sky_light)
+                    {
+                        set_block_sky_light_level(world, neighbour_chunk, neighbour_block_coords, 1);
+                    }
+                    else
+                    {
+                        set_block_light_source_level(world, neighbour_chunk, neighbour_block_coords, 1);
+                    }
+
+                    Light_Removal_Node neighbour_removal_node = {};
+                    neighbour_removal_node.node               = neighbour_node;
+                    neighbour_removal_node.light_level        = (u8)neighbour_light_level;
+                    light_removal_queue->push(neighbour_removal_node);
+                }
+                else if (neighbour_light_level >= node.light_level)
+                {
+                    // note(harlequin): lit by something else, it has to spread its light back into the darkened area
+                    light_queue->push(neighbour_node);
+                }
+            }
+        }
+    }
+
+    // note(harlequin): removes the light that went through the edited block then relights the darkened area from
+    // its lit border, the edited block and its neighbours. only blocks whose light changes are touched
+    void update_light_for_block_edit(World *world,
+                                     const Block_Edit& block_edit,
+                                     const World_Region_Bounds& region_bounds,
+                                     Circular_Queue< Light_Node > *light_queue,
+                                     Circular_Queue< Light_Removal_Node > *light_removal_queue)
+    {
+        Chunk *chunk = block_edit.chunk;
+        const glm::ivec3& block_coords = block_edit.block_coords;
+
+        mark_block_sub_chunks_dirty(world, chunk, block_coords);
+
+        const Block_Info *previous_info = &World::block_infos[block_edit.previous_block_id];
+        const Block_Info *info          = &World::block_infos[block_edit.block_id];
+
+        bool is_transparent_changed  = is_block_transparent(info) != is_block_transparent(previous_info);
+        bool is_light_source_changed = is_light_source(info) != is_light_source(previous_info);
+
+        if (!is_transparent_changed && !is_light_source_changed)
+        {
+            return;
+        }
+
+        i32 block_index = get_block_index(block_coords);
+        Light_Node node = pack_light_node(get_chunk_node_index(world, chunk), block_index);
+
+        Block_Light_Info *light_info = &chunk->light_map[block_index];
+
+        if (light_info->sky_light_level > 1)
+        {
+            Light_Removal_Node removal_node = {};
+            removal_node.node               = node;
+            removal_node.light_level        = light_info->sky_light_level;
+            light_removal_queue->push(removal_node);
+
+            set_block_sky_light_level(world, chunk, block_coords, 1);
+            remove_light(world, light_removal_queue, light_queue, region_bounds, true);
+        }
+
+        if (light_info->light_source_level > 1)
+        {
+            Light_Removal_Node removal_node = {};
+            removal_node.node               = node;
+            removal_node.light_level        = light_info->light_source_level;
+            light_removal_queue->push(removal_node);
+
+            set_block_light_source_level(world, chunk, block_coords, 1);
+            remove_light(world, light_removal_queue, light_queue, region_bounds, false);
+        }
+
+        if (is_light_source(info))
+        {
+            set_block_light_source_level(world, chunk, block_coords, 15);
+            light_queue->push(node);
+        }
+
+        if (is_block_transparent(info))
+        {
+            if (block_coords.y == Chunk::Height - 1)
+            {
+                set_block_sky_light_level(world, chunk, block_coords, 15);
+                light_queue->push(node);
+            }
+
+            u32  border_mask        = get_block_border_mask(block_index);
+            bool is_chunk_in_region = is_chunk_in_region_bounds(chunk->world_coords, region_bounds);
+
+            for (i32 d = 0; d < 6; d++)
+            {
+                i32 neighbour_block_index;
+                Chunk *neighbour_chunk = get_neighbour_block(chunk, block_index, border_mask, is_chunk_in_region, d, region_bounds, &neighbour_block_index);
+
+                if (neighbour_chunk)
+                {
+                    light_queue->push(pack_light_node(get_chunk_node_index(world, neighbour_chunk), neighbour_block_index));
+                }
+            }
+        }
+
+        propagate_light(world, light_queue, region_bounds);
+    }
+
+    // note(harlequin): same propagation rules as propagate_light but the bfs never leaves the chunk,
+    // a neighbour chunk block that gets brighter is written and pushed to that chunk pending light blocks.
+    // the caller has to make sure no other chunk within two chunks of this one is propagating at the same time
+    void propagate_chunk_light(World *world,
+                               Chunk *chunk,
+                               const World_Region_Bounds& region_bounds,
+                               Temprary_Memory_Arena *temp_arena)
+    {
+        auto *queue = ArenaPushAligned(temp_arena, Circular_Queue< u16 >);
+        Assert(queue);
+        queue->initialize();
+
+        constexpr u32 BlockMaskCount = Chunk::BlockCount / 64;
+        u64 *queued_block_mask = ArenaPushArray(temp_arena, u64, BlockMaskCount);
+        Assert(queued_block_mask);
+
+        chunk->has_pending_light_blocks = false;
+
+        for (u32 i = 0; i < BlockMaskCount; i++)
+        {
+            u64 mask = chunk->pending_light_block_mask[i];
+            chunk->pending_light_block_mask[i] = 0;
+            queued_block_mask[i] = mask;
+
+            while (mask)
+            {
+                u32 bit_index = count_trailing_zeros(mask);
+                mask &= mask - 1;
+                queue->push((u16)(i * 64 + bit_index));
+            }
+        }
+
+        bool is_chunk_in_region = is_chunk_in_region_bounds(chunk->world_coords, region_bounds);
+
+        while (!queue->is_empty())
+        {
+            i32 block_index = queue->pop();
+            queued_block_mask[block_index >> 6] &= ~((u64)1 << (block_index & 63));
+
+            Block_Light_Info block_light_info = chunk->light_map[block_index];
+            u32 border_mask                   = get_block_border_mask(block_index);
+
+            for (i32 d = 0; d < 6; d++)
+            {
+                i32 neighbour_block_index;
+                Chunk *neighbour_chunk = get_neighbour_block(chunk, block_index, border_mask, is_chunk_in_region, d, region_bounds, &neighbour_block_index);
+
+                if (!neighbour_chunk ||
+                    !spread_light_to_neighbour_block(world, block_light_info, d, neighbour_chunk, neighbour_block_index))
+                {
+                    continue;
+                }
+
+                if (neighbour_chunk != chunk)
+                {
+                    push_pending_light_block(world, neighbour_chunk, neighbour_block_index);
+                }
+                else
+                {
+                    u64 bit = (u64)1 << (neighbour_block_index & 63);
+                    u64 &mask = queued_block_mask[neighbour_block_index >> 6];
+                    if (!(mask & bit))
+                    {
+                        mask |= bit;
+                        queue->push((u16)neighbour_block_index);
+                    }
+                }
+            }
+        }
+    }
+
+    // note(harlequin): chunks are colored by (x mod 3, z mod 3), two chunks with the same color are at least
+    // three chunks apart so their propagate_chunk_light writes (their own blocks, their direct neighbours blocks and
+    // the edge light maps around those) never overlap. the colors run one after the other until no chunk has
+    // pending light blocks left, light only ever increases so this converges to the same light values as propagate_light
+    void propagate_light_in_parallel(World *world,
+                                     const World_Region_Bounds& region_bounds,
+                                     Temprary_Memory_Arena *temp_arena)
+    {
+        Propagate_Chunk_Light_Job *jobs = ArenaPushArrayAligned(temp_arena, Propagate_Chunk_Light_Job, World::ChunkCapacity);
+        Assert(jobs);
+
+        Chunk **chunks = ArenaPushArrayAligned(temp_arena, Chunk*, World::ChunkCapacity);
+        Assert(chunks);
+
+        Propagate_Light_Batch batch;
+        batch.pending_job_count = 0;
+
+        // note(harlequin): every round takes the chunks that became pending since the last one, a chunk that gets
+        // new pending blocks before its color runs still has its flag up so it is handled in this round, one that
+        // gets them after is pushed again and handled in the next
+        while (world->pending_light_chunk_count.load(std::memory_order_relaxed))
+        {
+            u32 chunk_count = world->pending_light_chunk_count.load(std::memory_order_relaxed);
+            memcpy(chunks, world->pending_light_chunks, sizeof(Chunk*) * chunk_count);
+            world->pending_light_chunk_count.store(0, std::memory_order_relaxed);
+
+            for (i32 color = 0; color < 9; color++)
+            {
+                u32 job_count = 0;
+
+                for (u32 i = 0; i < chunk_count; i++)
+                {
+                    Chunk *chunk = chunks[i];
+
+                    i32 chunk_color = ((chunk->world_coords.x % 3) + 3) % 3 + (((chunk->world_coords.y % 3) + 3) % 3) * 3;
+                    if (chunk_color != color)
+                    {
+                        continue;
+                    }
+
+                    Propagate_Chunk_Light_Job *job = &jobs[job_count++];
+                    job->world             = world;
+                    job->chunk             = chunk;
+                    job->region_bounds     = &region_bounds;
+                    job->batch             = &batch;
+                }
+
+                if (job_count == 0)
+                {
+                    continue;
+                }
+
+                batch.pending_job_count = job_count;
+                Job_System::schedule_batch(jobs, job_count);
+
+                // note(harlequin): the jobs may queue behind load and mesh jobs, sleep instead of spinning a core on them
+                std::unique_lock lock(batch.done_mutex);
+                batch.done_cv.wait(lock, [&] { return batch.pending_job_count.load(std::memory_order_acquire) == 0; });
+            }
+        }
+    }
+
+    bool is_block_exposed_to_sky(World *world, const glm::vec3& position)
+    {
+        Chunk *chunk = get_chunk(world, world_position_to_chunk_coords(position));
+        if (!chunk || chunk->state < ChunkState_Loaded)
+        {
+            return false;
+        }
+
+        glm::ivec3 block_coords = world_position_to_block_coords(world, position);
+        if (block_coords.y < 0)
+        {
+            return false;
+        }
+
+        if (block_coords.y >= Chunk::Height)
+        {
+            return true;
+        }
+
+        return is_block_exposed_to_sky(chunk, block_coords);
+    }
+
     Block* get_block(World *world, const glm::vec3& position)
     {
        glm::ivec2 chunk_coords = world_position_to_chunk_coords(position);
        Chunk* chunk = get_chunk(world, chunk_coords);
-       if (chunk)
+       if (chunk && chunk->blocks)
        {
             glm::ivec3 block_coords = world_position_to_block_coords(world, position);
             return get_block(chunk, block_coords);
@@ -738,7 +2054,7 @@ namespace minecraft {
     {
         glm::ivec2 chunk_coords = world_position_to_chunk_coords(position);
         Chunk* chunk = get_chunk(world, chunk_coords);
-        if (chunk)
+        if (chunk && chunk->blocks)
         {
             glm::ivec3 block_coords = world_position_to_block_coords(world, position);
             if (block_coords.x >= 0 && block_coords.x < Chunk::Width  &&
@@ -843,30 +2159,29 @@ namespace minecraft {
         return result;
     }
 
-    void save_chunks(World *world)
+    void save_chunks(World *world, Temprary_Memory_Arena *temp_arena)
     {
-        for (u32 i = 0; i < World::ChunkHashTableCapacity; i++)
-        {
-            if (get_entry_state(world->chunk_hash_table_values[i]) != ChunkHashTableEntryState_Occupied)
-            {
-                continue;
-            }
+        Serialize_Chunk_Job *serialize_chunk_jobs = ArenaBeginArray(temp_arena, Serialize_Chunk_Job);
 
-            u16 chunk_node_index = get_entry_value(world->chunk_hash_table_values[i]);
-            Chunk *chunk = &world->chunk_nodes[chunk_node_index].chunk;
-            Assert(chunk);
+        for (u32 i = 0; i < world->loaded_chunk_count; i++)
+        {
+            Chunk *chunk = world->loaded_chunks[i];
 
-            if (chunk->state > ChunkState_Initialized)
+            // note(harlequin): a far chunk saved its blocks when it gave them back
+            if (chunk->blocks && chunk->state > ChunkState_Initialized)
             {
                 chunk->state = ChunkState_PendingForSave;
 
-                Serialize_Chunk_Job job;
-                job.world = world;
-                job.chunk = chunk;
-                Job_System::schedule(job);
+                Serialize_Chunk_Job *job = ArenaPushArrayEntry(temp_arena, serialize_chunk_jobs);
+                Assert(job);
+                job->world = world;
+                job->chunk = chunk;
             }
         }
 
+        u32 serialize_chunk_job_count = (u32)ArenaEndArray(temp_arena, serialize_chunk_jobs);
+        Job_System::schedule_batch(serialize_chunk_jobs, serialize_chunk_job_count);
+
         Job_System::wait_for_jobs_to_finish();
     }
 
@@ -13,6 +13,8 @@
 #include <glm/glm.hpp>
 
 #include <array>
+#include <mutex>
+#include <condition_variable>
 
 namespace minecraft {
 
@@ -28,7 +30,19 @@ namespace minecraft {
         Chunk_Node *next;
     };
 
-    enum ChunkHashTableEntryState : u16
+    struct Chunk_Blocks_Node
+    {
+        Chunk_Blocks       chunk_blocks;
+        Chunk_Blocks_Node *next;
+    };
+
+    struct Chunk_Lod_Cells_Node
+    {
+        Chunk_Lod_Cells       chunk_lod_cells;
+        Chunk_Lod_Cells_Node *next;
+    };
+
+    enum ChunkHashTableEntryState : u32
     {
         ChunkHashTableEntryState_Empty    = 0x0,
         ChunkHashTableEntryState_Deleted  = 0x1,
@@ -42,6 +56,22 @@ namespace minecraft {
         Chunk      *chunk;
     };
 
+    // note(harlequin): the block id is written to the chunk by apply_block_edit, previous_block_id is filled in then
+    struct Block_Edit
+    {
+        Chunk      *chunk;
+        glm::ivec3  block_coords;
+        u16         previous_block_id;
+        u16         block_id;
+        bool        is_applied;
+    };
+
+    struct Light_Removal_Node
+    {
+        Light_Node node;
+        u8         light_level;
+    };
+
     struct Select_Block_Result
     {
         Block_Query_Result block_query;
@@ -55,13 +85,30 @@ namespace minecraft {
 
     struct World
     {
-        static constexpr i64 MaxChunkRadius            = 30;
+        // note(harlequin): the chunks up to MaxChunkRadius away from the player are lit and hold their blocks, the
+        // ones further away up to MaxFarChunkRadius only keep their lod cells, PendingFreeChunkRadius more chunks
+        // are kept around both regions as neighbours and so a chunk is not freed as soon as the player turns back
+        static constexpr i64 MaxChunkRadius            = 28;
+        static constexpr i64 MaxFarChunkRadius         = 48;
         static constexpr i64 PendingFreeChunkRadius    = 2;
-        static constexpr i64 ChunkCapacity             = 4 * (MaxChunkRadius + PendingFreeChunkRadius) * (MaxChunkRadius + PendingFreeChunkRadius);
-        static constexpr i64 SubChunkBucketCapacity    = 4 * ChunkCapacity;
-        static constexpr i64 SubChunkBucketFaceCount   = 1024;
-        static constexpr i64 SubChunkBucketVertexCount = 4 * SubChunkBucketFaceCount;
-        static constexpr i64 SubChunkBucketSize        = SubChunkBucketVertexCount * sizeof(Block_Face_Vertex);
+        static constexpr i64 ChunkBlocksCapacity       = (2 * (MaxChunkRadius + PendingFreeChunkRadius) + 1) * (2 * (MaxChunkRadius + PendingFreeChunkRadius) + 1);
+        static constexpr i64 ChunkCapacity             = (2 * (MaxFarChunkRadius + PendingFreeChunkRadius) + 1) * (2 * (MaxFarChunkRadius + PendingFreeChunkRadius) + 1);
+        static constexpr i64 SubChunkBucketCapacity    = 131072;
+
+        // note(harlequin): a chunk holds either its blocks or its lod cells, a far chunk that finds no free cells
+        // keeps or takes blocks instead so the two pools cover every loaded chunk whatever the active region is
+        static constexpr i64 ChunkLodCellsCapacity     = ChunkCapacity - ChunkBlocksCapacity;
+
+        // note(harlequin): sub chunk buckets are power of two runs of faces carved out of one face buffer, far chunks
+        // are meshed at MinFarLodLevel or coarser so they take a small share of the faces of the chunks holding blocks
+        static constexpr i64 SubChunkBucketMinFaceCount    = 32;
+        static constexpr i64 SubChunkBucketMaxFaceCount    = 16384;
+        static constexpr i64 SubChunkVertexBufferFaceCount = 1280 * SubChunkBucketMaxFaceCount;
+
+        // note(harlequin): how many sub chunks a light pass may remesh to move their buckets down the vertex buffer
+        static constexpr u32 SubChunkBucketDefragmentBudget = 16;
+
+        static constexpr u32 DefaultSubChunkMeshJobGroupSize = 4;
 
         f32 game_time_rate;
         f32 game_timer;
@@ -73,6 +120,13 @@ namespace minecraft {
         i32                 seed;
         World_Region_Bounds active_region_bounds;
 
+        // note(harlequin): chunks further than this from the player are meshed at a lower level of detail,
+        // every time the distance doubles the lod cells double in size
+        i32                 lod_chunk_radius;
+
+        // note(harlequin): how far the far chunks reach, never less than the radius of the active region
+        i32                 far_chunk_radius;
+
         static Block            null_block;
         static const Block_Info block_infos[BlockId_Count];  // todo(harlequin): this is going to be content driven in the future with the help of a tool
 
@@ -80,37 +134,125 @@ namespace minecraft {
         Chunk_Node  chunk_nodes[World::ChunkCapacity];
         Chunk_Node *first_free_chunk_node;
 
-        Sub_Chunk_Render_Data first_active_sub_chunk_render_data_sentinal;
-        Sub_Chunk_Render_Data *last_active_sub_chunk_render_data;
-
-        constexpr static u16 ChunkHashTableEntryStateMask = 0xC000;
-        constexpr static u16 ChunkHashTableEntryValueMask = 0x0FFF;
-        constexpr static i64 ChunkHashTableCapacity       = World::ChunkCapacity;
+        u32                free_chunk_blocks_count;
+        Chunk_Blocks_Node  chunk_blocks_nodes[World::ChunkBlocksCapacity];
+        Chunk_Blocks_Node *first_free_chunk_blocks_node;
+
+        u32                   free_chunk_lod_cells_count;
+        Chunk_Lod_Cells_Node  chunk_lod_cells_nodes[World::ChunkLodCellsCapacity];
+        Chunk_Lod_Cells_Node *first_free_chunk_lod_cells_node;
+
+        // note(harlequin): the chunks in the hash table and the ones taken out of it that wait for their save job,
+        // load_and_update_chunks walks these two instead of every chunk node
+        u32    loaded_chunk_count;
+        Chunk *loaded_chunks[World::ChunkCapacity];
+        u32    pending_free_chunk_count;
+        Chunk *pending_free_chunks[World::ChunkCapacity];
+
+        // note(harlequin): the chunks are only inserted again for a loaded region that moved or when a chunk could
+        // not be given a node or storage the last time
+        World_Region_Bounds loaded_region_bounds;
+        bool                has_pending_chunk_insertions;
+
+        // note(harlequin): the chunks that have sub chunks to draw this frame, rebuilt by load_and_update_chunks
+        u32    active_chunk_count;
+        Chunk *active_chunks[World::ChunkCapacity];
+
+        // note(harlequin): the chunks whose has_pending_light_blocks was set since the last light pass, a chunk is
+        // pushed once when its flag goes up so propagate_light_in_parallel never walks every chunk node
+        std::atomic< u32 > pending_light_chunk_count;
+        Chunk             *pending_light_chunks[World::ChunkCapacity];
+
+        // note(harlequin): the last find_reachable_sub_chunks, a chunk stamped with an older pass is not active
+        u32 visibility_pass_index;
+        u32 reachable_sub_chunk_count;
+        u64 last_visibility_pass_time;
+
+        // note(harlequin): twice the chunk capacity so a probe for a chunk that is not there ends at an empty entry
+        constexpr static u32 ChunkHashTableEntryStateMask = 0xC0000000;
+        constexpr static u32 ChunkHashTableEntryValueMask = 0x0000FFFF;
+        constexpr static i64 ChunkHashTableCapacity       = 2 * World::ChunkCapacity;
 
         glm::ivec2 chunk_hash_table_keys[World::ChunkHashTableCapacity];
-        u16        chunk_hash_table_values[World::ChunkHashTableCapacity];
+        u32        chunk_hash_table_values[World::ChunkHashTableCapacity];
+
+        std::mutex light_pass_mutex;
+        std::mutex update_chunk_jobs_queue_mutex;
 
         Circular_Queue< Update_Chunk_Job >                      update_chunk_jobs_queue;
         Circular_Queue< Calculate_Chunk_Light_Propagation_Job > light_propagation_queue;
         Circular_Queue< Calculate_Chunk_Lighting_Job >          calculate_chunk_lighting_queue;
+        Circular_Queue< Block_Edit, 4096 >                      block_edits_queue;
+
+        // note(harlequin): the light pass reads block ids without taking a lock, an edit made while a pass is running
+        // is deferred and applied by the light thread when it takes the edit off the queue, a full queue waits on
+        // block_edits_drained_cv for the light thread to drain it instead of dropping the edit
+        std::atomic< u32 >      deferred_block_edit_count;
+        std::condition_variable block_edits_drained_cv;
+
+        std::atomic< u64 > last_block_edit_light_update_time;
+
+        // note(harlequin): sub chunk remesh requests made by light writes and the updates they were coalesced into
+        std::atomic< u64 > dirty_sub_chunk_mark_count;
+        std::atomic< u64 > dirty_sub_chunk_flush_count;
+
+        // note(harlequin): the chunks that had a sub chunk marked dirty since the last flush, a chunk is pushed once
+        // when its is_dirty_chunk_listed flag goes up so flush_dirty_sub_chunks never walks every chunk node
+        std::mutex dirty_chunks_mutex;
+        u32        dirty_chunk_count;
+        Chunk     *dirty_chunks[World::ChunkCapacity];
+
+        // note(harlequin): how many pending sub chunks of a chunk are meshed by one job
+        std::atomic< u32 > sub_chunk_mesh_job_group_size;
+
+        // note(harlequin): from a chunk being queued for an update to its last sub chunk being uploaded
+        std::atomic< u64 > last_column_remesh_latency;
+        std::atomic< u64 > max_column_remesh_latency;
     };
 
-    inline ChunkHashTableEntryState get_entry_state(u16 entry)
+    static_assert(World::ChunkCapacity <= 0x10000,
+                  "a light node packs the chunk node index in its high 16 bits");
+
+    static_assert(Chunk::BlockCount <= 0x10000,
+                  "a light node packs the block index in its low 16 bits");
+
+    static_assert(World::ChunkCapacity <= World::ChunkHashTableEntryValueMask + 1,
+                  "a chunk hash table entry has to fit every chunk node index");
+
+    static_assert(World::SubChunkVertexBufferFaceCount % World::SubChunkBucketMaxFaceCount == 0,
+                  "the face buffer has to be made of whole runs of the largest bucket");
+
+    static_assert(World::SubChunkBucketMaxFaceCount >= Chunk::SubChunkBlockCount * 6,
+                  "a sub chunk bucket has to fit every face of a sub chunk");
+
+    inline u16 get_chunk_node_index(World *world, Chunk *chunk)
+    {
+        Chunk_Node *chunk_node = (Chunk_Node*)chunk;
+        Assert(chunk_node >= world->chunk_nodes && chunk_node < world->chunk_nodes + World::ChunkCapacity);
+        return (u16)(chunk_node - world->chunk_nodes);
+    }
+
+    inline Chunk* get_light_node_chunk(World *world, Light_Node node)
     {
-        return (ChunkHashTableEntryState)(entry >> 14);
+        return &world->chunk_nodes[get_light_node_chunk_node_index(node)].chunk;
     }
 
-    inline void set_entry_state(u16 &entry, ChunkHashTableEntryState state)
+    inline ChunkHashTableEntryState get_entry_state(u32 entry)
     {
-        entry = (entry & (~World::ChunkHashTableEntryStateMask)) | (state << 14);
+        return (ChunkHashTableEntryState)(entry >> 30);
     }
 
-    inline u16 get_entry_value(u16 entry)
+    inline void set_entry_state(u32 &entry, ChunkHashTableEntryState state)
     {
-        return entry & World::ChunkHashTableEntryValueMask;
+        entry = (entry & (~World::ChunkHashTableEntryStateMask)) | (state << 30);
     }
 
-    inline void set_entry_value(u16 &entry, u16 value)
+    inline u16 get_entry_value(u32 entry)
+    {
+        return (u16)(entry & World::ChunkHashTableEntryValueMask);
+    }
+
+    inline void set_entry_value(u32 &entry, u16 value)
     {
         entry = (entry & (~World::ChunkHashTableEntryValueMask)) | (value);
     }
@@ -133,9 +275,18 @@ namespace minecraft {
                                 u32 *out_seconds);
 
 
+    // note(harlequin): returns null when every chunk node is taken, the chunk is inserted once one is freed
     Chunk *allocate_chunk(World *world);
     void free_chunk(World *world, Chunk *chunk);
 
+    // note(harlequin): returns null when every chunk blocks is taken, the chunk stays far until one is given back
+    Chunk_Blocks *allocate_chunk_blocks(World *world);
+    void free_chunk_blocks(World *world, Chunk_Blocks *chunk_blocks);
+
+    // note(harlequin): returns null when every chunk lod cells is taken, a far chunk keeps its blocks then
+    Chunk_Lod_Cells *allocate_chunk_lod_cells(World *world);
+    void free_chunk_lod_cells(World *world, Chunk_Lod_Cells *chunk_lod_cells);
+
     Chunk *insert_and_allocate_chunk(World            *world,
                                      const glm::ivec2 &chunk_coords);
 
@@ -143,15 +294,19 @@ namespace minecraft {
 
     bool remove_chunk(World *world, const glm::ivec2& coords);
 
-    void load_and_update_chunks(World *world, const World_Region_Bounds& region_bounds);
+    void load_and_update_chunks(World *world,
+                                const World_Region_Bounds& region_bounds,
+                                Temprary_Memory_Arena *temp_arena);
 
     glm::ivec3 world_position_to_block_coords(World *world, const glm::vec3& position);
     World_Region_Bounds get_world_bounds_from_chunk_coords(i32 chunk_radius, const glm::ivec2& chunk_coords);
     bool is_chunk_in_region_bounds(const glm::ivec2& chunk_coords, const World_Region_Bounds& region_bounds);
+    u8 get_chunk_lod_level(const glm::ivec2& chunk_coords, const World_Region_Bounds& region_bounds, i32 lod_chunk_radius);
     bool is_block_query_valid(const Block_Query_Result& query);
     bool is_block_query_in_world_region(const Block_Query_Result& query, const World_Region_Bounds& bounds);
 
     Block* get_block(World *world, const glm::vec3& position);
+    bool is_block_exposed_to_sky(World *world, const glm::vec3& position);
     Block_Query_Result query_block(World *world, const glm::vec3& position);
 
     Block_Query_Result query_neighbour_block_from_top(Chunk *chunk,    const glm::ivec3& block_coords);
@@ -170,10 +325,59 @@ namespace minecraft {
                                     const glm::vec3 &view_direction,
                                     u32              max_block_select_dist_in_cube_units);
 
-    void set_block_id(Chunk *chunk, const glm::ivec3& block_coords, u16 block_id);
+    void queue_update_chunk_job(World *world, Chunk *chunk);
+    void mark_sub_chunk_dirty(World *world, Chunk *chunk, i32 sub_chunk_index);
+    u64 take_dirty_sub_chunk_mark_count();
+    void flush_dirty_sub_chunks(World *world);
+
+    // note(harlequin): walks the sub chunks of the active chunks that are in the frustum outwards from the sub chunk
+    // the view position is in, a sub chunk is left only through the faces its see through blocks connect to the face
+    // it was entered from and never in the direction opposite to a step taken on the way to it, sub chunks that are
+    // never reached are hidden behind opaque blocks, with should_cull_occluded_sub_chunks set to false every sub
+    // chunk of the active chunks is marked reachable
+    void find_reachable_sub_chunks(World                 *world,
+                                   const glm::vec3&       view_position,
+                                   const Frustum&         frustum,
+                                   bool                   should_cull_occluded_sub_chunks,
+                                   Temprary_Memory_Arena *temp_arena);
+
+    // note(harlequin): the edit is written to the chunk right away when no light pass is running and no earlier edit
+    // is deferred, otherwise the chunk keeps the old block id until the light thread applies the edit
+    void set_block_id(World *world, Chunk *chunk, const glm::ivec3& block_coords, u16 block_id);
+
+    // note(harlequin): writes the block id of the edit to its chunk and the edge blocks of its neighbours, has to be
+    // called with the light pass mutex held
+    void apply_block_edit(World *world, Block_Edit *block_edit);
     void set_block_sky_light_level(World *world, Chunk *chunk, const glm::ivec3& block_coords, u8 light_level);
     void set_block_light_source_level(World *world, Chunk *chunk, const glm::ivec3& block_coords, u8 light_level);
 
+    void push_pending_light_blocks(World *world, Circular_Queue< Light_Node > *queue);
+
+    // note(harlequin): returns the number of blocks taken out of the queue
+    u64 propagate_light(World *world,
+                        Circular_Queue< Light_Node > *queue,
+                        const World_Region_Bounds& region_bounds);
+
+    // note(harlequin): the light bfs before packed light nodes, kept as a baseline for benchmark_light_kernel
+    u64 propagate_light_with_block_queries(World *world,
+                                           Circular_Queue< Block_Query_Result > *queue,
+                                           const World_Region_Bounds& region_bounds);
+
+    void update_light_for_block_edit(World *world,
+                                     const Block_Edit& block_edit,
+                                     const World_Region_Bounds& region_bounds,
+                                     Circular_Queue< Light_Node > *light_queue,
+                                     Circular_Queue< Light_Removal_Node > *light_removal_queue);
+
+    void propagate_chunk_light(World *world,
+                               Chunk *chunk,
+                               const World_Region_Bounds& region_bounds,
+                               Temprary_Memory_Arena *temp_arena);
+
+    void propagate_light_in_parallel(World *world,
+                                     const World_Region_Bounds& region_bounds,
+                                     Temprary_Memory_Arena *temp_arena);
+
     inline const Block_Info* get_block_info(World *world, const Block *block)
     {
         return &world->block_infos[block->id];
@@ -190,5 +394,5 @@ namespace minecraft {
         return glm::max(get_sky_light_level(world, block_light_info), block_light_info->light_source_level);
     }
 
-    void save_chunks(World *world);
+    void save_chunks(World *world, Temprary_Memory_Arena *temp_arena);
 }
\ No newline at end of file
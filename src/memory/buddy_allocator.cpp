@@ -0,0 +1,530 @@
+#include "buddy_allocator.h"
+#include "memory/memory_arena.h"
+
+namespace minecraft {
+
+    static constexpr u8 BuddyBlockState_FreeBit   = 0x80;
+    static constexpr u8 BuddyBlockState_OrderMask = 0x0F;
+    static constexpr u8 BuddyBlockState_NotFirst  = 0x70;
+
+    static void set_free_block_bit(Buddy_Allocator *allocator, u32 order, u32 block_index)
+    {
+        u32 word_index = block_index >> 6;
+        allocator->free_block_bits[order][word_index] |= (u64)1 << (block_index & 63);
+        allocator->free_block_summary_bits[order][word_index >> 6] |= (u64)1 << (word_index & 63);
+        allocator->free_block_counts[order]++;
+    }
+
+    static void clear_free_block_bit(Buddy_Allocator *allocator, u32 order, u32 block_index)
+    {
+        u32 word_index = block_index >> 6;
+        u64& word = allocator->free_block_bits[order][word_index];
+        word &= ~((u64)1 << (block_index & 63));
+
+        if (!word)
+        {
+            allocator->free_block_summary_bits[order][word_index >> 6] &= ~((u64)1 << (word_index & 63));
+        }
+
+        allocator->free_block_counts[order]--;
+    }
+
+    // note(harlequin): returns the index of the lowest free block of the order in blocks of that order or -1
+    static i64 find_lowest_free_block(Buddy_Allocator *allocator, u32 order)
+    {
+        if (!allocator->free_block_counts[order])
+        {
+            return -1;
+        }
+
+        u32 summary_word_count = (allocator->free_block_word_counts[order] + 63) / 64;
+
+        for (u32 i = 0; i < summary_word_count; i++)
+        {
+            u64 summary_word = allocator->free_block_summary_bits[order][i];
+
+            if (summary_word)
+            {
+                u32 word_index = i * 64 + count_trailing_zeros(summary_word);
+                return (i64)word_index * 64 + count_trailing_zeros(allocator->free_block_bits[order][word_index]);
+            }
+        }
+
+        return -1;
+    }
+
+    static u32 get_buddy_order(Buddy_Allocator *allocator, u32 unit_count)
+    {
+        u32 block_count = (unit_count + (1 << allocator->min_block_unit_count_log2) - 1) >> allocator->min_block_unit_count_log2;
+
+        u32 order = 0;
+        while (((u32)1 << order) < block_count)
+        {
+            order++;
+        }
+
+        return order;
+    }
+
+    static i64 allocate_block(Buddy_Allocator *allocator, u32 order)
+    {
+        u32 found_order = order;
+        i64 block_index = -1;
+
+        for (; found_order < allocator->order_count; found_order++)
+        {
+            block_index = find_lowest_free_block(allocator, found_order);
+            if (block_index != -1)
+            {
+                break;
+            }
+        }
+
+        if (block_index == -1)
+        {
+            return -1;
+        }
+
+        clear_free_block_bit(allocator, found_order, (u32)block_index);
+
+        u32 first_block = (u32)block_index << found_order;
+
+        while (found_order > order)
+        {
+            found_order--;
+            u32 buddy = first_block + ((u32)1 << found_order);
+            allocator->block_states[buddy] = BuddyBlockState_FreeBit | (u8)found_order;
+            set_free_block_bit(allocator, found_order, buddy >> found_order);
+        }
+
+        allocator->block_states[first_block] = (u8)order;
+        allocator->allocated_unit_count += (u64)1 << (order + allocator->min_block_unit_count_log2);
+
+        return first_block;
+    }
+
+    static void free_block(Buddy_Allocator *allocator, u32 first_block)
+    {
+        u32 order = allocator->block_states[first_block] & BuddyBlockState_OrderMask;
+        Assert(!(allocator->block_states[first_block] & BuddyBlockState_FreeBit));
+
+        allocator->allocated_unit_count -= (u64)1 << (order + allocator->min_block_unit_count_log2);
+        allocator->block_tags[first_block].store(Buddy_Allocator::NullTag, std::memory_order_relaxed);
+
+        while (order + 1 < allocator->order_count)
+        {
+            u32 buddy = first_block ^ ((u32)1 << order);
+
+            if (allocator->block_states[buddy] != (BuddyBlockState_FreeBit | (u8)order))
+            {
+                break;
+            }
+
+            clear_free_block_bit(allocator, order, buddy >> order);
+
+            allocator->block_states[buddy]       = BuddyBlockState_NotFirst;
+            allocator->block_states[first_block] = BuddyBlockState_NotFirst;
+
+            first_block = Min(first_block, buddy);
+            order++;
+        }
+
+        allocator->block_states[first_block] = BuddyBlockState_FreeBit | (u8)order;
+        set_free_block_bit(allocator, order, first_block >> order);
+    }
+
+    bool initialize_buddy_allocator(Buddy_Allocator *allocator,
+                                    u64              unit_count,
+                                    u32              min_block_unit_count,
+                                    u32              max_block_unit_count,
+                                    Memory_Arena    *arena)
+    {
+        Assert(min_block_unit_count && (min_block_unit_count & (min_block_unit_count - 1)) == 0);
+        Assert(max_block_unit_count && (max_block_unit_count & (max_block_unit_count - 1)) == 0);
+        Assert(max_block_unit_count >= min_block_unit_count);
+        Assert(unit_count % max_block_unit_count == 0);
+
+        allocator->min_block_unit_count_log2 = count_trailing_zeros(min_block_unit_count);
+        allocator->order_count               = count_trailing_zeros(max_block_unit_count) - allocator->min_block_unit_count_log2 + 1;
+        allocator->block_count               = (u32)(unit_count >> allocator->min_block_unit_count_log2);
+        Assert(allocator->order_count <= Buddy_Allocator::MaxOrderCount);
+
+        allocator->block_states = ArenaPushArray(arena, u8, allocator->block_count);
+        allocator->block_tags   = ArenaPushArrayAligned(arena, std::atomic< u32 >, allocator->block_count);
+
+        if (!allocator->block_states || !allocator->block_tags)
+        {
+            return false;
+        }
+
+        memset(allocator->block_states, BuddyBlockState_NotFirst, allocator->block_count);
+
+        for (u32 i = 0; i < allocator->block_count; i++)
+        {
+            new (&allocator->block_tags[i]) std::atomic< u32 >(Buddy_Allocator::NullTag);
+        }
+
+        for (u32 order = 0; order < allocator->order_count; order++)
+        {
+            u32 word_count         = ((allocator->block_count >> order) + 63) / 64;
+            u32 summary_word_count = (word_count + 63) / 64;
+
+            allocator->free_block_bits[order]         = ArenaPushArrayAlignedZero(arena, u64, word_count);
+            allocator->free_block_summary_bits[order] = ArenaPushArrayAlignedZero(arena, u64, summary_word_count);
+            allocator->free_block_word_counts[order]  = word_count;
+            allocator->free_block_counts[order]       = 0;
+
+            if (!allocator->free_block_bits[order] || !allocator->free_block_summary_bits[order])
+            {
+                return false;
+            }
+        }
+
+        u32 top_order = allocator->order_count - 1;
+
+        for (u32 first_block = 0; first_block < allocator->block_count; first_block += (1 << top_order))
+        {
+            allocator->block_states[first_block] = BuddyBlockState_FreeBit | (u8)top_order;
+            set_free_block_bit(allocator, top_order, first_block >> top_order);
+        }
+
+        allocator->allocation_count     = 0;
+        allocator->allocated_unit_count = 0;
+        allocator->cached_unit_count    = 0;
+
+        new (&allocator->mutex) std::mutex;
+        return true;
+    }
+
+    i64 buddy_allocator_allocate(Buddy_Allocator              *allocator,
+                                 u32                           unit_count,
+                                 u32                           tag,
+                                 Buddy_Allocator_Thread_Cache *cache)
+    {
+        u32 order = get_buddy_order(allocator, unit_count);
+        if (order >= allocator->order_count)
+        {
+            return -1;
+        }
+
+        u64 block_unit_count = (u64)1 << (order + allocator->min_block_unit_count_log2);
+
+        if (cache && order < Buddy_Allocator_Thread_Cache::OrderCount)
+        {
+            u32& block_count = cache->block_counts[order];
+
+            if (block_count == 0)
+            {
+                std::unique_lock lock(allocator->mutex);
+
+                while (block_count < Buddy_Allocator_Thread_Cache::Capacity / 2)
+                {
+                    i64 first_block = allocate_block(allocator, order);
+                    if (first_block == -1)
+                    {
+                        break;
+                    }
+
+                    cache->blocks[order][block_count++] = (u32)first_block;
+                    allocator->cached_unit_count.fetch_add(block_unit_count, std::memory_order_relaxed);
+                }
+            }
+
+            if (block_count > 0)
+            {
+                u32 first_block = cache->blocks[order][--block_count];
+                allocator->cached_unit_count.fetch_sub(block_unit_count, std::memory_order_relaxed);
+                allocator->block_tags[first_block].store(tag, std::memory_order_relaxed);
+
+                std::unique_lock lock(allocator->mutex);
+                allocator->allocation_count++;
+                return (i64)first_block << allocator->min_block_unit_count_log2;
+            }
+
+            return -1;
+        }
+
+        std::unique_lock lock(allocator->mutex);
+
+        i64 first_block = allocate_block(allocator, order);
+        if (first_block == -1)
+        {
+            return -1;
+        }
+
+        allocator->block_tags[first_block].store(tag, std::memory_order_relaxed);
+        allocator->allocation_count++;
+        return first_block << allocator->min_block_unit_count_log2;
+    }
+
+    void buddy_allocator_free(Buddy_Allocator              *allocator,
+                              i64                           offset,
+                              Buddy_Allocator_Thread_Cache *cache)
+    {
+        u32 first_block = (u32)(offset >> allocator->min_block_unit_count_log2);
+        Assert(first_block < allocator->block_count);
+
+        // note(harlequin): the state of an allocated run only changes when it is freed so the owner can read it
+        u32 order = allocator->block_states[first_block] & BuddyBlockState_OrderMask;
+
+        if (cache && order < Buddy_Allocator_Thread_Cache::OrderCount)
+        {
+            u64 block_unit_count = (u64)1 << (order + allocator->min_block_unit_count_log2);
+            u32& block_count = cache->block_counts[order];
+
+            std::unique_lock lock(allocator->mutex);
+            allocator->allocation_count--;
+
+            if (block_count == Buddy_Allocator_Thread_Cache::Capacity)
+            {
+                while (block_count > Buddy_Allocator_Thread_Cache::Capacity / 2)
+                {
+                    free_block(allocator, cache->blocks[order][--block_count]);
+                    allocator->cached_unit_count.fetch_sub(block_unit_count, std::memory_order_relaxed);
+                }
+            }
+
+            allocator->block_tags[first_block].store(Buddy_Allocator::NullTag, std::memory_order_relaxed);
+            cache->blocks[order][block_count++] = first_block;
+            allocator->cached_unit_count.fetch_add(block_unit_count, std::memory_order_relaxed);
+            return;
+        }
+
+        std::unique_lock lock(allocator->mutex);
+        free_block(allocator, first_block);
+        allocator->allocation_count--;
+    }
+
+    i64 buddy_allocator_reallocate(Buddy_Allocator              *allocator,
+                                   i64                           offset,
+                                   u32                           unit_count,
+                                   u32                           tag,
+                                   Buddy_Allocator_Thread_Cache *cache)
+    {
+        if (offset != -1)
+        {
+            u32 first_block = (u32)(offset >> allocator->min_block_unit_count_log2);
+            u32 order       = allocator->block_states[first_block] & BuddyBlockState_OrderMask;
+
+            if (order == get_buddy_order(allocator, unit_count))
+            {
+                std::unique_lock lock(allocator->mutex);
+
+                i64 lowest_free_block = find_lowest_free_block(allocator, order);
+                if (lowest_free_block == -1 || ((u32)lowest_free_block << order) > first_block)
+                {
+                    allocator->block_tags[first_block].store(tag, std::memory_order_relaxed);
+                    return offset;
+                }
+            }
+
+            buddy_allocator_free(allocator, offset, cache);
+        }
+
+        return buddy_allocator_allocate(allocator, unit_count, tag, cache);
+    }
+
+    u32 buddy_allocator_get_run_unit_count(Buddy_Allocator *allocator, i64 offset)
+    {
+        u32 first_block = (u32)(offset >> allocator->min_block_unit_count_log2);
+        u32 order       = allocator->block_states[first_block] & BuddyBlockState_OrderMask;
+        return (u32)1 << (order + allocator->min_block_unit_count_log2);
+    }
+
+    void buddy_allocator_set_run_tag(Buddy_Allocator *allocator, i64 offset, u32 tag)
+    {
+        u32 first_block = (u32)(offset >> allocator->min_block_unit_count_log2);
+        Assert(!(allocator->block_states[first_block] & BuddyBlockState_FreeBit));
+        allocator->block_tags[first_block].store(tag, std::memory_order_relaxed);
+    }
+
+    void buddy_allocator_flush_thread_cache(Buddy_Allocator              *allocator,
+                                            Buddy_Allocator_Thread_Cache *cache)
+    {
+        std::unique_lock lock(allocator->mutex);
+
+        for (u32 order = 0; order < Buddy_Allocator_Thread_Cache::OrderCount; order++)
+        {
+            u64 block_unit_count = (u64)1 << (order + allocator->min_block_unit_count_log2);
+
+            while (cache->block_counts[order])
+            {
+                free_block(allocator, cache->blocks[order][--cache->block_counts[order]]);
+                allocator->cached_unit_count.fetch_sub(block_unit_count, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    u32 buddy_allocator_find_relocatable_runs(Buddy_Allocator *allocator,
+                                              u32             *tags,
+                                              u32              max_tag_count)
+    {
+        std::unique_lock lock(allocator->mutex);
+
+        u32 lowest_free_blocks[Buddy_Allocator::MaxOrderCount];
+        u32 lowest_free_block = allocator->block_count;
+
+        for (u32 order = 0; order < allocator->order_count; order++)
+        {
+            i64 block_index = find_lowest_free_block(allocator, order);
+            lowest_free_blocks[order] = block_index == -1 ? allocator->block_count : (u32)block_index << order;
+            lowest_free_block = Min(lowest_free_block, lowest_free_blocks[order]);
+        }
+
+        u32 tag_count         = 0;
+        u32 top_order         = allocator->order_count - 1;
+        u32 region_block_count = 1 << top_order;
+
+        for (i64 region_first_block = allocator->block_count - region_block_count;
+             region_first_block >= 0 && (u32)region_first_block + region_block_count > lowest_free_block;
+             region_first_block -= region_block_count)
+        {
+            u32 region_end = (u32)region_first_block + region_block_count;
+
+            for (u32 first_block = (u32)region_first_block; first_block < region_end;)
+            {
+                u8  state = allocator->block_states[first_block];
+                u32 order = state & BuddyBlockState_OrderMask;
+
+                if (!(state & BuddyBlockState_FreeBit) && lowest_free_blocks[order] < first_block)
+                {
+                    u32 tag = allocator->block_tags[first_block].load(std::memory_order_relaxed);
+                    if (tag != Buddy_Allocator::NullTag)
+                    {
+                        tags[tag_count++] = tag;
+                        if (tag_count == max_tag_count)
+                        {
+                            return tag_count;
+                        }
+                    }
+                }
+
+                first_block += 1 << order;
+            }
+        }
+
+        return tag_count;
+    }
+
+    Buddy_Allocator_Stats get_buddy_allocator_stats(Buddy_Allocator *allocator)
+    {
+        std::unique_lock lock(allocator->mutex);
+
+        Buddy_Allocator_Stats stats = {};
+        stats.unit_count           = (u64)allocator->block_count << allocator->min_block_unit_count_log2;
+        stats.cached_unit_count    = allocator->cached_unit_count.load(std::memory_order_relaxed);
+        stats.allocated_unit_count = allocator->allocated_unit_count - stats.cached_unit_count;
+        stats.allocation_count     = allocator->allocation_count;
+
+        for (u32 order = 0; order < allocator->order_count; order++)
+        {
+            u64 block_unit_count = (u64)1 << (order + allocator->min_block_unit_count_log2);
+
+            stats.free_block_counts[order] = allocator->free_block_counts[order];
+            stats.free_block_count        += allocator->free_block_counts[order];
+            stats.free_unit_count         += allocator->free_block_counts[order] * block_unit_count;
+
+            if (allocator->free_block_counts[order])
+            {
+                stats.largest_free_block_unit_count = block_unit_count;
+            }
+        }
+
+        return stats;
+    }
+
+    bool validate_buddy_allocator(Buddy_Allocator *allocator)
+    {
+        std::unique_lock lock(allocator->mutex);
+
+        u32 free_block_counts[Buddy_Allocator::MaxOrderCount] = {};
+        u64 allocated_unit_count = 0;
+
+        for (u32 first_block = 0; first_block < allocator->block_count;)
+        {
+            u8  state = allocator->block_states[first_block];
+            u32 order = state & BuddyBlockState_OrderMask;
+
+            if (state == BuddyBlockState_NotFirst ||
+                order >= allocator->order_count ||
+                (first_block & ((1 << order) - 1)) != 0)
+            {
+                return false;
+            }
+
+            u32 block_index = first_block >> order;
+            bool is_free_bit_set = (allocator->free_block_bits[order][block_index >> 6] >> (block_index & 63)) & 1;
+
+            if (state & BuddyBlockState_FreeBit)
+            {
+                if (!is_free_bit_set)
+                {
+                    return false;
+                }
+
+                // note(harlequin): a free run next to its free buddy should have been coalesced
+                u32 buddy = first_block ^ (1 << order);
+                if (order + 1 < allocator->order_count &&
+                    allocator->block_states[buddy] == (BuddyBlockState_FreeBit | (u8)order))
+                {
+                    return false;
+                }
+
+                free_block_counts[order]++;
+            }
+            else
+            {
+                if (is_free_bit_set)
+                {
+                    return false;
+                }
+
+                allocated_unit_count += (u64)1 << (order + allocator->min_block_unit_count_log2);
+            }
+
+            for (u32 i = 1; i < ((u32)1 << order); i++)
+            {
+                if (allocator->block_states[first_block + i] != BuddyBlockState_NotFirst)
+                {
+                    return false;
+                }
+            }
+
+            first_block += 1 << order;
+        }
+
+        for (u32 order = 0; order < allocator->order_count; order++)
+        {
+            if (free_block_counts[order] != allocator->free_block_counts[order])
+            {
+                return false;
+            }
+
+            u32 set_bit_count = 0;
+
+            for (u32 i = 0; i < allocator->free_block_word_counts[order]; i++)
+            {
+                u64 word = allocator->free_block_bits[order][i];
+
+                bool is_summary_bit_set = (allocator->free_block_summary_bits[order][i >> 6] >> (i & 63)) & 1;
+                if (is_summary_bit_set != (word != 0))
+                {
+                    return false;
+                }
+
+                while (word)
+                {
+                    word &= word - 1;
+                    set_bit_count++;
+                }
+            }
+
+            if (set_bit_count != free_block_counts[order])
+            {
+                return false;
+            }
+        }
+
+        return allocated_unit_count == allocator->allocated_unit_count;
+    }
+}
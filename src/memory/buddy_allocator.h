@@ -0,0 +1,110 @@
+#pragma once
+
+#include "core/common.h"
+
+#include <atomic>
+#include <mutex>
+
+namespace minecraft {
+
+    struct Memory_Arena;
+
+    // note(harlequin): hands out power of two runs of units from a fixed range, what a unit is is up to the caller
+    // (the renderer uses block faces of the chunk vertex buffer), the bookkeeping lives in cpu memory only so the
+    // allocator never reads the memory it manages and it can run without a gpu
+    struct Buddy_Allocator_Stats
+    {
+        u64 unit_count;
+        u64 allocated_unit_count;
+        u64 cached_unit_count;
+        u64 free_unit_count;
+        u64 largest_free_block_unit_count;
+        u32 allocation_count;
+        u32 free_block_count;
+        u32 free_block_counts[16];
+    };
+
+    struct Buddy_Allocator_Thread_Cache
+    {
+        // note(harlequin): only the smallest orders are cached, they are the bulk of the allocations
+        static constexpr u32 OrderCount = 2;
+        static constexpr u32 Capacity   = 8;
+
+        u32 blocks[OrderCount][Capacity];
+        u32 block_counts[OrderCount];
+    };
+
+    struct Buddy_Allocator
+    {
+        static constexpr u32 MaxOrderCount = 16;
+        static constexpr u32 NullTag       = 0xFFFFFFFF;
+
+        u32 min_block_unit_count_log2;
+        u32 order_count;
+        u32 block_count; // in blocks of the smallest order
+
+        // note(harlequin): one entry per smallest block, only the entry at the first block of a run means
+        // anything, it holds the order of the run and whether the run is free
+        u8 *block_states;
+
+        // note(harlequin): the user tag of each allocated run, written at its first block
+        std::atomic< u32 > *block_tags;
+
+        // note(harlequin): a bit per block of each order that is set while that block is free, plus a summary
+        // bit per word so the lowest free block is found without walking every word
+        u64 *free_block_bits[MaxOrderCount];
+        u64 *free_block_summary_bits[MaxOrderCount];
+        u32  free_block_word_counts[MaxOrderCount];
+        u32  free_block_counts[MaxOrderCount];
+
+        u32 allocation_count;
+        u64 allocated_unit_count;
+
+        std::atomic< u64 > cached_unit_count;
+
+        std::mutex mutex;
+    };
+
+    bool initialize_buddy_allocator(Buddy_Allocator *allocator,
+                                    u64              unit_count,
+                                    u32              min_block_unit_count,
+                                    u32              max_block_unit_count,
+                                    Memory_Arena    *arena);
+
+    // note(harlequin): returns the unit offset of the run or -1, the run is at the lowest free address that fits
+    i64 buddy_allocator_allocate(Buddy_Allocator              *allocator,
+                                 u32                           unit_count,
+                                 u32                           tag,
+                                 Buddy_Allocator_Thread_Cache *cache = nullptr);
+
+    void buddy_allocator_free(Buddy_Allocator              *allocator,
+                              i64                           offset,
+                              Buddy_Allocator_Thread_Cache *cache = nullptr);
+
+    // note(harlequin): keeps the run if it already has the order unit_count needs and no free run of that
+    // order sits below it, otherwise the run is moved down (or resized), the caller refills the new run
+    i64 buddy_allocator_reallocate(Buddy_Allocator              *allocator,
+                                   i64                           offset,
+                                   u32                           unit_count,
+                                   u32                           tag,
+                                   Buddy_Allocator_Thread_Cache *cache = nullptr);
+
+    u32 buddy_allocator_get_run_unit_count(Buddy_Allocator *allocator, i64 offset);
+
+    void buddy_allocator_set_run_tag(Buddy_Allocator *allocator, i64 offset, u32 tag);
+
+    void buddy_allocator_flush_thread_cache(Buddy_Allocator              *allocator,
+                                            Buddy_Allocator_Thread_Cache *cache);
+
+    // note(harlequin): walks the address range from the top and returns the tags of up to max_tag_count runs
+    // that have a free run of their order below them, reallocating those moves them down and lets the free
+    // runs above them coalesce
+    u32 buddy_allocator_find_relocatable_runs(Buddy_Allocator *allocator,
+                                              u32             *tags,
+                                              u32              max_tag_count);
+
+    Buddy_Allocator_Stats get_buddy_allocator_stats(Buddy_Allocator *allocator);
+
+    // note(harlequin): checks that the block states, the free bits and the counters agree
+    bool validate_buddy_allocator(Buddy_Allocator *allocator);
+}
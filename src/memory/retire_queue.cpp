@@ -0,0 +1,102 @@
+#include "retire_queue.h"
+#include "memory/memory_arena.h"
+#include "memory/buddy_allocator.h"
+
+namespace minecraft {
+
+    bool initialize_retire_queue(Retire_Queue    *queue,
+                                 Buddy_Allocator *allocator,
+                                 Memory_Arena    *arena)
+    {
+        // note(harlequin): every run takes at least one block so there are never more retired runs than blocks
+        u32 capacity = allocator->block_count;
+        Assert(capacity);
+
+        queue->runs = ArenaPushArrayAligned(arena, Retired_Run, capacity);
+        if (!queue->runs)
+        {
+            return false;
+        }
+
+        queue->capacity                  = capacity;
+        queue->min_block_unit_count_log2 = allocator->min_block_unit_count_log2;
+        queue->first_run_index           = 0;
+        queue->run_count                 = 0;
+        queue->unit_count                = 0;
+        queue->total_retired_run_count   = 0;
+        queue->total_freed_run_count     = 0;
+
+        new (&queue->mutex) std::mutex;
+        return true;
+    }
+
+    void retire_run(Retire_Queue    *queue,
+                    Buddy_Allocator *allocator,
+                    i64              offset,
+                    u64              frame_index)
+    {
+        Assert(offset != -1);
+
+        buddy_allocator_set_run_tag(allocator, offset, Buddy_Allocator::NullTag);
+        u32 unit_count = buddy_allocator_get_run_unit_count(allocator, offset);
+
+        std::unique_lock lock(queue->mutex);
+
+        // note(harlequin): the run is still allocated so the queue can't be full of other runs
+        Assert(queue->run_count < queue->capacity);
+
+        u32 run_index = queue->first_run_index + queue->run_count;
+        if (run_index >= queue->capacity) run_index -= queue->capacity;
+
+        queue->runs[run_index] = { (u32)(offset >> queue->min_block_unit_count_log2), (u32)frame_index };
+        queue->run_count++;
+        queue->unit_count += unit_count;
+        queue->total_retired_run_count++;
+    }
+
+    u32 free_retired_runs(Retire_Queue                 *queue,
+                          Buddy_Allocator              *allocator,
+                          u64                           first_pending_frame_index,
+                          Buddy_Allocator_Thread_Cache *cache)
+    {
+        std::unique_lock lock(queue->mutex);
+
+        u32 freed_run_count = 0;
+
+        while (queue->run_count)
+        {
+            const Retired_Run& run = queue->runs[queue->first_run_index];
+
+            // note(harlequin): a run is never retired more than 2^31 frames ahead of the fence so the difference of
+            // the low bits orders the frames across a wrap
+            if ((i32)(run.frame_index - (u32)first_pending_frame_index) >= 0)
+            {
+                break;
+            }
+
+            i64 offset = (i64)run.block_index << queue->min_block_unit_count_log2;
+            queue->unit_count -= buddy_allocator_get_run_unit_count(allocator, offset);
+            buddy_allocator_free(allocator, offset, cache);
+
+            queue->first_run_index++;
+            if (queue->first_run_index == queue->capacity) queue->first_run_index = 0;
+            queue->run_count--;
+            freed_run_count++;
+        }
+
+        queue->total_freed_run_count += freed_run_count;
+        return freed_run_count;
+    }
+
+    Retire_Queue_Stats get_retire_queue_stats(Retire_Queue *queue)
+    {
+        std::unique_lock lock(queue->mutex);
+
+        Retire_Queue_Stats stats;
+        stats.run_count               = queue->run_count;
+        stats.unit_count              = queue->unit_count;
+        stats.total_retired_run_count = queue->total_retired_run_count;
+        stats.total_freed_run_count   = queue->total_freed_run_count;
+        return stats;
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "core/common.h"
+
+#include <mutex>
+
+namespace minecraft {
+
+    struct Memory_Arena;
+    struct Buddy_Allocator;
+    struct Buddy_Allocator_Thread_Cache;
+
+    // note(harlequin): runs of a buddy allocator that the gpu may still be reading, a run is stamped with the frame
+    // that was being recorded when it was retired and goes back to the allocator once every frame up to that one is
+    // done on the gpu, the queue only deals in frame indices so it runs without a gpu.
+    // a run is kept as the index of its first block and the low bits of its frame, the queue has one entry for
+    // every block of the allocator so it holds every run the allocator can hand out and a retire never waits
+    struct Retired_Run
+    {
+        u32 block_index;
+        u32 frame_index;
+    };
+
+    struct Retire_Queue_Stats
+    {
+        u32 run_count;
+        u64 unit_count;
+        u64 total_retired_run_count;
+        u64 total_freed_run_count;
+    };
+
+    struct Retire_Queue
+    {
+        u32          capacity;
+        u32          min_block_unit_count_log2;
+        u32          first_run_index;
+        u32          run_count;
+        Retired_Run *runs;
+
+        u64 unit_count;
+        u64 total_retired_run_count;
+        u64 total_freed_run_count;
+
+        std::mutex mutex;
+    };
+
+    bool initialize_retire_queue(Retire_Queue    *queue,
+                                 Buddy_Allocator *allocator,
+                                 Memory_Arena    *arena);
+
+    // note(harlequin): frame_index is the frame being recorded, it may still draw the run, the tag of the run is
+    // cleared so it is never handed out for relocation
+    void retire_run(Retire_Queue    *queue,
+                    Buddy_Allocator *allocator,
+                    i64              offset,
+                    u64              frame_index);
+
+    // note(harlequin): frees the runs retired before first_pending_frame_index, the frames before it have to be
+    // done on the gpu, runs are freed in the order they were retired so a run that was stamped with an older
+    // frame than the run in front of it waits for that one, returns how many runs were freed
+    u32 free_retired_runs(Retire_Queue                 *queue,
+                          Buddy_Allocator              *allocator,
+                          u64                           first_pending_frame_index,
+                          Buddy_Allocator_Thread_Cache *cache = nullptr);
+
+    Retire_Queue_Stats get_retire_queue_stats(Retire_Queue *queue);
+}
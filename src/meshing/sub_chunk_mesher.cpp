@@ -0,0 +1,2333 @@
+#include "meshing/sub_chunk_mesher.h"
+#include "game/world.h"
+#include "game/job_system.h"
+#include "memory/memory_arena.h"
+
+#include <atomic>
+#include <mutex>
+
+namespace minecraft {
+
+// note(harlequin): a block face is a single 64 bit record that the vertex shader expands into the two triangles
+// of its quad with gl_VertexID, the texture and the flags of a face are looked up by block id in the shader
+//
+// attributes0: x 4 bits, y 3 bits (inside the sub chunk), z 4 bits, face 3 bits, block id 7 bits, lod level 2 bits,
+//              the uniform bit and the ambient occlusion level of each corner in 2 bits
+// attributes1: the sky light level and the light source level of each corner in a byte, a uniform face (all four
+//              corners the same, as every greedy merged quad is) keeps corner 0 followed by the texture repeat counts
+
+// attributes0 masks
+#define BLOCK_X_MASK 15 // 4 bits
+#define BLOCK_Y_MASK 7 // 3 bits
+#define BLOCK_Z_MASK 15 // 4 bits
+#define FACE_ID_MASK 7 // 3 bits
+#define BLOCK_ID_MASK 127 // 7 bits
+#define LOD_LEVEL_MASK 3 // 2 bits
+#define UNIFORM_FACE_BIT (1u << 23)
+#define AMBIENT_OCCLUSION_LEVEL_MASK 3 // 2 bits per corner
+
+// attributes1 masks
+#define SKY_LIGHT_LEVEL_MASK 15 // 4 bits
+#define LIGHT_SOURCE_LEVEL_MASK 15 // 4 bits
+#define TEXTURE_REPEAT_MASK 15 // 4 bits
+
+    static_assert(sizeof(Block_Face) == 8, "a block face has to be one 64 bit record");
+    static_assert(BlockId_Count <= BLOCK_ID_MASK + 1, "a block id has to fit in a block face");
+    static_assert(Chunk::SubChunkHeight <= BLOCK_Y_MASK + 1, "a sub chunk y has to fit in a block face");
+
+    // note(harlequin): the light of a face corner, the sky light level in the low nibble, the light source level
+    // in the high nibble and the ambient occlusion level above them
+    static constexpr u32 pack_corner_light(u32 sky_light_level,
+                                           u32 light_source_level,
+                                           u32 ambient_occlusion_level)
+    {
+        return sky_light_level | (light_source_level << 4) | (ambient_occlusion_level << 8);
+    }
+
+    struct Unpacked_Block_Face
+    {
+        i32 x;
+        i32 y;
+        i32 z;
+        u32 face_id;
+        u32 block_id;
+        u32 lod_level;
+        u32 texture_repeat_u_count;
+        u32 texture_repeat_v_count;
+        u32 corner_lights[4];
+    };
+
+    // note(harlequin): x, y and z are the first block (or lod cell) of the face in sub chunk coordinates,
+    // only a uniform face can repeat its texture
+    static constexpr Block_Face pack_block_face(i32 x,
+                                                i32 y,
+                                                i32 z,
+                                                u32 face_id,
+                                                u32 block_id,
+                                                u32 lod_level,
+                                                const u32 corner_lights[4],
+                                                u32 texture_repeat_u_count = 1,
+                                                u32 texture_repeat_v_count = 1)
+    {
+        bool is_uniform = corner_lights[0] == corner_lights[1] &&
+                          corner_lights[0] == corner_lights[2] &&
+                          corner_lights[0] == corner_lights[3];
+
+        Assert(x >= 0 && x <= BLOCK_X_MASK && y >= 0 && y <= BLOCK_Y_MASK && z >= 0 && z <= BLOCK_Z_MASK);
+        Assert(block_id <= BLOCK_ID_MASK);
+        Assert(lod_level <= LOD_LEVEL_MASK);
+        Assert(texture_repeat_u_count >= 1 && texture_repeat_u_count - 1 <= TEXTURE_REPEAT_MASK);
+        Assert(texture_repeat_v_count >= 1 && texture_repeat_v_count - 1 <= TEXTURE_REPEAT_MASK);
+        Assert(is_uniform || (texture_repeat_u_count == 1 && texture_repeat_v_count == 1));
+
+        u32 attributes0 = 0;
+        attributes0 |= (u32)x;
+        attributes0 |= (u32)y << 4;
+        attributes0 |= (u32)z << 7;
+        attributes0 |= face_id << 11;
+        attributes0 |= block_id << 14;
+        attributes0 |= lod_level << 21;
+
+        u32 attributes1 = 0;
+
+        if (is_uniform)
+        {
+            attributes0 |= UNIFORM_FACE_BIT;
+            attributes0 |= (corner_lights[0] >> 8) << 24;
+            attributes1 |= corner_lights[0] & 0xFF;
+            attributes1 |= (texture_repeat_u_count - 1) << 8;
+            attributes1 |= (texture_repeat_v_count - 1) << 12;
+        }
+        else
+        {
+            for (u32 corner = 0; corner < 4; corner++)
+            {
+                attributes0 |= (corner_lights[corner] >> 8) << (24 + corner * 2);
+                attributes1 |= (corner_lights[corner] & 0xFF) << (corner * 8);
+            }
+        }
+
+        return { attributes0, attributes1 };
+    }
+
+    static constexpr Unpacked_Block_Face unpack_block_face(const Block_Face& block_face)
+    {
+        u32 attributes0 = block_face.packed_face_attributes0;
+        u32 attributes1 = block_face.packed_face_attributes1;
+
+        Unpacked_Block_Face result = {};
+        result.x         = attributes0 & BLOCK_X_MASK;
+        result.y         = (attributes0 >> 4) & BLOCK_Y_MASK;
+        result.z         = (attributes0 >> 7) & BLOCK_Z_MASK;
+        result.face_id   = (attributes0 >> 11) & FACE_ID_MASK;
+        result.block_id  = (attributes0 >> 14) & BLOCK_ID_MASK;
+        result.lod_level = (attributes0 >> 21) & LOD_LEVEL_MASK;
+
+        if (attributes0 & UNIFORM_FACE_BIT)
+        {
+            u32 corner_light = (attributes1 & 0xFF) | (((attributes0 >> 24) & AMBIENT_OCCLUSION_LEVEL_MASK) << 8);
+
+            for (u32 corner = 0; corner < 4; corner++)
+            {
+                result.corner_lights[corner] = corner_light;
+            }
+
+            result.texture_repeat_u_count = ((attributes1 >> 8)  & TEXTURE_REPEAT_MASK) + 1;
+            result.texture_repeat_v_count = ((attributes1 >> 12) & TEXTURE_REPEAT_MASK) + 1;
+        }
+        else
+        {
+            for (u32 corner = 0; corner < 4; corner++)
+            {
+                result.corner_lights[corner] = ((attributes1 >> (corner * 8)) & 0xFF) |
+                                               (((attributes0 >> (24 + corner * 2)) & AMBIENT_OCCLUSION_LEVEL_MASK) << 8);
+            }
+
+            result.texture_repeat_u_count = 1;
+            result.texture_repeat_v_count = 1;
+        }
+
+        return result;
+    }
+
+    static constexpr bool does_block_face_round_trip(i32 x,
+                                                     i32 y,
+                                                     i32 z,
+                                                     u32 face_id,
+                                                     u32 block_id,
+                                                     u32 lod_level,
+                                                     u32 corner_light0,
+                                                     u32 corner_light1,
+                                                     u32 corner_light2,
+                                                     u32 corner_light3,
+                                                     u32 texture_repeat_u_count,
+                                                     u32 texture_repeat_v_count)
+    {
+        u32 corner_lights[4] = { corner_light0, corner_light1, corner_light2, corner_light3 };
+
+        Unpacked_Block_Face result = unpack_block_face(pack_block_face(x, y, z,
+                                                                       face_id,
+                                                                       block_id,
+                                                                       lod_level,
+                                                                       corner_lights,
+                                                                       texture_repeat_u_count,
+                                                                       texture_repeat_v_count));
+
+        bool do_corner_lights_match = true;
+        for (u32 corner = 0; corner < 4; corner++)
+        {
+            do_corner_lights_match = do_corner_lights_match && result.corner_lights[corner] == corner_lights[corner];
+        }
+
+        return result.x == x && result.y == y && result.z == z &&
+               result.face_id == face_id &&
+               result.block_id == block_id &&
+               result.lod_level == lod_level &&
+               result.texture_repeat_u_count == texture_repeat_u_count &&
+               result.texture_repeat_v_count == texture_repeat_v_count &&
+               do_corner_lights_match;
+    }
+
+    static_assert(does_block_face_round_trip(0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1));
+    static_assert(does_block_face_round_trip(15, 7, 15, 5, BlockId_Count - 1, 3, 0x3FF, 0x3FF, 0x3FF, 0x3FF, 16, 16));
+    static_assert(does_block_face_round_trip(3, 5, 9, 2, 7, 0, pack_corner_light(15, 0, 3), pack_corner_light(0, 15, 0), pack_corner_light(7, 8, 1), pack_corner_light(15, 15, 2), 1, 1));
+    static_assert(does_block_face_round_trip(15, 0, 0, 4, 1, 1, pack_corner_light(4, 9, 2), pack_corner_light(4, 9, 2), pack_corner_light(4, 9, 2), pack_corner_light(4, 9, 2), 16, 3));
+
+    struct Shader_Block_Face_Corner
+    {
+        u32 block_x;
+        u32 block_y;
+        u32 block_z;
+        u32 face_id;
+        u32 block_id;
+        u32 lod_level;
+        u32 corner_light;
+        u32 texture_repeat_u_count;
+        u32 texture_repeat_v_count;
+    };
+
+    // note(harlequin): the decoding of one face corner in opaque_chunk.glsl and transparent_chunk.glsl written out
+    // the same way, it has to change with them, block_y is inside the sub chunk as the shader adds the sub chunk
+    // base on top
+    static Shader_Block_Face_Corner decode_block_face_corner_like_shader(const Block_Face& block_face, u32 face_corner_id)
+    {
+        u32 packed_face_attributes0 = block_face.packed_face_attributes0;
+        u32 packed_face_attributes1 = block_face.packed_face_attributes1;
+
+        Shader_Block_Face_Corner result = {};
+        result.block_x   = packed_face_attributes0 & BLOCK_X_MASK;
+        result.block_y   = (packed_face_attributes0 >> 4) & BLOCK_Y_MASK;
+        result.block_z   = (packed_face_attributes0 >> 7) & BLOCK_Z_MASK;
+        result.face_id   = (packed_face_attributes0 >> 11) & FACE_ID_MASK;
+        result.block_id  = (packed_face_attributes0 >> 14) & BLOCK_ID_MASK;
+        result.lod_level = (packed_face_attributes0 >> 21) & LOD_LEVEL_MASK;
+
+        result.texture_repeat_u_count = 1;
+        result.texture_repeat_v_count = 1;
+
+        if ((packed_face_attributes0 & UNIFORM_FACE_BIT) != 0)
+        {
+            result.corner_light = (packed_face_attributes1 & 0xFF) | (((packed_face_attributes0 >> 24) & AMBIENT_OCCLUSION_LEVEL_MASK) << 8);
+            result.texture_repeat_u_count = ((packed_face_attributes1 >> 8)  & TEXTURE_REPEAT_MASK) + 1;
+            result.texture_repeat_v_count = ((packed_face_attributes1 >> 12) & TEXTURE_REPEAT_MASK) + 1;
+        }
+        else
+        {
+            result.corner_light = ((packed_face_attributes1 >> (face_corner_id * 8u)) & 0xFF) |
+                                  (((packed_face_attributes0 >> (24u + face_corner_id * 2u)) & AMBIENT_OCCLUSION_LEVEL_MASK) << 8);
+        }
+
+        return result;
+    }
+
+    // note(harlequin): whether unpack_block_face and every corner the shader decodes give back the expected face
+    static bool does_block_face_decode_to(const Block_Face& block_face, const Unpacked_Block_Face& expected)
+    {
+        Unpacked_Block_Face unpacked = unpack_block_face(block_face);
+
+        if (memcmp(&unpacked, &expected, sizeof(Unpacked_Block_Face)) != 0)
+        {
+            return false;
+        }
+
+        for (u32 corner = 0; corner < 4; corner++)
+        {
+            Shader_Block_Face_Corner decoded = decode_block_face_corner_like_shader(block_face, corner);
+
+            if (decoded.block_x                != (u32)expected.x                ||
+                decoded.block_y                != (u32)expected.y                ||
+                decoded.block_z                != (u32)expected.z                ||
+                decoded.face_id                != expected.face_id               ||
+                decoded.block_id               != expected.block_id              ||
+                decoded.lod_level              != expected.lod_level             ||
+                decoded.corner_light           != expected.corner_lights[corner] ||
+                decoded.texture_repeat_u_count != expected.texture_repeat_u_count ||
+                decoded.texture_repeat_v_count != expected.texture_repeat_v_count)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /*
+      1----------2
+      |\         |\
+      | 0--------|-3
+      | |        | |
+      5-|--------6 |
+       \|         \|
+        4----------7
+    */
+
+    struct Block_Face_Axes
+    {
+        i32 normal_axis;
+        i32 normal_sign;
+        i32 u_axis; // the axis the texture u coordinate runs along (bottom left to bottom right corner)
+        i32 v_axis; // the axis the texture v coordinate runs along (bottom left to top left corner)
+        u32 local_position_ids[4]; // bottom right, bottom left, top left, top right
+    };
+
+    static constexpr Block_Face_Axes BlockFaceAxes[6] =
+    {
+        { 1,  1, 0, 2, { 0, 1, 2, 3 } }, // top
+        { 1, -1, 0, 2, { 5, 4, 7, 6 } }, // bottom
+        { 0, -1, 2, 1, { 5, 6, 2, 1 } }, // left
+        { 0,  1, 2, 1, { 7, 4, 0, 3 } }, // right
+        { 2, -1, 0, 1, { 6, 7, 3, 2 } }, // front
+        { 2,  1, 0, 1, { 4, 5, 1, 0 } }  // back
+    };
+
+    // note(harlequin): 1 if the local position is on the positive side of the axis
+    static constexpr i32 LocalPositionSigns[8][3] =
+    {
+        { 1, 1, 1 }, // 0
+        { 0, 1, 1 }, // 1
+        { 0, 1, 0 }, // 2
+        { 1, 1, 0 }, // 3
+        { 1, 0, 1 }, // 4
+        { 0, 0, 1 }, // 5
+        { 0, 0, 0 }, // 6
+        { 1, 0, 0 }  // 7
+    };
+
+    static constexpr i32 SubChunkSize[3]         = { Chunk::Width, (i32)Chunk::SubChunkHeight, Chunk::Depth };
+    static constexpr i32 SubChunkBlockStrides[3] = { 1, Chunk::Width * Chunk::Depth, Chunk::Width };
+    static constexpr i32 HaloBlockStrides[3]     = { 1, Sub_Chunk_Halo::Width * Sub_Chunk_Halo::Depth, Sub_Chunk_Halo::Width };
+
+    enum HaloBlockFlags : u8
+    {
+        HaloBlockFlags_Transparent     = 1 << 0, // inside the world and lets light through
+        HaloBlockFlags_Occluder        = 1 << 1, // inside the world and blocks light
+        HaloBlockFlags_AmbientOccluder = 1 << 2  // an occluder that is not a light source
+    };
+
+    // note(harlequin): x, y and z are sub chunk coordinates, -1 and the sub chunk size land in the border
+    static constexpr i32 get_halo_block_index(i32 x, i32 y, i32 z)
+    {
+        return (x + 1) * HaloBlockStrides[0] + (y + 1) * HaloBlockStrides[1] + (z + 1) * HaloBlockStrides[2];
+    }
+
+    static constexpr i32 get_halo_row_index(i32 y, i32 z)
+    {
+        return (y + 1) * Sub_Chunk_Halo::Depth + (z + 1);
+    }
+
+    // note(harlequin): the chunk a border column is read from by the side of the sub chunk it is on in z then x,
+    // -1 is the sub chunk's own chunk
+    static constexpr i32 HaloColumnChunkNeighbours[3][3] =
+    {
+        { ChunkNeighbour_FrontLeft, ChunkNeighbour_Front, ChunkNeighbour_FrontRight },
+        { ChunkNeighbour_Left,      -1,                   ChunkNeighbour_Right      },
+        { ChunkNeighbour_BackLeft,  ChunkNeighbour_Back,  ChunkNeighbour_BackRight  }
+    };
+
+    struct Halo_Face_Offsets
+    {
+        i32 facing_block;  // the block the face looks at
+        i32 corners[4][3]; // the two side blocks and the diagonal block next to the facing block at each corner
+
+        i32 corner_samples[4];    // the corner sample of the 2x2 blocks around the facing block at each corner
+        u32 corner_side_masks[4]; // the bits of the two side blocks in the occluder mask of the corner sample
+    };
+
+    // note(harlequin): the 2x2 blocks of a corner sample are numbered by their offset from the lowest of them, bit 0
+    // for a step along the lower of the two axes the face is not facing and bit 1 for a step along the higher one
+    static constexpr u32 get_corner_sample_position_bit(i32 normal_axis, i32 axis)
+    {
+        i32 lower_axis = normal_axis == 0 ? 1 : 0;
+        return axis == lower_axis ? 1 : 2;
+    }
+
+    static constexpr i32 get_corner_sample_block_offset(i32 normal_axis, u32 position)
+    {
+        i32 lower_axis  = normal_axis == 0 ? 1 : 0;
+        i32 higher_axis = normal_axis == 2 ? 1 : 2;
+        return ((position & 1) ? HaloBlockStrides[lower_axis] : 0) + ((position & 2) ? HaloBlockStrides[higher_axis] : 0);
+    }
+
+    static constexpr Halo_Face_Offsets make_halo_face_offsets(u32 face)
+    {
+        const Block_Face_Axes& axes = BlockFaceAxes[face];
+
+        Halo_Face_Offsets offsets = {};
+        offsets.facing_block = axes.normal_sign * HaloBlockStrides[axes.normal_axis];
+
+        for (u32 corner = 0; corner < 4; corner++)
+        {
+            u32 local_position_id = axes.local_position_ids[corner];
+            i32 u = LocalPositionSigns[local_position_id][axes.u_axis] ? HaloBlockStrides[axes.u_axis] : -HaloBlockStrides[axes.u_axis];
+            i32 v = LocalPositionSigns[local_position_id][axes.v_axis] ? HaloBlockStrides[axes.v_axis] : -HaloBlockStrides[axes.v_axis];
+
+            offsets.corners[corner][0] = offsets.facing_block + u;
+            offsets.corners[corner][1] = offsets.facing_block + v;
+            offsets.corners[corner][2] = offsets.facing_block + u + v;
+
+            u32 u_bit = get_corner_sample_position_bit(axes.normal_axis, axes.u_axis);
+            u32 v_bit = get_corner_sample_position_bit(axes.normal_axis, axes.v_axis);
+
+            // note(harlequin): the facing block is on the high side of an axis the side blocks step down along
+            u32 facing_block_position = (u < 0 ? u_bit : 0) | (v < 0 ? v_bit : 0);
+
+            offsets.corner_samples[corner] = axes.normal_axis * Sub_Chunk_Halo::BlockCount +
+                                             offsets.facing_block + (u < 0 ? u : 0) + (v < 0 ? v : 0);
+            offsets.corner_side_masks[corner] = (1u << (facing_block_position ^ u_bit)) | (1u << (facing_block_position ^ v_bit));
+        }
+
+        return offsets;
+    }
+
+    // note(harlequin): added to the halo index of a block these give the blocks that light and shade its face corners
+    static constexpr Halo_Face_Offsets HaloFaceOffsets[6] =
+    {
+        make_halo_face_offsets(BlockFace_Top),
+        make_halo_face_offsets(BlockFace_Bottom),
+        make_halo_face_offsets(BlockFace_Left),
+        make_halo_face_offsets(BlockFace_Right),
+        make_halo_face_offsets(BlockFace_Front),
+        make_halo_face_offsets(BlockFace_Back)
+    };
+
+    // note(harlequin): the side blocks of each corner have to be found at the positions the side masks point at
+    static constexpr bool do_corner_samples_line_up()
+    {
+        for (u32 face = 0; face < 6; face++)
+        {
+            const Halo_Face_Offsets& offsets = HaloFaceOffsets[face];
+            i32 normal_axis = BlockFaceAxes[face].normal_axis;
+
+            for (u32 corner = 0; corner < 4; corner++)
+            {
+                i32 first_block = offsets.corner_samples[corner] - normal_axis * Sub_Chunk_Halo::BlockCount;
+                u32 side_mask   = 0;
+                u32 block_mask  = 0;
+
+                for (u32 position = 0; position < 4; position++)
+                {
+                    i32 block = first_block + get_corner_sample_block_offset(normal_axis, position);
+
+                    if (block == offsets.corners[corner][0] || block == offsets.corners[corner][1])
+                    {
+                        side_mask |= 1u << position;
+                    }
+
+                    if (block == offsets.facing_block || block == offsets.corners[corner][0] ||
+                        block == offsets.corners[corner][1] || block == offsets.corners[corner][2])
+                    {
+                        block_mask |= 1u << position;
+                    }
+                }
+
+                if (side_mask != offsets.corner_side_masks[corner] || block_mask != 0xF)
+                {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    static_assert(do_corner_samples_line_up(), "a corner sample has to cover the four blocks that light its face corner");
+
+    static_assert(HaloFaceOffsets[BlockFace_Top].corners[0][2] == get_halo_block_index(1, 1, 1) - get_halo_block_index(0, 0, 0),
+                  "the top face bottom right corner is shaded by the block above, right and behind");
+    static_assert(HaloFaceOffsets[BlockFace_Left].corners[3][2] == get_halo_block_index(-1, 1, 1) - get_halo_block_index(0, 0, 0),
+                  "the left face top right corner is shaded by the block to the left, above and behind");
+
+    static u8 get_halo_block_flags(const Block_Info *block_info)
+    {
+        if (is_block_transparent(block_info))
+        {
+            return HaloBlockFlags_Transparent;
+        }
+
+        if (is_light_source(block_info))
+        {
+            return HaloBlockFlags_Occluder;
+        }
+
+        return HaloBlockFlags_Occluder | HaloBlockFlags_AmbientOccluder;
+    }
+
+    // note(harlequin): a neighbour meshed at another level of detail does not line up with the sub chunk, its
+    // border blocks are read as air that keeps their light so the faces on both sides of the seam are emitted
+    // and close the gap between the two meshes
+    static bool is_lod_seam(Chunk *chunk, Chunk *block_chunk)
+    {
+        return block_chunk != chunk && block_chunk->lod_level.load(std::memory_order_relaxed) != chunk->lod_level.load(std::memory_order_relaxed);
+    }
+
+    static void copy_sub_chunk_halo(Chunk *chunk, u32 sub_chunk_index, Sub_Chunk_Halo *halo)
+    {
+        i32 sub_chunk_start_y = sub_chunk_index * Chunk::SubChunkHeight;
+
+        bool is_column_lod_seam[3][3];
+
+        for (i32 z = 0; z < 3; z++)
+        {
+            for (i32 x = 0; x < 3; x++)
+            {
+                i32 neighbour = HaloColumnChunkNeighbours[z][x];
+                is_column_lod_seam[z][x] = neighbour != -1 && is_lod_seam(chunk, chunk->neighbours[neighbour]);
+            }
+        }
+
+        for (i32 y = -1; y <= (i32)Chunk::SubChunkHeight; y++)
+        {
+            i32 block_y = sub_chunk_start_y + y;
+
+            // note(harlequin): the layers above and below the world are sentinels, air that neither occludes nor lights
+            if (block_y < 0 || block_y >= Chunk::Height)
+            {
+                i32 first_halo_block_index = get_halo_block_index(-1, y, -1);
+
+                for (i32 i = 0; i < HaloBlockStrides[1]; i++)
+                {
+                    halo->block_ids[first_halo_block_index + i]    = World::null_block.id;
+                    halo->block_flags[first_halo_block_index + i]  = 0;
+                    halo->light_levels[first_halo_block_index + i] = 0;
+                }
+
+                const Block_Info *null_block_info = &World::block_infos[World::null_block.id];
+                u32 full_row_mask = (1u << Sub_Chunk_Halo::Width) - 1;
+
+                for (i32 z = -1; z <= Chunk::Depth; z++)
+                {
+                    i32 row_index = get_halo_row_index(y, z);
+                    halo->solid_row_masks[row_index]       = is_block_solid(null_block_info) ? full_row_mask : 0;
+                    halo->transparent_row_masks[row_index] = is_block_transparent(null_block_info) ? full_row_mask : 0;
+                    halo->air_row_masks[row_index]         = World::null_block.id == BlockId_Air ? full_row_mask : 0;
+                }
+
+                continue;
+            }
+
+            for (i32 z = -1; z <= Chunk::Depth; z++)
+            {
+                i32 neighbour_z = (z >= 0) + (z >= Chunk::Depth);
+                i32 block_z     = (z + Chunk::Depth) % Chunk::Depth;
+
+                u32 solid_row_mask       = 0;
+                u32 transparent_row_mask = 0;
+                u32 air_row_mask         = 0;
+
+                for (i32 x = -1; x <= Chunk::Width; x++)
+                {
+                    i32 neighbour_x = (x >= 0) + (x >= Chunk::Width);
+                    i32 block_x     = (x + Chunk::Width) % Chunk::Width;
+
+                    i32 neighbour = HaloColumnChunkNeighbours[neighbour_z][neighbour_x];
+                    Chunk *block_chunk = neighbour == -1 ? chunk : chunk->neighbours[neighbour];
+                    Assert(block_chunk);
+
+                    i32 block_index      = block_y * Chunk::Width * Chunk::Depth + block_z * Chunk::Width + block_x;
+                    i32 halo_block_index = get_halo_block_index(x, y, z);
+
+                    u16 block_id     = BlockId_Air;
+                    u8  light_levels = 0;
+
+                    // note(harlequin): a far neighbour across a lod seam has no blocks and no light map, the light of
+                    // the faces drawn against it comes from its cells
+                    if (block_chunk->blocks)
+                    {
+                        const Block_Light_Info& light_info = block_chunk->light_map[block_index];
+                        block_id     = is_column_lod_seam[neighbour_z][neighbour_x] ? (u16)BlockId_Air : block_chunk->blocks[block_index].id;
+                        light_levels = light_info.sky_light_level | (light_info.light_source_level << 4);
+                    }
+                    else
+                    {
+                        glm::ivec3 cell_coords = glm::ivec3(block_x, block_y, block_z) >> (i32)Chunk::MinFarLodLevel;
+                        light_levels = get_lod_cell(block_chunk, cell_coords, Chunk::MinFarLodLevel).light_levels;
+                    }
+
+                    const Block_Info *block_info = &World::block_infos[block_id];
+
+                    halo->block_ids[halo_block_index]    = block_id;
+                    halo->block_flags[halo_block_index]  = get_halo_block_flags(block_info);
+                    halo->light_levels[halo_block_index] = light_levels;
+
+                    u32 bit = 1u << (x + 1);
+                    solid_row_mask       |= is_block_solid(block_info)       ? bit : 0;
+                    transparent_row_mask |= is_block_transparent(block_info) ? bit : 0;
+                    air_row_mask         |= block_id == BlockId_Air          ? bit : 0;
+                }
+
+                i32 row_index = get_halo_row_index(y, z);
+                halo->solid_row_masks[row_index]       = solid_row_mask;
+                halo->transparent_row_masks[row_index] = transparent_row_mask;
+                halo->air_row_masks[row_index]         = air_row_mask;
+            }
+        }
+    }
+
+    // note(harlequin): fills the halo with cells of 2^lod_level blocks on a side laid out like blocks at full
+    // resolution so the face offsets and row masks work unchanged, the cells come from get_lod_cell so a far
+    // chunk or a far neighbour is read from its stored cells
+    static void copy_sub_chunk_lod_halo(Chunk *chunk, u32 sub_chunk_index, u32 lod_level, Sub_Chunk_Halo *halo)
+    {
+        Assert(lod_level > 0 && lod_level <= Chunk::MaxLodLevel);
+
+        i32 cell_size    = 1 << lod_level;
+        i32 cell_count_x = Chunk::Width >> lod_level;
+        i32 cell_count_y = (i32)Chunk::SubChunkHeight >> lod_level;
+        i32 cell_count_z = Chunk::Depth >> lod_level;
+
+        i32 sub_chunk_start_y = sub_chunk_index * Chunk::SubChunkHeight;
+
+        for (i32 cell_y = -1; cell_y <= cell_count_y; cell_y++)
+        {
+            i32 first_block_y = sub_chunk_start_y + cell_y * cell_size;
+            bool is_sentinel  = first_block_y < 0 || first_block_y >= Chunk::Height;
+
+            for (i32 cell_z = -1; cell_z <= cell_count_z; cell_z++)
+            {
+                i32 neighbour_z = (cell_z >= 0) + (cell_z >= cell_count_z);
+
+                u32 solid_row_mask       = 0;
+                u32 transparent_row_mask = 0;
+                u32 air_row_mask         = 0;
+
+                for (i32 cell_x = -1; cell_x <= cell_count_x; cell_x++)
+                {
+                    i32 neighbour_x = (cell_x >= 0) + (cell_x >= cell_count_x);
+
+                    i32 halo_block_index = get_halo_block_index(cell_x, cell_y, cell_z);
+                    u32 bit = 1u << (cell_x + 1);
+
+                    if (is_sentinel)
+                    {
+                        const Block_Info *null_block_info = &World::block_infos[World::null_block.id];
+
+                        halo->block_ids[halo_block_index]    = World::null_block.id;
+                        halo->block_flags[halo_block_index]  = 0;
+                        halo->light_levels[halo_block_index] = 0;
+
+                        solid_row_mask       |= is_block_solid(null_block_info)       ? bit : 0;
+                        transparent_row_mask |= is_block_transparent(null_block_info) ? bit : 0;
+                        air_row_mask         |= World::null_block.id == BlockId_Air   ? bit : 0;
+                        continue;
+                    }
+
+                    i32 neighbour = HaloColumnChunkNeighbours[neighbour_z][neighbour_x];
+                    Chunk *block_chunk = neighbour == -1 ? chunk : chunk->neighbours[neighbour];
+                    Assert(block_chunk);
+
+                    glm::ivec3 cell_coords = { (cell_x + cell_count_x) % cell_count_x,
+                                               first_block_y >> lod_level,
+                                               (cell_z + cell_count_z) % cell_count_z };
+
+                    Lod_Cell cell = get_lod_cell(block_chunk, cell_coords, lod_level);
+
+                    if (is_lod_seam(chunk, block_chunk))
+                    {
+                        cell.block_id = BlockId_Air;
+                    }
+
+                    const Block_Info *block_info = &World::block_infos[cell.block_id];
+
+                    halo->block_ids[halo_block_index]    = cell.block_id;
+                    halo->block_flags[halo_block_index]  = get_halo_block_flags(block_info);
+                    halo->light_levels[halo_block_index] = cell.light_levels;
+
+                    solid_row_mask       |= is_block_solid(block_info)       ? bit : 0;
+                    transparent_row_mask |= is_block_transparent(block_info) ? bit : 0;
+                    air_row_mask         |= cell.block_id == BlockId_Air     ? bit : 0;
+                }
+
+                i32 row_index = get_halo_row_index(cell_y, cell_z);
+                halo->solid_row_masks[row_index]       = solid_row_mask;
+                halo->transparent_row_masks[row_index] = transparent_row_mask;
+                halo->air_row_masks[row_index]         = air_row_mask;
+            }
+        }
+    }
+
+#define GREEDY_FACE_KEY_VALID_BIT (1u << 31)
+
+    static std::atomic< bool > greedy_meshing_enabled { true };
+
+    void set_is_greedy_meshing_enabled(bool enabled)
+    {
+        greedy_meshing_enabled = enabled;
+    }
+
+    bool is_greedy_meshing_enabled()
+    {
+        return greedy_meshing_enabled.load(std::memory_order_relaxed);
+    }
+
+    static void push_face_to_sub_chunk_mesh(Sub_Chunk_Mesh *mesh,
+                                            bool is_transparent,
+                                            const Block_Face& face)
+    {
+        Assert(mesh->opaque_face_count + mesh->transparent_face_count + 1 <= Sub_Chunk_Mesh::MaxFaceCount);
+
+        if (is_transparent)
+        {
+            mesh->transparent_face_count++;
+            mesh->faces[Sub_Chunk_Mesh::MaxFaceCount - mesh->transparent_face_count] = face;
+        }
+        else
+        {
+            mesh->faces[mesh->opaque_face_count] = face;
+            mesh->opaque_face_count++;
+        }
+    }
+
+    // note(harlequin): a solid block shows the faces that look at a transparent block and a transparent block
+    // shows the faces that look at air
+    static bool is_block_face_visible(const Sub_Chunk_Halo *halo,
+                                      const Block_Info *block_info,
+                                      i32 halo_block_index,
+                                      u32 face)
+    {
+        u16 facing_block_id = halo->block_ids[halo_block_index + HaloFaceOffsets[face].facing_block];
+        const Block_Info* block_facing_normal_info = &World::block_infos[facing_block_id];
+
+        return (is_block_solid(block_info) && is_block_transparent(block_facing_normal_info)) ||
+               (is_block_transparent(block_info) && facing_block_id == BlockId_Air);
+    }
+
+    // note(harlequin): the same test as is_block_face_visible for a whole x row at once, returns a mask of
+    // the blocks of the row that show each face
+    static void get_halo_row_visible_face_masks(const Sub_Chunk_Halo *halo, i32 y, i32 z, u32 interior_row_mask, u32 visible_face_masks[6])
+    {
+        i32 row_index = get_halo_row_index(y, z);
+
+        u32 solid_mask       = halo->solid_row_masks[row_index] & interior_row_mask;
+        u32 transparent_mask = halo->transparent_row_masks[row_index] & ~halo->air_row_masks[row_index] & interior_row_mask;
+
+        auto get_visible_face_mask = [&](u32 facing_transparent_mask, u32 facing_air_mask) -> u32
+        {
+            return (solid_mask & facing_transparent_mask) | (transparent_mask & facing_air_mask);
+        };
+
+        i32 top_row_index    = row_index + Sub_Chunk_Halo::Depth;
+        i32 bottom_row_index = row_index - Sub_Chunk_Halo::Depth;
+        i32 front_row_index  = row_index - 1;
+        i32 back_row_index   = row_index + 1;
+
+        visible_face_masks[BlockFace_Top]    = get_visible_face_mask(halo->transparent_row_masks[top_row_index],    halo->air_row_masks[top_row_index]);
+        visible_face_masks[BlockFace_Bottom] = get_visible_face_mask(halo->transparent_row_masks[bottom_row_index], halo->air_row_masks[bottom_row_index]);
+        visible_face_masks[BlockFace_Left]   = get_visible_face_mask(halo->transparent_row_masks[row_index] << 1,   halo->air_row_masks[row_index] << 1);
+        visible_face_masks[BlockFace_Right]  = get_visible_face_mask(halo->transparent_row_masks[row_index] >> 1,   halo->air_row_masks[row_index] >> 1);
+        visible_face_masks[BlockFace_Front]  = get_visible_face_mask(halo->transparent_row_masks[front_row_index],  halo->air_row_masks[front_row_index]);
+        visible_face_masks[BlockFace_Back]   = get_visible_face_mask(halo->transparent_row_masks[back_row_index],   halo->air_row_masks[back_row_index]);
+    }
+
+    // note(harlequin): lights every face corner from its own blocks, kept as a baseline for benchmark_meshing
+    static void sample_corner_lights(Sub_Chunk_Mesh *mesh, i32 halo_block_index, u32 face, u32 corner_lights[4])
+    {
+        const Sub_Chunk_Halo& halo = mesh->halo;
+        const Halo_Face_Offsets& offsets = HaloFaceOffsets[face];
+
+        i32 facing_block_index = halo_block_index + offsets.facing_block;
+        u64 read_count         = 0;
+
+        for (i32 i = 0; i < 4; i++)
+        {
+            i32 side0_block_index  = halo_block_index + offsets.corners[i][0];
+            i32 side1_block_index  = halo_block_index + offsets.corners[i][1];
+            i32 corner_block_index = halo_block_index + offsets.corners[i][2];
+
+            u8 side0_flags  = halo.block_flags[side0_block_index];
+            u8 side1_flags  = halo.block_flags[side1_block_index];
+            u8 corner_flags = halo.block_flags[corner_block_index];
+
+            // note(harlequin): light leaks around the corner block only if one of the side blocks lets it through
+            bool is_corner_visible = !((side0_flags & HaloBlockFlags_Occluder) && (side1_flags & HaloBlockFlags_Occluder));
+
+            i32 sample_block_indices[4] = { facing_block_index, side0_block_index, side1_block_index, corner_block_index };
+            i32 sample_count = is_corner_visible ? 4 : 3;
+
+            u32 sky_light_level    = 0;
+            u32 light_source_level = 0;
+            u32 count              = 0;
+
+            for (i32 j = 0; j < sample_count; j++)
+            {
+                i32 sample_block_index = sample_block_indices[j];
+
+                if (halo.block_flags[sample_block_index] & HaloBlockFlags_Transparent)
+                {
+                    u8 light_levels = halo.light_levels[sample_block_index];
+                    sky_light_level    += light_levels & 0xF;
+                    light_source_level += light_levels >> 4;
+                    count++;
+                }
+            }
+
+            if (count)
+            {
+                sky_light_level    /= count;
+                light_source_level /= count;
+            }
+
+            u32 ambient_occlusion = 0;
+
+            if (is_corner_visible)
+            {
+                ambient_occlusion = 3 - (((side0_flags  & HaloBlockFlags_AmbientOccluder) != 0) +
+                                         ((side1_flags  & HaloBlockFlags_AmbientOccluder) != 0) +
+                                         ((corner_flags & HaloBlockFlags_AmbientOccluder) != 0));
+            }
+
+            corner_lights[i] = pack_corner_light(sky_light_level, light_source_level, ambient_occlusion);
+            read_count += 3 + sample_count + count;
+        }
+
+        mesh->corner_light_read_count += read_count;
+    }
+
+    static constexpr u32 CornerLightMask               = 0x3FF;
+    static constexpr u32 CornerSampleOccluderMaskShift = 12;
+
+    static constexpr i32 CornerSampleBlockOffsets[3][4] =
+    {
+        { get_corner_sample_block_offset(0, 0), get_corner_sample_block_offset(0, 1), get_corner_sample_block_offset(0, 2), get_corner_sample_block_offset(0, 3) },
+        { get_corner_sample_block_offset(1, 0), get_corner_sample_block_offset(1, 1), get_corner_sample_block_offset(1, 2), get_corner_sample_block_offset(1, 3) },
+        { get_corner_sample_block_offset(2, 0), get_corner_sample_block_offset(2, 1), get_corner_sample_block_offset(2, 2), get_corner_sample_block_offset(2, 3) }
+    };
+
+    // note(harlequin): the light of the 2x2 blocks is averaged over all four and every ambient occluder among them
+    // shades the corner, that is what a face corner gets unless both of its side blocks are occluders
+    static u16 compute_corner_sample(Sub_Chunk_Mesh *mesh, u32 corner_sample)
+    {
+        const Sub_Chunk_Halo& halo = mesh->halo;
+
+        i32 normal_axis       = (i32)(corner_sample / Sub_Chunk_Halo::BlockCount);
+        i32 first_block_index = (i32)(corner_sample % Sub_Chunk_Halo::BlockCount);
+
+        u32 sky_light_level        = 0;
+        u32 light_source_level     = 0;
+        u32 count                  = 0;
+        u32 ambient_occluder_count = 0;
+        u32 occluder_mask          = 0;
+
+        for (u32 position = 0; position < 4; position++)
+        {
+            i32 block_index = first_block_index + CornerSampleBlockOffsets[normal_axis][position];
+            u8  flags       = halo.block_flags[block_index];
+
+            if (flags & HaloBlockFlags_Transparent)
+            {
+                u8 light_levels = halo.light_levels[block_index];
+                sky_light_level    += light_levels & 0xF;
+                light_source_level += light_levels >> 4;
+                count++;
+            }
+
+            ambient_occluder_count += (flags & HaloBlockFlags_AmbientOccluder) != 0;
+            occluder_mask          |= (u32)((flags & HaloBlockFlags_Occluder) != 0) << position;
+        }
+
+        if (count)
+        {
+            sky_light_level    /= count;
+            light_source_level /= count;
+        }
+
+        mesh->corner_light_read_count += 4 + count;
+
+        // note(harlequin): the block a face is facing is never an ambient occluder
+        Assert(ambient_occluder_count <= 3);
+
+        return (u16)(pack_corner_light(sky_light_level, light_source_level, 3 - ambient_occluder_count) |
+                     (occluder_mask << CornerSampleOccluderMaskShift));
+    }
+
+    static void reset_corner_samples(Sub_Chunk_Mesh *mesh)
+    {
+        memset(mesh->computed_corner_sample_mask, 0, sizeof(mesh->computed_corner_sample_mask));
+    }
+
+    static void look_up_corner_lights(Sub_Chunk_Mesh *mesh, i32 halo_block_index, u32 face, u32 corner_lights[4])
+    {
+        const Halo_Face_Offsets& offsets = HaloFaceOffsets[face];
+
+        for (i32 i = 0; i < 4; i++)
+        {
+            u32 corner_sample = (u32)(halo_block_index + offsets.corner_samples[i]);
+            u64 bit           = (u64)1 << (corner_sample & 63);
+            u64 *mask_word    = &mesh->computed_corner_sample_mask[corner_sample >> 6];
+
+            if (!(*mask_word & bit))
+            {
+                mesh->corner_samples[corner_sample] = compute_corner_sample(mesh, corner_sample);
+                *mask_word |= bit;
+            }
+
+            u32 sample    = mesh->corner_samples[corner_sample];
+            u32 side_mask = offsets.corner_side_masks[i];
+
+            if (((sample >> CornerSampleOccluderMaskShift) & side_mask) != side_mask)
+            {
+                corner_lights[i] = sample & CornerLightMask;
+                continue;
+            }
+
+            // note(harlequin): light does not leak around the corner block so only the facing block lights the
+            // corner and the corner is not shaded
+            i32 facing_block_index = halo_block_index + offsets.facing_block;
+            corner_lights[i] = 0;
+
+            if (mesh->halo.block_flags[facing_block_index] & HaloBlockFlags_Transparent)
+            {
+                u8 light_levels = mesh->halo.light_levels[facing_block_index];
+                corner_lights[i] = pack_corner_light(light_levels & 0xF, light_levels >> 4, 0);
+            }
+
+            mesh->corner_light_read_count += 2;
+        }
+    }
+
+    static void submit_block_face_to_sub_chunk_mesh(Sub_Chunk_Mesh *mesh,
+                                                    const Block_Info *block_info,
+                                                    i32 halo_block_index,
+                                                    i32 sub_chunk_block_index,
+                                                    const glm::ivec3& block_coords,
+                                                    u32 face)
+    {
+        bool is_transparent = is_block_transparent(block_info);
+        u32  block_id       = mesh->halo.block_ids[halo_block_index];
+
+        u32 corner_lights[4];
+
+        if (mesh->should_cache_corner_samples)
+        {
+            look_up_corner_lights(mesh, halo_block_index, face, corner_lights);
+        }
+        else
+        {
+            sample_corner_lights(mesh, halo_block_index, face, corner_lights);
+        }
+
+        if (mesh->is_greedy_meshing_enabled && !is_transparent &&
+            corner_lights[0] == corner_lights[1] && corner_lights[0] == corner_lights[2] && corner_lights[0] == corner_lights[3])
+        {
+            mesh->greedy_face_keys[face][sub_chunk_block_index] = corner_lights[0] | (block_id << 10) | GREEDY_FACE_KEY_VALID_BIT;
+            return;
+        }
+
+        Block_Face packed_face = pack_block_face(block_coords.x,
+                                                 block_coords.y % (i32)Chunk::SubChunkHeight,
+                                                 block_coords.z,
+                                                 face,
+                                                 block_id,
+                                                 mesh->lod_level,
+                                                 corner_lights);
+
+        push_face_to_sub_chunk_mesh(mesh, is_transparent, packed_face);
+
+        if (mesh->face_index)
+        {
+            Sub_Chunk_Face_Index *face_index = mesh->face_index;
+            u16 block_face = (u16)(sub_chunk_block_index * 6 + face);
+
+            if (is_transparent)
+            {
+                u16 slot = (u16)(mesh->transparent_face_count - 1);
+                face_index->transparent_slot_block_faces[slot] = block_face;
+                face_index->block_face_slots[sub_chunk_block_index][face] = slot | Sub_Chunk_Face_Index::TransparentSlotBit;
+            }
+            else
+            {
+                u16 slot = (u16)(mesh->opaque_face_count - 1);
+                face_index->opaque_slot_block_faces[slot] = block_face;
+                face_index->block_face_slots[sub_chunk_block_index][face] = slot;
+            }
+        }
+    }
+
+    static void submit_block_to_sub_chunk_mesh(Chunk *chunk,
+                                               Sub_Chunk_Mesh *mesh,
+                                               const Block_Info *block_info,
+                                               i32 halo_block_index,
+                                               i32 sub_chunk_block_index,
+                                               const glm::ivec3& block_coords,
+                                               u32 visible_face_mask)
+    {
+        Assert(visible_face_mask);
+
+        for (u32 face = 0; face < 6; face++)
+        {
+            if (visible_face_mask & (1 << face))
+            {
+                submit_block_face_to_sub_chunk_mesh(mesh,
+                                                    block_info,
+                                                    halo_block_index,
+                                                    sub_chunk_block_index,
+                                                    block_coords,
+                                                    face);
+            }
+        }
+
+        f32 cell_size = (f32)(1 << mesh->lod_level);
+
+        glm::vec3 block_position = get_block_position(chunk, block_coords);
+        glm::vec3 min = block_position - glm::vec3(0.5f, 0.5f, 0.5f);
+        glm::vec3 max = min + glm::vec3(cell_size, cell_size, cell_size);
+        mesh->aabb.min = glm::min(mesh->aabb.min, min);
+        mesh->aabb.max = glm::max(mesh->aabb.max, max);
+    }
+
+    // note(harlequin): culls the faces of each row with the row masks and only visits the blocks that show a face,
+    // at a lower level of detail x, y and z count cells and the block coords are those of the first block of the cell
+    static void submit_sub_chunk_blocks_by_face_masks(Chunk *chunk, u32 sub_chunk_index, Sub_Chunk_Mesh *mesh)
+    {
+        i32 sub_chunk_start_y = sub_chunk_index * Chunk::SubChunkHeight;
+
+        u32 lod_level    = mesh->lod_level;
+        i32 cell_size    = 1 << lod_level;
+        i32 cell_count_x = Chunk::Width >> lod_level;
+        i32 cell_count_y = (i32)Chunk::SubChunkHeight >> lod_level;
+        i32 cell_count_z = Chunk::Depth >> lod_level;
+
+        u32 interior_row_mask = ((1u << cell_count_x) - 1) << 1;
+
+        for (i32 y = 0; y < cell_count_y; ++y)
+        {
+            for (i32 z = 0; z < cell_count_z; ++z)
+            {
+                u32 visible_face_masks[6];
+                get_halo_row_visible_face_masks(&mesh->halo, y, z, interior_row_mask, visible_face_masks);
+
+                u32 visible_block_mask = visible_face_masks[0] | visible_face_masks[1] | visible_face_masks[2] |
+                                         visible_face_masks[3] | visible_face_masks[4] | visible_face_masks[5];
+
+                while (visible_block_mask)
+                {
+                    u32 bit_index = count_trailing_zeros(visible_block_mask);
+                    visible_block_mask &= visible_block_mask - 1;
+
+                    u32 visible_face_mask = 0;
+                    for (u32 face = 0; face < 6; face++)
+                    {
+                        visible_face_mask |= ((visible_face_masks[face] >> bit_index) & 1) << face;
+                    }
+
+                    i32 x = (i32)bit_index - 1;
+                    i32 halo_block_index = get_halo_block_index(x, y, z);
+                    i32 sub_chunk_block_index = y * SubChunkBlockStrides[1] + z * SubChunkBlockStrides[2] + x;
+
+                    submit_block_to_sub_chunk_mesh(chunk,
+                                                   mesh,
+                                                   &World::block_infos[mesh->halo.block_ids[halo_block_index]],
+                                                   halo_block_index,
+                                                   sub_chunk_block_index,
+                                                   { x * cell_size, sub_chunk_start_y + y * cell_size, z * cell_size },
+                                                   visible_face_mask);
+                }
+            }
+        }
+    }
+
+    // note(harlequin): the per block face test the row masks replaced, kept as a baseline for benchmark_meshing
+    static void submit_sub_chunk_blocks_by_face_lookups(Chunk *chunk, u32 sub_chunk_index, Sub_Chunk_Mesh *mesh)
+    {
+        Assert(mesh->lod_level == 0);
+
+        i32 sub_chunk_start_y = sub_chunk_index * Chunk::SubChunkHeight;
+        i32 sub_chunk_block_index = 0;
+
+        for (i32 y = 0; y < (i32)Chunk::SubChunkHeight; ++y)
+        {
+            for (i32 z = 0; z < Chunk::Depth; ++z)
+            {
+                i32 halo_block_index = get_halo_block_index(0, y, z);
+
+                for (i32 x = 0; x < Chunk::Width; ++x, ++halo_block_index, ++sub_chunk_block_index)
+                {
+                    u16 block_id = mesh->halo.block_ids[halo_block_index];
+
+                    if (block_id == BlockId_Air)
+                    {
+                        continue;
+                    }
+
+                    const Block_Info *block_info = &World::block_infos[block_id];
+
+                    u32 visible_face_mask = 0;
+                    for (u32 face = 0; face < 6; face++)
+                    {
+                        visible_face_mask |= (u32)is_block_face_visible(&mesh->halo, block_info, halo_block_index, face) << face;
+                    }
+
+                    if (!visible_face_mask)
+                    {
+                        continue;
+                    }
+
+                    submit_block_to_sub_chunk_mesh(chunk,
+                                                   mesh,
+                                                   block_info,
+                                                   halo_block_index,
+                                                   sub_chunk_block_index,
+                                                   { x, sub_chunk_start_y + y, z },
+                                                   visible_face_mask);
+                }
+            }
+        }
+    }
+
+    static void submit_greedy_faces_to_sub_chunk_mesh(Sub_Chunk_Mesh *mesh)
+    {
+        i32 cell_size = 1 << mesh->lod_level;
+
+        for (u32 face = 0; face < 6; face++)
+        {
+            const Block_Face_Axes& axes = BlockFaceAxes[face];
+            u32 *keys = mesh->greedy_face_keys[face];
+
+            i32 u_stride = SubChunkBlockStrides[axes.u_axis];
+            i32 v_stride = SubChunkBlockStrides[axes.v_axis];
+            i32 u_size   = SubChunkSize[axes.u_axis] >> mesh->lod_level;
+            i32 v_size   = SubChunkSize[axes.v_axis] >> mesh->lod_level;
+
+            for (i32 slice = 0; slice < (SubChunkSize[axes.normal_axis] >> mesh->lod_level); slice++)
+            {
+                for (i32 v = 0; v < v_size; v++)
+                {
+                    for (i32 u = 0; u < u_size; u++)
+                    {
+                        i32 block_index = slice * SubChunkBlockStrides[axes.normal_axis] + u * u_stride + v * v_stride;
+                        u32 key = keys[block_index];
+
+                        if (!key)
+                        {
+                            continue;
+                        }
+
+                        i32 width = 1;
+                        while (u + width < u_size && keys[block_index + width * u_stride] == key)
+                        {
+                            width++;
+                        }
+
+                        i32 height = 1;
+                        while (v + height < v_size)
+                        {
+                            bool is_row_mergeable = true;
+
+                            for (i32 i = 0; i < width; i++)
+                            {
+                                if (keys[block_index + i * u_stride + height * v_stride] != key)
+                                {
+                                    is_row_mergeable = false;
+                                    break;
+                                }
+                            }
+
+                            if (!is_row_mergeable)
+                            {
+                                break;
+                            }
+
+                            height++;
+                        }
+
+                        for (i32 j = 0; j < height; j++)
+                        {
+                            for (i32 i = 0; i < width; i++)
+                            {
+                                keys[block_index + i * u_stride + j * v_stride] = 0;
+                            }
+                        }
+
+                        glm::ivec3 min;
+                        min[axes.normal_axis] = slice * cell_size;
+                        min[axes.u_axis]      = u * cell_size;
+                        min[axes.v_axis]      = v * cell_size;
+
+                        // note(harlequin): the quad keeps its first block and how many blocks it spans along the u and v
+                        // axes of the face, the shader finds each corner from them
+                        u32 corner_light     = key & 0x3FF;
+                        u32 corner_lights[4] = { corner_light, corner_light, corner_light, corner_light };
+
+                        Block_Face block_face = pack_block_face(min.x,
+                                                                min.y,
+                                                                min.z,
+                                                                face,
+                                                                (key >> 10) & BLOCK_ID_MASK,
+                                                                mesh->lod_level,
+                                                                corner_lights,
+                                                                width,
+                                                                height);
+
+                        push_face_to_sub_chunk_mesh(mesh, false, block_face);
+                    }
+                }
+            }
+        }
+    }
+
+    // note(harlequin): the run of set bits of open_mask that seed_bit is in
+    static u32 get_row_run(u32 open_mask, u32 seed_bit)
+    {
+        u32 run = seed_bit & open_mask;
+
+        for (;;)
+        {
+            u32 grown_run = (run | (run << 1) | (run >> 1)) & open_mask;
+
+            if (grown_run == run)
+            {
+                return run;
+            }
+
+            run = grown_run;
+        }
+    }
+
+    // note(harlequin): flood fills the transparent blocks of a sub chunk a run of a row at a time, every group of
+    // connected blocks connects each pair of sub chunk faces it touches
+    static u64 compute_sub_chunk_face_connectivity(const Sub_Chunk_Halo *halo, u32 lod_level)
+    {
+        constexpr i32 MaxRowCount = (i32)Chunk::SubChunkHeight * Chunk::Depth;
+
+        i32 width     = Chunk::Width >> lod_level;
+        i32 height    = (i32)Chunk::SubChunkHeight >> lod_level;
+        i32 depth     = Chunk::Depth >> lod_level;
+        i32 row_count = height * depth;
+
+        u32 interior_row_mask = ((1u << width) - 1) << 1;
+        u32 last_x_bit        = 1u << width;
+
+        u32 open_rows[MaxRowCount];
+        u32 visited_rows[MaxRowCount] = {};
+
+        bool is_fully_open   = true;
+        bool is_fully_closed = true;
+
+        for (i32 row = 0; row < row_count; row++)
+        {
+            open_rows[row] = halo->transparent_row_masks[get_halo_row_index(row / depth, row % depth)] & interior_row_mask;
+            is_fully_open   &= open_rows[row] == interior_row_mask;
+            is_fully_closed &= open_rows[row] == 0;
+        }
+
+        if (is_fully_open)
+        {
+            return SubChunkFullFaceConnectivity;
+        }
+
+        if (is_fully_closed)
+        {
+            return 0;
+        }
+
+        struct Row_Run
+        {
+            i32 row;
+            u32 mask;
+        };
+
+        // note(harlequin): a run is pushed once and a row has at most width / 2 runs
+        Row_Run runs[MaxRowCount * Chunk::Width / 2];
+
+        u64 face_connectivity = 0;
+
+        for (i32 first_row = 0; first_row < row_count; first_row++)
+        {
+            while (u32 unvisited_mask = open_rows[first_row] & ~visited_rows[first_row])
+            {
+                u32 run_count = 0;
+                u32 face_mask = 0;
+
+                u32 first_run = get_row_run(open_rows[first_row], unvisited_mask & (~unvisited_mask + 1));
+                visited_rows[first_row] |= first_run;
+                runs[run_count++] = { first_row, first_run };
+
+                while (run_count)
+                {
+                    Row_Run run = runs[--run_count];
+
+                    i32 y = run.row / depth;
+                    i32 z = run.row % depth;
+
+                    face_mask |= (run.mask & 2)          ? (1u << BlockFace_Left)   : 0;
+                    face_mask |= (run.mask & last_x_bit) ? (1u << BlockFace_Right)  : 0;
+                    face_mask |= y == 0                  ? (1u << BlockFace_Bottom) : 0;
+                    face_mask |= y == height - 1         ? (1u << BlockFace_Top)    : 0;
+                    face_mask |= z == 0                  ? (1u << BlockFace_Front)  : 0;
+                    face_mask |= z == depth - 1          ? (1u << BlockFace_Back)   : 0;
+
+                    i32 neighbour_rows[4] = {
+                        y > 0          ? run.row - depth : -1,
+                        y < height - 1 ? run.row + depth : -1,
+                        z > 0          ? run.row - 1     : -1,
+                        z < depth - 1  ? run.row + 1     : -1
+                    };
+
+                    for (i32 neighbour_row : neighbour_rows)
+                    {
+                        if (neighbour_row == -1)
+                        {
+                            continue;
+                        }
+
+                        u32 seed_mask = open_rows[neighbour_row] & ~visited_rows[neighbour_row] & run.mask;
+
+                        while (seed_mask)
+                        {
+                            u32 neighbour_run = get_row_run(open_rows[neighbour_row], seed_mask & (~seed_mask + 1));
+                            visited_rows[neighbour_row] |= neighbour_run;
+                            seed_mask &= ~neighbour_run;
+
+                            Assert(run_count < ArrayCount(runs));
+                            runs[run_count++] = { neighbour_row, neighbour_run };
+                        }
+                    }
+                }
+
+                for (u32 face = 0; face < 6; face++)
+                {
+                    if (face_mask & (1u << face))
+                    {
+                        face_connectivity |= (u64)face_mask << (face * 8);
+                    }
+                }
+            }
+        }
+
+        return face_connectivity;
+    }
+
+    // note(harlequin): the first bit and the length of the longest run of set bits of mask
+    static u32 get_longest_bit_run(u32 mask, u32 *first_bit)
+    {
+        u32 longest_run = 0;
+        *first_bit      = 0;
+
+        while (mask)
+        {
+            u32 first = count_trailing_zeros(mask);
+            u32 run   = count_trailing_zeros(~(mask >> first));
+
+            if (run > longest_run)
+            {
+                longest_run = run;
+                *first_bit  = first;
+            }
+
+            mask &= ~(((1u << run) - 1) << first);
+        }
+
+        return longest_run;
+    }
+
+    // note(harlequin): a plane of the sub chunk is an occluder when all of its blocks are opaque, the longest run
+    // of occluder planes along each axis makes a box that is solid all the way through, the box with the most blocks
+    // is kept, a lod mesh draws whole cells so its box is made of cells
+    static u64 compute_sub_chunk_occluder(const Sub_Chunk_Halo *halo, u32 lod_level)
+    {
+        i32 width  = Chunk::Width >> lod_level;
+        i32 height = (i32)Chunk::SubChunkHeight >> lod_level;
+        i32 depth  = Chunk::Depth >> lod_level;
+
+        u32 interior_row_mask = ((1u << width) - 1) << 1;
+
+        u32 x_plane_mask = interior_row_mask;
+        u32 y_plane_mask = (1u << height) - 1;
+        u32 z_plane_mask = (1u << depth) - 1;
+
+        for (i32 y = 0; y < height; y++)
+        {
+            for (i32 z = 0; z < depth; z++)
+            {
+                i32 row_index   = get_halo_row_index(y, z);
+                u32 opaque_mask = halo->solid_row_masks[row_index] & ~halo->transparent_row_masks[row_index] & interior_row_mask;
+
+                x_plane_mask &= opaque_mask;
+
+                if (opaque_mask != interior_row_mask)
+                {
+                    y_plane_mask &= ~(1u << y);
+                    z_plane_mask &= ~(1u << z);
+                }
+            }
+        }
+
+        x_plane_mask >>= 1;
+
+        u32 first_x, first_y, first_z;
+        u32 x_run = get_longest_bit_run(x_plane_mask, &first_x);
+        u32 y_run = get_longest_bit_run(y_plane_mask, &first_y);
+        u32 z_run = get_longest_bit_run(z_plane_mask, &first_z);
+
+        u32 x_volume = x_run * height * depth;
+        u32 y_volume = y_run * width  * depth;
+        u32 z_volume = z_run * width  * height;
+
+        if (Max(x_volume, Max(y_volume, z_volume)) == 0)
+        {
+            return 0;
+        }
+
+        glm::ivec3 min = { 0, 0, 0 };
+        glm::ivec3 max = { width, height, depth };
+
+        if (y_volume >= x_volume && y_volume >= z_volume)
+        {
+            min.y = first_y;
+            max.y = first_y + y_run;
+        }
+        else if (x_volume >= z_volume)
+        {
+            min.x = first_x;
+            max.x = first_x + x_run;
+        }
+        else
+        {
+            min.z = first_z;
+            max.z = first_z + z_run;
+        }
+
+        return pack_sub_chunk_occluder(min << (i32)lod_level, max << (i32)lod_level);
+    }
+
+    static u64 mix_content_hash(u64 hash, u64 word)
+    {
+        hash ^= word * 0x9E3779B97F4A7C15ull;
+        hash  = (hash << 31) | (hash >> 33);
+        return hash * 0xBF58476D1CE4E5B9ull;
+    }
+
+    static u64 hash_bytes(u64 hash, const void *data, u64 size)
+    {
+        const u8 *bytes = (const u8 *)data;
+
+        for (; size >= sizeof(u64); size -= sizeof(u64), bytes += sizeof(u64))
+        {
+            u64 word;
+            memcpy(&word, bytes, sizeof(u64));
+            hash = mix_content_hash(hash, word);
+        }
+
+        if (size)
+        {
+            u64 word = 0;
+            memcpy(&word, bytes, size);
+            hash = mix_content_hash(hash, word);
+        }
+
+        return hash;
+    }
+
+    // note(harlequin): only the rows a level of detail fills are hashed, the rest of the halo is left over from
+    // earlier meshes, the flags and row masks follow from the block ids so they are left out
+    static u64 hash_sub_chunk_mesh_content(const Sub_Chunk_Mesh *mesh)
+    {
+        const Sub_Chunk_Halo& halo = mesh->halo;
+
+        i32 cell_count_x = Chunk::Width >> mesh->lod_level;
+        i32 cell_count_y = (i32)Chunk::SubChunkHeight >> mesh->lod_level;
+        i32 cell_count_z = Chunk::Depth >> mesh->lod_level;
+        i32 row_length   = cell_count_x + 2;
+
+        u64 hash = mix_content_hash(0, ((u64)mesh->lod_level << 1) | (u64)mesh->is_greedy_meshing_enabled);
+
+        for (i32 y = -1; y <= cell_count_y; y++)
+        {
+            for (i32 z = -1; z <= cell_count_z; z++)
+            {
+                i32 first_halo_block_index = get_halo_block_index(-1, y, z);
+                hash = hash_bytes(hash, halo.block_ids + first_halo_block_index, row_length * sizeof(u16));
+                hash = hash_bytes(hash, halo.light_levels + first_halo_block_index, row_length * sizeof(u8));
+            }
+        }
+
+        // note(harlequin): the finalizer of splitmix64 so every bit of the hash can be used to index a table
+        hash ^= hash >> 30;
+        hash *= 0xBF58476D1CE4E5B9ull;
+        hash ^= hash >> 27;
+        hash *= 0x94D049BB133111EBull;
+        hash ^= hash >> 31;
+        return hash;
+    }
+
+    static void build_sub_chunk_mesh(Chunk *chunk,
+                                     u32 sub_chunk_index,
+                                     u32 lod_level,
+                                     bool is_greedy_meshing_enabled,
+                                     bool should_cull_faces_by_masks,
+                                     bool should_cache_corner_samples,
+                                     Sub_Chunk_Face_Index *face_index,
+                                     Sub_Chunk_Mesh *mesh)
+    {
+        Assert(!face_index || !is_greedy_meshing_enabled);
+
+        constexpr f32 inf = std::numeric_limits< f32 >::max();
+        mesh->aabb = { { inf, inf, inf }, { -inf, -inf, -inf } };
+        mesh->opaque_face_count         = 0;
+        mesh->transparent_face_count    = 0;
+        mesh->is_greedy_meshing_enabled = is_greedy_meshing_enabled;
+        mesh->lod_level                 = lod_level;
+        mesh->face_index                = face_index;
+
+        mesh->should_cache_corner_samples = should_cache_corner_samples;
+        mesh->corner_light_read_count     = 0;
+        reset_corner_samples(mesh);
+
+        if (face_index)
+        {
+            memset(face_index->block_face_slots, 0xFF, sizeof(face_index->block_face_slots));
+        }
+
+        if (is_greedy_meshing_enabled)
+        {
+            memset(mesh->greedy_face_keys, 0, sizeof(mesh->greedy_face_keys));
+        }
+
+        if (lod_level == 0)
+        {
+            copy_sub_chunk_halo(chunk, sub_chunk_index, &mesh->halo);
+        }
+        else
+        {
+            copy_sub_chunk_lod_halo(chunk, sub_chunk_index, lod_level, &mesh->halo);
+            should_cull_faces_by_masks = true;
+        }
+
+        if (should_cull_faces_by_masks)
+        {
+            submit_sub_chunk_blocks_by_face_masks(chunk, sub_chunk_index, mesh);
+        }
+        else
+        {
+            submit_sub_chunk_blocks_by_face_lookups(chunk, sub_chunk_index, mesh);
+        }
+
+        if (mesh->is_greedy_meshing_enabled)
+        {
+            submit_greedy_faces_to_sub_chunk_mesh(mesh);
+        }
+
+        mesh->content_hash      = hash_sub_chunk_mesh_content(mesh);
+        mesh->face_connectivity = compute_sub_chunk_face_connectivity(&mesh->halo, lod_level);
+        mesh->occluder          = compute_sub_chunk_occluder(&mesh->halo, lod_level);
+    }
+
+    void mesh_sub_chunk(World *world,
+                        Chunk *chunk,
+                        u32 sub_chunk_index,
+                        bool is_greedy_meshing_enabled,
+                        Sub_Chunk_Mesh *mesh)
+    {
+        u32 lod_level = chunk->lod_level.load(std::memory_order_relaxed);
+        build_sub_chunk_mesh(chunk, sub_chunk_index, lod_level, is_greedy_meshing_enabled, true, true, nullptr, mesh);
+    }
+
+    struct Sub_Chunk_Patch_State
+    {
+        Chunk     *chunk;
+        glm::ivec2 chunk_coords;
+        u32        sub_chunk_index;
+        u64        last_use;
+        bool       is_in_use;
+        bool       has_mesh;
+
+        Sub_Chunk_Mesh       mesh;
+        Sub_Chunk_Face_Index face_index;
+    };
+
+    // note(harlequin): a patch that has to redo more blocks than this rebuilds the whole mesh instead
+    static constexpr u32 MaxPatchedBlockCount = Chunk::SubChunkBlockCount / 8;
+
+    static constexpr u32 SubChunkPatchStateCount = 16;
+
+    struct Sub_Chunk_Patch_Cache
+    {
+        Sub_Chunk_Patch_State *states;
+        u64                    use_count;
+        std::mutex             mutex;
+
+        std::atomic< u64 > patch_count;
+        std::atomic< u64 > rebuild_count;
+        std::atomic< u64 > last_patch_time;
+        std::atomic< u32 > last_patched_block_count;
+    };
+
+    static Sub_Chunk_Patch_Cache sub_chunk_patch_cache;
+
+    bool initialize_sub_chunk_mesher(Memory_Arena *arena)
+    {
+        Sub_Chunk_Patch_Cache *cache = &sub_chunk_patch_cache;
+        cache->states = ArenaPushArrayAlignedZero(arena, Sub_Chunk_Patch_State, SubChunkPatchStateCount);
+        cache->use_count = 0;
+        return cache->states != nullptr;
+    }
+
+    // note(harlequin): hands out the patch state of the sub chunk, or the least recently used one that is free
+    // if the sub chunk has none yet, nothing is handed out twice at the same time
+    static Sub_Chunk_Patch_State *acquire_sub_chunk_patch_state(Chunk *chunk, u32 sub_chunk_index)
+    {
+        Sub_Chunk_Patch_Cache *cache = &sub_chunk_patch_cache;
+
+        if (!cache->states)
+        {
+            return nullptr;
+        }
+
+        std::unique_lock lock(cache->mutex);
+
+        Sub_Chunk_Patch_State *least_recently_used_state = nullptr;
+
+        for (u32 i = 0; i < SubChunkPatchStateCount; i++)
+        {
+            Sub_Chunk_Patch_State *state = &cache->states[i];
+
+            if (state->has_mesh &&
+                state->chunk == chunk &&
+                state->chunk_coords == chunk->world_coords &&
+                state->sub_chunk_index == sub_chunk_index)
+            {
+                if (state->is_in_use)
+                {
+                    return nullptr;
+                }
+
+                state->is_in_use = true;
+                state->last_use  = ++cache->use_count;
+                return state;
+            }
+
+            if (!state->is_in_use && (!least_recently_used_state || state->last_use < least_recently_used_state->last_use))
+            {
+                least_recently_used_state = state;
+            }
+        }
+
+        if (!least_recently_used_state)
+        {
+            return nullptr;
+        }
+
+        Sub_Chunk_Patch_State *state = least_recently_used_state;
+
+        // note(harlequin): the sub chunk that loses its state is meshed from scratch again the next time, the chunk
+        // node outlives the chunk so a chunk that was freed or reused for other coords is left alone
+        if (state->has_mesh && state->chunk->world_coords == state->chunk_coords)
+        {
+            state->chunk->patchable_sub_chunk_mask.fetch_and(~(1u << state->sub_chunk_index), std::memory_order_relaxed);
+        }
+
+        state->chunk           = chunk;
+        state->chunk_coords    = chunk->world_coords;
+        state->sub_chunk_index = sub_chunk_index;
+        state->has_mesh        = false;
+        state->is_in_use       = true;
+        state->last_use        = ++cache->use_count;
+        return state;
+    }
+
+    // note(harlequin): gives up the state of a sub chunk that is going to be meshed from scratch
+    static void drop_sub_chunk_patch_state(Chunk *chunk, u32 sub_chunk_index, Sub_Chunk_Patch_State *state)
+    {
+        Sub_Chunk_Patch_Cache *cache = &sub_chunk_patch_cache;
+
+        chunk->patchable_sub_chunk_mask.fetch_and(~(1u << sub_chunk_index), std::memory_order_relaxed);
+
+        std::unique_lock lock(cache->mutex);
+        state->has_mesh  = false;
+        state->is_in_use = false;
+    }
+
+    static Block_Face *get_face(Sub_Chunk_Mesh *mesh, bool is_transparent, u16 slot)
+    {
+        if (is_transparent)
+        {
+            return mesh->faces + Sub_Chunk_Mesh::MaxFaceCount - (slot + 1);
+        }
+
+        return mesh->faces + slot;
+    }
+
+    // note(harlequin): the last face of the stream moves into the slot of the removed face
+    static void remove_block_face_from_sub_chunk_mesh(Sub_Chunk_Mesh *mesh, i32 sub_chunk_block_index, u32 face)
+    {
+        Sub_Chunk_Face_Index *face_index = mesh->face_index;
+
+        u16 slot = face_index->block_face_slots[sub_chunk_block_index][face];
+
+        if (slot == Sub_Chunk_Face_Index::NullSlot)
+        {
+            return;
+        }
+
+        face_index->block_face_slots[sub_chunk_block_index][face] = Sub_Chunk_Face_Index::NullSlot;
+
+        bool is_transparent = (slot & Sub_Chunk_Face_Index::TransparentSlotBit) != 0;
+        slot &= ~Sub_Chunk_Face_Index::TransparentSlotBit;
+
+        i32 *face_count        = is_transparent ? &mesh->transparent_face_count : &mesh->opaque_face_count;
+        u16 *slot_block_faces  = is_transparent ? face_index->transparent_slot_block_faces : face_index->opaque_slot_block_faces;
+        u16  last_slot         = (u16)(*face_count - 1);
+
+        if (slot != last_slot)
+        {
+            *get_face(mesh, is_transparent, slot) = *get_face(mesh, is_transparent, last_slot);
+
+            u16 moved_block_face = slot_block_faces[last_slot];
+            slot_block_faces[slot] = moved_block_face;
+            face_index->block_face_slots[moved_block_face / 6][moved_block_face % 6] = is_transparent ? slot | Sub_Chunk_Face_Index::TransparentSlotBit : slot;
+        }
+
+        (*face_count)--;
+    }
+
+    // note(harlequin): sets the bit of every sub chunk block that has a face lit or shaded by a halo block that
+    // changed, a face only looks at blocks one step away from its block, returns how many bits are set
+    static u32 find_blocks_to_patch(const Sub_Chunk_Halo *previous_halo, const Sub_Chunk_Halo *halo, u64 *block_mask)
+    {
+        memset(block_mask, 0, Chunk::SubChunkBlockCount / 8);
+
+        u32 block_count = 0;
+
+        for (i32 y = -1; y <= (i32)Chunk::SubChunkHeight; y++)
+        {
+            for (i32 z = -1; z <= Chunk::Depth; z++)
+            {
+                i32 halo_block_index = get_halo_block_index(-1, y, z);
+
+                for (i32 x = -1; x <= Chunk::Width; x++, halo_block_index++)
+                {
+                    if (previous_halo->block_ids[halo_block_index]    == halo->block_ids[halo_block_index] &&
+                        previous_halo->light_levels[halo_block_index] == halo->light_levels[halo_block_index])
+                    {
+                        continue;
+                    }
+
+                    for (i32 block_y = Max(y - 1, 0); block_y <= Min(y + 1, (i32)Chunk::SubChunkHeight - 1); block_y++)
+                    {
+                        for (i32 block_z = Max(z - 1, 0); block_z <= Min(z + 1, Chunk::Depth - 1); block_z++)
+                        {
+                            for (i32 block_x = Max(x - 1, 0); block_x <= Min(x + 1, Chunk::Width - 1); block_x++)
+                            {
+                                i32 sub_chunk_block_index = block_y * SubChunkBlockStrides[1] + block_z * SubChunkBlockStrides[2] + block_x;
+                                u64 bit = (u64)1 << (sub_chunk_block_index & 63);
+
+                                if (!(block_mask[sub_chunk_block_index >> 6] & bit))
+                                {
+                                    block_mask[sub_chunk_block_index >> 6] |= bit;
+                                    block_count++;
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        return block_count;
+    }
+
+    Sub_Chunk_Mesh *patch_sub_chunk_mesh(Chunk *chunk, u32 sub_chunk_index, Sub_Chunk_Mesh *scratch_mesh)
+    {
+        u32 sub_chunk_bit = 1u << sub_chunk_index;
+
+        if (!(chunk->patchable_sub_chunk_mask.load(std::memory_order_relaxed) & sub_chunk_bit))
+        {
+            return nullptr;
+        }
+
+        if (chunk->lod_level.load(std::memory_order_relaxed) != 0)
+        {
+            chunk->patchable_sub_chunk_mask.fetch_and(~sub_chunk_bit, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        Sub_Chunk_Patch_State *state = acquire_sub_chunk_patch_state(chunk, sub_chunk_index);
+
+        if (!state)
+        {
+            return nullptr;
+        }
+
+        Sub_Chunk_Patch_Cache *cache = &sub_chunk_patch_cache;
+        Sub_Chunk_Mesh *mesh = &state->mesh;
+
+        u64 begin_time = Job_System::get_time_stamp();
+
+        u32 patched_block_count = Chunk::SubChunkBlockCount;
+
+        if (state->has_mesh)
+        {
+            copy_sub_chunk_halo(chunk, sub_chunk_index, &scratch_mesh->halo);
+
+            u64 block_mask[Chunk::SubChunkBlockCount / 64];
+            patched_block_count = find_blocks_to_patch(&mesh->halo, &scratch_mesh->halo, block_mask);
+
+            if (patched_block_count <= MaxPatchedBlockCount)
+            {
+                mesh->halo = scratch_mesh->halo;
+                mesh->content_hash      = hash_sub_chunk_mesh_content(mesh);
+                mesh->face_connectivity = compute_sub_chunk_face_connectivity(&mesh->halo, 0);
+                mesh->occluder          = compute_sub_chunk_occluder(&mesh->halo, 0);
+                reset_corner_samples(mesh);
+
+                for (u32 word_index = 0; word_index < ArrayCount(block_mask); word_index++)
+                {
+                    u64 word = block_mask[word_index];
+
+                    while (word)
+                    {
+                        i32 sub_chunk_block_index = (i32)(word_index * 64 + count_trailing_zeros(word));
+                        word &= word - 1;
+
+                        for (u32 face = 0; face < 6; face++)
+                        {
+                            remove_block_face_from_sub_chunk_mesh(mesh, sub_chunk_block_index, face);
+                        }
+
+                        i32 x = sub_chunk_block_index % Chunk::Width;
+                        i32 z = (sub_chunk_block_index / Chunk::Width) % Chunk::Depth;
+                        i32 y = sub_chunk_block_index / (Chunk::Width * Chunk::Depth);
+
+                        i32 halo_block_index = get_halo_block_index(x, y, z);
+                        u16 block_id = mesh->halo.block_ids[halo_block_index];
+
+                        if (block_id == BlockId_Air)
+                        {
+                            continue;
+                        }
+
+                        const Block_Info *block_info = &World::block_infos[block_id];
+
+                        u32 visible_face_mask = 0;
+                        for (u32 face = 0; face < 6; face++)
+                        {
+                            visible_face_mask |= (u32)is_block_face_visible(&mesh->halo, block_info, halo_block_index, face) << face;
+                        }
+
+                        if (visible_face_mask)
+                        {
+                            // note(harlequin): the aabb only grows, a patch that empties a corner of the sub chunk
+                            // leaves it a little larger than it has to be until the next rebuild
+                            submit_block_to_sub_chunk_mesh(chunk,
+                                                           mesh,
+                                                           block_info,
+                                                           halo_block_index,
+                                                           sub_chunk_block_index,
+                                                           { x, (i32)(sub_chunk_index * Chunk::SubChunkHeight) + y, z },
+                                                           visible_face_mask);
+                        }
+                    }
+                }
+
+                cache->patch_count++;
+            }
+        }
+
+        if (patched_block_count > MaxPatchedBlockCount)
+        {
+            cache->rebuild_count++;
+
+            // note(harlequin): too much changed for a patch to pay off, the sub chunk goes back to mesh_sub_chunk and
+            // its greedy faces until it is edited again
+            if (state->has_mesh)
+            {
+                drop_sub_chunk_patch_state(chunk, sub_chunk_index, state);
+                return nullptr;
+            }
+
+            // note(harlequin): patching needs a face per block face so the mesh of a sub chunk that holds a state
+            // is never greedy, it only holds one while it is being edited
+            build_sub_chunk_mesh(chunk, sub_chunk_index, 0, false, true, true, &state->face_index, mesh);
+            state->has_mesh = true;
+        }
+
+        cache->last_patch_time          = Job_System::get_time_stamp() - begin_time;
+        cache->last_patched_block_count = patched_block_count;
+
+        return mesh;
+    }
+
+    void release_patched_sub_chunk_mesh(Sub_Chunk_Mesh *mesh)
+    {
+        Sub_Chunk_Patch_Cache *cache = &sub_chunk_patch_cache;
+
+        std::unique_lock lock(cache->mutex);
+
+        for (u32 i = 0; i < SubChunkPatchStateCount; i++)
+        {
+            if (&cache->states[i].mesh == mesh)
+            {
+                cache->states[i].is_in_use = false;
+                return;
+            }
+        }
+
+        Assert(false);
+    }
+
+    Sub_Chunk_Patch_Stats get_sub_chunk_patch_stats()
+    {
+        Sub_Chunk_Patch_Cache *cache = &sub_chunk_patch_cache;
+
+        Sub_Chunk_Patch_Stats stats;
+        stats.patch_count              = cache->patch_count;
+        stats.rebuild_count            = cache->rebuild_count;
+        stats.last_patch_time          = cache->last_patch_time;
+        stats.last_patched_block_count = cache->last_patched_block_count;
+        return stats;
+    }
+
+    struct Greedy_Meshing_Face_Record
+    {
+        u32 key;              // block id and a valid bit
+        u32 corner_lights[4]; // sky light, light source and ambient occlusion levels of each face corner
+    };
+
+    // note(harlequin): expands every quad back into the block faces it covers, returns how many quads
+    // overlap an already expanded face or run past the sub chunk
+    static u32 expand_sub_chunk_quads(const Block_Face *faces,
+                                      i32 face_count,
+                                      Greedy_Meshing_Face_Record *records)
+    {
+        u32 invalid_quad_count = 0;
+
+        for (i32 quad_index = 0; quad_index < face_count; quad_index++)
+        {
+            Unpacked_Block_Face quad = unpack_block_face(faces[quad_index]);
+
+            const Block_Face_Axes& axes = BlockFaceAxes[quad.face_id];
+
+            glm::ivec3 min = { quad.x, quad.y, quad.z };
+            glm::ivec3 max = min;
+            max[axes.u_axis] += (i32)quad.texture_repeat_u_count - 1;
+            max[axes.v_axis] += (i32)quad.texture_repeat_v_count - 1;
+
+            if (max.x >= Chunk::Width || max.y >= (i32)Chunk::SubChunkHeight || max.z >= Chunk::Depth)
+            {
+                invalid_quad_count++;
+                continue;
+            }
+
+            u32 key = quad.block_id | GREEDY_FACE_KEY_VALID_BIT;
+
+            for (i32 y = min.y; y <= max.y; y++)
+            {
+                for (i32 z = min.z; z <= max.z; z++)
+                {
+                    for (i32 x = min.x; x <= max.x; x++)
+                    {
+                        i32 block_index = y * Chunk::Width * Chunk::Depth + z * Chunk::Width + x;
+                        Greedy_Meshing_Face_Record *record = &records[quad.face_id * Chunk::SubChunkBlockCount + block_index];
+
+                        if (record->key)
+                        {
+                            invalid_quad_count++;
+                            continue;
+                        }
+
+                        record->key = key;
+                        memcpy(record->corner_lights, quad.corner_lights, sizeof(quad.corner_lights));
+                    }
+                }
+            }
+        }
+
+        return invalid_quad_count;
+    }
+
+    static u32 validate_greedy_meshing(World *world,
+                                       Chunk *chunk,
+                                       u32 sub_chunk_index,
+                                       Sub_Chunk_Mesh **meshes,
+                                       Greedy_Meshing_Face_Record **records,
+                                       Greedy_Meshing_Validation_Result *result)
+    {
+        for (i32 i = 0; i < 2; i++)
+        {
+            memset(records[i], 0, 6 * Chunk::SubChunkBlockCount * sizeof(Greedy_Meshing_Face_Record));
+
+            u64 begin_time = Job_System::get_time_stamp();
+            build_sub_chunk_mesh(chunk, sub_chunk_index, 0, i == 1, true, true, nullptr, meshes[i]);
+            u64 elapsed_time = Job_System::get_time_stamp() - begin_time;
+
+            if (i == 0) result->time += elapsed_time;
+            else result->greedy_time += elapsed_time;
+        }
+
+        u32 mismatched_face_count = 0;
+
+        for (i32 i = 0; i < 2; i++)
+        {
+            mismatched_face_count += expand_sub_chunk_quads(get_opaque_faces(meshes[i]), meshes[i]->opaque_face_count, records[i]);
+        }
+
+        // note(harlequin): the faces the mesher emits have to decode the same on the gpu as they do here
+        for (i32 i = 0; i < 2; i++)
+        {
+            const Sub_Chunk_Mesh *mesh = meshes[i];
+
+            const Block_Face *streams[2]      = { get_opaque_faces(mesh), get_transparent_faces(mesh) };
+            i32               stream_sizes[2] = { mesh->opaque_face_count, mesh->transparent_face_count };
+
+            for (i32 stream = 0; stream < 2; stream++)
+            {
+                for (i32 face_index = 0; face_index < stream_sizes[stream]; face_index++)
+                {
+                    const Block_Face& face = streams[stream][face_index];
+                    Unpacked_Block_Face unpacked = unpack_block_face(face);
+
+                    if (unpacked.face_id >= 6 ||
+                        unpacked.block_id >= BlockId_Count ||
+                        unpacked.lod_level != mesh->lod_level ||
+                        !does_block_face_decode_to(face, unpacked))
+                    {
+                        result->mismatched_packed_face_count++;
+                    }
+                }
+            }
+        }
+
+        for (u32 i = 0; i < 6 * Chunk::SubChunkBlockCount; i++)
+        {
+            if (memcmp(&records[0][i], &records[1][i], sizeof(Greedy_Meshing_Face_Record)) != 0)
+            {
+                mismatched_face_count++;
+            }
+        }
+
+        // note(harlequin): transparent faces are never merged so both passes have to emit the same stream
+        if (meshes[0]->transparent_face_count != meshes[1]->transparent_face_count ||
+            memcmp(get_transparent_faces(meshes[0]), get_transparent_faces(meshes[1]), meshes[0]->transparent_face_count * sizeof(Block_Face)) != 0)
+        {
+            mismatched_face_count += meshes[0]->transparent_face_count;
+        }
+
+        i32 face_count        = meshes[0]->opaque_face_count + meshes[0]->transparent_face_count;
+        i32 greedy_face_count = meshes[1]->opaque_face_count + meshes[1]->transparent_face_count;
+
+        if (face_count > 0 &&
+            (meshes[0]->aabb.min != meshes[1]->aabb.min || meshes[0]->aabb.max != meshes[1]->aabb.max))
+        {
+            mismatched_face_count++;
+        }
+
+        result->face_count          += face_count;
+        result->greedy_face_count   += greedy_face_count;
+        result->bucket_count        += (meshes[0]->opaque_face_count > 0) + (meshes[0]->transparent_face_count > 0);
+        result->greedy_bucket_count += (meshes[1]->opaque_face_count > 0) + (meshes[1]->transparent_face_count > 0);
+
+        return mismatched_face_count;
+    }
+
+    bool validate_greedy_meshing(World *world,
+                                 Chunk **chunks,
+                                 u32 chunk_count,
+                                 Temprary_Memory_Arena *temp_arena,
+                                 Greedy_Meshing_Validation_Result *result)
+    {
+        Sub_Chunk_Mesh *meshes[2];
+        Greedy_Meshing_Face_Record *records[2];
+
+        for (i32 i = 0; i < 2; i++)
+        {
+            meshes[i]  = ArenaPushAligned(temp_arena, Sub_Chunk_Mesh);
+            records[i] = ArenaPushArrayAligned(temp_arena, Greedy_Meshing_Face_Record, 6 * Chunk::SubChunkBlockCount);
+            Assert(meshes[i] && records[i]);
+        }
+
+        for (u32 i = 0; i < chunk_count; i++)
+        {
+            for (u32 sub_chunk_index = 0; sub_chunk_index < Chunk::SubChunkCount; sub_chunk_index++)
+            {
+                result->mismatched_face_count += validate_greedy_meshing(world,
+                                                                         chunks[i],
+                                                                         sub_chunk_index,
+                                                                         meshes,
+                                                                         records,
+                                                                         result);
+                result->sub_chunk_count++;
+            }
+        }
+
+        return result->mismatched_face_count == 0 && result->mismatched_packed_face_count == 0;
+    }
+
+    static bool are_sub_chunk_meshes_equal(const Sub_Chunk_Mesh *mesh, const Sub_Chunk_Mesh *other_mesh)
+    {
+        if (mesh->opaque_face_count != other_mesh->opaque_face_count ||
+            mesh->transparent_face_count != other_mesh->transparent_face_count)
+        {
+            return false;
+        }
+
+        if (memcmp(get_opaque_faces(mesh), get_opaque_faces(other_mesh), mesh->opaque_face_count * sizeof(Block_Face)) != 0 ||
+            memcmp(get_transparent_faces(mesh), get_transparent_faces(other_mesh), mesh->transparent_face_count * sizeof(Block_Face)) != 0)
+        {
+            return false;
+        }
+
+        return mesh->opaque_face_count + mesh->transparent_face_count == 0 ||
+               (mesh->aabb.min == other_mesh->aabb.min && mesh->aabb.max == other_mesh->aabb.max);
+    }
+
+    bool validate_face_culling(Chunk **chunks,
+                               u32 chunk_count,
+                               Temprary_Memory_Arena *temp_arena,
+                               Face_Culling_Validation_Result *result)
+    {
+        Sub_Chunk_Mesh *meshes[2];
+
+        for (i32 i = 0; i < 2; i++)
+        {
+            meshes[i] = ArenaPushAligned(temp_arena, Sub_Chunk_Mesh);
+            Assert(meshes[i]);
+        }
+
+        for (u32 i = 0; i < chunk_count; i++)
+        {
+            for (u32 sub_chunk_index = 0; sub_chunk_index < Chunk::SubChunkCount; sub_chunk_index++)
+            {
+                // note(harlequin): greedy meshing would hide a face emitted twice behind the quad it merges into
+                build_sub_chunk_mesh(chunks[i], sub_chunk_index, 0, false, true, true, nullptr, meshes[0]);
+                build_sub_chunk_mesh(chunks[i], sub_chunk_index, 0, false, false, true, nullptr, meshes[1]);
+
+                result->sub_chunk_count++;
+                result->face_count                 += meshes[0]->opaque_face_count + meshes[0]->transparent_face_count;
+                result->mismatched_sub_chunk_count += !are_sub_chunk_meshes_equal(meshes[0], meshes[1]);
+            }
+        }
+
+        return result->mismatched_sub_chunk_count == 0;
+    }
+
+    bool validate_corner_samples(Chunk **chunks,
+                                 u32 chunk_count,
+                                 Temprary_Memory_Arena *temp_arena,
+                                 Corner_Sample_Validation_Result *result)
+    {
+        Sub_Chunk_Mesh *meshes[2];
+
+        for (i32 i = 0; i < 2; i++)
+        {
+            meshes[i] = ArenaPushAligned(temp_arena, Sub_Chunk_Mesh);
+            Assert(meshes[i]);
+        }
+
+        for (u32 i = 0; i < chunk_count; i++)
+        {
+            for (u32 sub_chunk_index = 0; sub_chunk_index < Chunk::SubChunkCount; sub_chunk_index++)
+            {
+                bool is_mismatched = false;
+
+                for (i32 greedy = 0; greedy < 2; greedy++)
+                {
+                    build_sub_chunk_mesh(chunks[i], sub_chunk_index, 0, greedy == 1, true, false, nullptr, meshes[0]);
+                    build_sub_chunk_mesh(chunks[i], sub_chunk_index, 0, greedy == 1, true, true, nullptr, meshes[1]);
+
+                    result->corner_light_read_count        += meshes[0]->corner_light_read_count;
+                    result->cached_corner_light_read_count += meshes[1]->corner_light_read_count;
+                    is_mismatched |= !are_sub_chunk_meshes_equal(meshes[0], meshes[1]);
+                }
+
+                result->sub_chunk_count++;
+                result->mismatched_sub_chunk_count += is_mismatched;
+            }
+        }
+
+        return result->mismatched_sub_chunk_count == 0;
+    }
+
+    bool validate_block_face_packing(Block_Face_Packing_Validation_Result *result)
+    {
+        u64 begin_time = Job_System::get_time_stamp();
+
+        auto check = [&](i32 x,
+                         i32 y,
+                         i32 z,
+                         u32 face_id,
+                         u32 block_id,
+                         u32 lod_level,
+                         const u32 corner_lights[4],
+                         u32 texture_repeat_u_count,
+                         u32 texture_repeat_v_count)
+        {
+            Unpacked_Block_Face expected = {};
+            expected.x                      = x;
+            expected.y                      = y;
+            expected.z                      = z;
+            expected.face_id                = face_id;
+            expected.block_id               = block_id;
+            expected.lod_level              = lod_level;
+            expected.texture_repeat_u_count = texture_repeat_u_count;
+            expected.texture_repeat_v_count = texture_repeat_v_count;
+            memcpy(expected.corner_lights, corner_lights, sizeof(expected.corner_lights));
+
+            Block_Face block_face = pack_block_face(x, y, z,
+                                                    face_id,
+                                                    block_id,
+                                                    lod_level,
+                                                    corner_lights,
+                                                    texture_repeat_u_count,
+                                                    texture_repeat_v_count);
+
+            result->checked_face_count++;
+
+            if (!does_block_face_decode_to(block_face, expected))
+            {
+                result->mismatched_face_count++;
+            }
+        };
+
+        constexpr u32 MaxCornerLight = pack_corner_light(SKY_LIGHT_LEVEL_MASK, LIGHT_SOURCE_LEVEL_MASK, AMBIENT_OCCLUSION_LEVEL_MASK);
+
+        // note(harlequin): a uniform face with all the light bits clear and a face with alternating corners at the
+        // extremes of every light field, the position, face, block and lod fields are swept together
+        const u32 extreme_corner_lights[2][4] =
+        {
+            { 0, 0, 0, 0 },
+            { MaxCornerLight, 0, MaxCornerLight, pack_corner_light(SKY_LIGHT_LEVEL_MASK, 0, 0) }
+        };
+
+        for (u32 lod_level = 0; lod_level <= LOD_LEVEL_MASK; lod_level++)
+        {
+            for (u32 block_id = 0; block_id <= BLOCK_ID_MASK; block_id++)
+            {
+                for (u32 face_id = 0; face_id < 6; face_id++)
+                {
+                    for (i32 y = 0; y <= BLOCK_Y_MASK; y++)
+                    {
+                        for (i32 z = 0; z <= BLOCK_Z_MASK; z++)
+                        {
+                            for (i32 x = 0; x <= BLOCK_X_MASK; x++)
+                            {
+                                for (u32 i = 0; i < 2; i++)
+                                {
+                                    check(x, y, z, face_id, block_id, lod_level, extreme_corner_lights[i], 1, 1);
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        // note(harlequin): every light value at every corner with the other corners and fields at both extremes
+        for (u32 extreme = 0; extreme < 2; extreme++)
+        {
+            i32 coord          = extreme ? BLOCK_X_MASK : 0;
+            i32 y              = extreme ? BLOCK_Y_MASK : 0;
+            u32 face_id        = extreme ? 5 : 0;
+            u32 block_id       = extreme ? BLOCK_ID_MASK : 0;
+            u32 lod_level      = extreme ? LOD_LEVEL_MASK : 0;
+            u32 other_light    = extreme ? MaxCornerLight : 0;
+
+            for (u32 corner = 0; corner < 4; corner++)
+            {
+                for (u32 corner_light = 0; corner_light <= MaxCornerLight; corner_light++)
+                {
+                    u32 corner_lights[4] = { other_light, other_light, other_light, other_light };
+                    corner_lights[corner] = corner_light;
+                    check(coord, y, coord, face_id, block_id, lod_level, corner_lights, 1, 1);
+                }
+            }
+
+            // note(harlequin): only uniform faces repeat their texture
+            for (u32 corner_light = 0; corner_light <= MaxCornerLight; corner_light++)
+            {
+                u32 corner_lights[4] = { corner_light, corner_light, corner_light, corner_light };
+
+                for (u32 texture_repeat_v_count = 1; texture_repeat_v_count <= TEXTURE_REPEAT_MASK + 1; texture_repeat_v_count++)
+                {
+                    for (u32 texture_repeat_u_count = 1; texture_repeat_u_count <= TEXTURE_REPEAT_MASK + 1; texture_repeat_u_count++)
+                    {
+                        check(coord, y, coord, face_id, block_id, lod_level, corner_lights, texture_repeat_u_count, texture_repeat_v_count);
+                    }
+                }
+            }
+        }
+
+        result->time = Job_System::get_time_stamp() - begin_time;
+        return result->mismatched_face_count == 0;
+    }
+
+    void benchmark_sub_chunk_meshing(World *world,
+                                     Chunk **chunks,
+                                     u32 chunk_count,
+                                     bool is_greedy_meshing_enabled,
+                                     bool should_cull_faces_by_masks,
+                                     bool should_cache_corner_samples,
+                                     Temprary_Memory_Arena *temp_arena,
+                                     Meshing_Benchmark_Result *result)
+    {
+        Sub_Chunk_Mesh *mesh = ArenaPushAligned(temp_arena, Sub_Chunk_Mesh);
+        Assert(mesh);
+
+        for (u32 i = 0; i < chunk_count; i++)
+        {
+            Chunk *chunk = chunks[i];
+
+            i32 min_height = Chunk::Height;
+            i32 max_height = -1;
+
+            for (i32 j = 0; j < Chunk::Width * Chunk::Depth; j++)
+            {
+                min_height = glm::min(min_height, (i32)chunk->height_map[j]);
+                max_height = glm::max(max_height, (i32)chunk->height_map[j]);
+            }
+
+            for (u32 sub_chunk_index = 0; sub_chunk_index < Chunk::SubChunkCount; sub_chunk_index++)
+            {
+                u64 begin_time = Job_System::get_time_stamp();
+                build_sub_chunk_mesh(chunk, sub_chunk_index, 0, is_greedy_meshing_enabled, should_cull_faces_by_masks, should_cache_corner_samples, nullptr, mesh);
+                u64 elapsed_time = Job_System::get_time_stamp() - begin_time;
+
+                i32 face_count = mesh->opaque_face_count + mesh->transparent_face_count;
+
+                result->sub_chunk_count++;
+                result->empty_sub_chunk_count   += face_count == 0;
+                result->face_count              += face_count;
+                result->corner_light_read_count += mesh->corner_light_read_count;
+                result->time                    += elapsed_time;
+                result->slowest_sub_chunk_time   = glm::max(result->slowest_sub_chunk_time, elapsed_time);
+
+                // note(harlequin): a sub chunk is in the sky when it is above every column of the chunk and
+                // underground when it is below every column
+                i32 sub_chunk_start_y = sub_chunk_index * Chunk::SubChunkHeight;
+                i32 sub_chunk_end_y   = sub_chunk_start_y + Chunk::SubChunkHeight - 1;
+
+                u32 layer = MeshingBenchmarkLayer_Surface;
+
+                if (sub_chunk_start_y > max_height)
+                {
+                    layer = MeshingBenchmarkLayer_Sky;
+                }
+                else if (sub_chunk_end_y < min_height)
+                {
+                    layer = MeshingBenchmarkLayer_Underground;
+                }
+
+                result->layer_sub_chunk_counts[layer]++;
+                result->layer_times[layer] += elapsed_time;
+            }
+        }
+    }
+}
@@ -0,0 +1,240 @@
+#pragma once
+
+#include "core/common.h"
+#include "game/world.h"
+
+namespace minecraft {
+
+    struct Memory_Arena;
+    struct Temprary_Memory_Arena;
+
+    // note(harlequin): the blocks of a sub chunk and a one block border around it copied out of the chunk and
+    // its eight neighbours before meshing, every block a face looks at for its visibility, light and ambient
+    // occlusion is then a fixed offset away from the block, the layers above and below the world are filled
+    // with sentinels that neither occlude nor light anything so no lookup has to check the bounds
+    struct Sub_Chunk_Halo
+    {
+        static constexpr i32 Width      = Chunk::Width + 2;
+        static constexpr i32 Height     = (i32)Chunk::SubChunkHeight + 2;
+        static constexpr i32 Depth      = Chunk::Depth + 2;
+        static constexpr i32 BlockCount = Width * Height * Depth;
+
+        u16 block_ids[BlockCount];
+        u8  block_flags[BlockCount];  // occluder and transparency bits of the block info
+        u8  light_levels[BlockCount]; // sky light level in the low nibble and light source level in the high nibble
+
+        // note(harlequin): a bit per block of each x row (bit x + 1 for sub chunk x) so the faces of a whole row
+        // are culled with a handful of bit operations, rows are indexed by (y + 1) * Depth + (z + 1)
+        u32 solid_row_masks[Height * Depth];
+        u32 transparent_row_masks[Height * Depth];
+        u32 air_row_masks[Height * Depth];
+    };
+
+    static_assert(Sub_Chunk_Halo::Width <= 32, "a halo row has to fit in a row mask");
+
+    // note(harlequin): the slot each block face of a mesh landed in and the block face in each slot, lets a
+    // face be taken out of the mesh by moving the last face of its stream into its slot
+    struct Sub_Chunk_Face_Index
+    {
+        static constexpr u32 MaxFaceCount       = Chunk::SubChunkBlockCount * 6;
+        static constexpr u16 NullSlot           = 0xFFFF;
+        static constexpr u16 TransparentSlotBit = 0x8000;
+
+        u16 block_face_slots[Chunk::SubChunkBlockCount][6]; // the transparent slot bit tells the stream apart
+        u16 opaque_slot_block_faces[MaxFaceCount];          // sub chunk block index * 6 + face
+        u16 transparent_slot_block_faces[MaxFaceCount];
+    };
+
+    static_assert(Sub_Chunk_Face_Index::MaxFaceCount <= Sub_Chunk_Face_Index::TransparentSlotBit,
+                  "a face slot has to leave the transparent slot bit free");
+
+    // note(harlequin): the cpu side face streams of a sub chunk, the mesher never touches gpu memory
+    // so a mesh is built in the scratch memory of the thread doing the work and copied into the sub chunk
+    // buckets by the renderer afterwards
+    struct Sub_Chunk_Mesh
+    {
+        static constexpr u32 MaxFaceCount = Chunk::SubChunkBlockCount * 6;
+
+        i32  opaque_face_count;
+        i32  transparent_face_count;
+        AABB aabb;
+
+        // note(harlequin): opaque faces are pushed from the front and transparent faces from the back so a
+        // sub chunk can never overflow no matter how its faces are split between the two streams
+        Block_Face faces[MaxFaceCount];
+
+        bool is_greedy_meshing_enabled;
+        u32  lod_level;
+
+        // note(harlequin): a hash of everything the faces are built from, the blocks and light of the halo, the level
+        // of detail and whether faces are merged, face positions are relative to the sub chunk so two sub chunks with
+        // the same hash have the same faces and can share them on the gpu
+        u64 content_hash;
+
+        // note(harlequin): which faces of the sub chunk can see each other through its transparent blocks, see
+        // get_connected_face_mask, a lod mesh is flood filled by its cells
+        u64 face_connectivity;
+
+        // note(harlequin): see pack_sub_chunk_occluder, the largest box of whole planes of opaque blocks
+        u64 occluder;
+
+        // note(harlequin): only set on the meshes kept for patching, their faces are never merged
+        Sub_Chunk_Face_Index *face_index;
+
+        Sub_Chunk_Halo halo;
+
+        // note(harlequin): opaque faces that have the same light and ambient occlusion at all four corners are
+        // kept here by face and sub chunk block index instead of being emitted, they are merged after the block loop
+        u32 greedy_face_keys[6][Chunk::SubChunkBlockCount];
+
+        // note(harlequin): a face corner is lit and shaded by the 2x2 blocks in front of it, the same blocks light the
+        // corners of up to four faces on each side of them, the light and ambient occlusion of each 2x2 blocks is
+        // worked out the first time a face corner needs it and kept with an occluder bit per block, samples are
+        // indexed by the axis they are facing along then the halo index of the lowest of their blocks
+        static constexpr u32 CornerSampleCount = 3 * Sub_Chunk_Halo::BlockCount;
+
+        bool should_cache_corner_samples;
+        u16  corner_samples[CornerSampleCount];
+        u64  computed_corner_sample_mask[(CornerSampleCount + 63) / 64];
+
+        // note(harlequin): how many halo blocks the face corners were lit from, for benchmark_meshing
+        u64 corner_light_read_count;
+    };
+
+    inline const Block_Face *get_opaque_faces(const Sub_Chunk_Mesh *mesh)
+    {
+        return mesh->faces;
+    }
+
+    inline const Block_Face *get_transparent_faces(const Sub_Chunk_Mesh *mesh)
+    {
+        return mesh->faces + Sub_Chunk_Mesh::MaxFaceCount - mesh->transparent_face_count;
+    }
+
+    bool initialize_sub_chunk_mesher(Memory_Arena *arena);
+
+    void set_is_greedy_meshing_enabled(bool enabled);
+    bool is_greedy_meshing_enabled();
+
+    // note(harlequin): meshes the sub chunk at the level of detail of its chunk
+    void mesh_sub_chunk(World          *world,
+                        Chunk          *chunk,
+                        u32             sub_chunk_index,
+                        bool            is_greedy_meshing_enabled,
+                        Sub_Chunk_Mesh *mesh);
+
+    // note(harlequin): remeshes a sub chunk that block edits touched by diffing its halo against the one of the last
+    // mesh and only redoing the faces of the blocks next to what changed, returns null when the sub chunk is not
+    // patchable and has to go through mesh_sub_chunk, the returned mesh has to be released once it is uploaded
+    Sub_Chunk_Mesh *patch_sub_chunk_mesh(Chunk          *chunk,
+                                         u32             sub_chunk_index,
+                                         Sub_Chunk_Mesh *scratch_mesh);
+
+    void release_patched_sub_chunk_mesh(Sub_Chunk_Mesh *mesh);
+
+    struct Sub_Chunk_Patch_Stats
+    {
+        u64 patch_count;
+        u64 rebuild_count;
+        u64 last_patch_time;
+        u32 last_patched_block_count;
+    };
+
+    Sub_Chunk_Patch_Stats get_sub_chunk_patch_stats();
+
+    struct Greedy_Meshing_Validation_Result
+    {
+        u32 sub_chunk_count;
+        u32 face_count;
+        u32 greedy_face_count;
+        u32 bucket_count;
+        u32 greedy_bucket_count;
+        u32 mismatched_face_count;
+        u32 mismatched_packed_face_count;
+        u64 time;
+        u64 greedy_time;
+    };
+
+    // note(harlequin): meshes every sub chunk of the given chunks with and without greedy meshing and
+    // checks that each block face ends up with the same texture, light and ambient occlusion, every face
+    // emitted also has to decode the same way in the chunk vertex shaders as it does on the cpu
+    bool validate_greedy_meshing(World                            *world,
+                                 Chunk                           **chunks,
+                                 u32                               chunk_count,
+                                 Temprary_Memory_Arena            *temp_arena,
+                                 Greedy_Meshing_Validation_Result *result);
+
+    struct Face_Culling_Validation_Result
+    {
+        u32 sub_chunk_count;
+        u32 face_count;
+        u32 mismatched_sub_chunk_count;
+    };
+
+    // note(harlequin): meshes every sub chunk of the given chunks with the row masks and with the per block face
+    // lookups they replaced and checks that both emit the same faces in the same order
+    bool validate_face_culling(Chunk                          **chunks,
+                               u32                              chunk_count,
+                               Temprary_Memory_Arena           *temp_arena,
+                               Face_Culling_Validation_Result  *result);
+
+    struct Corner_Sample_Validation_Result
+    {
+        u32 sub_chunk_count;
+        u64 corner_light_read_count;
+        u64 cached_corner_light_read_count;
+        u32 mismatched_sub_chunk_count;
+    };
+
+    // note(harlequin): meshes every sub chunk of the given chunks with the corner samples cached and with every face
+    // corner lit from its own blocks, with and without greedy meshing, and checks that both emit the same faces
+    bool validate_corner_samples(Chunk                           **chunks,
+                                 u32                               chunk_count,
+                                 Temprary_Memory_Arena            *temp_arena,
+                                 Corner_Sample_Validation_Result  *result);
+
+    struct Block_Face_Packing_Validation_Result
+    {
+        u64 checked_face_count;
+        u64 mismatched_face_count;
+        u64 time;
+    };
+
+    // note(harlequin): packs every value of every block face field with the other fields at their extremes and
+    // checks that unpack_block_face and the decoding of the chunk vertex shaders give each value back
+    bool validate_block_face_packing(Block_Face_Packing_Validation_Result *result);
+
+    enum MeshingBenchmarkLayer : u32
+    {
+        MeshingBenchmarkLayer_Underground = 0,
+        MeshingBenchmarkLayer_Surface     = 1,
+        MeshingBenchmarkLayer_Sky         = 2,
+        MeshingBenchmarkLayer_Count       = 3
+    };
+
+    struct Meshing_Benchmark_Result
+    {
+        u32 sub_chunk_count;
+        u32 empty_sub_chunk_count;
+        u64 face_count;
+        u64 time;
+        u64 slowest_sub_chunk_time;
+
+        u64 corner_light_read_count;
+
+        u32 layer_sub_chunk_counts[MeshingBenchmarkLayer_Count];
+        u64 layer_times[MeshingBenchmarkLayer_Count];
+    };
+
+    // note(harlequin): should_cull_faces_by_masks set to false meshes with the per block face lookups the
+    // row masks replaced and should_cache_corner_samples set to false lights every face corner from its own
+    // blocks so each can be compared with what replaced it
+    void benchmark_sub_chunk_meshing(World                    *world,
+                                     Chunk                   **chunks,
+                                     u32                       chunk_count,
+                                     bool                      is_greedy_meshing_enabled,
+                                     bool                      should_cull_faces_by_masks,
+                                     bool                      should_cache_corner_samples,
+                                     Temprary_Memory_Arena    *temp_arena,
+                                     Meshing_Benchmark_Result *result);
+}
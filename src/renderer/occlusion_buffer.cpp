@@ -0,0 +1,540 @@
+#include "occlusion_buffer.h"
+#include "camera.h"
+#include "game/chunk.h"
+#include "game/job_system.h"
+#include "memory/memory_arena.h"
+
+#include <algorithm>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define MC_SSE2 1
+#include <emmintrin.h>
+#else
+#define MC_SSE2 0
+#endif
+
+namespace minecraft {
+
+    // note(harlequin): occluders are shrunk a little so a sub chunk is never hidden by the box of its own blocks
+    // when one of its faces lies on the face of the box
+    static constexpr f32 OccluderInset = 1.0f / 32.0f;
+
+    struct Occluder_Candidate
+    {
+        AABB aabb;
+        f32  distance_squared;
+    };
+
+    struct Screen_Vertex
+    {
+        f32 x;
+        f32 y;
+        f32 inv_w;
+    };
+
+    bool initialize_occlusion_buffer(Occlusion_Buffer *buffer)
+    {
+        memset(buffer->depths, 0, sizeof(buffer->depths));
+
+        buffer->view_projection = glm::mat4(1.0f);
+        buffer->view_position   = { 0.0f, 0.0f, 0.0f };
+        buffer->near            = 0.0f;
+        buffer->occluder_count  = 0;
+
+        buffer->frame_index            = 0;
+        buffer->claimed_frame_index    = 0;
+        buffer->rasterized_frame_index = 0;
+
+        new (&buffer->rasterized_mutex) std::mutex;
+        new (&buffer->rasterized_cv) std::condition_variable;
+
+        buffer->candidate_occluder_count  = 0;
+        buffer->rasterized_triangle_count = 0;
+        buffer->gather_time               = 0;
+        buffer->rasterize_time            = 0;
+        return true;
+    }
+
+    static void push_occluder_candidate(Occluder_Candidate *candidates,
+                                        u32                *candidate_count,
+                                        AABB                aabb,
+                                        const Camera       *camera)
+    {
+        aabb.min += glm::vec3(OccluderInset);
+        aabb.max -= glm::vec3(OccluderInset);
+
+        if (!camera->frustum.is_aabb_visible(aabb))
+        {
+            return;
+        }
+
+        glm::vec3 offset = glm::clamp(camera->position, aabb.min, aabb.max) - camera->position;
+        f32 distance_squared = glm::dot(offset, offset);
+
+        // note(harlequin): the view position is inside the box so every face of it is behind the camera
+        if (distance_squared == 0.0f)
+        {
+            return;
+        }
+
+        candidates[(*candidate_count)++] = { aabb, distance_squared };
+    }
+
+    void gather_occluders(Occlusion_Buffer      *buffer,
+                          Chunk                **chunks,
+                          u32                    chunk_count,
+                          const Camera          *camera,
+                          Temprary_Memory_Arena *temp_arena)
+    {
+        u64 begin_time = Job_System::get_time_stamp();
+
+        Occluder_Candidate *candidates = ArenaPushArrayAligned(temp_arena,
+                                                               Occluder_Candidate,
+                                                               chunk_count * Chunk::SubChunkCount);
+        Assert(candidates);
+
+        u32 candidate_count = 0;
+
+        for (u32 chunk_index = 0; chunk_index < chunk_count; chunk_index++)
+        {
+            Chunk *chunk = chunks[chunk_index];
+
+            if (!camera->frustum.is_aabb_visible(get_chunk_column_aabb(chunk)))
+            {
+                continue;
+            }
+
+            bool has_box = false;
+            AABB box;
+
+            for (u32 sub_chunk_index = 0; sub_chunk_index < Chunk::SubChunkCount; sub_chunk_index++)
+            {
+                u64 occluder = chunk->sub_chunks_render_data[sub_chunk_index].occluder.load(std::memory_order_relaxed);
+
+                if (!occluder)
+                {
+                    if (has_box)
+                    {
+                        push_occluder_candidate(candidates, &candidate_count, box, camera);
+                        has_box = false;
+                    }
+
+                    continue;
+                }
+
+                glm::ivec3 occluder_min;
+                glm::ivec3 occluder_max;
+                unpack_sub_chunk_occluder(occluder, &occluder_min, &occluder_max);
+
+                glm::vec3 sub_chunk_position = chunk->position + glm::vec3(0.0f, (f32)(sub_chunk_index * Chunk::SubChunkHeight), 0.0f);
+                glm::vec3 min = sub_chunk_position + glm::vec3(occluder_min);
+                glm::vec3 max = sub_chunk_position + glm::vec3(occluder_max);
+
+                // note(harlequin): boxes of the same footprint stacked on top of each other are one box
+                if (has_box &&
+                    box.max.y == min.y &&
+                    box.min.x == min.x && box.max.x == max.x &&
+                    box.min.z == min.z && box.max.z == max.z)
+                {
+                    box.max.y = max.y;
+                    continue;
+                }
+
+                if (has_box)
+                {
+                    push_occluder_candidate(candidates, &candidate_count, box, camera);
+                }
+
+                box     = { min, max };
+                has_box = true;
+            }
+
+            if (has_box)
+            {
+                push_occluder_candidate(candidates, &candidate_count, box, camera);
+            }
+        }
+
+        auto compare = [](const Occluder_Candidate& a, const Occluder_Candidate& b) -> bool
+        {
+            return a.distance_squared < b.distance_squared;
+        };
+
+        if (candidate_count > Occlusion_Buffer::MaxOccluderCount)
+        {
+            std::nth_element(candidates,
+                             candidates + Occlusion_Buffer::MaxOccluderCount,
+                             candidates + candidate_count,
+                             compare);
+        }
+
+        buffer->occluder_count = Min(candidate_count, Occlusion_Buffer::MaxOccluderCount);
+
+        for (u32 i = 0; i < buffer->occluder_count; i++)
+        {
+            buffer->occluders[i] = candidates[i].aabb;
+        }
+
+        buffer->view_projection          = camera->projection * camera->view;
+        buffer->view_position            = camera->position;
+        buffer->near                     = camera->near;
+        buffer->candidate_occluder_count = candidate_count;
+        buffer->frame_index++;
+
+        buffer->gather_time = Job_System::get_time_stamp() - begin_time;
+    }
+
+    static Screen_Vertex project_to_screen(const glm::vec4& clip_position)
+    {
+        f32 inv_w = 1.0f / clip_position.w;
+
+        Screen_Vertex result;
+        result.x     = (clip_position.x * inv_w * 0.5f + 0.5f) * (f32)Occlusion_Buffer::Width;
+        result.y     = (clip_position.y * inv_w * 0.5f + 0.5f) * (f32)Occlusion_Buffer::Height;
+        result.inv_w = inv_w;
+        return result;
+    }
+
+    // note(harlequin): a pixel is covered when its center is inside the triangle or on one of its edges, the
+    // depth is interpolated from the three edge functions of the pixel center
+    static bool rasterize_triangle(Occlusion_Buffer *buffer,
+                                   Screen_Vertex     v0,
+                                   Screen_Vertex     v1,
+                                   Screen_Vertex     v2)
+    {
+        f32 area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+
+        if (area < 0.0f)
+        {
+            Screen_Vertex temp = v1;
+            v1   = v2;
+            v2   = temp;
+            area = -area;
+        }
+
+        if (area < 1e-6f)
+        {
+            return false;
+        }
+
+        f32 min_x = Min(v0.x, Min(v1.x, v2.x));
+        f32 min_y = Min(v0.y, Min(v1.y, v2.y));
+        f32 max_x = Max(v0.x, Max(v1.x, v2.x));
+        f32 max_y = Max(v0.y, Max(v1.y, v2.y));
+
+        // note(harlequin): clamped before the conversion since a vertex near the near plane can land far off screen
+        i32 first_x = (i32)glm::ceil(glm::clamp(min_x - 0.5f, -1.0f, (f32)Occlusion_Buffer::Width));
+        i32 first_y = (i32)glm::ceil(glm::clamp(min_y - 0.5f, -1.0f, (f32)Occlusion_Buffer::Height));
+        i32 last_x  = (i32)glm::floor(glm::clamp(max_x - 0.5f, -1.0f, (f32)Occlusion_Buffer::Width));
+        i32 last_y  = (i32)glm::floor(glm::clamp(max_y - 0.5f, -1.0f, (f32)Occlusion_Buffer::Height));
+
+        first_x = Max(first_x, 0);
+        first_y = Max(first_y, 0);
+        last_x  = Min(last_x, Occlusion_Buffer::Width - 1);
+        last_y  = Min(last_y, Occlusion_Buffer::Height - 1);
+
+        if (first_x > last_x || first_y > last_y)
+        {
+            return true;
+        }
+
+        // note(harlequin): edge i is the edge in front of vertex i, a * x + b * y + c is zero on the edge and
+        // the area of the triangle at vertex i
+        f32 a0 = v1.y - v2.y, b0 = v2.x - v1.x, c0 = v1.x * v2.y - v1.y * v2.x;
+        f32 a1 = v2.y - v0.y, b1 = v0.x - v2.x, c1 = v2.x * v0.y - v2.y * v0.x;
+        f32 a2 = v0.y - v1.y, b2 = v1.x - v0.x, c2 = v0.x * v1.y - v0.y * v1.x;
+
+        f32 z0 = v0.inv_w / area;
+        f32 z1 = v1.inv_w / area;
+        f32 z2 = v2.inv_w / area;
+
+        // note(harlequin): the rows are walked four pixels at a time from a multiple of four, the pixels outside
+        // the bounds of the triangle are outside the triangle so they are never written
+        first_x &= ~3;
+
+#if MC_SSE2
+        __m128 lane_offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+        __m128 zero         = _mm_setzero_ps();
+
+        __m128 a0x4 = _mm_set1_ps(a0), a1x4 = _mm_set1_ps(a1), a2x4 = _mm_set1_ps(a2);
+        __m128 z0x4 = _mm_set1_ps(z0), z1x4 = _mm_set1_ps(z1), z2x4 = _mm_set1_ps(z2);
+
+        for (i32 y = first_y; y <= last_y; y++)
+        {
+            f32 pixel_y = (f32)y + 0.5f;
+
+            __m128 row_e0 = _mm_set1_ps(b0 * pixel_y + c0);
+            __m128 row_e1 = _mm_set1_ps(b1 * pixel_y + c1);
+            __m128 row_e2 = _mm_set1_ps(b2 * pixel_y + c2);
+
+            f32 *row = buffer->depths + y * Occlusion_Buffer::Width;
+
+            for (i32 x = first_x; x <= last_x; x += 4)
+            {
+                __m128 pixel_x = _mm_add_ps(_mm_set1_ps((f32)x), lane_offsets);
+
+                __m128 e0 = _mm_add_ps(_mm_mul_ps(a0x4, pixel_x), row_e0);
+                __m128 e1 = _mm_add_ps(_mm_mul_ps(a1x4, pixel_x), row_e1);
+                __m128 e2 = _mm_add_ps(_mm_mul_ps(a2x4, pixel_x), row_e2);
+
+                __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)),
+                                           _mm_cmpge_ps(e2, zero));
+
+                if (!_mm_movemask_ps(inside))
+                {
+                    continue;
+                }
+
+                __m128 depth = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e0, z0x4), _mm_mul_ps(e1, z1x4)),
+                                          _mm_mul_ps(e2, z2x4));
+
+                // note(harlequin): the depths are positive so the masked out lanes keep what is in the buffer
+                __m128 old_depth = _mm_load_ps(row + x);
+                _mm_store_ps(row + x, _mm_max_ps(old_depth, _mm_and_ps(inside, depth)));
+            }
+        }
+#else
+        for (i32 y = first_y; y <= last_y; y++)
+        {
+            f32 pixel_y = (f32)y + 0.5f;
+            f32 *row = buffer->depths + y * Occlusion_Buffer::Width;
+
+            for (i32 x = first_x; x <= last_x; x++)
+            {
+                f32 pixel_x = (f32)x + 0.5f;
+
+                f32 e0 = a0 * pixel_x + b0 * pixel_y + c0;
+                f32 e1 = a1 * pixel_x + b1 * pixel_y + c1;
+                f32 e2 = a2 * pixel_x + b2 * pixel_y + c2;
+
+                if (e0 >= 0.0f && e1 >= 0.0f && e2 >= 0.0f)
+                {
+                    row[x] = Max(row[x], (e0 * z0 + e1 * z1) + e2 * z2);
+                }
+            }
+        }
+#endif
+
+        return true;
+    }
+
+    // note(harlequin): the corners of face i of a box in order around the face, corner j of a box is at the max
+    // of the box along x when bit 0 of j is set, along y when bit 1 is set and along z when bit 2 is set
+    static constexpr u8 BoxFaceCorners[6][4] =
+    {
+        { 0, 2, 6, 4 }, // min x
+        { 1, 3, 7, 5 }, // max x
+        { 0, 1, 5, 4 }, // min y
+        { 2, 3, 7, 6 }, // max y
+        { 0, 1, 3, 2 }, // min z
+        { 4, 5, 7, 6 }  // max z
+    };
+
+    // note(harlequin): only the faces looking at the view position are drawn, they are clipped by the near plane
+    // and drawn as a fan, returns the number of triangles drawn
+    static u32 rasterize_occluder(Occlusion_Buffer *buffer, const AABB& aabb)
+    {
+        glm::vec4 clip_positions[8];
+
+        for (u32 i = 0; i < 8; i++)
+        {
+            glm::vec4 corner = { (i & 1) ? aabb.max.x : aabb.min.x,
+                                 (i & 2) ? aabb.max.y : aabb.min.y,
+                                 (i & 4) ? aabb.max.z : aabb.min.z,
+                                 1.0f };
+            clip_positions[i] = buffer->view_projection * corner;
+        }
+
+        const glm::vec3& view_position = buffer->view_position;
+
+        bool is_face_visible[6] =
+        {
+            view_position.x < aabb.min.x,
+            view_position.x > aabb.max.x,
+            view_position.y < aabb.min.y,
+            view_position.y > aabb.max.y,
+            view_position.z < aabb.min.z,
+            view_position.z > aabb.max.z
+        };
+
+        u32 triangle_count = 0;
+
+        for (u32 face = 0; face < 6; face++)
+        {
+            if (!is_face_visible[face])
+            {
+                continue;
+            }
+
+            // note(harlequin): a quad clipped by a plane has at most five vertices
+            glm::vec4 polygon[5];
+            u32 vertex_count = 0;
+
+            for (u32 i = 0; i < 4; i++)
+            {
+                const glm::vec4& a = clip_positions[BoxFaceCorners[face][i]];
+                const glm::vec4& b = clip_positions[BoxFaceCorners[face][(i + 1) & 3]];
+
+                f32 distance_a = a.w - buffer->near;
+                f32 distance_b = b.w - buffer->near;
+
+                if (distance_a >= 0.0f)
+                {
+                    polygon[vertex_count++] = a;
+                }
+
+                if ((distance_a >= 0.0f) != (distance_b >= 0.0f))
+                {
+                    f32 t = distance_a / (distance_a - distance_b);
+                    polygon[vertex_count++] = a + (b - a) * t;
+                }
+            }
+
+            if (vertex_count < 3)
+            {
+                continue;
+            }
+
+            Screen_Vertex vertices[5];
+
+            for (u32 i = 0; i < vertex_count; i++)
+            {
+                vertices[i] = project_to_screen(polygon[i]);
+            }
+
+            for (u32 i = 1; i + 1 < vertex_count; i++)
+            {
+                triangle_count += rasterize_triangle(buffer, vertices[0], vertices[i], vertices[i + 1]);
+            }
+        }
+
+        return triangle_count;
+    }
+
+    bool rasterize_occluders(Occlusion_Buffer *buffer, u64 frame_index)
+    {
+        u64 previous_frame_index = frame_index - 1;
+
+        if (!buffer->claimed_frame_index.compare_exchange_strong(previous_frame_index, frame_index))
+        {
+            return false;
+        }
+
+        u64 begin_time = Job_System::get_time_stamp();
+
+        memset(buffer->depths, 0, sizeof(buffer->depths));
+
+        u32 triangle_count = 0;
+
+        for (u32 i = 0; i < buffer->occluder_count; i++)
+        {
+            triangle_count += rasterize_occluder(buffer, buffer->occluders[i]);
+        }
+
+        buffer->rasterized_triangle_count = triangle_count;
+        buffer->rasterize_time            = Job_System::get_time_stamp() - begin_time;
+
+        {
+            // note(harlequin): published under the mutex so a waiter can't miss the notify between its check and its wait
+            std::lock_guard lock(buffer->rasterized_mutex);
+            buffer->rasterized_frame_index.store(frame_index, std::memory_order_release);
+        }
+
+        buffer->rasterized_cv.notify_all();
+        return true;
+    }
+
+    void wait_for_occluders(Occlusion_Buffer *buffer)
+    {
+        u64 frame_index = buffer->frame_index;
+
+        if (rasterize_occluders(buffer, frame_index))
+        {
+            return;
+        }
+
+        std::unique_lock lock(buffer->rasterized_mutex);
+        buffer->rasterized_cv.wait(lock, [&] { return buffer->rasterized_frame_index.load(std::memory_order_acquire) == frame_index; });
+    }
+
+    bool is_aabb_occluded(const Occlusion_Buffer *buffer, const AABB& aabb)
+    {
+        glm::vec2 screen_min    = {  Infinity32,  Infinity32 };
+        glm::vec2 screen_max    = { -Infinity32, -Infinity32 };
+        f32       nearest_inv_w = 0.0f;
+
+        for (u32 i = 0; i < 8; i++)
+        {
+            glm::vec4 corner = { (i & 1) ? aabb.max.x : aabb.min.x,
+                                 (i & 2) ? aabb.max.y : aabb.min.y,
+                                 (i & 4) ? aabb.max.z : aabb.min.z,
+                                 1.0f };
+            glm::vec4 clip_position = buffer->view_projection * corner;
+
+            if (clip_position.w < buffer->near)
+            {
+                return false;
+            }
+
+            Screen_Vertex vertex = project_to_screen(clip_position);
+            screen_min    = glm::min(screen_min, { vertex.x, vertex.y });
+            screen_max    = glm::max(screen_max, { vertex.x, vertex.y });
+            nearest_inv_w = Max(nearest_inv_w, vertex.inv_w);
+        }
+
+        // note(harlequin): every pixel the screen rectangle of the aabb touches is tested
+        i32 first_x = (i32)glm::floor(glm::clamp(screen_min.x, -1.0f, (f32)Occlusion_Buffer::Width));
+        i32 first_y = (i32)glm::floor(glm::clamp(screen_min.y, -1.0f, (f32)Occlusion_Buffer::Height));
+        i32 last_x  = (i32)glm::floor(glm::clamp(screen_max.x, -1.0f, (f32)Occlusion_Buffer::Width));
+        i32 last_y  = (i32)glm::floor(glm::clamp(screen_max.y, -1.0f, (f32)Occlusion_Buffer::Height));
+
+        first_x = Max(first_x, 0);
+        first_y = Max(first_y, 0);
+        last_x  = Min(last_x, Occlusion_Buffer::Width - 1);
+        last_y  = Min(last_y, Occlusion_Buffer::Height - 1);
+
+        if (first_x > last_x || first_y > last_y)
+        {
+            return false;
+        }
+
+#if MC_SSE2
+        __m128 lane_offsets   = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+        __m128 first_x4       = _mm_set1_ps((f32)first_x);
+        __m128 last_x4        = _mm_set1_ps((f32)last_x);
+        __m128 nearest_inv_w4 = _mm_set1_ps(nearest_inv_w);
+
+        for (i32 y = first_y; y <= last_y; y++)
+        {
+            const f32 *row = buffer->depths + y * Occlusion_Buffer::Width;
+
+            for (i32 x = first_x & ~3; x <= last_x; x += 4)
+            {
+                __m128 pixel_x = _mm_add_ps(_mm_set1_ps((f32)x), lane_offsets);
+                __m128 in_rect = _mm_and_ps(_mm_cmpge_ps(pixel_x, first_x4), _mm_cmple_ps(pixel_x, last_x4));
+                __m128 farther = _mm_cmplt_ps(_mm_load_ps(row + x), nearest_inv_w4);
+
+                if (_mm_movemask_ps(_mm_and_ps(in_rect, farther)))
+                {
+                    return false;
+                }
+            }
+        }
+#else
+        for (i32 y = first_y; y <= last_y; y++)
+        {
+            const f32 *row = buffer->depths + y * Occlusion_Buffer::Width;
+
+            for (i32 x = first_x; x <= last_x; x++)
+            {
+                if (row[x] < nearest_inv_w)
+                {
+                    return false;
+                }
+            }
+        }
+#endif
+
+        return true;
+    }
+}
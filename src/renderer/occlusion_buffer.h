@@ -0,0 +1,71 @@
+#pragma once
+
+#include "core/common.h"
+#include "game/math.h"
+
+#include <glm/glm.hpp>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+namespace minecraft {
+
+    struct Chunk;
+    struct Camera;
+    struct Temprary_Memory_Arena;
+
+    // note(harlequin): a small depth buffer the occluders of the nearest sub chunks are rasterized into on the cpu,
+    // it holds 1 / view depth so the nearest depth wins with a max and a cleared pixel is infinitely far away, the
+    // sub chunks in the frustum are tested against it before their buckets are pushed
+    struct alignas(16) Occlusion_Buffer
+    {
+        static constexpr i32 Width            = 256;
+        static constexpr i32 Height           = 128;
+        static constexpr u32 MaxOccluderCount = 512;
+
+        f32 depths[Width * Height];
+
+        glm::mat4 view_projection;
+        glm::vec3 view_position;
+        f32       near;
+
+        u32  occluder_count;
+        AABB occluders[MaxOccluderCount];
+
+        // note(harlequin): whoever claims a frame first rasterizes it, the job or the thread waiting on it,
+        // a thread that finds the frame claimed by someone else sleeps on rasterized_cv until it is published
+        u64                     frame_index;
+        std::atomic< u64 >      claimed_frame_index;
+        std::atomic< u64 >      rasterized_frame_index;
+        std::mutex              rasterized_mutex;
+        std::condition_variable rasterized_cv;
+
+        u32 candidate_occluder_count;
+        u32 rasterized_triangle_count;
+        u64 gather_time;
+        u64 rasterize_time;
+    };
+
+    static_assert(Occlusion_Buffer::Width % 4 == 0, "the occlusion buffer is rasterized four pixels at a time");
+
+    bool initialize_occlusion_buffer(Occlusion_Buffer *buffer);
+
+    // note(harlequin): picks the MaxOccluderCount nearest occluders of the sub chunks of chunks that are in the
+    // frustum of camera and starts a new frame, the occluders of a column that touch are merged into one box
+    void gather_occluders(Occlusion_Buffer      *buffer,
+                          Chunk                **chunks,
+                          u32                    chunk_count,
+                          const Camera          *camera,
+                          Temprary_Memory_Arena *temp_arena);
+
+    // note(harlequin): rasterizes the occluders of frame_index unless it was claimed already, returns whether it did
+    bool rasterize_occluders(Occlusion_Buffer *buffer, u64 frame_index);
+
+    // note(harlequin): rasterizes the occluders of the current frame on this thread when nobody claimed them yet
+    // and waits for them otherwise
+    void wait_for_occluders(Occlusion_Buffer *buffer);
+
+    // note(harlequin): an aabb is occluded when every pixel it covers holds a depth nearer than its nearest corner,
+    // an aabb crossing the near plane is never occluded
+    bool is_aabb_occluded(const Occlusion_Buffer *buffer, const AABB& aabb);
+}
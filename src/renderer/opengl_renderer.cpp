@@ -12,6 +12,10 @@
 #include "opengl_frame_buffer.h"
 #include "memory/memory_arena.h"
 #include "containers/queue.h"
+#include "meshing/sub_chunk_mesher.h"
+#include "memory/buddy_allocator.h"
+#include "memory/retire_queue.h"
+#include "occlusion_buffer.h"
 
 #include <glad/glad.h>
 #include <glm/gtc/type_ptr.hpp>
@@ -23,19 +27,6 @@
 
 namespace minecraft {
 
-// vertex0 masks
-#define BLOCK_X_MASK 15 // 4 bits
-#define BLOCK_Y_MASK 255 // 8 bits
-#define BLOCK_Z_MASK 15 // 4 bits
-#define LOCAL_POSITION_ID_MASK 7 // 3 bits
-#define FACE_ID_MASK 7 // 3 bits
-#define FACE_CORNER_ID_MASK 3 // 2 bits
-
-// vertex1 masks
-#define SKY_LIGHT_LEVEL_MASK 15 // 4 bits
-#define LIGHT_SOURCE_LEVEL_MASK 15 // 4 bits
-#define AMBIENT_OCCLUSION_LEVEL_MASK 3 // 2 bits
-
     static void APIENTRY gl_debug_output(GLenum      source,
                                          GLenum      type,
                                          u32         id,
@@ -44,20 +35,21 @@ namespace minecraft {
                                          const char *message,
                                          const void *user_param);
 
-    struct Draw_Elements_Indirect_Command
+    // note(harlequin): a face is drawn as two triangles, the vertex shader finds the face and the corner
+    // it is drawing from gl_VertexID so first and count are in faces times six
+    struct Draw_Arrays_Indirect_Command
     {
         u32 count;
         u32 instanceCount;
-        u32 firstIndex;
-        u32 baseVertex;
+        u32 first;
         u32 baseInstance;
     };
 
     struct Command_Buffer
     {
-        u32                             handle;
-        u32                             command_count;
-        Draw_Elements_Indirect_Command *commands;
+        u32                           handle;
+        u32                           command_count;
+        Draw_Arrays_Indirect_Command *commands;
     };
 
     static bool initialize_command_buffer(Command_Buffer *command_buffer,
@@ -71,41 +63,112 @@ namespace minecraft {
                            GL_MAP_WRITE_BIT |
                            GL_MAP_COHERENT_BIT;
 
-        u64 size = sizeof(Draw_Elements_Indirect_Command) * max_command_count;
+        u64 size = sizeof(Draw_Arrays_Indirect_Command) * max_command_count;
         glNamedBufferStorage(command_buffer->handle,
                              size,
                              nullptr,
                              flags);
 
         command_buffer->commands =
-            (Draw_Elements_Indirect_Command *)glMapNamedBufferRange(command_buffer->handle,
-                                                                    0,
-                                                                    size,
-                                                                    flags);
+            (Draw_Arrays_Indirect_Command *)glMapNamedBufferRange(command_buffer->handle,
+                                                                  0,
+                                                                  size,
+                                                                  flags);
+        return true;
+    }
+
+    struct Shader_Storage_Buffer
+    {
+        u32   handle;
+        void *data; // null unless the buffer is mapped
+    };
+
+    static bool initialize_shader_storage_buffer(Shader_Storage_Buffer *storage_buffer,
+                                                 u64 size,
+                                                 const void *data,
+                                                 bool is_mapped)
+    {
+        storage_buffer->handle = 0;
+        storage_buffer->data   = nullptr;
+        glCreateBuffers(1, &storage_buffer->handle);
+        Assert(storage_buffer->handle);
+
+        GLbitfield flags = 0;
+
+        if (is_mapped)
+        {
+            flags = GL_MAP_PERSISTENT_BIT |
+                    GL_MAP_WRITE_BIT |
+                    GL_MAP_COHERENT_BIT;
+        }
+
+        glNamedBufferStorage(storage_buffer->handle,
+                             size,
+                             data,
+                             flags);
+
+        if (is_mapped)
+        {
+            storage_buffer->data = glMapNamedBufferRange(storage_buffer->handle,
+                                                         0,
+                                                         size,
+                                                         flags);
+            Assert(storage_buffer->data);
+        }
+
         return true;
     }
 
     static void push_sub_chunk_bucket(Command_Buffer *command_buffer, Sub_Chunk_Bucket *bucket, i64 instance_memory_id)
     {
-        Draw_Elements_Indirect_Command *command = command_buffer->commands + command_buffer->command_count++;
+        Draw_Arrays_Indirect_Command *command = command_buffer->commands + command_buffer->command_count++;
         command->count         = bucket->face_count * 6;
-        command->firstIndex    = 0;
         command->instanceCount = 1;
-        command->baseVertex    = bucket->memory_id * World::SubChunkBucketVertexCount;
+        command->first         = (u32)(bucket->memory_offset * 6);
         command->baseInstance  = (u32)instance_memory_id;
     }
 
     static void draw_commands(Command_Buffer *command_buffer)
     {
         glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer->handle);
-        glMultiDrawElementsIndirect(GL_TRIANGLES,
-                                    GL_UNSIGNED_INT,
-                                    0,
-                                    command_buffer->command_count,
-                                    sizeof(Draw_Elements_Indirect_Command));
+        glMultiDrawArraysIndirect(GL_TRIANGLES,
+                                  0,
+                                  command_buffer->command_count,
+                                  sizeof(Draw_Arrays_Indirect_Command));
         command_buffer->command_count = 0;
     }
 
+    struct Sub_Chunk_Mesh_Cache_Entry
+    {
+        u64              content_hash;
+        u64              face_hash;
+        Sub_Chunk_Bucket opaque_bucket;
+        Sub_Chunk_Bucket transparent_bucket;
+        u32              reference_count; // zero marks a free slot
+    };
+
+    // note(harlequin): the buckets of every mesh drawn by a sub chunk by content hash, sub chunks with the same
+    // content hold a reference to the same buckets, entries are found by linear probing and the entries after a
+    // removed one are shifted back so sub chunks coming and going never leave tombstones behind
+    struct Sub_Chunk_Mesh_Cache
+    {
+        static constexpr u32 Capacity = 2 * World::SubChunkBucketCapacity;
+
+        Sub_Chunk_Mesh_Cache_Entry *entries;
+        std::mutex                  mutex;
+
+        u32 mesh_count;
+        u32 sub_chunk_count;
+        u64 face_count;
+        u64 shared_face_count;
+        u64 hit_count;
+        u64 miss_count;
+        u64 collision_count;
+    };
+
+    static_assert((Sub_Chunk_Mesh_Cache::Capacity & (Sub_Chunk_Mesh_Cache::Capacity - 1)) == 0,
+                  "the mesh cache is indexed by masking the content hash");
+
     struct Opengl_Renderer
     {
         glm::vec2 frame_buffer_size;
@@ -115,6 +178,11 @@ namespace minecraft {
 
         Opengl_Vertex_Array chunk_vertex_array;
 
+        // note(harlequin): the block faces of every sub chunk bucket and the textures and flags of every block,
+        // both are read by the chunk vertex shaders instead of going through vertex attributes
+        Shader_Storage_Buffer chunk_face_buffer;
+        Shader_Storage_Buffer block_info_buffer;
+
         Command_Buffer opaque_command_buffer;
         Command_Buffer transparent_command_buffer;
         GLsync command_buffer_sync_object;
@@ -122,11 +190,16 @@ namespace minecraft {
         Asset_Handle blocks_atlas;
         Opengl_Array_Texture block_array_texture;
 
-        Block_Face_Vertex *base_vertex;
-        Chunk_Instance    *base_instance;
+        Block_Face     *base_face;
+        Chunk_Instance *base_instance;
 
-        std::mutex free_buckets_mutex;
-        Circular_Queue< i32, World::SubChunkBucketCapacity > free_buckets;
+        // note(harlequin): hands out the sub chunk buckets, its units are block faces of the chunk face buffer
+        Buddy_Allocator      vertex_allocator;
+        Retire_Queue         retire_queue;
+        Sub_Chunk_Mesh_Cache mesh_cache;
+
+        // note(harlequin): the frame being recorded, the fence of the frame before it is waited on in begin frame
+        std::atomic< u64 > frame_index;
 
         std::mutex free_instances_mutex;
         Circular_Queue< i32, World::SubChunkBucketCapacity > free_instances;
@@ -220,30 +293,34 @@ namespace minecraft {
         }
         renderer->transparent_frame_buffer = transparent_frame_buffer;
 
+        initialize_shader_storage_buffer(&renderer->chunk_face_buffer,
+                                         World::SubChunkVertexBufferFaceCount * sizeof(Block_Face),
+                                         nullptr,
+                                         true);
+
+        // note(harlequin): the top, bottom and side texture ids of a block packed in 10 bits each and its flags
+        u32 block_infos[BlockId_Count][2];
+
+        for (u32 i = 0; i < BlockId_Count; i++)
+        {
+            const Block_Info *block_info = &World::block_infos[i];
+            Assert(block_info->top_texture_id < 1024 && block_info->bottom_texture_id < 1024 && block_info->side_texture_id < 1024);
+
+            block_infos[i][0] = block_info->top_texture_id | (block_info->bottom_texture_id << 10) | (block_info->side_texture_id << 20);
+            block_infos[i][1] = block_info->flags;
+        }
+
+        initialize_shader_storage_buffer(&renderer->block_info_buffer,
+                                         sizeof(block_infos),
+                                         block_infos,
+                                         false);
+
         Opengl_Vertex_Array chunk_vertex_array = begin_vertex_array(arena);
 
         GLbitfield flags = GL_MAP_PERSISTENT_BIT |
                            GL_MAP_WRITE_BIT |
                            GL_MAP_COHERENT_BIT;
 
-        Opengl_Vertex_Buffer chunk_vertex_buffer = push_vertex_buffer(&chunk_vertex_array,
-                                                                      sizeof(Block_Face_Vertex),
-                                                                      World::SubChunkBucketVertexCount * World::SubChunkBucketCapacity,
-                                                                      nullptr,
-                                                                      flags);
-
-        push_vertex_attribute(&chunk_vertex_array,
-                              &chunk_vertex_buffer,
-                              "in_packed_vertex_attributes0",
-                              VertexAttributeType_U32,
-                              offsetof(Block_Face_Vertex, packed_vertex_attributes0));
-
-        push_vertex_attribute(&chunk_vertex_array,
-                              &chunk_vertex_buffer,
-                              "in_packed_vertex_attributes1",
-                              VertexAttributeType_U32,
-                              offsetof(Block_Face_Vertex, packed_vertex_attributes1));
-
         Opengl_Vertex_Buffer chunk_instance_buffer = push_vertex_buffer(&chunk_vertex_array,
                                                                         sizeof(Chunk_Instance),
                                                                         World::SubChunkBucketCapacity,
@@ -258,49 +335,59 @@ namespace minecraft {
                               offsetof(Chunk_Instance, chunk_coords),
                               per_instance);
 
-        Temprary_Memory_Arena temp_arena = begin_temprary_memory_arena(arena);
-        u32 *chunk_indicies = ArenaPushArrayAligned(&temp_arena, u32, Chunk::SubChunkIndexCount);
-
-        u32 element_index = 0;
-        u32 vertex_index  = 0;
-
-        for (u32 i = 0; i < Chunk::SubChunkBlockCount * 6; i++)
-        {
-            chunk_indicies[element_index + 0] = vertex_index + 3;
-            chunk_indicies[element_index + 1] = vertex_index + 1;
-            chunk_indicies[element_index + 2] = vertex_index + 0;
-
-            chunk_indicies[element_index + 3] = vertex_index + 3;
-            chunk_indicies[element_index + 4] = vertex_index + 2;
-            chunk_indicies[element_index + 5] = vertex_index + 1;
-
-            element_index += 6;
-            vertex_index  += 4;
-        }
-
-        Opengl_Index_Buffer chunk_index_buffer = push_index_buffer(&chunk_vertex_array,
-                                                                   chunk_indicies,
-                                                                   Chunk::SubChunkIndexCount);
-        end_temprary_memory_arena(&temp_arena);
+        push_vertex_attribute(&chunk_vertex_array,
+                              &chunk_instance_buffer,
+                              "in_sub_chunk_index",
+                              VertexAttributeType_I32,
+                              offsetof(Chunk_Instance, sub_chunk_index),
+                              per_instance);
 
         end_vertex_array(&chunk_vertex_array);
 
         renderer->chunk_vertex_array = chunk_vertex_array;
-        renderer->base_vertex        = (Block_Face_Vertex *) chunk_vertex_buffer.data;
+        renderer->base_face          = (Block_Face *) renderer->chunk_face_buffer.data;
         renderer->base_instance      = (Chunk_Instance *) chunk_instance_buffer.data;
 
-        new (&renderer->free_buckets_mutex) std::mutex;
         new (&renderer->free_instances_mutex) std::mutex;
 
-        renderer->free_buckets.initialize();
         renderer->free_instances.initialize();
 
         for (i32 i = 0; i < World::SubChunkBucketCapacity; ++i)
         {
-            renderer->free_buckets.push(i);
             renderer->free_instances.push(i);
         }
 
+        success = initialize_buddy_allocator(&renderer->vertex_allocator,
+                                             World::SubChunkVertexBufferFaceCount,
+                                             World::SubChunkBucketMinFaceCount,
+                                             World::SubChunkBucketMaxFaceCount,
+                                             arena);
+        if (!success)
+        {
+            return false;
+        }
+
+        success = initialize_retire_queue(&renderer->retire_queue,
+                                          &renderer->vertex_allocator,
+                                          arena);
+        if (!success)
+        {
+            return false;
+        }
+
+        // note(harlequin): every sub chunk with faces has an instance so the cache is never more than half full
+        renderer->mesh_cache.entries = ArenaPushArrayAlignedZero(arena,
+                                                                 Sub_Chunk_Mesh_Cache_Entry,
+                                                                 Sub_Chunk_Mesh_Cache::Capacity);
+        if (!renderer->mesh_cache.entries)
+        {
+            return false;
+        }
+
+        new (&renderer->mesh_cache.mutex) std::mutex;
+
+        renderer->frame_index = 0;
+
         initialize_command_buffer(&renderer->opaque_command_buffer,
                                   World::SubChunkBucketCapacity);
         initialize_command_buffer(&renderer->transparent_command_buffer,
@@ -325,7 +412,7 @@ namespace minecraft {
                                  TextureFormat_RGBA8,
                                  mipmapping);
 
-        temp_arena = begin_temprary_memory_arena(arena);
+        Temprary_Memory_Arena temp_arena = begin_temprary_memory_arena(arena);
         u32 *magenta_pixel_data = ArenaPushArrayAligned(&temp_arena, u32, 32 * 32);
 
         for (u32 i = 0; i < 32 * 32; i++)
@@ -427,1051 +514,630 @@ namespace minecraft {
         return false;
     }
 
-    static u32 compress_vertex0(const glm::ivec3& block_coords,
-                                u32 local_position_id,
-                                u32 face_id,
-                                u32 face_corner_id,
-                                u32 flags)
-    {
-        u32 result = 0;
-
-        result |= block_coords.x;
-        result |= ((u32)block_coords.y << 4);
-        result |= ((u32)block_coords.z << 12);
-        result |= ((u32)local_position_id << 16);
-        result |= ((u32)face_id << 19);
-        result |= ((u32)face_corner_id << 22);
-        result |= ((u32)flags << 24);
+    // note(harlequin): small buckets come and go from every worker thread, each thread keeps a few of
+    // them around so most of them never take the allocator lock
+    static thread_local Buddy_Allocator_Thread_Cache vertex_allocator_thread_cache;
 
-        return result;
-    }
+    // note(harlequin): the transparent bit, 5 bits of sub chunk index and the chunk node index in the 26 bits left,
+    // the last node stays below 2^26 - 1 so no tag is ever Buddy_Allocator::NullTag
+    static_assert(Chunk::SubChunkCount <= 32 && World::ChunkCapacity < ((i64)1 << 26),
+                  "a sub chunk bucket tag has to fit the chunk node index in the 26 bits above the sub chunk index");
 
-    static void extract_vertex0(u32 vertex,
-                                glm::ivec3& block_coords,
-                                u32 &out_local_position_id,
-                                u32 &out_face_id,
-                                u32 &out_face_corner_id,
-                                u32 &out_flags)
+    static u32 get_sub_chunk_bucket_tag(World *world, Chunk *chunk, u32 sub_chunk_index, bool is_transparent)
     {
-        block_coords.x        = vertex & BLOCK_X_MASK;
-        block_coords.y        = (vertex >> 4) & BLOCK_Y_MASK;
-        block_coords.z        = (vertex >> 12) & BLOCK_Z_MASK;
-        out_local_position_id = (vertex >> 16) & LOCAL_POSITION_ID_MASK;
-        out_face_id           = (vertex >> 19) & FACE_ID_MASK;
-        out_face_corner_id    = (vertex >> 22) & FACE_CORNER_ID_MASK;
-        out_flags             = (vertex >> 24);
+        return ((u32)get_chunk_node_index(world, chunk) << 6) | (sub_chunk_index << 1) | (u32)is_transparent;
     }
 
-    static u32 compress_vertex1(u32 texture_id,
-                                u32 sky_light_level,
-                                u32 light_source_level,
-                                u32 ambient_occlusion_level)
+    // note(harlequin): the frame being recorded may still draw the run so it is only freed after its fence
+    static void retire_sub_chunk_bucket(const Sub_Chunk_Bucket *bucket)
     {
-        u32 result = 0;
-        result |= sky_light_level;
-        result |= light_source_level << 4;
-        result |= ambient_occlusion_level << 8;
-        result |= texture_id << 10;
-        return result;
-    }
-
-    static void extract_vertex1(u32 vertex,
-                                u32 &out_texture_id,
-                                u32 &out_sky_light_level,
-                                u32 &out_light_source_level,
-                                u32 &out_ambient_occlusion_level)
-    {
-        out_sky_light_level         = vertex        & SKY_LIGHT_LEVEL_MASK;
-        out_light_source_level      = (vertex >> 4) & LIGHT_SOURCE_LEVEL_MASK;
-        out_ambient_occlusion_level = (vertex >> 8) & AMBIENT_OCCLUSION_LEVEL_MASK;
-        out_texture_id              = (vertex >> 10);
-    }
-
-    void opengl_renderer_allocate_sub_chunk_bucket(Sub_Chunk_Bucket *bucket)
-    {
-        renderer->free_buckets_mutex.lock();
-        bucket->memory_id = renderer->free_buckets.pop();
-        renderer->free_buckets_mutex.unlock();
-        bucket->current_vertex = renderer->base_vertex + bucket->memory_id * World::SubChunkBucketVertexCount;
-        bucket->face_count = 0;
-    }
-
-    void opengl_renderer_reset_sub_chunk_bucket(Sub_Chunk_Bucket *bucket)
-    {
-        Assert(bucket->memory_id != -1 && bucket->current_vertex);
-        bucket->current_vertex = renderer->base_vertex + bucket->memory_id * World::SubChunkBucketVertexCount;
-        bucket->face_count = 0;
-    }
+        if (!is_sub_chunk_bucket_allocated(bucket))
+        {
+            return;
+        }
 
-    void opengl_renderer_free_sub_chunk_bucket(Sub_Chunk_Bucket *bucket)
-    {
-        Assert(bucket->memory_id != -1 && bucket->current_vertex);
-        renderer->free_buckets_mutex.lock();
-        renderer->free_buckets.push(bucket->memory_id);
-        renderer->free_buckets_mutex.unlock();
-        bucket->memory_id = -1;
-        bucket->current_vertex = nullptr;
-        bucket->face_count = 0;
+        renderer->stats.persistent.sub_chunk_used_memory -= bucket->face_count * sizeof(Block_Face);
+        retire_run(&renderer->retire_queue,
+                   &renderer->vertex_allocator,
+                   bucket->memory_offset,
+                   renderer->frame_index.load());
     }
 
-    i32 opengl_renderer_allocate_sub_chunk_instance()
+    // note(harlequin): a mesh always lands in a new run at the lowest free address that fits it, the run it
+    // replaces may still be drawn by a frame in flight so it can not be written in place
+    static Sub_Chunk_Bucket upload_sub_chunk_faces(u32 tag, const Block_Face *faces, i32 face_count)
     {
-        renderer->free_instances_mutex.lock();
-        i32 instance_memory_id = renderer->free_instances.pop();
-        renderer->free_instances_mutex.unlock();
-        return instance_memory_id;
-    }
+        Sub_Chunk_Bucket bucket;
+        initialize_sub_chunk_bucket(&bucket);
 
-    void opengl_renderer_free_sub_chunk_instance(i32 instance_memory_id)
-    {
-        renderer->free_instances_mutex.lock();
-        renderer->free_instances.push(instance_memory_id);
-        renderer->free_instances_mutex.unlock();
-    }
-
-    void opengl_renderer_free_sub_chunk(Chunk* chunk, u32 sub_chunk_index)
-    {
-        Sub_Chunk_Render_Data& render_data = chunk->sub_chunks_render_data[sub_chunk_index];
-
-        if (render_data.instance_memory_id != -1)
+        if (face_count == 0)
         {
-            opengl_renderer_free_sub_chunk_instance(render_data.instance_memory_id);
-            render_data.instance_memory_id = -1;
-            render_data.base_instance = nullptr;
+            return bucket;
         }
 
-        for (i32 i = 0; i < 2; i++)
+        bucket.memory_offset = buddy_allocator_allocate(&renderer->vertex_allocator,
+                                                        face_count,
+                                                        tag,
+                                                        &vertex_allocator_thread_cache);
+        if (bucket.memory_offset == -1)
         {
-            if (render_data.opaque_buckets[i].memory_id != -1)
-            {
-                renderer->stats.persistent.sub_chunk_used_memory -= render_data.opaque_buckets[i].face_count * 4 * sizeof(Block_Face_Vertex);
-                opengl_renderer_free_sub_chunk_bucket(&render_data.opaque_buckets[i]);
-            }
-
-            if (render_data.transparent_buckets[i].memory_id != -1)
-            {
-                renderer->stats.persistent.sub_chunk_used_memory -= render_data.transparent_buckets[i].face_count * 4 * sizeof(Block_Face_Vertex);
-                opengl_renderer_free_sub_chunk_bucket(&render_data.transparent_buckets[i]);
-            }
-
-            constexpr f32 infinity = std::numeric_limits<f32>::max();
-            render_data.aabb[i] = { { infinity, infinity, infinity }, { -infinity, -infinity, -infinity } };
+            return bucket;
         }
 
-        render_data.face_count = 0;
-        render_data.state      = TessellationState_Done;
+        memcpy(renderer->base_face + bucket.memory_offset, faces, face_count * sizeof(Block_Face));
+        bucket.face_count = face_count;
+
+        renderer->stats.persistent.sub_chunk_used_memory += face_count * sizeof(Block_Face);
+        return bucket;
     }
 
-    void opengl_renderer_update_sub_chunk(World *world, Chunk* chunk, u32 sub_chunk_index)
+    static void free_unpublished_sub_chunk_bucket(const Sub_Chunk_Bucket *bucket)
     {
-        Sub_Chunk_Render_Data& render_data = chunk->sub_chunks_render_data[sub_chunk_index];
-
-        i32 bucket_index = render_data.active_bucket_index + 1;
-        if (bucket_index == 2) bucket_index = 0;
-
-        Sub_Chunk_Bucket& opqaue_bucket = render_data.opaque_buckets[bucket_index];
-        Sub_Chunk_Bucket& transparent_bucket = render_data.transparent_buckets[bucket_index];
-
-        if (is_sub_chunk_bucket_allocated(&render_data.opaque_buckets[bucket_index]))
+        if (!is_sub_chunk_bucket_allocated(bucket))
         {
-            opengl_renderer_reset_sub_chunk_bucket(&render_data.opaque_buckets[bucket_index]);
-            renderer->stats.persistent.sub_chunk_used_memory -= render_data.opaque_buckets[bucket_index].face_count * 4 * sizeof(Block_Face_Vertex);
+            return;
         }
 
-        if (is_sub_chunk_bucket_allocated(&render_data.transparent_buckets[bucket_index]))
-        {
-            opengl_renderer_reset_sub_chunk_bucket(&render_data.transparent_buckets[bucket_index]);
-            renderer->stats.persistent.sub_chunk_used_memory -= render_data.transparent_buckets[bucket_index].face_count * 4 * sizeof(Block_Face_Vertex);
-        }
+        renderer->stats.persistent.sub_chunk_used_memory -= bucket->face_count * sizeof(Block_Face);
+        buddy_allocator_free(&renderer->vertex_allocator, bucket->memory_offset, &vertex_allocator_thread_cache);
+    }
 
-        opengl_renderer_upload_sub_chunk_to_gpu(world, chunk, sub_chunk_index);
+    static Sub_Chunk_Mesh_Cache_Entry *find_sub_chunk_mesh_cache_entry(Sub_Chunk_Mesh_Cache *cache, u64 content_hash)
+    {
+        u32 index = (u32)content_hash & (Sub_Chunk_Mesh_Cache::Capacity - 1);
 
-        if (render_data.opaque_buckets[bucket_index].face_count == 0 && is_sub_chunk_bucket_allocated(&render_data.opaque_buckets[bucket_index]))
+        while (cache->entries[index].reference_count)
         {
-            opengl_renderer_free_sub_chunk_bucket(&render_data.opaque_buckets[bucket_index]);
-        }
+            if (cache->entries[index].content_hash == content_hash)
+            {
+                return &cache->entries[index];
+            }
 
-        if (render_data.transparent_buckets[bucket_index].face_count == 0 && is_sub_chunk_bucket_allocated(&render_data.transparent_buckets[bucket_index]))
-        {
-            opengl_renderer_free_sub_chunk_bucket(&render_data.transparent_buckets[bucket_index]);
+            index = (index + 1) & (Sub_Chunk_Mesh_Cache::Capacity - 1);
         }
 
-        render_data.active_bucket_index = bucket_index;
+        return nullptr;
     }
 
-    std::array< Block_Query_Result, 4 > get_vertex_neighbours_from_top(Chunk* chunk, const glm::ivec3& block_coords, u16 face, u16 vertex_id)
+    static Sub_Chunk_Mesh_Cache_Entry *insert_sub_chunk_mesh_cache_entry(Sub_Chunk_Mesh_Cache *cache, u64 content_hash)
     {
-        std::array< Block_Query_Result, 4 > neighbours = {};
-        Block_Query_Result null_query = {};
-        auto top_query = query_neighbour_block_from_top(chunk, block_coords);
-
-        auto left_query  = is_block_query_valid(top_query) ? query_neighbour_block_from_left(top_query.chunk,  top_query.block_coords)  : null_query;
-        auto right_query = is_block_query_valid(top_query) ? query_neighbour_block_from_right(top_query.chunk, top_query.block_coords)  : null_query;
-        auto front_query = is_block_query_valid(top_query) ? query_neighbour_block_from_front(top_query.chunk, top_query.block_coords)  : null_query;
-        auto back_query  = is_block_query_valid(top_query) ? query_neighbour_block_from_back(top_query.chunk,  top_query.block_coords)  : null_query;
-
-        auto front_right_query = is_block_query_valid(front_query) ? query_neighbour_block_from_right(front_query.chunk, front_query.block_coords) : null_query;
-        auto front_left_query  = is_block_query_valid(front_query) ? query_neighbour_block_from_left(front_query.chunk, front_query.block_coords)  : null_query;
-        auto back_right_query  = is_block_query_valid(back_query)  ? query_neighbour_block_from_right(back_query.chunk, back_query.block_coords)   : null_query;
-        auto back_left_query   = is_block_query_valid(back_query)  ? query_neighbour_block_from_left(back_query.chunk, back_query.block_coords)    : null_query;
+        Assert(cache->mesh_count < Sub_Chunk_Mesh_Cache::Capacity);
 
-        neighbours[0] = is_block_query_valid(top_query) ? top_query : null_query;
+        u32 index = (u32)content_hash & (Sub_Chunk_Mesh_Cache::Capacity - 1);
 
-        switch (vertex_id)
+        while (cache->entries[index].reference_count)
         {
-            case 0:
-            case 1:
-            {
-                neighbours[1] = is_block_query_valid(back_query) ? back_query : null_query;
-            } break;
-
-            case 2:
-            case 3:
-            {
-                neighbours[1] = is_block_query_valid(front_query) ? front_query : null_query;
-            } break;
+            index = (index + 1) & (Sub_Chunk_Mesh_Cache::Capacity - 1);
         }
 
-        switch (vertex_id)
-        {
-            case 0:
-            case 3:
-            {
-                neighbours[2] = is_block_query_valid(right_query) ? right_query : null_query;
-            } break;
+        Sub_Chunk_Mesh_Cache_Entry *entry = &cache->entries[index];
+        entry->content_hash = content_hash;
+        return entry;
+    }
 
-            case 1:
-            case 2:
-            {
-                neighbours[2] = is_block_query_valid(left_query) ? left_query : null_query;
-            } break;
-        }
+    static void remove_sub_chunk_mesh_cache_entry(Sub_Chunk_Mesh_Cache *cache, Sub_Chunk_Mesh_Cache_Entry *entry)
+    {
+        constexpr u32 IndexMask = Sub_Chunk_Mesh_Cache::Capacity - 1;
 
-        switch (vertex_id)
+        u32 index      = (u32)(entry - cache->entries);
+        u32 next_index = index;
+
+        while (true)
         {
-            case 0:
-            {
-                neighbours[3] = is_block_query_valid(back_right_query) ? back_right_query : null_query;
-            } break;
+            next_index = (next_index + 1) & IndexMask;
+            Sub_Chunk_Mesh_Cache_Entry *next_entry = &cache->entries[next_index];
 
-            case 1:
+            if (!next_entry->reference_count)
             {
-                neighbours[3] = is_block_query_valid(back_left_query) ? back_left_query : null_query;
-            } break;
+                break;
+            }
 
-            case 2:
+            // note(harlequin): an entry whose home slot lies after the hole would no longer be found from its home
+            // slot if it moved into the hole
+            u32 home_index = (u32)next_entry->content_hash & IndexMask;
+            if (((next_index - home_index) & IndexMask) < ((next_index - index) & IndexMask))
             {
-                neighbours[3] = is_block_query_valid(front_left_query) ? front_left_query : null_query;
-            } break;
+                continue;
+            }
 
-            case 3:
-            {
-                neighbours[3] = is_block_query_valid(front_right_query) ? front_right_query : null_query;
-            } break;
+            cache->entries[index] = *next_entry;
+            index = next_index;
         }
 
-        return neighbours;
+        cache->entries[index].reference_count = 0;
     }
 
-    std::array< Block_Query_Result, 4 > get_vertex_neighbours_from_bottom(Chunk* chunk, const glm::ivec3& block_coords, u16 face, u16 vertex_id)
+    // note(harlequin): the faces are hashed again with a hash that shares nothing with the content hash, the mesh is
+    // built even when it is found in the cache so this only costs a pass over its faces, the cached faces live in the
+    // gpu buffer and are never read back. the mixed faces are summed so the hash does not depend on their order, a
+    // patched mesh holds the same faces as a fresh one in a different order
+    static u64 hash_sub_chunk_mesh_faces(const Sub_Chunk_Mesh *mesh)
     {
-        std::array< Block_Query_Result, 4 > neighbours = {};
-        Block_Query_Result null_query = {};
-        auto bottom_query = query_neighbour_block_from_bottom(chunk, block_coords);
-
-        auto left_query  = is_block_query_valid(bottom_query) ? query_neighbour_block_from_left(bottom_query.chunk, bottom_query.block_coords)  : null_query;
-        auto right_query = is_block_query_valid(bottom_query) ? query_neighbour_block_from_right(bottom_query.chunk, bottom_query.block_coords) : null_query;
-        auto front_query = is_block_query_valid(bottom_query) ? query_neighbour_block_from_front(bottom_query.chunk, bottom_query.block_coords) : null_query;
-        auto back_query  = is_block_query_valid(bottom_query) ? query_neighbour_block_from_back(bottom_query.chunk, bottom_query.block_coords)  : null_query;
+        static_assert(sizeof(Block_Face) == sizeof(u64), "faces are hashed a word at a time");
 
-        auto front_right_query = is_block_query_valid(front_query) ? query_neighbour_block_from_right(front_query.chunk, front_query.block_coords) : null_query;
-        auto front_left_query  = is_block_query_valid(front_query) ? query_neighbour_block_from_left(front_query.chunk, front_query.block_coords)  : null_query;
-        auto back_right_query  = is_block_query_valid(back_query)  ? query_neighbour_block_from_right(back_query.chunk, back_query.block_coords)   : null_query;
-        auto back_left_query   = is_block_query_valid(back_query)  ? query_neighbour_block_from_left(back_query.chunk, back_query.block_coords)    : null_query;
-
-        neighbours[0] = is_block_query_valid(bottom_query) ? bottom_query : null_query;
-
-        switch (vertex_id)
-        {
-            case 4:
-            case 5:
-            {
-                neighbours[1] = is_block_query_valid(back_query) ? back_query : null_query;
-            } break;
-
-            case 6:
-            case 7:
-            {
-                neighbours[1] = is_block_query_valid(front_query) ? front_query : null_query;
-            } break;
-        }
-
-        switch (vertex_id)
+        auto hash_faces = [](const Block_Face *faces, i32 face_count, u64 seed) -> u64
         {
-            case 4:
-            case 7:
-            {
-                neighbours[2] = is_block_query_valid(right_query) ? right_query : null_query;
-            } break;
-
-            case 5:
-            case 6:
-            {
-                neighbours[2] = is_block_query_valid(left_query) ? left_query : null_query;
-            } break;
-        }
+            u64 sum = 0;
 
-        switch (vertex_id)
-        {
-            case 4:
+            for (i32 i = 0; i < face_count; i++)
             {
-                neighbours[3] = is_block_query_valid(back_right_query) ? back_right_query : null_query;
-            } break;
+                u64 word;
+                memcpy(&word, &faces[i], sizeof(u64));
 
-            case 5:
-            {
-                neighbours[3] = is_block_query_valid(back_left_query) ? back_left_query : null_query;
-            } break;
+                word ^= seed;
+                word ^= word >> 33;
+                word *= 0xFF51AFD7ED558CCDull;
+                word ^= word >> 33;
+                word *= 0xC4CEB9FE1A85EC53ull;
+                word ^= word >> 33;
 
-            case 6:
-            {
-                neighbours[3] = is_block_query_valid(front_left_query) ? front_left_query : null_query;
-            } break;
+                sum += word;
+            }
 
-            case 7:
-            {
-                neighbours[3] = is_block_query_valid(front_right_query) ? front_right_query : null_query;
-            } break;
-        }
+            return sum;
+        };
 
-        return neighbours;
+        u64 hash = 0xCBF29CE484222325ull ^ (((u64)(u32)mesh->opaque_face_count << 32) | (u64)(u32)mesh->transparent_face_count);
+        hash ^= hash_faces(get_opaque_faces(mesh), mesh->opaque_face_count, 0x9E3779B97F4A7C15ull);
+        hash  = ((hash << 27) | (hash >> 37)) * 0x94D049BB133111EBull;
+        hash ^= hash_faces(get_transparent_faces(mesh), mesh->transparent_face_count, 0x52DCE72952DCE729ull);
+        hash  = ((hash << 27) | (hash >> 37)) * 0x94D049BB133111EBull;
+        return hash;
     }
 
-    std::array< Block_Query_Result, 4 > get_vertex_neighbours_from_right(Chunk* chunk, const glm::ivec3& block_coords, u16 face, u16 vertex_id)
+    // note(harlequin): a mesh is only shared when both the content hash it was found by and the hash of its faces
+    // match, a content hash collision is counted and the colliding mesh is drawn from its own buckets
+    static bool does_sub_chunk_mesh_cache_entry_match(const Sub_Chunk_Mesh_Cache_Entry *entry,
+                                                      const Sub_Chunk_Mesh             *mesh,
+                                                      u64                               face_hash)
     {
-        std::array< Block_Query_Result, 4 > neighbours = {};
-        Block_Query_Result null_query = {};
-        auto right_query = query_neighbour_block_from_right(chunk, block_coords);
-
-        auto top_query    = is_block_query_valid(right_query) ? query_neighbour_block_from_top(right_query.chunk, right_query.block_coords)  : null_query;
-        auto bottom_query = is_block_query_valid(right_query) ? query_neighbour_block_from_bottom(right_query.chunk, right_query.block_coords) : null_query;
-        auto front_query  = is_block_query_valid(right_query) ? query_neighbour_block_from_front(right_query.chunk, right_query.block_coords) : null_query;
-        auto back_query   = is_block_query_valid(right_query) ? query_neighbour_block_from_back(right_query.chunk, right_query.block_coords) : null_query;
-
-        auto front_top_query    = is_block_query_valid(front_query) ? query_neighbour_block_from_top(front_query.chunk, front_query.block_coords) : null_query;
-        auto front_bottom_query = is_block_query_valid(front_query) ? query_neighbour_block_from_bottom(front_query.chunk, front_query.block_coords)  : null_query;
-        auto back_top_query     = is_block_query_valid(back_query)  ? query_neighbour_block_from_top(back_query.chunk, back_query.block_coords)   : null_query;
-        auto back_bottom_query  = is_block_query_valid(back_query)  ? query_neighbour_block_from_bottom(back_query.chunk, back_query.block_coords) : null_query;
-
-        neighbours[0] = is_block_query_valid(right_query) ? right_query : null_query;
+        return entry->opaque_bucket.face_count      == mesh->opaque_face_count      &&
+               entry->transparent_bucket.face_count == mesh->transparent_face_count &&
+               entry->face_hash                     == face_hash;
+    }
 
-        switch (vertex_id)
-        {
-            case 0:
-            case 4:
-            {
-                neighbours[1] = is_block_query_valid(back_query) ? back_query : null_query;
-            } break;
+    static bool is_sub_chunk_mesh_cache_entry_drawn_from(const Sub_Chunk_Mesh_Cache_Entry *entry,
+                                                         const Sub_Chunk_Bucket& opaque_bucket,
+                                                         const Sub_Chunk_Bucket& transparent_bucket)
+    {
+        return entry->opaque_bucket.memory_offset      == opaque_bucket.memory_offset &&
+               entry->transparent_bucket.memory_offset == transparent_bucket.memory_offset;
+    }
 
-            case 3:
-            case 7:
-            {
-                neighbours[1] = is_block_query_valid(front_query) ? front_query : null_query;
-            } break;
-        }
+    static void share_sub_chunk_mesh_cache_entry(Sub_Chunk_Mesh_Cache_Entry *entry,
+                                                 Sub_Chunk_Bucket *opaque_bucket,
+                                                 Sub_Chunk_Bucket *transparent_bucket)
+    {
+        Sub_Chunk_Mesh_Cache *cache = &renderer->mesh_cache;
 
-        switch (vertex_id)
+        // note(harlequin): shared buckets can not be moved by remeshing one of the sub chunks drawing them, their tag is
+        // cleared so defragmentation leaves them where they are
+        if (entry->reference_count == 1)
         {
-            case 0:
-            case 3:
+            if (is_sub_chunk_bucket_allocated(&entry->opaque_bucket))
             {
-                neighbours[2] = is_block_query_valid(top_query) ? top_query : null_query;
-            } break;
+                buddy_allocator_set_run_tag(&renderer->vertex_allocator, entry->opaque_bucket.memory_offset, Buddy_Allocator::NullTag);
+            }
 
-            case 4:
-            case 7:
+            if (is_sub_chunk_bucket_allocated(&entry->transparent_bucket))
             {
-                neighbours[2] = is_block_query_valid(bottom_query) ? bottom_query : null_query;
-            } break;
+                buddy_allocator_set_run_tag(&renderer->vertex_allocator, entry->transparent_bucket.memory_offset, Buddy_Allocator::NullTag);
+            }
         }
 
-        switch (vertex_id)
-        {
-            case 0:
-            {
-                neighbours[3] = is_block_query_valid(back_top_query) ? back_top_query : null_query;
-            } break;
-
-            case 3:
-            {
-                neighbours[3] = is_block_query_valid(front_top_query) ? front_top_query : null_query;
-            } break;
-
-            case 4:
-            {
-                neighbours[3] = is_block_query_valid(back_bottom_query) ? back_bottom_query : null_query;
-            } break;
-
-            case 7:
-            {
-                neighbours[3] = is_block_query_valid(front_bottom_query) ? front_bottom_query : null_query;
-            } break;
-        }
+        entry->reference_count++;
+        cache->sub_chunk_count++;
+        cache->shared_face_count += entry->opaque_bucket.face_count + entry->transparent_bucket.face_count;
+        cache->hit_count++;
 
-        return neighbours;
+        *opaque_bucket      = entry->opaque_bucket;
+        *transparent_bucket = entry->transparent_bucket;
     }
 
-    std::array< Block_Query_Result, 4 > get_vertex_neighbours_from_left(Chunk* chunk, const glm::ivec3& block_coords, u16 face, u16 vertex_id)
+    // note(harlequin): hands out the buckets of the cached mesh with the content of the mesh or uploads the mesh into
+    // new buckets and caches them, the sub chunk holds a reference to the buckets until it lets go of them in
+    // release_sub_chunk_mesh
+    static void acquire_sub_chunk_mesh(World                *world,
+                                       Chunk                *chunk,
+                                       u32                   sub_chunk_index,
+                                       const Sub_Chunk_Mesh *mesh,
+                                       Sub_Chunk_Bucket     *opaque_bucket,
+                                       Sub_Chunk_Bucket     *transparent_bucket)
     {
-        std::array< Block_Query_Result, 4 > neighbours = {};
-        Block_Query_Result null_query = {};
-        auto left_query = query_neighbour_block_from_left(chunk, block_coords);
-
-        auto top_query    = is_block_query_valid(left_query) ? query_neighbour_block_from_top(left_query.chunk, left_query.block_coords)  : null_query;
-        auto bottom_query = is_block_query_valid(left_query) ? query_neighbour_block_from_bottom(left_query.chunk, left_query.block_coords) : null_query;
-        auto front_query  = is_block_query_valid(left_query) ? query_neighbour_block_from_front(left_query.chunk, left_query.block_coords) : null_query;
-        auto back_query   = is_block_query_valid(left_query) ? query_neighbour_block_from_back(left_query.chunk, left_query.block_coords) : null_query;
-
-        auto front_top_query    = is_block_query_valid(front_query) ? query_neighbour_block_from_top(front_query.chunk, front_query.block_coords) : null_query;
-        auto front_bottom_query = is_block_query_valid(front_query) ? query_neighbour_block_from_bottom(front_query.chunk, front_query.block_coords)  : null_query;
-        auto back_top_query     = is_block_query_valid(back_query)  ? query_neighbour_block_from_top(back_query.chunk, back_query.block_coords)   : null_query;
-        auto back_bottom_query  = is_block_query_valid(back_query)  ? query_neighbour_block_from_bottom(back_query.chunk, back_query.block_coords) : null_query;
+        initialize_sub_chunk_bucket(opaque_bucket);
+        initialize_sub_chunk_bucket(transparent_bucket);
 
-        neighbours[0] = is_block_query_valid(left_query) ? left_query : null_query;
-
-        switch (vertex_id)
+        if (mesh->opaque_face_count == 0 && mesh->transparent_face_count == 0)
         {
-            case 1:
-            case 5:
-            {
-                neighbours[1] = is_block_query_valid(back_query) ? back_query : null_query;
-            } break;
-
-            case 2:
-            case 6:
-            {
-                neighbours[1] = is_block_query_valid(front_query) ? front_query : null_query;
-            } break;
+            return;
         }
 
-        switch (vertex_id)
-        {
-            case 1:
-            case 2:
-            {
-                neighbours[2] = is_block_query_valid(top_query) ? top_query : null_query;
-            } break;
+        Sub_Chunk_Mesh_Cache *cache = &renderer->mesh_cache;
+        const Sub_Chunk_Render_Data& render_data = chunk->sub_chunks_render_data[sub_chunk_index];
 
-            case 5:
-            case 6:
-            {
-                neighbours[2] = is_block_query_valid(bottom_query) ? bottom_query : null_query;
-            } break;
-        }
+        u64 face_hash = hash_sub_chunk_mesh_faces(mesh);
 
-        switch (vertex_id)
         {
-            case 1:
-            {
-                neighbours[3] = is_block_query_valid(back_top_query) ? back_top_query : null_query;
-            } break;
+            std::unique_lock lock(cache->mutex);
 
-            case 2:
-            {
-                neighbours[3] = is_block_query_valid(front_top_query) ? front_top_query : null_query;
-            } break;
+            Sub_Chunk_Mesh_Cache_Entry *entry = find_sub_chunk_mesh_cache_entry(cache, mesh->content_hash);
 
-            case 5:
+            if (entry && does_sub_chunk_mesh_cache_entry_match(entry, mesh, face_hash))
             {
-                neighbours[3] = is_block_query_valid(back_bottom_query) ? back_bottom_query : null_query;
-            } break;
+                bool is_drawn_by_sub_chunk_alone = entry->reference_count == 1 &&
+                                                   render_data.content_hash == mesh->content_hash &&
+                                                   is_sub_chunk_mesh_cache_entry_drawn_from(entry,
+                                                                                            render_data.opaque_bucket,
+                                                                                            render_data.transparent_bucket);
 
-            case 6:
-            {
-                neighbours[3] = is_block_query_valid(front_bottom_query) ? front_bottom_query : null_query;
-            } break;
+                if (!is_drawn_by_sub_chunk_alone)
+                {
+                    share_sub_chunk_mesh_cache_entry(entry, opaque_bucket, transparent_bucket);
+                    return;
+                }
+
+                // note(harlequin): a sub chunk remeshed without a change is being moved by defragmentation, the mesh
+                // leaves the cache with the sub chunk as its only owner and is uploaded again, the old buckets are then
+                // retired like any buckets that are not cached
+                cache->mesh_count--;
+                cache->sub_chunk_count--;
+                cache->face_count -= entry->opaque_bucket.face_count + entry->transparent_bucket.face_count;
+                remove_sub_chunk_mesh_cache_entry(cache, entry);
+            }
         }
 
-        return neighbours;
-    }
+        Sub_Chunk_Bucket uploaded_opaque_bucket = upload_sub_chunk_faces(get_sub_chunk_bucket_tag(world, chunk, sub_chunk_index, false),
+                                                                         get_opaque_faces(mesh),
+                                                                         mesh->opaque_face_count);
 
-    std::array< Block_Query_Result, 4 > get_vertex_neighbours_from_back(Chunk* chunk, const glm::ivec3& block_coords, u16 face, u16 vertex_id)
-    {
-        std::array< Block_Query_Result, 4 > neighbours = {};
-        Block_Query_Result null_query = {};
-        auto back_query = query_neighbour_block_from_back(chunk, block_coords);
+        Sub_Chunk_Bucket uploaded_transparent_bucket = upload_sub_chunk_faces(get_sub_chunk_bucket_tag(world, chunk, sub_chunk_index, true),
+                                                                              get_transparent_faces(mesh),
+                                                                              mesh->transparent_face_count);
 
-        auto top_query    = is_block_query_valid(back_query) ? query_neighbour_block_from_top(back_query.chunk, back_query.block_coords)  : null_query;
-        auto bottom_query = is_block_query_valid(back_query) ? query_neighbour_block_from_bottom(back_query.chunk, back_query.block_coords) : null_query;
-        auto left_query   = is_block_query_valid(back_query) ? query_neighbour_block_from_left(back_query.chunk, back_query.block_coords) : null_query;
-        auto right_query  = is_block_query_valid(back_query) ? query_neighbour_block_from_right(back_query.chunk, back_query.block_coords) : null_query;
+        *opaque_bucket      = uploaded_opaque_bucket;
+        *transparent_bucket = uploaded_transparent_bucket;
 
-        auto left_top_query     = is_block_query_valid(left_query) ? query_neighbour_block_from_top(left_query.chunk, left_query.block_coords) : null_query;
-        auto left_bottom_query  = is_block_query_valid(left_query) ? query_neighbour_block_from_bottom(left_query.chunk, left_query.block_coords)  : null_query;
-        auto right_top_query    = is_block_query_valid(right_query) ? query_neighbour_block_from_top(right_query.chunk, right_query.block_coords)   : null_query;
-        auto right_bottom_query = is_block_query_valid(right_query) ? query_neighbour_block_from_bottom(right_query.chunk, right_query.block_coords) : null_query;
+        std::unique_lock lock(cache->mutex);
 
-        neighbours[0] = is_block_query_valid(back_query) ? back_query : null_query;
+        Sub_Chunk_Mesh_Cache_Entry *entry = find_sub_chunk_mesh_cache_entry(cache, mesh->content_hash);
 
-        switch (vertex_id)
+        if (entry)
         {
-            case 0:
-            case 4:
+            if (does_sub_chunk_mesh_cache_entry_match(entry, mesh, face_hash))
             {
-                neighbours[1] = is_block_query_valid(right_query) ? right_query : null_query;
-            } break;
+                // note(harlequin): another worker cached the same content while the mesh was being uploaded, nothing
+                // has drawn the new buckets yet so they are freed right away
+                share_sub_chunk_mesh_cache_entry(entry, opaque_bucket, transparent_bucket);
+                lock.unlock();
+
+                free_unpublished_sub_chunk_bucket(&uploaded_opaque_bucket);
+                free_unpublished_sub_chunk_bucket(&uploaded_transparent_bucket);
+                return;
+            }
 
-            case 1:
-            case 5:
-            {
-                neighbours[1] = is_block_query_valid(left_query) ? left_query : null_query;
-            } break;
+            // note(harlequin): a mesh that collides with a cached one is drawn from its own buckets without being cached
+            cache->collision_count++;
+            return;
         }
 
-        switch (vertex_id)
+        // note(harlequin): a mesh that did not fit in the face buffer is not cached so it is uploaded again next time
+        if (uploaded_opaque_bucket.face_count      != mesh->opaque_face_count ||
+            uploaded_transparent_bucket.face_count != mesh->transparent_face_count)
         {
-            case 0:
-            case 1:
-            {
-                neighbours[2] = is_block_query_valid(top_query) ? top_query : null_query;
-            } break;
-
-            case 4:
-            case 5:
-            {
-                neighbours[2] = is_block_query_valid(bottom_query) ? bottom_query : null_query;
-            } break;
+            return;
         }
 
-        switch (vertex_id)
-        {
-            case 0:
-            {
-                neighbours[3] = is_block_query_valid(right_top_query) ? right_top_query : null_query;
-            } break;
-
-            case 1:
-            {
-                neighbours[3] = is_block_query_valid(left_top_query) ? left_top_query : null_query;
-            } break;
+        entry = insert_sub_chunk_mesh_cache_entry(cache, mesh->content_hash);
+        entry->face_hash          = face_hash;
+        entry->opaque_bucket      = uploaded_opaque_bucket;
+        entry->transparent_bucket = uploaded_transparent_bucket;
+        entry->reference_count    = 1;
 
-            case 4:
-            {
-                neighbours[3] = is_block_query_valid(right_bottom_query) ? right_bottom_query : null_query;
-            } break;
-
-            case 5:
-            {
-                neighbours[3] = is_block_query_valid(left_bottom_query) ? left_bottom_query : null_query;
-            } break;
-        }
-
-        return neighbours;
+        cache->mesh_count++;
+        cache->sub_chunk_count++;
+        cache->face_count += mesh->opaque_face_count + mesh->transparent_face_count;
+        cache->miss_count++;
     }
 
-    std::array< Block_Query_Result, 4 > get_vertex_neighbours_from_front(Chunk* chunk, const glm::ivec3& block_coords, u16 face, u16 vertex_id)
+    // note(harlequin): lets go of the buckets a sub chunk no longer draws, buckets the cache does not have under the
+    // content hash were only ever drawn by this sub chunk and are retired right away
+    static void release_sub_chunk_mesh(u64 content_hash,
+                                       const Sub_Chunk_Bucket& opaque_bucket,
+                                       const Sub_Chunk_Bucket& transparent_bucket)
     {
-        std::array< Block_Query_Result, 4 > neighbours = {};
-        Block_Query_Result null_query = {};
-        auto front_query = query_neighbour_block_from_front(chunk, block_coords);
-
-        auto top_query = is_block_query_valid(front_query) ? query_neighbour_block_from_top(front_query.chunk, front_query.block_coords)  : null_query;
-        auto bottom_query = is_block_query_valid(front_query) ? query_neighbour_block_from_bottom(front_query.chunk, front_query.block_coords) : null_query;
-        auto left_query = is_block_query_valid(front_query) ? query_neighbour_block_from_left(front_query.chunk, front_query.block_coords) : null_query;
-        auto right_query = is_block_query_valid(front_query) ? query_neighbour_block_from_right(front_query.chunk, front_query.block_coords) : null_query;
-
-        auto left_top_query = is_block_query_valid(left_query) ? query_neighbour_block_from_top(left_query.chunk, left_query.block_coords) : null_query;
-        auto left_bottom_query = is_block_query_valid(left_query) ? query_neighbour_block_from_bottom(left_query.chunk, left_query.block_coords)  : null_query;
-        auto right_top_query = is_block_query_valid(right_query)  ? query_neighbour_block_from_top(right_query.chunk, right_query.block_coords)   : null_query;
-        auto right_bottom_query = is_block_query_valid(right_query) ? query_neighbour_block_from_bottom(right_query.chunk, right_query.block_coords) : null_query;
-
-        neighbours[0] = is_block_query_valid(front_query) ? front_query : null_query;
-
-        switch (vertex_id)
+        if (!is_sub_chunk_bucket_allocated(&opaque_bucket) &&
+            !is_sub_chunk_bucket_allocated(&transparent_bucket))
         {
-            case 3:
-            case 7:
-            {
-                neighbours[1] = is_block_query_valid(right_query) ? right_query : null_query;
-            } break;
-
-            case 2:
-            case 6:
-            {
-                neighbours[1] = is_block_query_valid(left_query) ? left_query : null_query;
-            } break;
+            return;
         }
 
-        switch (vertex_id)
+        Sub_Chunk_Mesh_Cache *cache = &renderer->mesh_cache;
+
         {
-            case 3:
-            case 2:
-            {
-                neighbours[2] = is_block_query_valid(top_query) ? top_query : null_query;
-            } break;
+            std::unique_lock lock(cache->mutex);
 
-            case 7:
-            case 6:
-            {
-                neighbours[2] = is_block_query_valid(bottom_query) ? bottom_query : null_query;
-            } break;
-        }
+            Sub_Chunk_Mesh_Cache_Entry *entry = find_sub_chunk_mesh_cache_entry(cache, content_hash);
 
-        switch (vertex_id)
-        {
-            case 3:
+            if (entry && is_sub_chunk_mesh_cache_entry_drawn_from(entry, opaque_bucket, transparent_bucket))
             {
-                neighbours[3] = is_block_query_valid(right_top_query) ? right_top_query : null_query;
-            } break;
+                u64 face_count = entry->opaque_bucket.face_count + entry->transparent_bucket.face_count;
 
-            case 2:
-            {
-                neighbours[3] = is_block_query_valid(left_top_query) ? left_top_query : null_query;
-            } break;
+                cache->sub_chunk_count--;
+                entry->reference_count--;
 
-            case 7:
-            {
-                neighbours[3] = is_block_query_valid(right_bottom_query) ? right_bottom_query : null_query;
-            } break;
+                if (entry->reference_count)
+                {
+                    cache->shared_face_count -= face_count;
+                    return;
+                }
 
-            case 6:
-            {
-                neighbours[3] = is_block_query_valid(left_bottom_query) ? left_bottom_query : null_query;
-            } break;
+                cache->mesh_count--;
+                cache->face_count -= face_count;
+                remove_sub_chunk_mesh_cache_entry(cache, entry);
+            }
         }
 
-        return neighbours;
+        retire_sub_chunk_bucket(&opaque_bucket);
+        retire_sub_chunk_bucket(&transparent_bucket);
     }
 
-    std::array< Block_Query_Result, 4 > get_vertex_neighbours(Chunk* chunk, const glm::ivec3& block_coords, u16 face, u16 vertex_id)
+    // note(harlequin): the render thread reads the buckets of a sub chunk while a worker may be swapping them,
+    // the copy is retried until it did not overlap a swap
+    static void load_sub_chunk_buckets(const Sub_Chunk_Render_Data *render_data,
+                                       Sub_Chunk_Bucket *opaque_bucket,
+                                       Sub_Chunk_Bucket *transparent_bucket,
+                                       AABB *aabb)
     {
-        /*
-          1----------2
-          |\         |\
-          | 0--------|-3
-          | |        | |
-          5-|--------6 |
-           \|         \|
-            4----------7
-        */
-
-        std::array< Block_Query_Result, 4 > neighbours = {};
-
-        switch (face)
+        while (true)
         {
-            case BlockFace_Top:
-            {
-                return get_vertex_neighbours_from_top(chunk, block_coords, face, vertex_id);
-            } break;
-
-            case BlockFace_Bottom:
-            {
-                return get_vertex_neighbours_from_bottom(chunk, block_coords, face, vertex_id);
-            } break;
+            u32 version = render_data->bucket_version.load(std::memory_order_acquire);
 
-            case BlockFace_Right:
+            if (version & 1)
             {
-                return get_vertex_neighbours_from_right(chunk, block_coords, face, vertex_id);
-            } break;
+                continue;
+            }
 
-            case BlockFace_Left:
-            {
-                return get_vertex_neighbours_from_left(chunk, block_coords, face, vertex_id);
-            } break;
+            *opaque_bucket      = render_data->opaque_bucket;
+            *transparent_bucket = render_data->transparent_bucket;
+            *aabb               = render_data->aabb;
 
-            case BlockFace_Back:
-            {
-                return get_vertex_neighbours_from_back(chunk, block_coords, face, vertex_id);
-            } break;
+            std::atomic_thread_fence(std::memory_order_acquire);
 
-            case BlockFace_Front:
+            if (render_data->bucket_version.load(std::memory_order_relaxed) == version)
             {
-                return get_vertex_neighbours_from_front(chunk, block_coords, face, vertex_id);
-            } break;
+                return;
+            }
         }
-
-        return neighbours;
     }
 
-    static bool submit_block_face_to_sub_chunk_render_data(World *world,
-                                                           Chunk *chunk,
-                                                           i32 sub_chunk_index,
-                                                           Block *block,
-                                                           Block *block_facing_normal,
-                                                           const glm::ivec3& block_coords,
-                                                           u16 texture_id,
-                                                           u16 face,
-                                                           u32 p0,
-                                                           u32 p1,
-                                                           u32 p2,
-                                                           u32 p3)
+    static void store_sub_chunk_buckets(Sub_Chunk_Render_Data *render_data,
+                                        u64 content_hash,
+                                        const Sub_Chunk_Bucket& opaque_bucket,
+                                        const Sub_Chunk_Bucket& transparent_bucket,
+                                        const AABB& aabb)
     {
-        const Block_Info* block_info               = get_block_info(world, block);
-        const Block_Info* block_facing_normal_info = get_block_info(world, block_facing_normal);
-
-        bool is_solid       = is_block_solid(block_info);
-        bool is_transparent = is_block_transparent(block_info);
-
-        if ((is_solid && is_block_transparent(block_facing_normal_info)) ||
-            (is_transparent && block_facing_normal->id == BlockId_Air))
-        {
-            const u32& block_flags = block_info->flags;
-
-            Sub_Chunk_Render_Data& sub_chunk_render_data = chunk->sub_chunks_render_data[sub_chunk_index];
-            i32 bucket_index = sub_chunk_render_data.active_bucket_index + 1;
-            if (bucket_index == 2) bucket_index = 0;
-            Sub_Chunk_Bucket *bucket = is_transparent ? &sub_chunk_render_data.transparent_buckets[bucket_index] : &sub_chunk_render_data.opaque_buckets[bucket_index];
+        u64              retired_content_hash       = render_data->content_hash;
+        Sub_Chunk_Bucket retired_opaque_bucket      = render_data->opaque_bucket;
+        Sub_Chunk_Bucket retired_transparent_bucket = render_data->transparent_bucket;
 
-            if (!is_sub_chunk_bucket_allocated(bucket))
-            {
-                opengl_renderer_allocate_sub_chunk_bucket(bucket);
-            }
-
-            Assert(bucket->face_count + 1 <= World::SubChunkBucketFaceCount);
+        render_data->bucket_version.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
 
-            u32 data00 = compress_vertex0(block_coords, p0, face, BlockFaceCorner_BottomRight, block_flags);
-            u32 data01 = compress_vertex0(block_coords, p1, face, BlockFaceCorner_BottomLeft,  block_flags);
-            u32 data02 = compress_vertex0(block_coords, p2, face, BlockFaceCorner_TopLeft,     block_flags);
-            u32 data03 = compress_vertex0(block_coords, p3, face, BlockFaceCorner_TopRight,    block_flags);
+        render_data->opaque_bucket      = opaque_bucket;
+        render_data->transparent_bucket = transparent_bucket;
+        render_data->aabb               = aabb;
 
-            glm::ivec4 sky_light_levels    = {};
-            glm::ivec4 light_source_levels = {};
-            glm::ivec4 ambient_occlusions  = {};
-            glm::ivec4 vertices = { p0, p1, p2, p3 };
+        render_data->bucket_version.fetch_add(1, std::memory_order_release);
+        render_data->content_hash = content_hash;
 
-            for (i32 i = 0; i < 4; i++)
-            {
-                u32 count = 0;
+        // note(harlequin): the frame index is read after the swap, a frame recorded after that never sees the old runs
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        release_sub_chunk_mesh(retired_content_hash, retired_opaque_bucket, retired_transparent_bucket);
+    }
 
-                auto neighbours = get_vertex_neighbours(chunk, block_coords, face, vertices[i]);
+    i32 opengl_renderer_allocate_sub_chunk_instance()
+    {
+        renderer->free_instances_mutex.lock();
+        i32 instance_memory_id = renderer->free_instances.pop();
+        renderer->free_instances_mutex.unlock();
+        return instance_memory_id;
+    }
 
-                for (i32 j = 0; j < (i32)neighbours.size() - 1; ++j)
-                {
-                    auto& neighbour = neighbours[j];
-                    Block *neighbour_block = neighbour.block;
-                    if (neighbour_block)
-                    {
-                        const Block_Info* neighbour_info = get_block_info(world, neighbour_block);
-                        Block_Light_Info *neighbour_light_info = get_block_light_info(neighbour.chunk, neighbour.block_coords);
-                        if (is_block_transparent(neighbour_info))
-                        {
-                            sky_light_levels[i]    += neighbour_light_info->sky_light_level;
-                            light_source_levels[i] += neighbour_light_info->light_source_level;
-                            ++count;
-                        }
-                    }
-                }
+    void opengl_renderer_free_sub_chunk_instance(i32 instance_memory_id)
+    {
+        renderer->free_instances_mutex.lock();
+        renderer->free_instances.push(instance_memory_id);
+        renderer->free_instances_mutex.unlock();
+    }
 
-                Block *side0  = neighbours[1].block;
-                Block *side1  = neighbours[2].block;
-                Block *corner = neighbours[3].block;
+    void opengl_renderer_free_sub_chunk(Chunk* chunk, u32 sub_chunk_index)
+    {
+        Sub_Chunk_Render_Data& render_data = chunk->sub_chunks_render_data[sub_chunk_index];
 
-                bool has_side0  = side0  && !(is_block_transparent(get_block_info(world, side0)));
-                bool has_side1  = side1  && !(is_block_transparent(get_block_info(world, side1)));
-                bool has_corner = corner && !(is_block_transparent(get_block_info(world, corner)));
+        if (render_data.instance_memory_id != -1)
+        {
+            opengl_renderer_free_sub_chunk_instance(render_data.instance_memory_id);
+            render_data.instance_memory_id = -1;
+            render_data.base_instance = nullptr;
+        }
 
-                if (corner && is_block_transparent(get_block_info(world, corner)) && (!has_side0 || !has_side1))
-                {
-                    Block_Light_Info *corner_light_info = get_block_light_info(neighbours[3].chunk, neighbours[3].block_coords);
-                    sky_light_levels[i]    += corner_light_info->sky_light_level;
-                    light_source_levels[i] += corner_light_info->light_source_level;
-                    ++count;
-                }
+        Sub_Chunk_Bucket empty_bucket;
+        initialize_sub_chunk_bucket(&empty_bucket);
 
-                if (count)
-                {
-                    sky_light_levels[i]    /= count;
-                    light_source_levels[i] /= count;
-                }
+        constexpr f32 infinity = std::numeric_limits<f32>::max();
+        AABB empty_aabb = { { infinity, infinity, infinity }, { -infinity, -infinity, -infinity } };
 
-                if (!has_side0 || !has_side1)
-                {
-                    i32 side0_ao  = has_side0  && !is_light_source(get_block_info(world, side0));
-                    i32 side1_ao  = has_side1  && !is_light_source(get_block_info(world, side1));
-                    i32 corner_ao = has_corner && !is_light_source(get_block_info(world, corner));
+        store_sub_chunk_buckets(&render_data, 0, empty_bucket, empty_bucket, empty_aabb);
 
-                    ambient_occlusions[i] = 3 - (side0_ao + side1_ao + corner_ao);
-                }
-            }
+        render_data.face_count = 0;
+        render_data.face_connectivity.store(SubChunkFullFaceConnectivity, std::memory_order_relaxed);
+        render_data.occluder.store(0, std::memory_order_relaxed);
+        render_data.state      = TessellationState_Done;
+    }
 
-            u32 data10 = compress_vertex1(texture_id, sky_light_levels[0], light_source_levels[0], ambient_occlusions[0]);
-            u32 data11 = compress_vertex1(texture_id, sky_light_levels[1], light_source_levels[1], ambient_occlusions[1]);
-            u32 data12 = compress_vertex1(texture_id, sky_light_levels[2], light_source_levels[2], ambient_occlusions[2]);
-            u32 data13 = compress_vertex1(texture_id, sky_light_levels[3], light_source_levels[3], ambient_occlusions[3]);
+    void opengl_renderer_update_sub_chunk(World *world, Chunk *chunk, u32 sub_chunk_index, const Sub_Chunk_Mesh *mesh)
+    {
+        Sub_Chunk_Render_Data& render_data = chunk->sub_chunks_render_data[sub_chunk_index];
 
-            *bucket->current_vertex++ = { data00, data10 };
-            *bucket->current_vertex++ = { data01, data11 };
-            *bucket->current_vertex++ = { data02, data12 };
-            *bucket->current_vertex++ = { data03, data13 };
+        Sub_Chunk_Bucket opaque_bucket;
+        Sub_Chunk_Bucket transparent_bucket;
+        acquire_sub_chunk_mesh(world, chunk, sub_chunk_index, mesh, &opaque_bucket, &transparent_bucket);
 
-            bucket->face_count++;
-            sub_chunk_render_data.face_count++;
+        render_data.face_count = mesh->opaque_face_count + mesh->transparent_face_count;
 
-            return true;
+        if (render_data.face_count > 0 && render_data.instance_memory_id == -1)
+        {
+            render_data.instance_memory_id = opengl_renderer_allocate_sub_chunk_instance();
+            render_data.base_instance = renderer->base_instance + render_data.instance_memory_id;
+            render_data.base_instance->chunk_coords    = chunk->world_coords;
+            render_data.base_instance->sub_chunk_index = (i32)sub_chunk_index;
         }
 
-        return false;
+        store_sub_chunk_buckets(&render_data, mesh->content_hash, opaque_bucket, transparent_bucket, mesh->aabb);
+        render_data.face_connectivity.store(mesh->face_connectivity, std::memory_order_relaxed);
+        render_data.occluder.store(mesh->occluder, std::memory_order_relaxed);
     }
 
-    static void submit_block_to_sub_chunk_render_data(World *world,
-                                                      Chunk *chunk,
-                                                      u32 sub_chunk_index,
-                                                      Block *block,
-                                                      const glm::ivec3& block_coords)
+    static void render_sub_chunk_buckets(Sub_Chunk_Render_Data *render_data,
+                                         Sub_Chunk_Bucket *opaque_bucket,
+                                         Sub_Chunk_Bucket *transparent_bucket)
     {
-        const Block_Info* block_info = get_block_info(world, block);
-
-        u32 submitted_face_count = 0;
-
-         /*
-          1----------2
-          |\         |\
-          | 0--------|-3
-          | |        | |
-          5-|--------6 |
-           \|         \|
-            4----------7
-        */
-
-        /*
-            top face
-
-             2 ----- 3
-            |      /  |
-            |     /   |
-            |    /    |
-            |   /     |
-            |  /      |
-             1 ----- 0
-        */
-
-        Block* top_block = get_neighbour_block_from_top(chunk, block_coords);
-        submitted_face_count += submit_block_face_to_sub_chunk_render_data(world, chunk, sub_chunk_index, block, top_block, block_coords, block_info->top_texture_id, BlockFace_Top, 0, 1, 2, 3);
-
-        /*
-            bottom face
-
-             7 ----- 6
-            |      /  |
-            |     /   |
-            |    /    |
-            |   /     |
-            |  /      |
-             4 ----- 5
-        */
-
-        Block* bottom_block = get_neighbour_block_from_bottom(chunk, block_coords);
-        submitted_face_count += submit_block_face_to_sub_chunk_render_data(world, chunk, sub_chunk_index, block, bottom_block, block_coords, block_info->bottom_texture_id, BlockFace_Bottom, 5, 4, 7, 6);
-
-        /*
-            left face
-
-             2 ----- 1
-            |      /  |
-            |     /   |
-            |    /    |
-            |   /     |
-            |  /      |
-             6 ----- 5
-        */
-        Block* left_block = nullptr;
-
-        if (block_coords.x == 0)
+        if (opaque_bucket->face_count > 0)
         {
-            left_block = &(chunk->left_edge_blocks[block_coords.y * Chunk::Depth + block_coords.z]);
+            push_sub_chunk_bucket(&renderer->opaque_command_buffer,
+                                  opaque_bucket,
+                                  render_data->instance_memory_id);
         }
-        else
+
+        if (transparent_bucket->face_count > 0)
         {
-            left_block = get_neighbour_block_from_left(chunk, block_coords);
+            push_sub_chunk_bucket(&renderer->transparent_command_buffer,
+                                  transparent_bucket,
+                                  render_data->instance_memory_id);
         }
-        submitted_face_count += submit_block_face_to_sub_chunk_render_data(world, chunk, sub_chunk_index, block, left_block, block_coords, block_info->side_texture_id, BlockFace_Left, 5, 6, 2, 1);
 
-        /*
-            right face
-
-             0 ----- 3
-            |      /  |
-            |     /   |
-            |    /    |
-            |   /     |
-            |  /      |
-             4 ----- 7
-        */
+        auto& stats = renderer->stats;
+        stats.per_frame.face_count += opaque_bucket->face_count + transparent_bucket->face_count;
+        stats.per_frame.sub_chunk_count++;
+    }
 
-        Block* right_block = nullptr;
+    void opengl_renderer_render_sub_chunk(Sub_Chunk_Render_Data *render_data)
+    {
+        Sub_Chunk_Bucket opaque_bucket;
+        Sub_Chunk_Bucket transparent_bucket;
+        AABB aabb;
+        load_sub_chunk_buckets(render_data, &opaque_bucket, &transparent_bucket, &aabb);
+        render_sub_chunk_buckets(render_data, &opaque_bucket, &transparent_bucket);
+    }
 
-        if (block_coords.x == Chunk::Width - 1)
-        {
-            right_block = &(chunk->right_edge_blocks[block_coords.y * Chunk::Depth + block_coords.z]);
-        }
-        else
-        {
-            right_block = get_neighbour_block_from_right(chunk, block_coords);
-        }
-        submitted_face_count += submit_block_face_to_sub_chunk_render_data(world, chunk, sub_chunk_index, block, right_block, block_coords, block_info->side_texture_id, BlockFace_Right, 7, 4, 0, 3);
-
-        /*
-            front face
-
-             3 ----- 2
-            |      /  |
-            |     /   |
-            |    /    |
-            |   /     |
-            |  /      |
-             7 ----- 6
-        */
-        Block* front_block = nullptr;
-
-        if (block_coords.z == 0)
-        {
-            front_block = &(chunk->front_edge_blocks[block_coords.y * Chunk::Width + block_coords.x]);
-        }
-        else
-        {
-            front_block = get_neighbour_block_from_front(chunk, block_coords);
-        }
+    void opengl_renderer_render_sub_chunk(Chunk *chunk, u32 sub_chunk_index)
+    {
+        Assert(sub_chunk_index < Chunk::SubChunkCount);
+        Sub_Chunk_Render_Data *render_data = &chunk->sub_chunks_render_data[sub_chunk_index];
+        opengl_renderer_render_sub_chunk(render_data);
+    }
 
-        submitted_face_count += submit_block_face_to_sub_chunk_render_data(world, chunk, sub_chunk_index, block, front_block, block_coords, block_info->side_texture_id, BlockFace_Front, 6, 7, 3, 2);
+    static_assert(Chunk::SubChunkCount <= AABB_Batch::Capacity, "the sub chunks of a chunk are culled as one aabb batch");
 
-        /*
-            back face
+    static void render_chunk_column(Chunk                  *chunk,
+                                    const Frustum&          frustum,
+                                    const Occlusion_Buffer *occlusion_buffer)
+    {
+        Sub_Chunk_Bucket opaque_buckets[Chunk::SubChunkCount];
+        Sub_Chunk_Bucket transparent_buckets[Chunk::SubChunkCount];
 
-              1 ----- 0
-             |      /  |
-             |     /   |
-             |    /    |
-             |   /     |
-             |  /      |
-              5 ----- 4
-        */
+        // note(harlequin): only the sub chunks with faces go in the batch, most of a column is empty sky
+        AABB_Batch batch;
+        batch.count = 0;
 
-        Block* back_block = nullptr;
+        u8 sub_chunk_indices[Chunk::SubChunkCount];
 
-        if (block_coords.z == Chunk::Depth - 1)
-        {
-            back_block = &(chunk->back_edge_blocks[block_coords.y * Chunk::Width + block_coords.x]);
-        }
-        else
+        for (u32 sub_chunk_index = 0; sub_chunk_index < Chunk::SubChunkCount; sub_chunk_index++)
         {
-            back_block = get_neighbour_block_from_back(chunk, block_coords);
-        }
+            Sub_Chunk_Render_Data *render_data = &chunk->sub_chunks_render_data[sub_chunk_index];
 
-        submitted_face_count += submit_block_face_to_sub_chunk_render_data(world, chunk, sub_chunk_index, block, back_block, block_coords, block_info->side_texture_id, BlockFace_Back, 4, 5, 1, 0);
+            AABB aabb;
+            load_sub_chunk_buckets(render_data,
+                                   &opaque_buckets[sub_chunk_index],
+                                   &transparent_buckets[sub_chunk_index],
+                                   &aabb);
 
-        if (submitted_face_count > 0)
-        {
-            Sub_Chunk_Render_Data& sub_chunk_render_data = chunk->sub_chunks_render_data[sub_chunk_index];
-            glm::vec3 block_position = get_block_position(chunk, block_coords);
-            glm::vec3 min = block_position - glm::vec3(0.5f, 0.5f, 0.5f);
-            glm::vec3 max = block_position + glm::vec3(0.5f, 0.5f, 0.5f);
-            i32 bucket_index = sub_chunk_render_data.active_bucket_index + 1;
-            if (bucket_index == 2) bucket_index = 0;
-            sub_chunk_render_data.aabb[bucket_index].min = glm::min(sub_chunk_render_data.aabb[bucket_index].min, min);
-            sub_chunk_render_data.aabb[bucket_index].max = glm::max(sub_chunk_render_data.aabb[bucket_index].max, max);
+            u64 face_count = (u64)opaque_buckets[sub_chunk_index].face_count + (u64)transparent_buckets[sub_chunk_index].face_count;
+            if (face_count > 0)
+            {
+                sub_chunk_indices[batch.count] = (u8)sub_chunk_index;
+                set_aabb_batch_entry(&batch, batch.count, aabb);
+                batch.count++;
+            }
         }
-    }
-
-    void opengl_renderer_upload_sub_chunk_to_gpu(World *world,
-                                                 Chunk *chunk,
-                                                 u32 sub_chunk_index)
-    {
-        Sub_Chunk_Render_Data& render_data = chunk->sub_chunks_render_data[sub_chunk_index];
 
-        i32 bucket_index = render_data.active_bucket_index + 1;
-        if (bucket_index == 2) bucket_index = 0;
+        if (!batch.count)
+        {
+            return;
+        }
 
-        constexpr f32 inf = std::numeric_limits< f32 >::max();
-        render_data.aabb[bucket_index] = { { inf, inf, inf }, { -inf, -inf, -inf } };
+        auto& stats = renderer->stats;
 
-        i32 sub_chunk_start_y = sub_chunk_index * Chunk::SubChunkHeight;
-        i32 sub_chunk_end_y = (sub_chunk_index + 1) * Chunk::SubChunkHeight;
+        u32 visible_mask = frustum.get_visible_aabb_mask(&batch);
+        stats.per_frame.culled_sub_chunk_count += batch.count - count_set_bits(visible_mask);
 
-        for (i32 y = sub_chunk_start_y; y < sub_chunk_end_y; ++y)
+        while (visible_mask)
         {
-            for (i32 z = 0; z < Chunk::Depth; ++z)
-            {
-                for (i32 x = 0; x < Chunk::Width; ++x)
-                {
-                    glm::ivec3 block_coords = { x, y, z };
-                    Block *block = get_block(chunk, block_coords);
+            u32 batch_index     = count_trailing_zeros(visible_mask);
+            u32 sub_chunk_index = sub_chunk_indices[batch_index];
+            visible_mask &= visible_mask - 1;
 
-                    if (block->id == BlockId_Air)
-                    {
-                        continue;
-                    }
+            i32 face_count = opaque_buckets[sub_chunk_index].face_count + transparent_buckets[sub_chunk_index].face_count;
 
-                    submit_block_to_sub_chunk_render_data(world, chunk, sub_chunk_index, block, block_coords);
-                }
+            if (!(chunk->reachable_sub_chunk_mask & (1u << sub_chunk_index)))
+            {
+                stats.per_frame.occluded_sub_chunk_count++;
+                stats.per_frame.occluded_face_count += face_count;
+                continue;
             }
-        }
 
-        if (render_data.face_count > 0)
-        {
-            if (render_data.instance_memory_id == -1)
+            if (occlusion_buffer && is_aabb_occluded(occlusion_buffer, get_aabb_batch_entry(&batch, batch_index)))
             {
-                render_data.instance_memory_id = opengl_renderer_allocate_sub_chunk_instance();
-                render_data.base_instance = renderer->base_instance + render_data.instance_memory_id;
-                render_data.base_instance->chunk_coords = chunk->world_coords;
+                stats.per_frame.depth_occluded_sub_chunk_count++;
+                stats.per_frame.depth_occluded_face_count += face_count;
+                continue;
             }
 
-            Sub_Chunk_Bucket& opqaue_bucket = render_data.opaque_buckets[bucket_index];
-            Sub_Chunk_Bucket& transparent_bucket = render_data.transparent_buckets[bucket_index];
-
-            renderer->stats.persistent.sub_chunk_used_memory += opqaue_bucket.face_count * 4 * sizeof(Block_Face_Vertex);
-            renderer->stats.persistent.sub_chunk_used_memory += transparent_bucket.face_count * 4 * sizeof(Block_Face_Vertex);
+            render_sub_chunk_buckets(&chunk->sub_chunks_render_data[sub_chunk_index],
+                                     &opaque_buckets[sub_chunk_index],
+                                     &transparent_buckets[sub_chunk_index]);
         }
     }
 
-    void opengl_renderer_render_sub_chunk(Sub_Chunk_Render_Data *render_data)
+    void opengl_renderer_render_chunks(Chunk                  **chunks,
+                                       u32                      chunk_count,
+                                       Camera                  *camera,
+                                       const Occlusion_Buffer  *occlusion_buffer)
     {
-        const u32& active_chunk_index = render_data->active_bucket_index;
-        if (render_data->opaque_buckets[active_chunk_index].face_count > 0)
-        {
-            push_sub_chunk_bucket(&renderer->opaque_command_buffer,
-                                  &render_data->opaque_buckets[active_chunk_index],
-                                  render_data->instance_memory_id);
-        }
+        const Frustum& frustum = camera->frustum;
+        auto& stats = renderer->stats;
 
-        if (render_data->transparent_buckets[active_chunk_index].face_count > 0)
+        for (u32 first_chunk_index = 0; first_chunk_index < chunk_count; first_chunk_index += AABB_Batch::Capacity)
         {
-            push_sub_chunk_bucket(&renderer->transparent_command_buffer,
-                                  &render_data->transparent_buckets[active_chunk_index],
-                                  render_data->instance_memory_id);
-        }
-
-        auto& stats = renderer->stats;
-        stats.per_frame.face_count +=
-            render_data->opaque_buckets[active_chunk_index].face_count + render_data->transparent_buckets[active_chunk_index].face_count;
-        stats.per_frame.sub_chunk_count++;
-    }
+            AABB_Batch column_batch;
+            column_batch.count = Min(chunk_count - first_chunk_index, AABB_Batch::Capacity);
 
-    void opengl_renderer_render_sub_chunk(Chunk *chunk, u32 sub_chunk_index)
-    {
-        Assert(sub_chunk_index < Chunk::SubChunkCount);
-        Sub_Chunk_Render_Data *render_data = &chunk->sub_chunks_render_data[sub_chunk_index];
-        opengl_renderer_render_sub_chunk(render_data);
-    }
+            for (u32 i = 0; i < column_batch.count; i++)
+            {
+                set_aabb_batch_entry(&column_batch, i, get_chunk_column_aabb(chunks[first_chunk_index + i]));
+            }
 
-    void opengl_renderer_render_chunks(Sub_Chunk_Render_Data *first_active_sub_chunk_render_data,
-                                       Camera                *camera)
-    {
-        Sub_Chunk_Render_Data *sub_chunk_render_data = first_active_sub_chunk_render_data;
-        while (sub_chunk_render_data)
-        {
-            const u32 &active_bucket_index = sub_chunk_render_data->active_bucket_index;
-            Sub_Chunk_Bucket& opaque_bucket = sub_chunk_render_data->opaque_buckets[active_bucket_index];
-            Sub_Chunk_Bucket& transparent_bucket = sub_chunk_render_data->transparent_buckets[active_bucket_index];
-            u64 face_count = (u64)opaque_bucket.face_count + (u64)transparent_bucket.face_count;
+            u32 visible_column_mask = frustum.get_visible_aabb_mask(&column_batch);
 
-            bool is_sub_chunk_visible = face_count > 0 &&
-                                        camera->frustum.is_aabb_visible(sub_chunk_render_data->aabb[active_bucket_index]);
+            stats.per_frame.chunk_column_count         += column_batch.count;
+            stats.per_frame.visible_chunk_column_count += count_set_bits(visible_column_mask);
 
-            if (is_sub_chunk_visible)
+            while (visible_column_mask)
             {
-                opengl_renderer_render_sub_chunk(sub_chunk_render_data);
+                u32 i = count_trailing_zeros(visible_column_mask);
+                visible_column_mask &= visible_column_mask - 1;
+                render_chunk_column(chunks[first_chunk_index + i], frustum, occlusion_buffer);
             }
-            sub_chunk_render_data = sub_chunk_render_data->next;
         }
     }
 
@@ -1481,6 +1147,12 @@ namespace minecraft {
     {
         wait_for_gpu_to_finish_work();
 
+        // note(harlequin): every frame before this one is done on the gpu
+        free_retired_runs(&renderer->retire_queue,
+                          &renderer->vertex_allocator,
+                          renderer->frame_index.load(),
+                          &vertex_allocator_thread_cache);
+
         renderer->sky_color  = clear_color;
         renderer->tint_color = tint_color;
         renderer->camera     = camera;
@@ -1521,6 +1193,8 @@ namespace minecraft {
 
         bind_vertex_array(&renderer->chunk_vertex_array);
         bind_texture(&renderer->block_array_texture, 1);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, renderer->chunk_face_buffer.handle);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, renderer->block_info_buffer.handle);
 
         // opaque pass
         glEnable(GL_CULL_FACE);
@@ -1612,6 +1286,7 @@ namespace minecraft {
         draw_commands(&renderer->transparent_command_buffer);
 
         signal_gpu_for_work();
+        renderer->frame_index++;
 
         glDepthFunc(GL_ALWAYS);
         glEnable(GL_BLEND);
@@ -1691,9 +1366,58 @@ namespace minecraft {
         return &renderer->stats;
     }
 
-    i64 opengl_renderer_get_free_chunk_bucket_count()
+    Buddy_Allocator_Stats opengl_renderer_get_sub_chunk_bucket_stats()
+    {
+        return get_buddy_allocator_stats(&renderer->vertex_allocator);
+    }
+
+    Retire_Queue_Stats opengl_renderer_get_retired_sub_chunk_bucket_stats()
+    {
+        return get_retire_queue_stats(&renderer->retire_queue);
+    }
+
+    Sub_Chunk_Mesh_Cache_Stats opengl_renderer_get_sub_chunk_mesh_cache_stats()
+    {
+        Sub_Chunk_Mesh_Cache *cache = &renderer->mesh_cache;
+
+        std::unique_lock lock(cache->mutex);
+
+        Sub_Chunk_Mesh_Cache_Stats stats;
+        stats.mesh_count        = cache->mesh_count;
+        stats.sub_chunk_count   = cache->sub_chunk_count;
+        stats.face_count        = cache->face_count;
+        stats.shared_face_count = cache->shared_face_count;
+        stats.hit_count         = cache->hit_count;
+        stats.miss_count        = cache->miss_count;
+        stats.collision_count   = cache->collision_count;
+        return stats;
+    }
+
+    u32 opengl_renderer_defragment_sub_chunk_buckets(World *world, u32 max_sub_chunk_count)
     {
-        return renderer->free_buckets.count;
+        u32 tags[64];
+        u32 tag_count = buddy_allocator_find_relocatable_runs(&renderer->vertex_allocator,
+                                                              tags,
+                                                              Min(max_sub_chunk_count, (u32)ArrayCount(tags)));
+        u32 relocated_sub_chunk_count = 0;
+
+        for (u32 i = 0; i < tag_count; i++)
+        {
+            Chunk *chunk = &world->chunk_nodes[tags[i] >> 6].chunk;
+            u32 sub_chunk_index = (tags[i] >> 1) & 0x1F;
+
+            if (chunk->state != ChunkState_LightCalculated)
+            {
+                continue;
+            }
+
+            // note(harlequin): remeshing the sub chunk copies its mesh into the lowest free runs that fit it
+            mark_sub_chunk_dirty(world, chunk, sub_chunk_index);
+            relocated_sub_chunk_count++;
+        }
+
+        renderer->stats.persistent.relocated_sub_chunk_bucket_count += relocated_sub_chunk_count;
+        return relocated_sub_chunk_count;
     }
 
     void opengl_renderer_set_is_fxaa_enabled(bool enabled)
@@ -3,6 +3,8 @@
 #include "core/common.h"
 #include "core/event.h"
 #include "core/platform.h"
+#include "memory/buddy_allocator.h"
+#include "memory/retire_queue.h"
 
 #include <glm/glm.hpp>
 #include <vector>
@@ -17,18 +19,47 @@ namespace minecraft {
     struct Platform;
     struct Camera;
     struct Memory_Arena;
+    struct Sub_Chunk_Mesh;
     struct Opengl_Texture;
     struct Opengl_Shader;
+    struct Occlusion_Buffer;
 
     struct PerFrame_Stats
     {
         i32 face_count;
         i32 sub_chunk_count;
+
+        i32 chunk_column_count;
+        i32 visible_chunk_column_count;
+        i32 culled_sub_chunk_count;
+
+        // note(harlequin): sub chunks in the frustum that find_reachable_sub_chunks did not reach
+        i32 occluded_sub_chunk_count;
+        i32 occluded_face_count;
+
+        // note(harlequin): sub chunks find_reachable_sub_chunks reached that the occlusion buffer hid
+        i32 depth_occluded_sub_chunk_count;
+        i32 depth_occluded_face_count;
     };
 
     struct Persistent_Stats
     {
         std::atomic< u64 > sub_chunk_used_memory;
+        std::atomic< u64 > relocated_sub_chunk_bucket_count;
+    };
+
+    // note(harlequin): sub chunks with the same content draw the same buckets, shared faces are the faces that
+    // would have been uploaded once more for every extra sub chunk drawing a mesh, collisions are meshes whose content
+    // hash was cached with other faces
+    struct Sub_Chunk_Mesh_Cache_Stats
+    {
+        u32 mesh_count;
+        u32 sub_chunk_count;
+        u64 face_count;
+        u64 shared_face_count;
+        u64 hit_count;
+        u64 miss_count;
+        u64 collision_count;
     };
 
     struct Opengl_Renderer_Stats
@@ -46,9 +77,12 @@ namespace minecraft {
 
     bool opengl_renderer_on_resize(const Event* event, void *sender);
 
-    void opengl_renderer_update_sub_chunk(World *world,
-                                          Chunk *chunk,
-                                          u32    sub_chunk_index);
+    // note(harlequin): shares the buckets of a cached mesh with the same content or copies the mesh into new buckets,
+    // the old buckets of the sub chunk are retired once no sub chunk draws them
+    void opengl_renderer_update_sub_chunk(World                *world,
+                                          Chunk                *chunk,
+                                          u32                   sub_chunk_index,
+                                          const Sub_Chunk_Mesh *mesh);
 
     void opengl_renderer_begin_frame(const glm::vec4 &clear_color,
                                      const glm::vec4 &tint_color,
@@ -59,8 +93,13 @@ namespace minecraft {
     void opengl_renderer_render_sub_chunk(Chunk *chunk,
                                           u32    sub_chunk_index);
 
-    void opengl_renderer_render_chunks(Sub_Chunk_Render_Data *first_active_sub_chunk_render_data,
-                                       Camera                *camera);
+    // note(harlequin): chunk columns out of the frustum are culled before any of their sub chunks are looked at,
+    // the sub chunks find_reachable_sub_chunks did not reach this frame are not drawn and neither are the ones
+    // occlusion_buffer hides when it is not null, its occluders have to be rasterized already
+    void opengl_renderer_render_chunks(Chunk                  **chunks,
+                                       u32                      chunk_count,
+                                       Camera                  *camera,
+                                       const Occlusion_Buffer  *occlusion_buffer);
 
     void opengl_renderer_end_frame(struct Game_Assets *assets,
                                    i32                 chunk_radius,
@@ -69,24 +108,22 @@ namespace minecraft {
 
     void opengl_renderer_swap_buffers(struct GLFWwindow *window);
 
-    void opengl_renderer_allocate_sub_chunk_bucket(Sub_Chunk_Bucket *bucket);
-    void opengl_renderer_reset_sub_chunk_bucket(Sub_Chunk_Bucket *bucket);
-    void opengl_renderer_free_sub_chunk_bucket(Sub_Chunk_Bucket *bucket);
-
     i32  opengl_renderer_allocate_sub_chunk_instance();
     void opengl_renderer_free_sub_chunk_instance(i32 instance_memory_id);
 
     void opengl_renderer_free_sub_chunk(Chunk *chunk, u32 sub_chunk_index);
 
-    void opengl_renderer_upload_sub_chunk_to_gpu(World *world,
-                                                 Chunk *chunk,
-                                                 u32 sub_chunk_index);
-
     bool opengl_renderer_resize_frame_buffers(u32 width, u32 height);
 
     glm::vec2 opengl_renderer_get_frame_buffer_size();
     const Opengl_Renderer_Stats* opengl_renderer_get_stats();
-    i64 opengl_renderer_get_free_chunk_bucket_count();
+    Buddy_Allocator_Stats opengl_renderer_get_sub_chunk_bucket_stats();
+    Retire_Queue_Stats opengl_renderer_get_retired_sub_chunk_bucket_stats();
+    Sub_Chunk_Mesh_Cache_Stats opengl_renderer_get_sub_chunk_mesh_cache_stats();
+
+    // note(harlequin): marks up to max_sub_chunk_count sub chunks dirty whose buckets could move down the
+    // vertex buffer, returns how many were marked
+    u32 opengl_renderer_defragment_sub_chunk_buckets(World *world, u32 max_sub_chunk_count);
 
     void opengl_renderer_set_is_fxaa_enabled(bool enabled);
     bool *opengl_renderer_is_fxaa_enabled();
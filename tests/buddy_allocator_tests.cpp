@@ -0,0 +1,193 @@
+#include "test.h"
+
+#include "memory/memory_arena.h"
+#include "memory/buddy_allocator.h"
+
+#include <stdlib.h>
+
+namespace minecraft {
+
+    void test_buddy_allocator()
+    {
+        constexpr u64 UnitCount         = 1 << 16;
+        constexpr u32 MinBlockUnitCount = 32;
+        constexpr u32 MaxBlockUnitCount = 1024;
+        constexpr u32 SlotCount         = 256;
+        constexpr u32 StepCount         = 20000;
+        constexpr u64 ArenaSize         = MegaBytes(4);
+
+        void *arena_memory = malloc(ArenaSize);
+        Memory_Arena arena = create_memory_arena(arena_memory, ArenaSize);
+
+        Buddy_Allocator *allocator = ArenaPushAlignedZero(&arena, Buddy_Allocator);
+        u32 *owners = ArenaPushArrayAligned(&arena, u32, UnitCount);
+        i64 *slots  = ArenaPushArrayAligned(&arena, i64, SlotCount);
+        Buddy_Allocator_Thread_Cache cache = {};
+
+        bool success = allocator && owners && slots &&
+                       initialize_buddy_allocator(allocator, UnitCount, MinBlockUnitCount, MaxBlockUnitCount, &arena);
+        TestCheck(success);
+
+        if (!success)
+        {
+            free(arena_memory);
+            return;
+        }
+
+        for (u32 i = 0; i < UnitCount; i++)
+        {
+            owners[i] = Buddy_Allocator::NullTag;
+        }
+
+        for (u32 i = 0; i < SlotCount; i++)
+        {
+            slots[i] = -1;
+        }
+
+        // note(harlequin): every unit remembers the slot that owns it so two live runs can never overlap
+        auto claim_run = [&](u32 slot_index, i64 offset, u32 unit_count) -> bool
+        {
+            u32 run_unit_count = buddy_allocator_get_run_unit_count(allocator, offset);
+            bool is_valid_run  = run_unit_count >= unit_count &&
+                                 run_unit_count >= MinBlockUnitCount &&
+                                 run_unit_count <= MaxBlockUnitCount &&
+                                 offset % run_unit_count == 0 &&
+                                 offset + run_unit_count <= (i64)UnitCount;
+            if (!is_valid_run)
+            {
+                return false;
+            }
+
+            for (u32 i = 0; i < run_unit_count; i++)
+            {
+                if (owners[offset + i] != Buddy_Allocator::NullTag)
+                {
+                    return false;
+                }
+                owners[offset + i] = slot_index;
+            }
+
+            return true;
+        };
+
+        auto release_run = [&](u32 slot_index, i64 offset) -> bool
+        {
+            u32 run_unit_count = buddy_allocator_get_run_unit_count(allocator, offset);
+            bool is_owned      = true;
+
+            for (u32 i = 0; i < run_unit_count; i++)
+            {
+                is_owned &= owners[offset + i] == slot_index;
+                owners[offset + i] = Buddy_Allocator::NullTag;
+            }
+
+            return is_owned;
+        };
+
+        u32 random_state        = 0x9E3779B9;
+        u32 overlap_count       = 0;
+        u32 invalid_state_count = 0;
+
+        for (u32 step = 0; step < StepCount; step++)
+        {
+            u32 slot_index = next_test_random(&random_state) % SlotCount;
+            i64& slot      = slots[slot_index];
+            u32 unit_count = 1 + next_test_random(&random_state) % MaxBlockUnitCount;
+            u32 action     = next_test_random(&random_state) % 3;
+
+            if (slot == -1)
+            {
+                slot = buddy_allocator_allocate(allocator, unit_count, slot_index, &cache);
+                if (slot != -1 && !claim_run(slot_index, slot, unit_count))
+                {
+                    overlap_count++;
+                }
+            }
+            else if (action == 0)
+            {
+                overlap_count += !release_run(slot_index, slot);
+                buddy_allocator_free(allocator, slot, &cache);
+                slot = -1;
+            }
+            else
+            {
+                overlap_count += !release_run(slot_index, slot);
+                slot = buddy_allocator_reallocate(allocator, slot, unit_count, slot_index, &cache);
+                if (slot != -1 && !claim_run(slot_index, slot, unit_count))
+                {
+                    overlap_count++;
+                }
+            }
+
+            if (step % 1000 == 0)
+            {
+                buddy_allocator_flush_thread_cache(allocator, &cache);
+                invalid_state_count += !validate_buddy_allocator(allocator);
+            }
+        }
+
+        TestCheck(overlap_count == 0);
+        TestCheck(invalid_state_count == 0);
+
+        for (u32 i = 0; i < SlotCount; i++)
+        {
+            if (slots[i] != -1)
+            {
+                buddy_allocator_free(allocator, slots[i], &cache);
+                slots[i] = -1;
+            }
+        }
+
+        // note(harlequin): the thread cache holds on to freed blocks until it is flushed
+        buddy_allocator_flush_thread_cache(allocator, &cache);
+
+        Buddy_Allocator_Stats stats = get_buddy_allocator_stats(allocator);
+        TestCheck(validate_buddy_allocator(allocator));
+        TestCheck(stats.allocation_count == 0);
+        TestCheck(stats.allocated_unit_count == 0);
+        TestCheck(stats.cached_unit_count == 0);
+        TestCheck(stats.free_unit_count == UnitCount);
+        TestCheck(stats.largest_free_block_unit_count == MaxBlockUnitCount);
+        TestCheck(stats.free_block_count == UnitCount / MaxBlockUnitCount);
+
+        // note(harlequin): everything coalesced back so the whole range can be handed out as the largest runs
+        u32 max_block_count = 0;
+        i64 expected_offset = 0;
+        while (true)
+        {
+            i64 offset = buddy_allocator_allocate(allocator, MaxBlockUnitCount, max_block_count);
+            if (offset == -1)
+            {
+                break;
+            }
+            TestCheck(offset == expected_offset);
+            expected_offset += MaxBlockUnitCount;
+            max_block_count++;
+        }
+
+        TestCheck(max_block_count == UnitCount / MaxBlockUnitCount);
+        TestCheck(buddy_allocator_allocate(allocator, 1, 0) == -1);
+        TestCheck(get_buddy_allocator_stats(allocator).free_unit_count == 0);
+
+        for (u32 i = 0; i < max_block_count; i++)
+        {
+            buddy_allocator_free(allocator, (i64)i * MaxBlockUnitCount);
+        }
+
+        // note(harlequin): a run is split down to the smallest order that fits and handed out from the lowest address
+        i64 small_offset = buddy_allocator_allocate(allocator, 1, 0);
+        i64 large_offset = buddy_allocator_allocate(allocator, MinBlockUnitCount + 1, 1);
+        TestCheck(small_offset == 0);
+        TestCheck(buddy_allocator_get_run_unit_count(allocator, small_offset) == MinBlockUnitCount);
+        TestCheck(large_offset == 2 * MinBlockUnitCount);
+        TestCheck(buddy_allocator_get_run_unit_count(allocator, large_offset) == 2 * MinBlockUnitCount);
+        TestCheck(buddy_allocator_allocate(allocator, MaxBlockUnitCount + 1, 2) == -1);
+
+        // note(harlequin): once the hole below it is gone the larger run is moved down by a reallocation
+        buddy_allocator_free(allocator, small_offset);
+        TestCheck(buddy_allocator_reallocate(allocator, large_offset, MinBlockUnitCount + 1, 1) == 0);
+        TestCheck(validate_buddy_allocator(allocator));
+
+        free(arena_memory);
+    }
+}
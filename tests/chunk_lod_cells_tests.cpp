@@ -0,0 +1,72 @@
+#include "test.h"
+
+#include "game/world.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace minecraft {
+
+    // note(harlequin): a far chunk that was never saved gets its cells straight from the terrain heights, they have to
+    // be the cells it would have built from its generated blocks or it would not agree with a near neighbour on the seam
+    void test_generate_chunk_lod_cells()
+    {
+        constexpr i32 Seed       = 4242;
+        constexpr i32 ChunkCount = 64;
+
+        Chunk           *chunk          = (Chunk *)calloc(1, sizeof(Chunk));
+        Chunk_Blocks    *chunk_blocks   = (Chunk_Blocks *)calloc(1, sizeof(Chunk_Blocks));
+        Chunk_Lod_Cells *expected_cells = (Chunk_Lod_Cells *)calloc(1, sizeof(Chunk_Lod_Cells));
+        Chunk_Lod_Cells *cells          = (Chunk_Lod_Cells *)calloc(1, sizeof(Chunk_Lod_Cells));
+        TestCheck(chunk && chunk_blocks && expected_cells && cells);
+
+        if (!chunk || !chunk_blocks || !expected_cells || !cells)
+        {
+            free(chunk);
+            free(chunk_blocks);
+            free(expected_cells);
+            free(cells);
+            return;
+        }
+
+        i16 expected_height_map[Chunk::Depth * Chunk::Width];
+
+        u32 random_state     = 0x9E3779B9;
+        u32 water_cell_count = 0;
+
+        for (i32 i = 0; i < ChunkCount; i++)
+        {
+            // note(harlequin): chunks far apart so the terrain goes from under the water level to the highest hills
+            glm::ivec2 chunk_coords = { (i32)(next_test_random(&random_state) % 2048) - 1024,
+                                        (i32)(next_test_random(&random_state) % 2048) - 1024 };
+
+            initialize_chunk(chunk, chunk_coords);
+            attach_chunk_blocks(chunk, chunk_blocks);
+            generate_chunk(chunk, Seed);
+            calculate_height_map(chunk);
+            calculate_lod_cells(chunk, expected_cells);
+            memcpy(expected_height_map, chunk->height_map, sizeof(expected_height_map));
+            detach_chunk_blocks(chunk);
+
+            initialize_chunk(chunk, chunk_coords);
+            memset(chunk->height_map, 0, sizeof(chunk->height_map));
+            generate_chunk_lod_cells(chunk, cells, Seed);
+
+            TestCheck(memcmp(chunk->height_map, expected_height_map, sizeof(expected_height_map)) == 0);
+            TestCheck(memcmp(cells->block_ids, expected_cells->block_ids, sizeof(cells->block_ids)) == 0);
+            TestCheck(memcmp(cells->light_levels, expected_cells->light_levels, sizeof(cells->light_levels)) == 0);
+
+            for (u64 cell_index = 0; cell_index < Chunk::LodCellCount; cell_index++)
+            {
+                water_cell_count += expected_cells->block_ids[cell_index] == BlockId_Water;
+            }
+        }
+
+        TestCheck(water_cell_count > 0);
+
+        free(chunk);
+        free(chunk_blocks);
+        free(expected_cells);
+        free(cells);
+    }
+}
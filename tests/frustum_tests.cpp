@@ -0,0 +1,90 @@
+#include "test.h"
+
+#include "game/chunk.h"
+#include "renderer/camera.h"
+
+#include <math.h>
+
+namespace minecraft {
+
+    // note(harlequin): a random value in [min, max] snapped to a multiple of step so a box often lands right on a
+    // block or chunk boundary like the aabbs of the renderer do
+    static f32 get_test_random_value(u32 *random_state, f32 min, f32 max, f32 step)
+    {
+        f32 t = (f32)(next_test_random(random_state) % 65536) / 65535.0f;
+        return floorf((min + t * (max - min)) / step) * step;
+    }
+
+    // note(harlequin): get_visible_aabb_mask has to keep every box is_aabb_visible keeps and cull every box it culls,
+    // boxes lined up on block and chunk boundaries included, and never set the bits of the lanes past the end of the batch
+    void test_frustum_aabb_batch()
+    {
+        constexpr u32 CameraCount      = 64;
+        constexpr u32 BatchesPerCamera = 64;
+
+        u32 random_state = 0x85EBCA6B;
+
+        u32 box_count         = 0;
+        u32 visible_box_count = 0;
+
+        for (u32 camera_index = 0; camera_index < CameraCount; camera_index++)
+        {
+            glm::vec3 camera_position = { get_test_random_value(&random_state, -1000.0f, 1000.0f, 0.25f),
+                                          get_test_random_value(&random_state, 0.0f, 300.0f, 0.25f),
+                                          get_test_random_value(&random_state, -1000.0f, 1000.0f, 0.25f) };
+
+            Camera camera;
+            initialize_camera(&camera, camera_position, 90.0f, 16.0f / 9.0f, 0.1f, 500.0f);
+            camera.yaw   = get_test_random_value(&random_state, 0.0f, 360.0f, 1.0f);
+            camera.pitch = get_test_random_value(&random_state, -89.0f, 89.0f, 1.0f);
+            update_camera(&camera);
+
+            for (u32 batch_index = 0; batch_index < BatchesPerCamera; batch_index++)
+            {
+                AABB_Batch batch;
+                batch.count = 1 + next_test_random(&random_state) % AABB_Batch::Capacity;
+
+                AABB boxes[AABB_Batch::Capacity];
+
+                for (u32 i = 0; i < AABB_Batch::Capacity; i++)
+                {
+                    // note(harlequin): chunk columns, sub chunks and single blocks around the camera
+                    glm::vec3 size;
+
+                    switch (next_test_random(&random_state) % 3)
+                    {
+                        case 0: size = { (f32)Chunk::Width, (f32)Chunk::Height, (f32)Chunk::Depth }; break;
+                        case 1: size = { (f32)Chunk::Width, (f32)Chunk::SubChunkHeight, (f32)Chunk::Depth }; break;
+                        default: size = { 1.0f, 1.0f, 1.0f }; break;
+                    }
+
+                    glm::vec3 min = camera_position + glm::vec3(get_test_random_value(&random_state, -520.0f, 520.0f, size.x),
+                                                                get_test_random_value(&random_state, -300.0f, 300.0f, size.y),
+                                                                get_test_random_value(&random_state, -520.0f, 520.0f, size.z));
+
+                    boxes[i] = { min, min + size };
+
+                    // note(harlequin): the lanes past the end of the batch hold whatever was there before
+                    set_aabb_batch_entry(&batch, i, i < batch.count ? boxes[i] : AABB { { NAN, NAN, NAN }, { NAN, NAN, NAN } });
+                }
+
+                u32 visible_mask = camera.frustum.get_visible_aabb_mask(&batch);
+
+                u32 expected_visible_mask = 0;
+
+                for (u32 i = 0; i < batch.count; i++)
+                {
+                    expected_visible_mask |= (u32)camera.frustum.is_aabb_visible(boxes[i]) << i;
+                }
+
+                TestCheck(visible_mask == expected_visible_mask);
+
+                box_count         += batch.count;
+                visible_box_count += count_set_bits(expected_visible_mask);
+            }
+        }
+
+        // note(harlequin): the boxes have to land on both sides of the frustum for the comparison to mean anything
+        TestCheck(visible_box_count > 0 && visible_box_count < box_count);
+    }
+}
@@ -0,0 +1,42 @@
+#include "test.h"
+
+namespace minecraft {
+
+    u32 failed_check_count = 0;
+}
+
+// note(harlequin): the parts of the engine that run without a gpu or a window, returns the number of failed checks
+int main()
+{
+    using namespace minecraft;
+
+    struct Test
+    {
+        const char *name;
+        void      (*run)();
+    };
+
+    Test tests[] =
+    {
+        { "buddy_allocator",           &test_buddy_allocator           },
+        { "retire_queue",              &test_retire_queue              },
+        { "find_reachable_sub_chunks", &test_find_reachable_sub_chunks },
+        { "occlusion_buffer",          &test_occlusion_buffer          },
+        { "generate_chunk_lod_cells",  &test_generate_chunk_lod_cells  },
+        { "greedy_meshing",            &test_greedy_meshing            },
+        { "face_culling",              &test_face_culling              },
+        { "patch_sub_chunk_mesh",      &test_patch_sub_chunk_mesh      },
+        { "corner_samples",            &test_corner_samples            },
+        { "block_face_packing",        &test_block_face_packing        },
+        { "frustum_aabb_batch",        &test_frustum_aabb_batch        }
+    };
+
+    for (u32 i = 0; i < ArrayCount(tests); i++)
+    {
+        u32 failed_check_count_before = failed_check_count;
+        tests[i].run();
+        fprintf(stderr, "[%s]: %s\n", failed_check_count == failed_check_count_before ? "PASSED" : "FAILED", tests[i].name);
+    }
+
+    return (int)failed_check_count;
+}
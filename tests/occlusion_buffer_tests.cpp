@@ -0,0 +1,101 @@
+#include "test.h"
+
+#include "memory/memory_arena.h"
+#include "game/chunk.h"
+#include "renderer/camera.h"
+#include "renderer/occlusion_buffer.h"
+
+#include <stdlib.h>
+
+namespace minecraft {
+
+    void test_occlusion_buffer()
+    {
+        constexpr i32 WallSubChunkCount = 8;
+        constexpr u64 ArenaSize         = MegaBytes(2);
+
+        void *arena_memory = malloc(ArenaSize);
+        Memory_Arena arena = create_memory_arena(arena_memory, ArenaSize);
+
+        Occlusion_Buffer *buffer = ArenaPushAlignedZero(&arena, Occlusion_Buffer);
+        Chunk            *chunk  = ArenaPushAlignedZero(&arena, Chunk);
+
+        bool success = buffer && chunk && initialize_occlusion_buffer(buffer);
+        TestCheck(success);
+
+        if (!success)
+        {
+            free(arena_memory);
+            return;
+        }
+
+        // note(harlequin): the lower sub chunks of a chunk are solid, their occluders stack into one wall
+        chunk->world_coords = { 0, 0 };
+        chunk->position     = { 0.0f, 0.0f, 0.0f };
+
+        for (i32 i = 0; i < WallSubChunkCount; i++)
+        {
+            u64 occluder = pack_sub_chunk_occluder({ 0, 0, 0 }, { Chunk::Width, (i32)Chunk::SubChunkHeight, Chunk::Depth });
+            new (&chunk->sub_chunks_render_data[i].occluder) std::atomic< u64 >(occluder);
+        }
+
+        f32 wall_height = (f32)(WallSubChunkCount * Chunk::SubChunkHeight);
+
+        // note(harlequin): looking down -z at the middle of the wall
+        Camera camera = {};
+        initialize_camera(&camera, { Chunk::Width * 0.5f, wall_height * 0.5f, Chunk::Depth + 24.0f });
+        update_camera(&camera);
+
+        Temprary_Memory_Arena temp_arena = begin_temprary_memory_arena(&arena);
+        gather_occluders(buffer, &chunk, 1, &camera, &temp_arena);
+        end_temprary_memory_arena(&temp_arena);
+
+        TestCheck(buffer->frame_index == 1);
+        TestCheck(buffer->candidate_occluder_count == 1);
+        TestCheck(buffer->occluder_count == 1);
+        TestCheck(buffer->occluders[0].min.y < 1.0f && buffer->occluders[0].max.y > wall_height - 1.0f);
+
+        // note(harlequin): a frame is rasterized by whoever claims it first and only once
+        TestCheck(rasterize_occluders(buffer, buffer->frame_index));
+        TestCheck(!rasterize_occluders(buffer, buffer->frame_index));
+        TestCheck(!rasterize_occluders(buffer, buffer->frame_index - 1));
+        wait_for_occluders(buffer);
+        TestCheck(buffer->rasterized_frame_index == buffer->frame_index);
+        TestCheck(buffer->rasterized_triangle_count > 0);
+
+        // note(harlequin): the depth of the wall face is the inverse of its view distance, nothing is around it
+        f32 wall_distance = camera.position.z - buffer->occluders[0].max.z;
+        f32 center_depth  = buffer->depths[(Occlusion_Buffer::Height / 2) * Occlusion_Buffer::Width + Occlusion_Buffer::Width / 2];
+        f32 corner_depth  = buffer->depths[0];
+        TestCheck(glm::abs(center_depth * wall_distance - 1.0f) < 1e-3f);
+        TestCheck(corner_depth == 0.0f);
+
+        AABB behind_wall   = { { 6.0f, 30.0f, -10.0f }, { 10.0f, 34.0f, -6.0f } };
+        AABB in_front      = { { 6.0f, 30.0f,  20.0f }, { 10.0f, 34.0f, 24.0f } };
+        AABB beside_wall   = { { 60.0f, 30.0f, -10.0f }, { 64.0f, 34.0f, -6.0f } };
+        AABB crossing_near = { camera.position - glm::vec3(1.0f), camera.position + glm::vec3(1.0f) };
+        AABB wall_blocks   = { { 0.0f, 0.0f, 0.0f }, { (f32)Chunk::Width, wall_height, (f32)Chunk::Depth } };
+
+        TestCheck(is_aabb_occluded(buffer, behind_wall));
+        TestCheck(!is_aabb_occluded(buffer, in_front));
+        TestCheck(!is_aabb_occluded(buffer, beside_wall));
+        TestCheck(!is_aabb_occluded(buffer, crossing_near));
+
+        // note(harlequin): the wall never hides the sub chunks it was built from
+        TestCheck(!is_aabb_occluded(buffer, wall_blocks));
+
+        // note(harlequin): a camera inside an occluder drops it rather than hiding the world
+        camera.position = { Chunk::Width * 0.5f, wall_height * 0.5f, Chunk::Depth * 0.5f };
+        update_camera(&camera);
+
+        temp_arena = begin_temprary_memory_arena(&arena);
+        gather_occluders(buffer, &chunk, 1, &camera, &temp_arena);
+        end_temprary_memory_arena(&temp_arena);
+
+        TestCheck(buffer->occluder_count == 0);
+        wait_for_occluders(buffer);
+        TestCheck(!is_aabb_occluded(buffer, behind_wall));
+
+        free(arena_memory);
+    }
+}
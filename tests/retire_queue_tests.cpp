@@ -0,0 +1,105 @@
+#include "test.h"
+
+#include "memory/memory_arena.h"
+#include "memory/buddy_allocator.h"
+#include "memory/retire_queue.h"
+
+#include <stdlib.h>
+
+namespace minecraft {
+
+    void test_retire_queue()
+    {
+        constexpr u64 UnitCount         = 1 << 14;
+        constexpr u32 MinBlockUnitCount = 32;
+        constexpr u32 MaxBlockUnitCount = 1024;
+        constexpr u32 BlockCount        = UnitCount / MinBlockUnitCount;
+        constexpr u64 ArenaSize         = MegaBytes(1);
+
+        void *arena_memory = malloc(ArenaSize);
+        Memory_Arena arena = create_memory_arena(arena_memory, ArenaSize);
+
+        Buddy_Allocator *allocator    = ArenaPushAlignedZero(&arena, Buddy_Allocator);
+        Retire_Queue    *retire_queue = ArenaPushAlignedZero(&arena, Retire_Queue);
+        i64             *offsets      = ArenaPushArrayAligned(&arena, i64, BlockCount);
+
+        bool success = allocator && retire_queue && offsets &&
+                       initialize_buddy_allocator(allocator, UnitCount, MinBlockUnitCount, MaxBlockUnitCount, &arena) &&
+                       initialize_retire_queue(retire_queue, allocator, &arena);
+        TestCheck(success);
+
+        if (!success)
+        {
+            free(arena_memory);
+            return;
+        }
+
+        // note(harlequin): a run retired while frame 10 was recorded stays allocated until frame 10 is done
+        i64 offset = buddy_allocator_allocate(allocator, MaxBlockUnitCount, 7);
+        retire_run(retire_queue, allocator, offset, 10);
+
+        Retire_Queue_Stats retire_stats = get_retire_queue_stats(retire_queue);
+        TestCheck(retire_stats.run_count == 1);
+        TestCheck(retire_stats.unit_count == MaxBlockUnitCount);
+        TestCheck(free_retired_runs(retire_queue, allocator, 9) == 0);
+        TestCheck(free_retired_runs(retire_queue, allocator, 10) == 0);
+        TestCheck(get_buddy_allocator_stats(allocator).allocated_unit_count == MaxBlockUnitCount);
+        TestCheck(free_retired_runs(retire_queue, allocator, 11) == 1);
+        TestCheck(get_buddy_allocator_stats(allocator).allocated_unit_count == 0);
+
+        // note(harlequin): runs leave in the order they were retired, a newer frame in front holds back an older one
+        i64 first_offset  = buddy_allocator_allocate(allocator, MinBlockUnitCount, 0);
+        i64 second_offset = buddy_allocator_allocate(allocator, MinBlockUnitCount, 1);
+        retire_run(retire_queue, allocator, first_offset, 20);
+        retire_run(retire_queue, allocator, second_offset, 15);
+        TestCheck(free_retired_runs(retire_queue, allocator, 16) == 0);
+        TestCheck(free_retired_runs(retire_queue, allocator, 21) == 2);
+
+        // note(harlequin): the queue has room for every block of the allocator, and it wraps around its ring
+        for (u32 round = 0; round < 3; round++)
+        {
+            for (u32 i = 0; i < BlockCount; i++)
+            {
+                offsets[i] = buddy_allocator_allocate(allocator, 1, i);
+                TestCheck(offsets[i] != -1);
+            }
+
+            TestCheck(buddy_allocator_allocate(allocator, 1, 0) == -1);
+
+            for (u32 i = 0; i < BlockCount; i++)
+            {
+                retire_run(retire_queue, allocator, offsets[i], 100 + round * 2 + (i >= BlockCount / 2));
+            }
+
+            TestCheck(get_retire_queue_stats(retire_queue).run_count == BlockCount);
+            TestCheck(free_retired_runs(retire_queue, allocator, 101 + round * 2) == BlockCount / 2);
+            TestCheck(free_retired_runs(retire_queue, allocator, 102 + round * 2) == BlockCount / 2);
+        }
+
+        // note(harlequin): only the low bits of a frame are kept, the order survives the wrap of the counter
+        u64 wrap_frame_index = ((u64)1 << 32) - 2;
+        for (u32 i = 0; i < 4; i++)
+        {
+            offsets[i] = buddy_allocator_allocate(allocator, 1, i);
+            retire_run(retire_queue, allocator, offsets[i], wrap_frame_index + i);
+        }
+
+        TestCheck(free_retired_runs(retire_queue, allocator, wrap_frame_index) == 0);
+        TestCheck(free_retired_runs(retire_queue, allocator, wrap_frame_index + 2) == 2);
+        TestCheck(free_retired_runs(retire_queue, allocator, wrap_frame_index + 3) == 1);
+        TestCheck(free_retired_runs(retire_queue, allocator, wrap_frame_index + 4) == 1);
+
+        retire_stats = get_retire_queue_stats(retire_queue);
+        TestCheck(retire_stats.run_count == 0);
+        TestCheck(retire_stats.unit_count == 0);
+        TestCheck(retire_stats.total_retired_run_count == 3 + 3 * BlockCount + 4);
+        TestCheck(retire_stats.total_freed_run_count == retire_stats.total_retired_run_count);
+
+        Buddy_Allocator_Stats stats = get_buddy_allocator_stats(allocator);
+        TestCheck(validate_buddy_allocator(allocator));
+        TestCheck(stats.allocation_count == 0);
+        TestCheck(stats.free_unit_count == UnitCount);
+
+        free(arena_memory);
+    }
+}
@@ -0,0 +1,441 @@
+#include "test.h"
+
+#include "memory/memory_arena.h"
+#include "meshing/sub_chunk_mesher.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+namespace minecraft {
+
+    // note(harlequin): a chunk and its eight neighbours generated from the same seed as the lod cell tests and lit
+    // without a world, the sky light falls off a level per block below the height map and a few glow stones light up
+    // the blocks around them, the transparent and solid blocks scattered around the surface give the mesher seams,
+    // ambient occlusion and transparent faces to deal with
+    struct Mesher_Test_Chunks
+    {
+        static constexpr i32 GridSize = 3;
+
+        Chunk        chunks[GridSize * GridSize];
+        Chunk_Blocks chunk_blocks[GridSize * GridSize];
+    };
+
+    static Chunk *get_center_test_chunk(Mesher_Test_Chunks *test_chunks)
+    {
+        return &test_chunks->chunks[(Mesher_Test_Chunks::GridSize * Mesher_Test_Chunks::GridSize) / 2];
+    }
+
+    static void light_test_chunk_block(Chunk *chunk, const glm::ivec3& light_source_coords, u8 light_source_level)
+    {
+        i32 radius = light_source_level - 1;
+
+        for (i32 y = Max(light_source_coords.y - radius, 0); y <= Min(light_source_coords.y + radius, Chunk::Height - 1); y++)
+        {
+            for (i32 z = Max(light_source_coords.z - radius, 0); z <= Min(light_source_coords.z + radius, Chunk::Depth - 1); z++)
+            {
+                for (i32 x = Max(light_source_coords.x - radius, 0); x <= Min(light_source_coords.x + radius, Chunk::Width - 1); x++)
+                {
+                    i32 distance = glm::abs(x - light_source_coords.x) + glm::abs(y - light_source_coords.y) + glm::abs(z - light_source_coords.z);
+
+                    if (distance >= light_source_level)
+                    {
+                        continue;
+                    }
+
+                    Block_Light_Info *light_info = &chunk->light_map[y * Chunk::Width * Chunk::Depth + z * Chunk::Width + x];
+                    light_info->light_source_level = Max(light_info->light_source_level, (u8)(light_source_level - distance));
+                }
+            }
+        }
+    }
+
+    static void create_mesher_test_chunks(Mesher_Test_Chunks *test_chunks, i32 seed, u32 *random_state)
+    {
+        constexpr i32 GridSize = Mesher_Test_Chunks::GridSize;
+
+        constexpr u16 ScatteredBlockIds[] =
+        {
+            BlockId_Air,
+            BlockId_Stone,
+            BlockId_Glass,
+            BlockId_Oak_Leaves,
+            BlockId_Water,
+            BlockId_Blue_Stained_Glass
+        };
+
+        for (i32 z = 0; z < GridSize; z++)
+        {
+            for (i32 x = 0; x < GridSize; x++)
+            {
+                Chunk *chunk = &test_chunks->chunks[z * GridSize + x];
+                initialize_chunk(chunk, { x + 37, z - 81 });
+                attach_chunk_blocks(chunk, &test_chunks->chunk_blocks[z * GridSize + x]);
+                generate_chunk(chunk, seed);
+                calculate_height_map(chunk);
+
+                for (i32 i = 0; i < Chunk::Width * Chunk::Depth; i++)
+                {
+                    i32 y = chunk->height_map[i] - 2 + (i32)(next_test_random(random_state) % 6);
+
+                    if (next_test_random(random_state) % 16 == 0 && y >= 0 && y < Chunk::Height)
+                    {
+                        u16 block_id = ScatteredBlockIds[next_test_random(random_state) % ArrayCount(ScatteredBlockIds)];
+                        chunk->blocks[y * Chunk::Width * Chunk::Depth + i].id = block_id;
+                    }
+                }
+
+                calculate_height_map(chunk);
+
+                for (i32 y = 0; y < Chunk::Height; y++)
+                {
+                    for (i32 i = 0; i < Chunk::Width * Chunk::Depth; i++)
+                    {
+                        i32 depth = chunk->height_map[i] - y;
+
+                        Block_Light_Info *light_info = &chunk->light_map[y * Chunk::Width * Chunk::Depth + i];
+                        light_info->sky_light_level    = (u8)(depth < 0 ? 15 : Max(15 - depth, 0));
+                        light_info->light_source_level = 0;
+                    }
+                }
+
+                for (i32 i = 0; i < 4; i++)
+                {
+                    i32 column_index = (i32)(next_test_random(random_state) % (Chunk::Width * Chunk::Depth));
+                    glm::ivec3 block_coords = { column_index % Chunk::Width, chunk->height_map[column_index] + 1, column_index / Chunk::Width };
+
+                    if (block_coords.y < Chunk::Height)
+                    {
+                        chunk->blocks[block_coords.y * Chunk::Width * Chunk::Depth + column_index].id = BlockId_Glow_Stone;
+                        light_test_chunk_block(chunk, block_coords, 15);
+                    }
+                }
+            }
+        }
+
+        for (i32 z = 0; z < GridSize; z++)
+        {
+            for (i32 x = 0; x < GridSize; x++)
+            {
+                Chunk *chunk = &test_chunks->chunks[z * GridSize + x];
+
+                for (u32 i = 0; i < ChunkNeighbour_Count; i++)
+                {
+                    glm::ivec2 neighbour_coords = glm::ivec2(x, z) + Chunk::NeighbourDirections[i];
+
+                    // note(harlequin): the chunks on the edge of the grid wrap around so each of them can be meshed
+                    neighbour_coords = (neighbour_coords + GridSize) % GridSize;
+                    chunk->neighbours[i] = &test_chunks->chunks[neighbour_coords.y * GridSize + neighbour_coords.x];
+                }
+            }
+        }
+    }
+
+    // note(harlequin): every block face of a sub chunk has to come out of greedy meshing with the texture, light and
+    // ambient occlusion it has without it, the faces are compared by validate_greedy_meshing
+    void test_greedy_meshing()
+    {
+        constexpr u64 ArenaSize = MegaBytes(16);
+
+        Mesher_Test_Chunks *test_chunks = (Mesher_Test_Chunks *)calloc(1, sizeof(Mesher_Test_Chunks));
+        void *arena_memory = malloc(ArenaSize);
+        TestCheck(test_chunks && arena_memory);
+
+        if (!test_chunks || !arena_memory)
+        {
+            free(test_chunks);
+            free(arena_memory);
+            return;
+        }
+
+        Memory_Arena arena = create_memory_arena(arena_memory, ArenaSize);
+
+        u32 random_state = 0x2545F491;
+        create_mesher_test_chunks(test_chunks, 4242, &random_state);
+
+        Chunk *chunks[ArrayCount(test_chunks->chunks)];
+        for (u32 i = 0; i < ArrayCount(test_chunks->chunks); i++)
+        {
+            chunks[i] = &test_chunks->chunks[i];
+        }
+
+        Temprary_Memory_Arena temp_arena = begin_temprary_memory_arena(&arena);
+
+        Greedy_Meshing_Validation_Result result = {};
+        bool success = validate_greedy_meshing(nullptr, chunks, ArrayCount(chunks), &temp_arena, &result);
+
+        TestCheck(success);
+        TestCheck(result.sub_chunk_count == ArrayCount(chunks) * Chunk::SubChunkCount);
+        TestCheck(result.mismatched_face_count == 0);
+        TestCheck(result.mismatched_packed_face_count == 0);
+        TestCheck(result.face_count > 0);
+        TestCheck(result.greedy_face_count < result.face_count);
+
+        end_temprary_memory_arena(&temp_arena);
+
+        free(test_chunks);
+        free(arena_memory);
+    }
+
+    // note(harlequin): the row masks have to cull exactly the faces the per block face lookups culled, the faces of
+    // both are compared by validate_face_culling
+    void test_face_culling()
+    {
+        constexpr u64 ArenaSize = MegaBytes(4);
+
+        Mesher_Test_Chunks *test_chunks = (Mesher_Test_Chunks *)calloc(1, sizeof(Mesher_Test_Chunks));
+        void *arena_memory = malloc(ArenaSize);
+        TestCheck(test_chunks && arena_memory);
+
+        if (!test_chunks || !arena_memory)
+        {
+            free(test_chunks);
+            free(arena_memory);
+            return;
+        }
+
+        Memory_Arena arena = create_memory_arena(arena_memory, ArenaSize);
+
+        u32 random_state = 0x6C8E9CF5;
+        create_mesher_test_chunks(test_chunks, 4242, &random_state);
+
+        Chunk *chunks[ArrayCount(test_chunks->chunks)];
+        for (u32 i = 0; i < ArrayCount(test_chunks->chunks); i++)
+        {
+            chunks[i] = &test_chunks->chunks[i];
+        }
+
+        Temprary_Memory_Arena temp_arena = begin_temprary_memory_arena(&arena);
+
+        Face_Culling_Validation_Result result = {};
+        bool success = validate_face_culling(chunks, ArrayCount(chunks), &temp_arena, &result);
+
+        TestCheck(success);
+        TestCheck(result.sub_chunk_count == ArrayCount(chunks) * Chunk::SubChunkCount);
+        TestCheck(result.mismatched_sub_chunk_count == 0);
+        TestCheck(result.face_count > 0);
+
+        end_temprary_memory_arena(&temp_arena);
+
+        free(test_chunks);
+        free(arena_memory);
+    }
+
+    // note(harlequin): the faces of both streams as 64 bit records sorted so two meshes that emit the same faces in
+    // a different order compare equal, a patched mesh moves the last face of a stream into the slot of a removed one
+    static u32 get_sorted_sub_chunk_mesh_faces(const Sub_Chunk_Mesh *mesh, u64 *faces)
+    {
+        const Block_Face *streams[2]      = { get_opaque_faces(mesh), get_transparent_faces(mesh) };
+        i32               stream_sizes[2] = { mesh->opaque_face_count, mesh->transparent_face_count };
+
+        u32 face_count = 0;
+
+        for (i32 stream = 0; stream < 2; stream++)
+        {
+            u32 first_face_index = face_count;
+
+            for (i32 i = 0; i < stream_sizes[stream]; i++)
+            {
+                const Block_Face& face = streams[stream][i];
+                faces[face_count++] = ((u64)face.packed_face_attributes1 << 32) | face.packed_face_attributes0;
+            }
+
+            std::sort(faces + first_face_index, faces + face_count);
+        }
+
+        return face_count;
+    }
+
+    // note(harlequin): a sub chunk patched after each round of block and light edits in and around it has to end up
+    // with the faces a full rebuild gives it, the edits also land in the halo blocks owned by the sub chunks above and
+    // below and by the neighbouring chunks
+    void test_patch_sub_chunk_mesh()
+    {
+        constexpr u64 ArenaSize     = MegaBytes(32);
+        constexpr u32 RoundCount    = 24;
+        constexpr u32 EditsPerRound = 6;
+
+        constexpr u16 EditBlockIds[] =
+        {
+            BlockId_Air,
+            BlockId_Stone,
+            BlockId_Glass,
+            BlockId_Water,
+            BlockId_Oak_Leaves,
+            BlockId_Glow_Stone
+        };
+
+        Mesher_Test_Chunks *test_chunks = (Mesher_Test_Chunks *)calloc(1, sizeof(Mesher_Test_Chunks));
+        void *arena_memory = malloc(ArenaSize);
+        TestCheck(test_chunks && arena_memory);
+
+        if (!test_chunks || !arena_memory)
+        {
+            free(test_chunks);
+            free(arena_memory);
+            return;
+        }
+
+        Memory_Arena arena = create_memory_arena(arena_memory, ArenaSize);
+
+        bool is_mesher_initialized = initialize_sub_chunk_mesher(&arena);
+        TestCheck(is_mesher_initialized);
+
+        Sub_Chunk_Mesh *scratch_mesh  = ArenaPushAligned(&arena, Sub_Chunk_Mesh);
+        Sub_Chunk_Mesh *rebuilt_mesh  = ArenaPushAligned(&arena, Sub_Chunk_Mesh);
+        u64            *patched_faces = ArenaPushArrayAligned(&arena, u64, Sub_Chunk_Mesh::MaxFaceCount);
+        u64            *rebuilt_faces = ArenaPushArrayAligned(&arena, u64, Sub_Chunk_Mesh::MaxFaceCount);
+        TestCheck(scratch_mesh && rebuilt_mesh && patched_faces && rebuilt_faces);
+
+        if (!is_mesher_initialized || !scratch_mesh || !rebuilt_mesh || !patched_faces || !rebuilt_faces)
+        {
+            free(test_chunks);
+            free(arena_memory);
+            return;
+        }
+
+        u32 random_state = 0x1B873593;
+        create_mesher_test_chunks(test_chunks, 4242, &random_state);
+
+        Chunk *chunk = get_center_test_chunk(test_chunks);
+
+        // note(harlequin): the sub chunk the surface of the first column is in
+        u32 sub_chunk_index = (u32)chunk->height_map[0] / Chunk::SubChunkHeight;
+        i32 sub_chunk_start_y = (i32)(sub_chunk_index * Chunk::SubChunkHeight);
+
+        Sub_Chunk_Patch_Stats stats_before = get_sub_chunk_patch_stats();
+
+        chunk->patchable_sub_chunk_mask |= 1u << sub_chunk_index;
+        Sub_Chunk_Mesh *mesh = patch_sub_chunk_mesh(chunk, sub_chunk_index, scratch_mesh);
+        TestCheck(mesh);
+
+        if (!mesh)
+        {
+            free(test_chunks);
+            free(arena_memory);
+            return;
+        }
+
+        release_patched_sub_chunk_mesh(mesh);
+
+        for (u32 round = 0; round < RoundCount; round++)
+        {
+            for (u32 i = 0; i < EditsPerRound; i++)
+            {
+                glm::ivec3 block_coords = { (i32)(next_test_random(&random_state) % (Chunk::Width + 2)) - 1,
+                                            (i32)(next_test_random(&random_state) % (Chunk::SubChunkHeight + 2)) - 1,
+                                            (i32)(next_test_random(&random_state) % (Chunk::Depth + 2)) - 1 };
+
+                glm::ivec2 neighbour_direction = { (block_coords.x >= Chunk::Width) - (block_coords.x < 0),
+                                                   (block_coords.z >= Chunk::Depth) - (block_coords.z < 0) };
+
+                Chunk *block_chunk = chunk;
+
+                for (u32 neighbour = 0; neighbour < ChunkNeighbour_Count; neighbour++)
+                {
+                    if (Chunk::NeighbourDirections[neighbour] == neighbour_direction)
+                    {
+                        block_chunk = chunk->neighbours[neighbour];
+                    }
+                }
+
+                i32 block_x = (block_coords.x + Chunk::Width) % Chunk::Width;
+                i32 block_y = sub_chunk_start_y + block_coords.y;
+                i32 block_z = (block_coords.z + Chunk::Depth) % Chunk::Depth;
+                i32 block_index = block_y * Chunk::Width * Chunk::Depth + block_z * Chunk::Width + block_x;
+
+                block_chunk->blocks[block_index].id = EditBlockIds[next_test_random(&random_state) % ArrayCount(EditBlockIds)];
+
+                Block_Light_Info *light_info = &block_chunk->light_map[block_index];
+                light_info->sky_light_level    = (u8)(next_test_random(&random_state) % 16);
+                light_info->light_source_level = (u8)(next_test_random(&random_state) % 16);
+            }
+
+            mesh = patch_sub_chunk_mesh(chunk, sub_chunk_index, scratch_mesh);
+            TestCheck(mesh);
+
+            if (!mesh)
+            {
+                break;
+            }
+
+            mesh_sub_chunk(nullptr, chunk, sub_chunk_index, false, rebuilt_mesh);
+
+            u32 patched_face_count = get_sorted_sub_chunk_mesh_faces(mesh, patched_faces);
+            u32 rebuilt_face_count = get_sorted_sub_chunk_mesh_faces(rebuilt_mesh, rebuilt_faces);
+
+            TestCheck(mesh->opaque_face_count == rebuilt_mesh->opaque_face_count);
+            TestCheck(mesh->transparent_face_count == rebuilt_mesh->transparent_face_count);
+            TestCheck(patched_face_count == rebuilt_face_count &&
+                      memcmp(patched_faces, rebuilt_faces, patched_face_count * sizeof(u64)) == 0);
+            TestCheck(mesh->content_hash == rebuilt_mesh->content_hash);
+
+            release_patched_sub_chunk_mesh(mesh);
+        }
+
+        // note(harlequin): no round changed enough blocks to fall back on a rebuild
+        Sub_Chunk_Patch_Stats stats = get_sub_chunk_patch_stats();
+        TestCheck(stats.patch_count - stats_before.patch_count == RoundCount);
+        TestCheck(stats.rebuild_count - stats_before.rebuild_count == 1);
+
+        free(test_chunks);
+        free(arena_memory);
+    }
+
+    // note(harlequin): the cached corner samples have to light and shade every face corner the way the blocks in front
+    // of it do and read fewer halo blocks doing it, the faces of both are compared by validate_corner_samples
+    void test_corner_samples()
+    {
+        constexpr u64 ArenaSize = MegaBytes(4);
+
+        Mesher_Test_Chunks *test_chunks = (Mesher_Test_Chunks *)calloc(1, sizeof(Mesher_Test_Chunks));
+        void *arena_memory = malloc(ArenaSize);
+        TestCheck(test_chunks && arena_memory);
+
+        if (!test_chunks || !arena_memory)
+        {
+            free(test_chunks);
+            free(arena_memory);
+            return;
+        }
+
+        Memory_Arena arena = create_memory_arena(arena_memory, ArenaSize);
+
+        u32 random_state = 0xE6546B64;
+        create_mesher_test_chunks(test_chunks, 4242, &random_state);
+
+        Chunk *chunks[ArrayCount(test_chunks->chunks)];
+        for (u32 i = 0; i < ArrayCount(test_chunks->chunks); i++)
+        {
+            chunks[i] = &test_chunks->chunks[i];
+        }
+
+        Temprary_Memory_Arena temp_arena = begin_temprary_memory_arena(&arena);
+
+        Corner_Sample_Validation_Result result = {};
+        bool success = validate_corner_samples(chunks, ArrayCount(chunks), &temp_arena, &result);
+
+        TestCheck(success);
+        TestCheck(result.sub_chunk_count == ArrayCount(chunks) * Chunk::SubChunkCount);
+        TestCheck(result.mismatched_sub_chunk_count == 0);
+        TestCheck(result.cached_corner_light_read_count > 0);
+        TestCheck(result.cached_corner_light_read_count < result.corner_light_read_count);
+
+        end_temprary_memory_arena(&temp_arena);
+
+        free(test_chunks);
+        free(arena_memory);
+    }
+
+    // note(harlequin): every value of every block face field has to come back out of unpack_block_face and the
+    // decoding of the chunk vertex shaders, see validate_block_face_packing
+    void test_block_face_packing()
+    {
+        Block_Face_Packing_Validation_Result result = {};
+        bool success = validate_block_face_packing(&result);
+
+        TestCheck(success);
+        TestCheck(result.checked_face_count > 0);
+        TestCheck(result.mismatched_face_count == 0);
+    }
+}
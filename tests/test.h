@@ -0,0 +1,45 @@
+#pragma once
+
+#include "core/common.h"
+
+#include <stdio.h>
+
+namespace minecraft {
+
+    // note(harlequin): a failed check is reported and counted, the test keeps going so one run shows every failure
+    extern u32 failed_check_count;
+
+    #define TestCheck(Expression)\
+        do\
+        {\
+            if (!(Expression))\
+            {\
+                fprintf(stderr, "[FAILED]: %s:%d: %s\n", __FILE__, __LINE__, #Expression);\
+                minecraft::failed_check_count++;\
+            }\
+        }\
+        while (0)
+
+    // note(harlequin): xorshift so every run of the tests walks the same sequences
+    inline u32 next_test_random(u32 *state)
+    {
+        u32 x = *state;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        *state = x;
+        return x;
+    }
+
+    void test_buddy_allocator();
+    void test_retire_queue();
+    void test_find_reachable_sub_chunks();
+    void test_occlusion_buffer();
+    void test_generate_chunk_lod_cells();
+    void test_greedy_meshing();
+    void test_face_culling();
+    void test_patch_sub_chunk_mesh();
+    void test_corner_samples();
+    void test_block_face_packing();
+    void test_frustum_aabb_batch();
+}
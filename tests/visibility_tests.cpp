@@ -0,0 +1,143 @@
+#include "test.h"
+
+#include "memory/memory_arena.h"
+#include "game/world.h"
+#include "renderer/camera.h"
+
+#include <stdlib.h>
+#include <new>
+
+namespace minecraft {
+
+    void test_find_reachable_sub_chunks()
+    {
+        constexpr i32 GridSize         = 5;
+        constexpr i32 LayerSubChunk    = 10;
+        constexpr i32 CaveSubChunk     = 5;
+        constexpr u32 AllSubChunksMask = (u32)(((u64)1 << Chunk::SubChunkCount) - 1);
+        constexpr u64 ArenaSize        = MegaBytes(16);
+
+        // note(harlequin): only the active chunk list of the world is touched, the rest of it is never paged in
+        World *world = (World *)calloc(1, sizeof(World));
+        void *arena_memory = malloc(ArenaSize);
+        Memory_Arena arena = create_memory_arena(arena_memory, ArenaSize);
+
+        Chunk *chunks = ArenaPushArrayAlignedZero(&arena, Chunk, GridSize * GridSize);
+        TestCheck(world && chunks);
+
+        if (!world || !chunks)
+        {
+            free(world);
+            free(arena_memory);
+            return;
+        }
+
+        auto get_chunk = [&](i32 x, i32 z) -> Chunk*
+        {
+            return &chunks[z * GridSize + x];
+        };
+
+        for (i32 z = 0; z < GridSize; z++)
+        {
+            for (i32 x = 0; x < GridSize; x++)
+            {
+                Chunk *chunk        = get_chunk(x, z);
+                chunk->world_coords = { x, z };
+                chunk->position     = { x * Chunk::Width, 0.0f, z * Chunk::Depth };
+
+                for (u32 i = 0; i < Chunk::SubChunkCount; i++)
+                {
+                    new (&chunk->sub_chunks_render_data[i].face_connectivity) std::atomic< u64 >(SubChunkFullFaceConnectivity);
+                }
+
+                // note(harlequin): a solid layer across every chunk
+                chunk->sub_chunks_render_data[LayerSubChunk].face_connectivity = 0;
+
+                for (u32 i = 0; i < ChunkNeighbour_Count; i++)
+                {
+                    glm::ivec2 neighbour_coords = chunk->world_coords + Chunk::NeighbourDirections[i];
+                    if (neighbour_coords.x >= 0 && neighbour_coords.x < GridSize &&
+                        neighbour_coords.y >= 0 && neighbour_coords.y < GridSize)
+                    {
+                        chunk->neighbours[i] = get_chunk(neighbour_coords.x, neighbour_coords.y);
+                    }
+                }
+
+                world->active_chunks[world->active_chunk_count++] = chunk;
+            }
+        }
+
+        // note(harlequin): a sealed cave under the layer in the center column
+        Chunk *center_chunk = get_chunk(GridSize / 2, GridSize / 2);
+        center_chunk->sub_chunks_render_data[CaveSubChunk].face_connectivity = 0;
+
+        auto get_reachable_sub_chunk_count = [&](u32 mask) -> u32
+        {
+            u32 count = 0;
+            for (i32 i = 0; i < GridSize * GridSize; i++)
+            {
+                count += count_set_bits(chunks[i].reachable_sub_chunk_mask & mask);
+            }
+            return count;
+        };
+
+        u32 below_layer_mask = (1u << LayerSubChunk) - 1;
+        u32 above_layer_mask = AllSubChunksMask & ~((1u << (LayerSubChunk + 1)) - 1);
+
+        glm::vec3 center_position = center_chunk->position + glm::vec3(Chunk::Width * 0.5f, 0.0f, Chunk::Depth * 0.5f);
+
+        Camera camera = {};
+        initialize_camera(&camera, center_position + glm::vec3(0.0f, Chunk::SubChunkHeight * 14.5f, 0.0f));
+        camera.pitch = 45.0f;
+        update_camera(&camera);
+        TestCheck(camera.forward.y < 0.0f);
+
+        // note(harlequin): above the layer the layer itself is reached but nothing under it
+        Temprary_Memory_Arena temp_arena = begin_temprary_memory_arena(&arena);
+        find_reachable_sub_chunks(world, camera.position, camera.frustum, true, &temp_arena);
+        end_temprary_memory_arena(&temp_arena);
+
+        TestCheck(center_chunk->reachable_sub_chunk_mask & (1u << 14));
+        TestCheck(center_chunk->reachable_sub_chunk_mask & (1u << LayerSubChunk));
+        TestCheck(get_reachable_sub_chunk_count(below_layer_mask) == 0);
+        TestCheck(get_reachable_sub_chunk_count(AllSubChunksMask) == world->reachable_sub_chunk_count);
+        TestCheck(world->reachable_sub_chunk_count > 1);
+
+        // note(harlequin): the view sub chunk is left through every face whatever its connectivity, from the cave
+        // the walk spreads under the layer and never gets above it
+        camera.position = center_position + glm::vec3(0.0f, Chunk::SubChunkHeight * (CaveSubChunk + 0.5f), 0.0f);
+        camera.pitch    = 0.0f;
+        update_camera(&camera);
+
+        temp_arena = begin_temprary_memory_arena(&arena);
+        find_reachable_sub_chunks(world, camera.position, camera.frustum, true, &temp_arena);
+        end_temprary_memory_arena(&temp_arena);
+
+        TestCheck(center_chunk->reachable_sub_chunk_mask & (1u << CaveSubChunk));
+        TestCheck(get_reachable_sub_chunk_count(above_layer_mask) == 0);
+        TestCheck(get_reachable_sub_chunk_count(below_layer_mask) > 1);
+
+        // note(harlequin): a neighbour pointer to a chunk that was reused for other coords is never followed
+        Chunk *front_chunk = center_chunk->neighbours[ChunkNeighbour_Front];
+        glm::ivec2 front_chunk_coords = front_chunk->world_coords;
+        front_chunk->world_coords = { -100, -100 };
+
+        temp_arena = begin_temprary_memory_arena(&arena);
+        find_reachable_sub_chunks(world, camera.position, camera.frustum, true, &temp_arena);
+        end_temprary_memory_arena(&temp_arena);
+
+        TestCheck(front_chunk->reachable_sub_chunk_mask == 0);
+        front_chunk->world_coords = front_chunk_coords;
+
+        // note(harlequin): without culling every sub chunk of every active chunk is reachable
+        temp_arena = begin_temprary_memory_arena(&arena);
+        find_reachable_sub_chunks(world, camera.position, camera.frustum, false, &temp_arena);
+        end_temprary_memory_arena(&temp_arena);
+
+        TestCheck(get_reachable_sub_chunk_count(AllSubChunksMask) == GridSize * GridSize * Chunk::SubChunkCount);
+        TestCheck(world->reachable_sub_chunk_count == GridSize * GridSize * Chunk::SubChunkCount);
+
+        free(world);
+        free(arena_memory);
+    }
+}